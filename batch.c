@@ -0,0 +1,435 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		batch.c
+ *
+ * @brief 		Code file for executing a file of jack commands on one
+ * 				MCTP session
+ *
+ * Each line of a batch file is a jack command line, with or without the
+ * leading application name. Blank lines and lines starting with '#' are
+ * ignored. Words may be quoted with single or double quotes.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* gettid()
+ * getline()
+ */
+#define _GNU_SOURCE
+
+/* printf()
+ */
+#include <stdio.h>
+
+/* malloc()
+ * free()
+ */
+#include <stdlib.h>
+
+/* basename()
+ * strdup()
+ */
+#include <string.h>
+
+/* dup()
+ * dup2()
+ */
+#include <unistd.h>
+
+#include <ctype.h>
+#include <fcntl.h>
+
+/* clock_gettime()
+ */
+#include <time.h>
+
+/* ARGP_NO_EXIT
+ */
+#include <argp.h>
+
+#include "batch.h"
+#include "options.h"
+
+/* MACROS ====================================================================*/
+
+#ifdef JACK_VERBOSE
+ #define INIT 			unsigned step = 0;
+ #define ENTER 					if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_THREADS) 	printf("%d:%s Enter\n", 				gettid(), __FUNCTION__);
+ #define STEP 			step++; if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_STEPS) 		printf("%d:%s STEP: %u\n", 				gettid(), __FUNCTION__, step);
+ #define EXIT(rc) 				if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_THREADS)	printf("%d:%s Exit: %d\n", 				gettid(), __FUNCTION__,rc);
+#else
+ #define INIT
+ #define ENTER
+ #define STEP
+ #define EXIT(rc)
+#endif
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Return time elapsed between two timespecs in seconds
+ */
+static double elapsed(struct timespec *start, struct timespec *stop)
+{
+	return (stop->tv_sec - start->tv_sec) + (stop->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Split a line into words in place
+ *
+ * @param line 	Line to split. NUL characters are written into this buffer
+ * @param words Array to store pointers to each word in
+ * @param max 	Size of the words array
+ * @return 		Number of words found, -1 on unterminated quote or too many
+ */
+static int split_line(char *line, char **words, int max)
+{
+	char *src, *dst, quote;
+	int n;
+
+	n = 0;
+	src = line;
+
+	while (*src)
+	{
+		// Skip leading whitespace
+		while (*src && isspace((unsigned char) *src))
+			src++;
+		if (*src == 0 || *src == '#')
+			break;
+
+		if (n >= max)
+			return -1;
+
+		// Copy word down over the quote characters
+		words[n++] = dst = src;
+		quote = 0;
+		while (*src && (quote || !isspace((unsigned char) *src)))
+		{
+			if (quote && *src == quote)
+				quote = 0;
+			else if (!quote && (*src == '"' || *src == '\''))
+				quote = *src;
+			else
+				*dst++ = *src;
+			src++;
+		}
+		if (quote)
+			return -1;
+		if (*src)
+			src++;
+		*dst = 0;
+	}
+
+	return n;
+}
+
+/**
+ * Load a batch file
+ *
+ * @param path 	Filename of the batch file, or "-" for stdin
+ * @param app 	Application name to use as argv[0] of each line
+ * @return 		struct batch* upon success, NULL otherwise
+ *
+ * STEPS
+ * 1: Open file
+ * 2: Allocate batch
+ * 3: Read each line
+ * 4: Split line into argv
+ */
+struct batch *batch_load(const char *path, char *app)
+{
+	struct batch *b;
+	struct batch_line *l;
+	char *words[JKLN_BATCH_MAX_ARGS];
+	char *line, *copy;
+	size_t cap;
+	ssize_t len;
+	FILE *fp;
+	int num, n, first, i, max;
+
+	b = NULL;
+	line = NULL;
+	cap = 0;
+	num = 0;
+	max = 0;
+
+	// STEP 1: Open file
+	if (!strcmp(path, "-"))
+		fp = stdin;
+	else
+		fp = fopen(path, "r");
+	if (fp == NULL)
+	{
+		printf("Error: Could not open batch file %s\n", path);
+		goto end;
+	}
+
+	// STEP 2: Allocate batch
+	b = calloc(1, sizeof(struct batch));
+	if (b == NULL)
+		goto close;
+
+	// STEP 3: Read each line
+	while ( (len = getline(&line, &cap, fp)) >= 0 )
+	{
+		num++;
+
+		// Strip line ending
+		while (len > 0 && (line[len-1] == '\n' || line[len-1] == '\r'))
+			line[--len] = 0;
+
+		copy = strdup(line);
+		if (copy == NULL)
+			goto fail;
+
+		// STEP 4: Split line into argv
+		n = split_line(line, words, JKLN_BATCH_MAX_ARGS);
+		if (n < 0)
+		{
+			printf("Error: batch line %d: Unterminated quote or too many words\n", num);
+			free(copy);
+			goto fail;
+		}
+		if (n == 0)
+		{
+			free(copy);
+			continue;
+		}
+
+		// Drop a leading application name
+		first = 0;
+		if (!strcmp(words[0], "jack") || !strcmp(words[0], basename(app)))
+			first = 1;
+		if (first == n)
+		{
+			free(copy);
+			continue;
+		}
+
+		if (b->count == max)
+		{
+			max = max ? max * 2 : 64;
+			l = realloc(b->lines, max * sizeof(struct batch_line));
+			if (l == NULL)
+			{
+				free(copy);
+				goto fail;
+			}
+			b->lines = l;
+		}
+
+		l = &b->lines[b->count];
+		l->num = num;
+		l->text = copy;
+		l->argc = n - first + 1;
+		l->argv = calloc(l->argc + 1, sizeof(char*));
+		if (l->argv == NULL)
+		{
+			free(copy);
+			goto fail;
+		}
+		b->count++;
+
+		l->argv[0] = strdup(app);
+		for ( i = first ; i < n ; i++ )
+			l->argv[i - first + 1] = strdup(words[i]);
+	}
+
+	goto close;
+
+fail:
+
+	batch_free(b);
+	b = NULL;
+
+close:
+
+	free(line);
+	if (fp != stdin)
+		fclose(fp);
+
+end:
+
+	return b;
+}
+
+/**
+ * Check that a parsed line can be executed on the session of a batch
+ *
+ * Commands that start their own session and options that main() handles 
+ * before a session is opened would be ignored by batch_run()
+ *
+ * @param o 	Options parsed from the line
+ * @return 		NULL if the line is valid, the reason it is not otherwise
+ */
+static const char *line_error(struct opt *o)
+{
+	if (!o[CLOP_CMD].set)
+		return "Invalid command";
+
+	if (o[CLOP_SNAPSHOT].set)
+		return "--snapshot cannot be used in a batch";
+
+	switch (o[CLOP_CMD].val)
+	{
+		case CLCM_DAEMON:
+		case CLCM_BATCH:
+		case CLCM_WATCH_PORT:
+		case CLCM_WATCH_VCS:
+		case CLCM_WATCH_QOS:
+		case CLCM_EVENTS:
+			return "Command cannot be used in a batch";
+
+		case CLCM_LD_SNAPSHOT_DIFF:
+			return "ld snapshot diff cannot be used in a batch";
+	}
+
+	return NULL;
+}
+
+/**
+ * Verify every line of a batch parses before any of them are executed
+ *
+ * Lines are parsed in process with ARGP_NO_EXIT so invalid input and help 
+ * requests return an error instead of exiting. Help text is discarded. This
+ * must be called before any threads are started
+ *
+ * @return 0 if every line is valid, number of invalid lines otherwise
+ */
+int batch_check(struct batch *b)
+{
+	struct batch_line *l;
+	struct opt *o;
+	const char *why;
+	int i, bad, fd, out;
+
+	bad = 0;
+
+	// Suppress help text while parsing
+	fflush(stdout);
+	out = dup(STDOUT_FILENO);
+	fd = open("/dev/null", O_WRONLY);
+	if (out < 0 || fd < 0)
+	{
+		if (out >= 0)
+			close(out);
+		if (fd >= 0)
+			close(fd);
+		return -1;
+	}
+
+	for ( i = 0 ; i < b->count ; i++ )
+	{
+		l = &b->lines[i];
+
+		dup2(fd, STDOUT_FILENO);
+		why = "Invalid command";
+		if (options_parse_argv(&o, l->argc, l->argv, ARGP_NO_EXIT | ARGP_NO_ERRS) == 0)
+		{
+			why = line_error(o);
+			options_free(o);
+		}
+		fflush(stdout);
+		dup2(out, STDOUT_FILENO);
+
+		if (why != NULL)
+		{
+			printf("Error: batch line %d: %s: %s\n", l->num, why, l->text);
+			bad++;
+		}
+	}
+
+	close(fd);
+	close(out);
+
+	return bad;
+}
+
+/**
+ * Execute each line of a batch on one MCTP session
+ *
+ * @param m 	struct mctp* that is already connected to the endpoint
+ * @param b 	Batch to execute
+ * @param fn 	Function to execute one command line
+ * @return 		0 if every line succeeded, number of failed lines otherwise
+ *
+ * STEPS
+ * 1: Execute each line and print its status
+ * 2: Print summary
+ */
+int batch_run(struct mctp *m, struct batch *b, int (*fn)(struct mctp *m, int argc, char **argv))
+{
+	INIT
+	struct batch_line *l;
+	struct timespec start, stop, t0, t1;
+	int i, rv, failed;
+	double total;
+
+	ENTER
+
+	failed = 0;
+
+	STEP // 1: Execute each line and print its status
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for ( i = 0 ; i < b->count ; i++ )
+	{
+		l = &b->lines[i];
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		rv = fn(m, l->argc, l->argv);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		if (rv != 0)
+			failed++;
+
+		printf("[%4d] %-4s rv: %-3d %9.3f ms  %s\n", l->num, rv ? "FAIL" : "OK", rv, elapsed(&t0, &t1) * 1000, l->text);
+		fflush(stdout);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	STEP // 2: Print summary
+	total = elapsed(&start, &stop);
+	printf("Batch: %d commands, %d failed, %.3f s elapsed", b->count, failed, total);
+	if (total > 0)
+		printf(", %.1f commands/s", b->count / total);
+	printf("\n");
+
+	EXIT(failed)
+
+	return failed;
+}
+
+/**
+ * Free a batch
+ */
+void batch_free(struct batch *b)
+{
+	int i, k;
+
+	if (b == NULL)
+		return;
+
+	for ( i = 0 ; i < b->count ; i++ )
+	{
+		for ( k = 0 ; k < b->lines[i].argc ; k++ )
+			free(b->lines[i].argv[k]);
+		free(b->lines[i].argv);
+		free(b->lines[i].text);
+	}
+	free(b->lines);
+	free(b);
+}
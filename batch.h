@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		batch.h
+ *
+ * @brief 		Header file for executing a file of jack commands on one
+ * 				MCTP session
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _BATCH_H
+#define _BATCH_H
+
+/* struct mctp
+ */
+#include <mctp.h>
+
+/* MACROS ====================================================================*/
+
+#define JKLN_BATCH_MAX_ARGS 	64 		//!< Max number of words on one line
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * One command line of a batch file
+ */
+struct batch_line
+{
+	int 	num;	//!< Line number in the file (1 based)
+	int 	argc;	//!< Number of strings in argv
+	char 	**argv;	//!< argv[0] is the application name
+	char 	*text;	//!< Original text of the line
+};
+
+/**
+ * A loaded batch file
+ */
+struct batch
+{
+	int 				count;	//!< Number of command lines
+	struct batch_line 	*lines;	//!< Array of command lines
+};
+
+/* PROTOTYPES ================================================================*/
+
+struct batch *batch_load(const char *path, char *app);
+
+int batch_check(struct batch *b);
+
+int batch_run(struct mctp *m, struct batch *b, int (*fn)(struct mctp *m, int argc, char **argv));
+
+void batch_free(struct batch *b);
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_BATCH_H
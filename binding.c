@@ -0,0 +1,297 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		binding.c
+ *
+ * @brief 		Code file for the index of port / LD bindings to vPPBs
+ *
+ * The index maps a physical port and LD ID to the VCS and vPPB it is bound
+ * to, so a lookup does not have to scan every vPPB of every VCS. It is kept
+ * alongside the cached switch state and is protected by the same mutex.
+ * Each port has one slot for a binding of the whole port and one for each LD.
+ * Every published view carries a copy of the index for lock free lookups
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* printf()
+ */
+#include <stdio.h>
+
+/* calloc()
+ * free()
+ */
+#include <stdlib.h>
+
+/* memcpy()
+ * memset()
+ */
+#include <string.h>
+
+#include <fmapi.h>
+
+#include "binding.h"
+#include "view.h"
+
+/* MACROS ====================================================================*/
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * Array of num_ports * BDLN_SLOTS entries
+ */
+static struct bind_entry *table;
+static unsigned num_ports;
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Return the index of the slot of a port / LD, or -1 if it has none
+ */
+static int slot_index(unsigned ports, unsigned ppid, unsigned ldid)
+{
+	if (ppid >= ports)
+		return -1;
+
+	if (ldid == BDLN_PORT_LD)
+		return ppid * BDLN_SLOTS;
+
+	if (ldid < BDLN_LDS)
+		return ppid * BDLN_SLOTS + 1 + ldid;
+
+	return -1;
+}
+
+/**
+ * Return the slot of a port / LD or NULL if it is not held in the index
+ */
+static struct bind_entry *slot(unsigned ppid, unsigned ldid)
+{
+	int i;
+
+	i = slot_index(num_ports, ppid, ldid);
+
+	return i < 0 ? NULL : &table[i];
+}
+
+/**
+ * Return 1 if a vPPB status is a binding to a port or LD
+ */
+static int is_bound(int status)
+{
+	return status == FMBS_BOUND_PORT || status == FMBS_BOUND_LD;
+}
+
+/**
+ * Size the index for the ports of a switch and fill it from its VCSs
+ *
+ * Must be called with s->mtx held
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+int binding_rebuild(struct cxl_switch *s)
+{
+	struct bind_entry *e;
+	struct cxl_vcs *v;
+	unsigned i, k;
+
+	if (s->num_ports != num_ports)
+	{
+		free(table);
+		num_ports = 0;
+		table = calloc(s->num_ports * BDLN_SLOTS + 1, sizeof(struct bind_entry));
+		if (table == NULL)
+			return 1;
+		num_ports = s->num_ports;
+	}
+
+	for ( i = 0 ; i < num_ports * BDLN_SLOTS ; i++ )
+		table[i].valid = 0;
+
+	for ( i = 0 ; i < s->num_vcss ; i++ )
+	{
+		v = &s->vcss[i];
+		for ( k = 0 ; k < v->num ; k++ )
+		{
+			if (!is_bound(v->vppbs[k].bind_status))
+				continue;
+
+			e = slot(v->vppbs[k].ppid, v->vppbs[k].ldid);
+			if (e == NULL)
+				continue;
+
+			e->valid 	= 1;
+			e->vcsid 	= i;
+			e->vppbid 	= k;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Set the state of a cached vPPB and update the index to match
+ *
+ * Must be called with the mutex of the switch held. vPPBs past the number 
+ * of vPPBs of the VCS, which never exceeds num_vppbs of the switch, are 
+ * ignored
+ *
+ * @param v 		struct cxl_vcs* the vPPB belongs to
+ * @param vppbid 	vPPB of the VCS
+ * @param status 	Bind status [FMBS]
+ * @param ppid 		Physical port of the binding
+ * @param ldid 		LD of the binding. BDLN_PORT_LD for the whole port
+ */
+void binding_update(struct cxl_vcs *v, unsigned vppbid, int status, int ppid, int ldid)
+{
+	struct cxl_vppb *b;
+	struct bind_entry *e;
+
+	if (vppbid >= v->num)
+		return;
+
+	b = &v->vppbs[vppbid];
+
+	// Drop the previous binding if the index still points to this vPPB
+	if (is_bound(b->bind_status))
+	{
+		e = slot(b->ppid, b->ldid);
+		if (e != NULL && e->valid && e->vcsid == v->vcsid && e->vppbid == vppbid)
+			e->valid = 0;
+	}
+
+	b->bind_status 	= status;
+	b->ppid 		= ppid;
+	b->ldid 		= ldid;
+
+	if (is_bound(status))
+	{
+		e = slot(ppid, ldid);
+		if (e != NULL)
+		{
+			e->valid 	= 1;
+			e->vcsid 	= v->vcsid;
+			e->vppbid 	= vppbid;
+		}
+	}
+}
+
+/**
+ * Copy the slots of the first ports ports of the index
+ *
+ * Must be called with the mutex of the switch held. Slots of ports the index
+ * does not hold are cleared
+ *
+ * @param dst 	Array of ports * BDLN_SLOTS entries
+ */
+void binding_copy(struct bind_entry *dst, unsigned ports)
+{
+	unsigned n;
+
+	n = ports < num_ports ? ports : num_ports;
+
+	if (n > 0)
+		memcpy(dst, table, n * BDLN_SLOTS * sizeof(struct bind_entry));
+	memset(dst + n * BDLN_SLOTS, 0, (ports - n) * BDLN_SLOTS * sizeof(struct bind_entry));
+}
+
+/**
+ * Look up the vPPB a port / LD is bound to in a copy of the index
+ *
+ * @param t 	Copy of the index from binding_copy()
+ * @param ports Number of ports in t
+ * @return 		0 if bound, non zero otherwise
+ */
+int binding_find(const struct bind_entry *t, unsigned ports, unsigned ppid, unsigned ldid, __u8 *vcsid, __u8 *vppbid)
+{
+	const struct bind_entry *e;
+	int i;
+
+	i = slot_index(ports, ppid, ldid);
+	if (i < 0 || !t[i].valid)
+		return 1;
+
+	e = &t[i];
+
+	*vcsid = e->vcsid;
+	*vppbid = e->vppbid;
+
+	return 0;
+}
+
+/**
+ * Print the bindings of a port, or of one LD of a port
+ *
+ * Reads the copy of the index in the current view, so the cache is not 
+ * locked. The bindings are collected before printing since a view must not 
+ * be held while blocking
+ *
+ * @param ppid 	Physical port
+ * @param ldid 	LD to print. -1 for the whole port and all of its LDs
+ * @return 		0 upon success. Non zero otherwise
+ */
+int binding_print(unsigned ppid, int ldid)
+{
+	const struct cxl_view *view;
+	unsigned lds[BDLN_SLOTS], token, ld;
+	__u8 vcsids[BDLN_SLOTS], vppbids[BDLN_SLOTS];
+	int i, n, ports;
+
+	n = 0;
+
+	view = view_acquire(&token);
+	ports = view ? (int) view->num_ports : 0;
+	for ( i = -1 ; i < BDLN_LDS && (int) ppid < ports ; i++ )
+	{
+		ld = (i < 0) ? BDLN_PORT_LD : (unsigned) i;
+		if (ldid >= 0 && ld != (unsigned) ldid)
+			continue;
+		if (binding_find(view->binds, view->num_ports, ppid, ld, &vcsids[n], &vppbids[n]))
+			continue;
+		lds[n++] = ld;
+	}
+	view_release(token);
+
+	if ((int) ppid >= ports)
+	{
+		printf("Error: Invalid port: %u\n", ppid);
+		return 1;
+	}
+
+	printf("Show Binding:\n");
+	printf("PPID LDID  VCS vPPB\n");
+	printf("---- ---- ---- ----\n");
+
+	for ( i = 0 ; i < n ; i++ )
+	{
+		if (lds[i] == BDLN_PORT_LD)
+			printf("%4u    - %4u %4u\n", ppid, vcsids[i], vppbids[i]);
+		else
+			printf("%4u %4u %4u %4u\n", ppid, lds[i], vcsids[i], vppbids[i]);
+	}
+
+	if (n == 0)
+		printf("Not bound\n");
+
+	return 0;
+}
+
+/**
+ * Free the index
+ */
+void binding_free()
+{
+	free(table);
+	table = NULL;
+	num_ports = 0;
+}
@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		binding.h
+ *
+ * @brief 		Header file for the index of port / LD bindings to vPPBs
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _BINDING_H
+#define _BINDING_H
+
+/* __u8
+ * __u16
+ */
+#include <linux/types.h>
+
+/* struct cxl_switch
+ * struct cxl_vcs
+ */
+#include <cxlstate.h>
+
+/* MACROS ====================================================================*/
+
+#define BDLN_LDS 			16 		//!< LD IDs of a port held in the index
+#define BDLN_PORT_LD 		0xFFFF 	//!< LD ID of a binding of a whole port
+#define BDLN_SLOTS 			(BDLN_LDS + 1) 	//!< Slots per port: whole port + LDs
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * One slot of the index
+ */
+struct bind_entry
+{
+	__u8 valid;
+	__u8 vcsid;
+	__u8 vppbid;
+};
+
+/* PROTOTYPES ================================================================*/
+
+int binding_rebuild(struct cxl_switch *s);
+
+void binding_update(struct cxl_vcs *v, unsigned vppbid, int status, int ppid, int ldid);
+
+void binding_copy(struct bind_entry *dst, unsigned ports);
+
+int binding_find(const struct bind_entry *t, unsigned ports, unsigned ppid, unsigned ldid, __u8 *vcsid, __u8 *vppbid);
+
+int binding_print(unsigned ppid, int ldid);
+
+void binding_free();
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_BINDING_H
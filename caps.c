@@ -0,0 +1,547 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		caps.c
+ *
+ * @brief 		Code file for the PCIe capability and CXL DVSEC walker
+ *
+ * The walk runs over a local copy of the config space. When it reaches a
+ * DWord that has not been read yet it notes it and goes on with what it
+ * can still decode. The noted DWords are then read as one batch of requests
+ * in flight and the walk is run again, until it completes. Each capability
+ * header is read together with the DWords that follow it, so its fields and
+ * often the next header arrive in the same batch
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* printf()
+ */
+#include <stdio.h>
+
+/* calloc()
+ * free()
+ */
+#include <stdlib.h>
+
+/* memcpy()
+ * memset()
+ */
+#include <string.h>
+
+/* le32toh()
+ */
+#include <endian.h>
+
+/* PCLN_CFG
+ */
+#include <pciutils.h>
+
+#include <fmapi.h>
+#include <emapi.h>
+
+#include "caps.h"
+#include "cfgdump.h"
+#include "cmd_encoder.h"
+#include "fmapi_handler.h"
+#include "options.h"
+#include "snapshot.h"
+
+/* MACROS ====================================================================*/
+
+#define CPLN_DWORDS 		(PCLN_CFG / 4) 	//!< DWords of a config space
+#define CPLN_HDR 			0x40 			//!< Bytes of the config space header
+#define CPLN_STD 			0x100 			//!< End of the standard config space
+#define CPLN_LOCATORS 		8 				//!< Max register blocks decoded
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * Local copy of a config space and the DWords the walk is missing
+ */
+struct caps_walk
+{
+	__u8 data[PCLN_CFG];
+	__u8 valid[CPLN_DWORDS];	//!< DWord has been read
+	__u8 need[CPLN_DWORDS];		//!< DWord is needed by the walk
+	unsigned missing;			//!< DWords needed by the last pass
+	int print;					//!< Print the decode. Set on the last pass
+};
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * String representation of CPDV Enumeration
+ */
+static char *STR_CPDV[] = {
+	"CXL Device",
+	"",
+	"Non-CXL Function Map",
+	"CXL Extensions for Ports",
+	"GPF for CXL Ports",
+	"GPF for CXL Devices",
+	"",
+	"Flex Bus Port",
+	"Register Locator",
+	"MLD",
+	"Test Capability"
+};
+
+/**
+ * Names of the register blocks of a Register Locator DVSEC
+ */
+static char *STR_REGBLK[] = {
+	"Empty",
+	"Component Registers",
+	"BAR Virtualization ACL",
+	"CXL Memory Device Registers",
+	"CPMU Registers"
+};
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Return a DWord of the config space, or note that the walk needs it
+ *
+ * @return Value of the DWord. 0 if it has not been read yet
+ */
+static __u32 dw(struct caps_walk *c, unsigned off)
+{
+	__u32 v;
+
+	off = (off & (PCLN_CFG - 1)) / 4;
+
+	if (!c->valid[off])
+	{
+		if (!c->need[off])
+			c->missing++;
+		c->need[off] = 1;
+		return 0;
+	}
+
+	memcpy(&v, &c->data[off * 4], 4);
+	return le32toh(v);
+}
+
+/**
+ * Return 1 if a DWord has been read. Notes the DWords of a span from it
+ * that have not been read yet otherwise
+ *
+ * @param end 	The span is clipped to this offset
+ */
+static int have(struct caps_walk *c, unsigned off, unsigned end)
+{
+	unsigned i;
+
+	if (c->valid[(off & (PCLN_CFG - 1)) / 4])
+		return 1;
+
+	for ( i = off & ~3 ; i < off + CPLN_SPAN && i < end ; i += 4 )
+		if (!c->valid[i / 4])
+			dw(c, i);
+
+	return 0;
+}
+
+/**
+ * Return the name of a standard capability ID
+ */
+static const char *cap_name(unsigned id)
+{
+	switch (id)
+	{
+		case 0x01: return "Power Management";
+		case 0x05: return "MSI";
+		case 0x09: return "Vendor Specific";
+		case 0x0D: return "Subsystem Vendor ID";
+		case 0x10: return "PCI Express";
+		case 0x11: return "MSI-X";
+		case 0x12: return "SATA";
+		case 0x13: return "Advanced Features";
+		default:   return "Unknown";
+	}
+}
+
+/**
+ * Return the name of an extended capability ID
+ */
+static const char *ext_name(unsigned id)
+{
+	switch (id)
+	{
+		case 0x0001: return "Advanced Error Reporting";
+		case 0x0002: return "Virtual Channel";
+		case 0x0003: return "Device Serial Number";
+		case 0x0004: return "Power Budgeting";
+		case 0x000B: return "Vendor Specific";
+		case 0x000D: return "Access Control Services";
+		case 0x000E: return "Alternative Routing-ID";
+		case 0x0010: return "SR-IOV";
+		case 0x0015: return "Resizable BAR";
+		case 0x0017: return "TLP Processing Hints";
+		case 0x0018: return "Latency Tolerance Reporting";
+		case 0x0019: return "Secondary PCI Express";
+		case 0x001E: return "L1 PM Substates";
+		case 0x0023: return "Designated Vendor-Specific";
+		case 0x0025: return "Data Link Feature";
+		case 0x0026: return "Physical Layer 16.0 GT/s";
+		case 0x0027: return "Lane Margining at the Receiver";
+		case 0x002A: return "Physical Layer 32.0 GT/s";
+		case 0x002E: return "Data Object Exchange";
+		case 0x0031: return "Physical Layer 64.0 GT/s";
+		default:     return "Unknown";
+	}
+}
+
+/**
+ * Return the name of a PCIe Device/Port Type
+ */
+static const char *port_type(unsigned t)
+{
+	switch (t)
+	{
+		case 0x0: return "Endpoint";
+		case 0x1: return "Legacy Endpoint";
+		case 0x4: return "Root Port";
+		case 0x5: return "Upstream Switch Port";
+		case 0x6: return "Downstream Switch Port";
+		case 0x7: return "PCIe to PCI Bridge";
+		case 0x8: return "PCI to PCIe Bridge";
+		case 0x9: return "RC Integrated Endpoint";
+		case 0xA: return "RC Event Collector";
+		default:  return "Unknown";
+	}
+}
+
+/**
+ * Decode the PCI Express capability
+ */
+static void decode_pcie(struct caps_walk *c, unsigned p)
+{
+	__u32 cap, lcap, lsts;
+
+	cap  = dw(c, p) >> 16;
+	lcap = dw(c, p + 0x0C);
+	lsts = dw(c, p + 0x10) >> 16;
+
+	if (!c->print)
+		return;
+
+	printf("        Type: %s  Link Cap: Gen%u x%u  Link Status: Gen%u x%u\n",
+		port_type((cap >> 4) & 0xF), lcap & 0xF, (lcap >> 4) & 0x3F, lsts & 0xF, (lsts >> 4) & 0x3F);
+}
+
+/**
+ * Decode the Advanced Error Reporting capability
+ */
+static void decode_aer(struct caps_walk *c, unsigned p)
+{
+	__u32 ue, um, us, ce, cm, cc;
+
+	ue = dw(c, p + 0x04);
+	um = dw(c, p + 0x08);
+	us = dw(c, p + 0x0C);
+	ce = dw(c, p + 0x10);
+	cm = dw(c, p + 0x14);
+	cc = dw(c, p + 0x18);
+
+	if (!c->print)
+		return;
+
+	printf("        Uncorrectable: Status 0x%08x Mask 0x%08x Severity 0x%08x\n", ue, um, us);
+	printf("        Correctable:   Status 0x%08x Mask 0x%08x  First Error Pointer: %u\n", ce, cm, cc & 0x1F);
+}
+
+/**
+ * Decode the Device Serial Number capability
+ */
+static void decode_dsn(struct caps_walk *c, unsigned p)
+{
+	__u32 lo, hi;
+
+	lo = dw(c, p + 0x04);
+	hi = dw(c, p + 0x08);
+
+	if (!c->print)
+		return;
+
+	printf("        Serial: %08x%08x\n", hi, lo);
+}
+
+/**
+ * Print the Cache, IO and Mem bits of a CXL capability, control or status
+ */
+static void print_cxl_bits(const char *what, unsigned v)
+{
+	printf("        %-8s Cache%c IO%c Mem%c\n", what, 
+		v & 0x1 ? '+' : '-', v & 0x2 ? '+' : '-', v & 0x4 ? '+' : '-');
+}
+
+/**
+ * Decode a DVSEC. Only CXL DVSECs have their fields decoded
+ */
+static void decode_dvsec(struct caps_walk *c, unsigned p)
+{
+	__u32 h1, h2, v, lo, hi;
+	__u64 size, base;
+	unsigned vid, id, len, i, n;
+
+	h1 = dw(c, p + 0x04);
+	h2 = dw(c, p + 0x08);
+	vid = h1 & 0xFFFF;
+	len = h1 >> 20;
+	id = h2 & 0xFFFF;
+
+	// The fields are not known until the headers are
+	if (!c->valid[((p + 0x04) & (PCLN_CFG - 1)) / 4] || !c->valid[((p + 0x08) & (PCLN_CFG - 1)) / 4])
+		return;
+
+	if (vid != CPVD_CXL)
+	{
+		if (c->print)
+			printf("        Vendor 0x%04x ID 0x%04x Rev %u Length %u\n", vid, id, (h1 >> 16) & 0xF, len);
+		return;
+	}
+
+	if (c->print)
+		printf("        CXL DVSEC 0x%04x: %s (Rev %u, %u bytes)\n", id, 
+			(id < CPDV_MAX && STR_CPDV[id][0]) ? STR_CPDV[id] : "Unknown", (h1 >> 16) & 0xF, len);
+
+	switch (id)
+	{
+		case CPDV_DEVICE:
+			v = dw(c, p + 0x08) >> 16;
+			n = dw(c, p + 0x0C);
+			if (c->print)
+			{
+				print_cxl_bits("Cap:", v);
+				printf("        HDM Count: %u  Mem HwInit: %u\n", (v >> 4) & 0x3, (v >> 3) & 0x1);
+				print_cxl_bits("Ctrl:", n);
+			}
+			for ( i = 0 ; i < 2 ; i++ )
+			{
+				hi = dw(c, p + 0x18 + i * 0x10);
+				lo = dw(c, p + 0x1C + i * 0x10);
+				size = ((__u64) hi << 32) | (lo & 0xF0000000);
+				hi = dw(c, p + 0x20 + i * 0x10);
+				v  = dw(c, p + 0x24 + i * 0x10);
+				base = ((__u64) hi << 32) | (v & 0xF0000000);
+				if (c->print && (lo & 0x1))
+					printf("        Range %u: Size 0x%llx Base 0x%llx Active%c\n", i + 1, size, base, lo & 0x2 ? '+' : '-');
+			}
+			break;
+
+		case CPDV_FLEXBUS:
+			v = dw(c, p + 0x08) >> 16;
+			n = dw(c, p + 0x0C) >> 16;
+			if (c->print)
+			{
+				print_cxl_bits("Cap:", v);
+				print_cxl_bits("Status:", n);
+				printf("        68B Flit%c MLD%c\n", n & 0x20 ? '+' : '-', n & 0x40 ? '+' : '-');
+			}
+			break;
+
+		case CPDV_REG_LOCATOR:
+			n = len > 0x0C ? (len - 0x0C) / 8 : 0;
+			for ( i = 0 ; i < n && i < CPLN_LOCATORS ; i++ )
+			{
+				lo = dw(c, p + 0x0C + i * 8);
+				hi = dw(c, p + 0x10 + i * 8);
+				if (!c->print)
+					continue;
+				v = (lo >> 8) & 0xFF;
+				printf("        Block %u: %s BAR %u Offset 0x%llx\n", i, 
+					v < sizeof(STR_REGBLK) / sizeof(STR_REGBLK[0]) ? STR_REGBLK[v] : "Unknown",
+					lo & 0x7, ((__u64) hi << 32) | (lo & 0xFFFF0000));
+			}
+			break;
+
+		case CPDV_MLD:
+			v = dw(c, p + 0x08) >> 16;
+			n = dw(c, p + 0x0C) & 0xFFFF;
+			if (c->print)
+				printf("        LDs Supported: %u  LD-ID Hot Reset Vector: 0x%04x\n", v, n);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+ * Walk the standard capability list
+ */
+static void walk_std(struct caps_walk *c)
+{
+	__u32 h;
+	unsigned p, id, n;
+
+	// Status and the capabilities pointer live in the header
+	if (!have(c, 0x04, CPLN_HDR) || !have(c, 0x34, CPLN_HDR))
+		return;
+
+	if (!((dw(c, 0x04) >> 16) & 0x10))
+	{
+		if (c->print)
+			printf("No capability list\n");
+		return;
+	}
+
+	p = dw(c, 0x34) & 0xFC;
+	for ( n = 0 ; p >= CPLN_HDR && p < CPLN_STD && n < (CPLN_STD - CPLN_HDR) / 4 ; n++ )
+	{
+		// The standard list is short, so all of it is read in one batch
+		if (!have(c, p, p))
+		{
+			have(c, CPLN_HDR, CPLN_STD);
+			have(c, CPLN_HDR + CPLN_SPAN, CPLN_STD);
+			have(c, CPLN_HDR + 2 * CPLN_SPAN, CPLN_STD);
+			return;
+		}
+
+		h = dw(c, p);
+		id = h & 0xFF;
+
+		if (c->print)
+			printf("[%03x] Cap 0x%02x: %s\n", p, id, cap_name(id));
+
+		if (id == 0x10)
+			decode_pcie(c, p);
+
+		p = (h >> 8) & 0xFC;
+	}
+}
+
+/**
+ * Walk the extended capability list
+ */
+static void walk_ext(struct caps_walk *c)
+{
+	__u32 h;
+	unsigned p, id, n;
+
+	p = CPLN_STD;
+	for ( n = 0 ; p >= CPLN_STD && p < PCLN_CFG && n < (PCLN_CFG - CPLN_STD) / 4 ; n++ )
+	{
+		if (!have(c, p, PCLN_CFG))
+			return;
+
+		h = dw(c, p);
+		if (h == 0 || h == 0xFFFFFFFF)
+		{
+			if (c->print && p == CPLN_STD)
+				printf("No extended capabilities\n");
+			return;
+		}
+
+		id = h & 0xFFFF;
+
+		if (c->print)
+			printf("[%03x] Ext Cap 0x%04x v%u: %s\n", p, id, (h >> 16) & 0xF, ext_name(id));
+
+		switch (id)
+		{
+			case 0x0001: decode_aer(c, p); 		break;
+			case 0x0003: decode_dsn(c, p); 		break;
+			case 0x0023: decode_dvsec(c, p); 	break;
+			default: 							break;
+		}
+
+		p = (h >> 20) & 0xFFC;
+	}
+}
+
+/**
+ * Run a port caps or ld caps command from the CLI options
+ *
+ * @param fn 	Function to read sections of the switch state with. Used to 
+ * 				learn the ports if they are not known yet
+ * @return 		0 upon success. Non zero otherwise
+ */
+int caps_cmd(struct mctp *m, int (*fn)(struct mctp *m, unsigned mask))
+{
+	struct caps_walk *c;
+	unsigned *list, reads;
+	int rv, ppid, ldid, window, rounds, num, bad, cached, i;
+
+	rv = 1;
+	reads = 0;
+	bad = 0;
+
+	ppid 	= opts[CLOP_PPID].u8;
+	ldid 	= (opts[CLOP_CMD].val == CLCM_LD_CAPS) ? opts[CLOP_LDID].u16 : -1;
+	window 	= cmd_window_size();
+
+	c = calloc(1, sizeof(*c));
+	list = calloc(CPLN_DWORDS, sizeof(*list));
+	if (c == NULL || list == NULL)
+		goto end;
+
+	memset(c->data, 0xFF, PCLN_CFG);
+
+	// Discovery caches the config space header of every present port 
+	if (ldid < 0 && snapshot_generation(JKSN_PORTS) == 0)
+		fn(m, JKSN_BIT(JKSN_SWITCH) | JKSN_BIT(JKSN_PORTS) | JKSN_BIT(JKSN_CFGSPACE));
+
+	// Start from every DWord already read, such as by discovery or a dump
+	cached = cfgdump_cached(ppid, ldid, c->data, c->valid);
+
+	for ( rounds = 0 ; rounds < CPLN_ROUNDS ; rounds++ )
+	{
+		c->missing = 0;
+		memset(c->need, 0, sizeof(c->need));
+
+		walk_std(c);
+		walk_ext(c);
+
+		if (c->missing == 0)
+			break;
+
+		num = 0;
+		for ( i = 0 ; i < CPLN_DWORDS ; i++ )
+			if (c->need[i])
+				list[num++] = i;
+
+		i = cfgdump_fetch(m, ppid, ldid, c->data, c->valid, list, num, window);
+		if (i < 0)
+		{
+			printf("Error: Could not read config space\n");
+			goto end;
+		}
+		reads += num;
+		bad += i;
+
+		// DWords that could not be read are walked as 0xFFFFFFFF
+		for ( i = 0 ; i < num ; i++ )
+			c->valid[list[i]] = 1;
+	}
+
+	if (ldid < 0)
+		printf("Port %d capabilities:\n", ppid);
+	else
+		printf("Port %d LD %d capabilities:\n", ppid, ldid);
+
+	c->print = 1;
+	walk_std(c);
+	walk_ext(c);
+
+	printf("Config reads: %u in %d batches, %d failed, %d cached\n", reads, rounds, bad, cached);
+
+	rv = bad ? 1 : 0;
+
+end:
+
+	free(list);
+	free(c);
+
+	return rv;
+}
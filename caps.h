@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		caps.h
+ *
+ * @brief 		Header file for the PCIe capability and CXL DVSEC walker
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _CAPS_H
+#define _CAPS_H
+
+/* struct mctp
+ */
+#include <mctp.h>
+
+/* MACROS ====================================================================*/
+
+#define CPLN_ROUNDS 		16 		//!< Max batches of reads of one walk
+#define CPLN_SPAN 			0x40 	//!< Bytes read with each capability header
+#define CPVD_CXL 			0x1E98 	//!< Vendor ID of CXL DVSECs
+
+/* ENUMERATIONS ==============================================================*/
+
+/**
+ * CXL DVSEC IDs (DV)
+ */
+enum _CPDV
+{
+	CPDV_DEVICE 		= 0x0000,	//!< PCIe DVSEC for CXL Devices
+	CPDV_NON_CXL_FN 	= 0x0002,	//!< Non-CXL Function Map DVSEC
+	CPDV_PORT_EXT 		= 0x0003,	//!< CXL Extensions DVSEC for Ports
+	CPDV_GPF_PORT 		= 0x0004,	//!< GPF DVSEC for CXL Ports
+	CPDV_GPF_DEVICE 	= 0x0005,	//!< GPF DVSEC for CXL Devices
+	CPDV_FLEXBUS 		= 0x0007,	//!< PCIe DVSEC for Flex Bus Port
+	CPDV_REG_LOCATOR 	= 0x0008,	//!< Register Locator DVSEC
+	CPDV_MLD 			= 0x0009,	//!< MLD DVSEC
+	CPDV_TEST 			= 0x000A,	//!< PCIe DVSEC for Test Capability
+	CPDV_MAX
+};
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+int caps_cmd(struct mctp *m, int (*fn)(struct mctp *m, unsigned mask));
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_CAPS_H
@@ -0,0 +1,524 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		cfgdump.c
+ *
+ * @brief 		Code file for full config space dumps of ports and LDs
+ *
+ * The FM API reads config space one DWord per request. A dump sends the
+ * 1024 reads of the 4 KiB extended config space through one window so they
+ * are in flight at the same time. Responses update the cached config space
+ * in cxls like any other read and are collected into the dump
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* printf()
+ * fopen()
+ */
+#include <stdio.h>
+
+/* calloc()
+ * realloc()
+ * free()
+ */
+#include <stdlib.h>
+
+/* memcpy()
+ * memset()
+ * strerror()
+ */
+#include <string.h>
+
+#include <errno.h>
+
+/* pthread_mutex_t
+ */
+#include <pthread.h>
+
+/* clock_gettime()
+ */
+#include <time.h>
+
+/* PCLN_CFG
+ */
+#include <pciutils.h>
+
+#include <fmapi.h>
+#include <emapi.h>
+
+#include "cfgdump.h"
+#include "cmd_encoder.h"
+#include "fmapi_handler.h"
+#include "options.h"
+#include "snapshot.h"
+
+/* MACROS ====================================================================*/
+
+#define CDLN_DWORDS 		(PCLN_CFG / 4) 	//!< Reads of a full dump
+#define CDLN_LINE 			16 				//!< Bytes per line of a hex dump
+#define CDLN_LDS 			16 				//!< Entries of cxl_mld.cfgspace
+#define CDLN_SLOTS 			(CDLN_LDS + 1) 	//!< Config spaces per port: port + LDs
+#define CDLN_MAP 			(CDLN_DWORDS / 8) 	//!< Bytes of the valid map of a config space
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * Dump in progress. Shared with the completion functions
+ */
+struct cfgdump
+{
+	pthread_mutex_t mtx;
+	pthread_cond_t cond;
+	__u8 *data;
+	__u8 *valid;			//!< Set per DWord that was read. May be NULL
+	unsigned errors;		//!< Reads that returned an error 
+	unsigned pending;		//!< Reads whose completion function has not run
+};
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * Bit per DWord of each cached config space that holds a value read from 
+ * the switch. Array of map_ports * CDLN_SLOTS maps. Protected by cxls->mtx
+ */
+static __u8 *map;
+static unsigned map_ports;
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Return the valid map of a port / LD or NULL if it has none
+ *
+ * @param grow 	Enlarge the array if the port is not held yet
+ */
+static __u8 *map_slot(unsigned ppid, int ldid, int grow)
+{
+	__u8 *n;
+
+	if (ldid >= CDLN_LDS)
+		return NULL;
+
+	if (ppid >= map_ports)
+	{
+		if (!grow)
+			return NULL;
+
+		n = realloc(map, (size_t) (ppid + 1) * CDLN_SLOTS * CDLN_MAP);
+		if (n == NULL)
+			return NULL;
+		memset(&n[(size_t) map_ports * CDLN_SLOTS * CDLN_MAP], 0, (size_t) (ppid + 1 - map_ports) * CDLN_SLOTS * CDLN_MAP);
+		map = n;
+		map_ports = ppid + 1;
+	}
+
+	return &map[((size_t) ppid * CDLN_SLOTS + 1 + ldid) * CDLN_MAP];
+}
+
+/**
+ * Record whether a DWord of the cached config space holds a value read from
+ * the switch
+ *
+ * Caller must hold cxls->mtx
+ *
+ * @param ldid 	LD-ID, or -1 for the port
+ * @param reg 	Byte offset of the DWord
+ * @param valid 1 after a read of the full DWord, 0 after a write
+ */
+void cfgdump_mark(unsigned ppid, int ldid, unsigned reg, int valid)
+{
+	__u8 *m;
+
+	if (reg >= PCLN_CFG)
+		return;
+
+	m = map_slot(ppid, ldid, valid);
+	if (m == NULL)
+		return;
+
+	reg /= 4;
+	if (valid)
+		m[reg / 8] |= 1 << (reg % 8);
+	else
+		m[reg / 8] &= ~(1 << (reg % 8));
+}
+
+/**
+ * Forget the valid DWords of ports at or above a port number
+ *
+ * Used when ports are dropped or the cache is replaced. Caller must hold 
+ * cxls->mtx
+ */
+void cfgdump_reset(unsigned ports)
+{
+	if (ports < map_ports)
+		memset(&map[(size_t) ports * CDLN_SLOTS * CDLN_MAP], 0, (size_t) (map_ports - ports) * CDLN_SLOTS * CDLN_MAP);
+}
+
+/**
+ * Copy the DWords of the cached config space that were read from the switch
+ *
+ * @param ldid 		LD-ID, or -1 for the port
+ * @param data 		PCLN_CFG bytes to fill
+ * @param valid 	Set to 1 per DWord copied
+ * @return 			Number of DWords copied
+ */
+int cfgdump_cached(unsigned ppid, int ldid, __u8 *data, __u8 *valid)
+{
+	struct cxl_mld *mld;
+	__u8 *cfg, *m;
+	int num, i;
+
+	num = 0;
+
+	pthread_mutex_lock(&cxls->mtx);
+
+	if (ppid >= cxls->num_ports)
+		goto unlock;
+
+	cfg = NULL;
+	mld = cxls->ports[ppid].mld;
+	if (ldid < 0)
+		cfg = cxls->ports[ppid].cfgspace;
+	else if (mld != NULL && ldid < mld->num && ldid < CDLN_LDS)
+		cfg = mld->cfgspace[ldid];
+
+	m = map_slot(ppid, ldid, 0);
+	if (cfg == NULL || m == NULL)
+		goto unlock;
+
+	for ( i = 0 ; i < CDLN_DWORDS ; i++ )
+	{
+		if (!(m[i / 8] & (1 << (i % 8))))
+			continue;
+		memcpy(&data[i * 4], &cfg[i * 4], 4);
+		valid[i] = 1;
+		num++;
+	}
+
+unlock:
+
+	pthread_mutex_unlock(&cxls->mtx);
+
+	return num;
+}
+
+/**
+ * Free the valid maps
+ */
+void cfgdump_free()
+{
+	free(map);
+	map = NULL;
+	map_ports = 0;
+}
+
+/**
+ * Count a read as finished and wake up the submitting thread
+ *
+ * Last access to the dump by a completion function 
+ */
+static void cfg_finish(struct cfgdump *d)
+{
+	pthread_mutex_lock(&d->mtx);
+	d->pending--;
+	pthread_cond_broadcast(&d->cond);
+	pthread_mutex_unlock(&d->mtx);
+}
+
+/**
+ * fn_completed of a read. Called from an MCTP thread
+ */
+static void cfg_completed(struct mctp *m, struct mctp_action *ma)
+{
+	struct cfgdump *d = ma->user_data;
+	struct fmapi_msg req, rsp;
+	unsigned reg;
+	__u8 *data;
+
+	req.buf = (struct fmapi_buf*) ma->req->payload;
+	rsp.buf = (struct fmapi_buf*) ma->rsp->payload;
+
+	fmapi_deserialize(&req.hdr, req.buf->hdr, FMOB_HDR, NULL);
+	fmapi_deserialize(&req.obj, req.buf->payload, fmapi_fmob_req(req.hdr.opcode), NULL);
+	fmapi_deserialize(&rsp.hdr, rsp.buf->hdr, FMOB_HDR, NULL);
+
+	if (rsp.hdr.category != FMMT_RESP || rsp.hdr.return_code != FMRC_SUCCESS)
+	{
+		pthread_mutex_lock(&d->mtx);
+		d->errors++;
+		pthread_mutex_unlock(&d->mtx);
+		mctp_retire(m, ma);
+		cfg_finish(d);
+		return;
+	}
+
+	fmapi_deserialize(&rsp.obj, rsp.buf->payload, fmapi_fmob_rsp(rsp.hdr.opcode), &req.obj);
+
+	if (req.hdr.opcode == FMOP_PSC_CFG)
+	{
+		reg = (req.obj.psc_cfg_req.ext << 8) | req.obj.psc_cfg_req.reg;
+		data = rsp.obj.psc_cfg_rsp.data;
+	}
+	else 
+	{
+		reg = (req.obj.mpc_cfg_req.ext << 8) | req.obj.mpc_cfg_req.reg;
+		data = rsp.obj.mpc_cfg_rsp.data;
+	}
+
+	// Each read fills its own DWord
+	if (reg + 4 <= PCLN_CFG)
+	{
+		memcpy(&d->data[reg], data, 4);
+		if (d->valid != NULL)
+			d->valid[reg / 4] = 1;
+	}
+
+	// Update the cached config space 
+	fmapi_update(m, ma);
+
+	cfg_finish(d);
+}
+
+/**
+ * fn_failed of a read. Called from an MCTP thread
+ */
+static void cfg_failed(struct mctp *m, struct mctp_action *ma)
+{
+	struct cfgdump *d = ma->user_data;
+
+	mctp_retire(m, ma);
+
+	cfg_finish(d);
+}
+
+/**
+ * Read a list of DWords of the config space of a port or an LD
+ *
+ * The reads are in flight at the same time. DWords that could not be read
+ * are not changed in data
+ *
+ * @param ldid 		LD-ID, or -1 for the port
+ * @param data 		PCLN_CFG bytes to fill
+ * @param valid 	Set to 1 per DWord that was read. May be NULL
+ * @param list 		DWord indexes to read
+ * @param num 		Entries in list
+ * @param window 	Reads in flight
+ * @return 			Number of DWords that could not be read, or -1 upon error
+ */
+int cfgdump_fetch(struct mctp *m, int ppid, int ldid, __u8 *data, __u8 *valid, const unsigned *list, int num, int window)
+{
+	struct cmd_window w;
+	struct cfgdump d;
+	struct fmapi_msg msg;
+	struct cxl_mld *mld;
+	unsigned reg;
+	int rv, i;
+
+	rv = -1;
+
+	memset(&d, 0, sizeof(d));
+	d.data = data;
+	d.valid = valid;
+
+	// Make room in the cache so the responses can be stored
+	pthread_mutex_lock(&cxls->mtx);
+	if (ppid < cxls->num_ports)
+	{
+		if (ldid < 0 && cxls->ports[ppid].cfgspace == NULL)
+			cxls->ports[ppid].cfgspace = calloc(1, PCLN_CFG);
+
+		mld = cxls->ports[ppid].mld;
+		if (ldid >= 0 && mld != NULL && ldid < mld->num && mld->cfgspace[ldid] == NULL)
+			mld->cfgspace[ldid] = calloc(1, PCLN_CFG);
+	}
+	pthread_mutex_unlock(&cxls->mtx);
+
+	if (pthread_mutex_init(&d.mtx, NULL))
+		return -1;
+
+	if (pthread_cond_init(&d.cond, NULL))
+		goto mutex;
+
+	if (cmd_window_init(&w, window))
+		goto destroy;
+
+	for ( i = 0 ; i < num ; i++ )
+	{
+		reg = (list[i] % CDLN_DWORDS) * 4;
+
+		if (ldid < 0)
+			fmapi_fill_psc_cfg(&msg, ppid, reg & 0xFF, reg >> 8, 0xF, FMCT_READ, NULL);
+		else
+			fmapi_fill_mpc_cfg(&msg, ppid, ldid, reg & 0xFF, reg >> 8, 0xF, FMCT_READ, NULL);
+
+		pthread_mutex_lock(&d.mtx);
+		d.pending++;
+		pthread_mutex_unlock(&d.mtx);
+
+		if (submit_fmapi_async(m, &w, &msg, &d, cfg_completed, cfg_failed) == NULL)
+		{
+			pthread_mutex_lock(&d.mtx);
+			d.pending--;
+			pthread_mutex_unlock(&d.mtx);
+			break;
+		}
+	}
+
+	// Completion functions reference the window and d, so every one of 
+	// them must have run before either is freed, even past a timeout
+	pthread_mutex_lock(&d.mtx);
+	while (d.pending > 0)
+		pthread_cond_wait(&d.cond, &d.mtx);
+	pthread_mutex_unlock(&d.mtx);
+
+	if (i == num)
+		rv = w.failed + d.errors;
+
+	cmd_window_free(&w);
+
+destroy:
+
+	pthread_cond_destroy(&d.cond);
+
+mutex:
+
+	pthread_mutex_destroy(&d.mtx);
+
+	return rv;
+}
+
+/**
+ * Read the full config space of a port or an LD
+ *
+ * DWords that could not be read are left as 0xFF like reads of a missing
+ * function
+ *
+ * @param ldid 		LD-ID, or -1 for the port
+ * @param data 		Filled with PCLN_CFG bytes
+ * @param window 	Reads in flight
+ * @return 			Number of DWords that could not be read, or -1 upon error
+ */
+int cfgdump_read(struct mctp *m, int ppid, int ldid, __u8 *data, int window)
+{
+	unsigned list[CDLN_DWORDS];
+	int i;
+
+	memset(data, 0xFF, PCLN_CFG);
+
+	for ( i = 0 ; i < CDLN_DWORDS ; i++ )
+		list[i] = i;
+
+	return cfgdump_fetch(m, ppid, ldid, data, NULL, list, CDLN_DWORDS, window);
+}
+
+/**
+ * Print a config space in the format of lspci -xxxx, which lspci -F reads
+ *
+ * @param ldid 	LD-ID, or -1 for the port
+ */
+void cfgdump_print(FILE *fp, int ppid, int ldid, __u8 *data)
+{
+	int i, k;
+
+	// lspci needs a bus:device.function. The port is the bus and the LD the device
+	if (ldid < 0)
+		fprintf(fp, "%02x:00.0 CXL switch port %d\n", ppid, ppid);
+	else
+		fprintf(fp, "%02x:%02x.0 CXL port %d LD %d\n", ppid, ldid, ppid, ldid);
+
+	for ( i = 0 ; i < PCLN_CFG ; i += CDLN_LINE )
+	{
+		fprintf(fp, "%02x:", i);
+		for ( k = 0 ; k < CDLN_LINE ; k++ )
+			fprintf(fp, " %02x", data[i + k]);
+		fprintf(fp, "\n");
+	}
+	fprintf(fp, "\n");
+}
+
+/**
+ * Run a port config --dump or ld config --dump command from the CLI options
+ *
+ * @param fn 	Function to read sections of the switch state with. Used to 
+ * 				learn the ports and MLDs if they are not known yet
+ * @return 		0 upon success. Non zero otherwise
+ */
+int cfgdump_cmd(struct mctp *m, int (*fn)(struct mctp *m, unsigned mask))
+{
+	struct timespec start, stop;
+	__u8 *data;
+	FILE *fp, *info;
+	unsigned mask;
+	int rv, ppid, ldid, window, bad;
+
+	rv = 1;
+	fp = stdout;
+	info = stderr;
+
+	ppid 	= opts[CLOP_PPID].u8;
+	ldid 	= (opts[CLOP_CMD].val == CLCM_LD_CONFIG) ? opts[CLOP_LDID].u16 : -1;
+	window 	= cmd_window_size();
+
+	// The cache can only hold the dump once the port or MLD is known
+	mask = 0;
+	if (snapshot_generation(JKSN_PORTS) == 0)
+		mask |= JKSN_BIT(JKSN_SWITCH) | JKSN_BIT(JKSN_PORTS);
+	if (ldid >= 0 && snapshot_generation(JKSN_MLDS) == 0)
+		mask |= JKSN_BIT(JKSN_MLDS);
+	if (mask != 0 && fn(m, mask) != 0)
+		fprintf(stderr, "Warning: Could not read switch state. The dump is not cached\n");
+
+	data = malloc(PCLN_CFG);
+	if (data == NULL)
+		return 1;
+
+	if (opts[CLOP_OUTFILE].set)
+	{
+		fp = fopen(opts[CLOP_OUTFILE].str, "w");
+		if (fp == NULL)
+		{
+			printf("Error: Could not open %s: %s\n", opts[CLOP_OUTFILE].str, strerror(errno));
+			goto free;
+		}
+		info = stdout;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	bad = cfgdump_read(m, ppid, ldid, data, window);
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	if (bad < 0)
+	{
+		fprintf(info, "Error: Could not read config space\n");
+		goto close;
+	}
+
+	cfgdump_print(fp, ppid, ldid, data);
+
+	// Keep the summary out of a dump written to stdout
+	fprintf(info, "Config space: %d bytes in %d requests, %d failed, %d in flight, in %.3f ms\n",
+		PCLN_CFG, CDLN_DWORDS, bad, window,
+		((stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec)) / 1e6);
+
+	rv = bad ? 1 : 0;
+
+close:
+
+	if (fp != stdout && fclose(fp) != 0)
+		rv = 1;
+
+free:
+
+	free(data);
+
+	return rv;
+}
@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		cfgdump.h
+ *
+ * @brief 		Header file for full config space dumps of ports and LDs
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _CFGDUMP_H
+#define _CFGDUMP_H
+
+/* FILE
+ */
+#include <stdio.h>
+
+/* __u8
+ */
+#include <linux/types.h>
+
+/* struct mctp
+ */
+#include <mctp.h>
+
+/* MACROS ====================================================================*/
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+void cfgdump_mark(unsigned ppid, int ldid, unsigned reg, int valid);
+
+void cfgdump_reset(unsigned ports);
+
+int cfgdump_cached(unsigned ppid, int ldid, __u8 *data, __u8 *valid);
+
+void cfgdump_free();
+
+int cfgdump_fetch(struct mctp *m, int ppid, int ldid, __u8 *data, __u8 *valid, const unsigned *list, int num, int window);
+
+int cfgdump_read(struct mctp *m, int ppid, int ldid, __u8 *data, int window);
+
+void cfgdump_print(FILE *fp, int ppid, int ldid, __u8 *data);
+
+int cfgdump_cmd(struct mctp *m, int (*fn)(struct mctp *m, unsigned mask));
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_CFGDUMP_H
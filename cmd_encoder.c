@@ -28,6 +28,12 @@
 
 #include <stdlib.h>
 
+#include <errno.h>
+
+/* clock_gettime()
+ */
+#include <time.h>
+
 /* autl_prnt_buf()
  */
 #include <arrayutils.h>
@@ -37,6 +43,10 @@
 #include <fmapi.h>
 #include <emapi.h>
 
+/* pthread_mutex_t
+ */
+#include <pthread.h>
+
 /* mctp_init()
  * mctp_set_mh()
  * mctp_run()
@@ -66,20 +76,197 @@
  #define EXIT(rc)
 #endif
 
-#define JKLN_CMD_TIMEOUT_SEC	10
-#define JKLN_CMD_TIMEOUT_NSEC	0
-
 
 /* ENUMERATIONS ==============================================================*/
 
 /* STRUCTS ===================================================================*/
 
+/**
+ * Per request context of an asynchronous submission
+ *
+ * Stored in mctp_action.user_data while the request is in flight
+ */
+struct cmd_ctx
+{
+	struct cmd_window *w;
+	int space;		//!< Tag space [JKTG]
+	int tag;		//!< Tag assigned to the request
+	void *user_data;
+	void (*fn_completed)(struct mctp *m, struct mctp_action *a);
+	void (*fn_failed)(struct mctp *m, struct mctp_action *a);
+};
+
+/**
+ * Allocation state of one tag space
+ */
+struct cmd_tags
+{
+	pthread_mutex_t mtx;
+	pthread_cond_t 	cond;
+	unsigned 		num;						//!< Number of tags in this space
+	unsigned 		next;						//!< Next tag to try 
+	unsigned 		inflight;					//!< Number of tags allocated
+	__u64 			used[JKLN_TAGS / 64];		//!< Bitmap of allocated tags
+};
+
 /* PROTOTYPES ================================================================*/
 
 /* GLOBAL VARIABLES ==========================================================*/
 
+/**
+ * Tag allocation state indexed by [JKTG]
+ */
+static struct cmd_tags tags[JKTG_MAX] = 
+{
+	{PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, JKLN_TAGS_CTRL, 	0, 0, {0}},
+	{PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, JKLN_TAGS, 		0, 0, {0}},
+	{PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, JKLN_TAGS, 		0, 0, {0}},
+};
+
+/**
+ * Serializes claiming an asynchronous action in window_completed() and 
+ * window_failed(), which may both be called for the same action
+ */
+static pthread_mutex_t claim_mtx = PTHREAD_MUTEX_INITIALIZER;
+
 /* FUNCTIONS =================================================================*/
 
+/**
+ * Allocate a tag that is not used by any request in flight
+ *
+ * Tags are handed out round robin so that a late response to a timed out 
+ * request is unlikely to match a new request. Blocks while every tag in the
+ * space is in use
+ *
+ * @param space Tag space [JKTG]
+ * @return 		Allocated tag
+ */
+int cmd_tag_alloc(int space)
+{
+	struct cmd_tags *t = &tags[space];
+	unsigned tag;
+
+	pthread_mutex_lock(&t->mtx);
+	while (t->inflight >= t->num)
+		pthread_cond_wait(&t->cond, &t->mtx);
+
+	tag = t->next;
+	while (t->used[tag / 64] & (1ULL << (tag % 64)))
+		tag = (tag + 1) % t->num;
+
+	t->used[tag / 64] |= (1ULL << (tag % 64));
+	t->inflight++;
+	t->next = (tag + 1) % t->num;
+	pthread_mutex_unlock(&t->mtx);
+
+	return tag;
+}
+
+/**
+ * Return a tag to its space
+ */
+void cmd_tag_release(int space, int tag)
+{
+	struct cmd_tags *t = &tags[space];
+
+	pthread_mutex_lock(&t->mtx);
+	if (t->used[tag / 64] & (1ULL << (tag % 64)))
+	{
+		t->used[tag / 64] &= ~(1ULL << (tag % 64));
+		t->inflight--;
+		pthread_cond_signal(&t->cond);
+	}
+	pthread_mutex_unlock(&t->mtx);
+}
+
+/**
+ * Return the number of tags of a space currently in use
+ */
+int cmd_tag_inflight(int space)
+{
+	struct cmd_tags *t = &tags[space];
+	int rv;
+
+	pthread_mutex_lock(&t->mtx);
+	rv = t->inflight;
+	pthread_mutex_unlock(&t->mtx);
+
+	return rv;
+}
+
+/**
+ * Verify the response of an action carries the tag of its request
+ *
+ * libmctp matches responses to actions by the MCTP transport tag. This only
+ * cross checks the instance ID or FM / EM API tag of the message against
+ * the one the request was sent with
+ *
+ * @return 0 if the tags match, 1 otherwise
+ */
+static int tag_check(struct mctp_action *ma, int tag)
+{
+	INIT
+	struct fmapi_hdr fh;
+	struct emapi_hdr eh;
+	int rsp;
+
+	if (ma->rsp == NULL)
+		return 1;
+
+	switch (ma->rsp->type)
+	{
+		case MCMT_CONTROL:
+			rsp = ((struct mctp_ctrl_hdr*) ma->rsp->payload)->inst;
+			break;
+
+		case MCMT_CXLFMAPI:
+			fmapi_deserialize(&fh, ma->rsp->payload, FMOB_HDR, NULL);
+			rsp = fh.tag;
+			break;
+
+		case MCMT_CSE:
+			emapi_deserialize(&eh, ma->rsp->payload, EMOB_HDR, NULL);
+			rsp = eh.tag;
+			break;
+
+		default:
+			return 1;
+	}
+
+	if (rsp == tag)
+		return 0;
+
+	ERR32("Request tag", tag);
+	ERR32("Response tag", rsp);
+	return 1;
+}
+
+/**
+ * Finish a blocking submission: verify the response tag and free the tag 
+ *
+ * @return ma if the response belongs to the request, NULL otherwise
+ */
+static struct mctp_action *tag_finish(struct mctp *m, struct mctp_action *ma, int space, int tag)
+{
+	if (ma != NULL && tag_check(ma, tag))
+	{
+		mctp_retire(m, ma);
+		ma = NULL;
+		errno = EPROTO;
+	}
+
+	cmd_tag_release(space, tag);
+
+	return ma;
+}
+
+/**
+ * Submit an MCTP Control Message
+ *
+ * A blocking submission (fn_completed == NULL) allocates its own instance ID 
+ * for the duration of the call. An asynchronous submission uses the instance
+ * ID already in msg->hdr.inst, see submit_ctrl_async()
+ */
 struct mctp_action *submit_ctrl(
 	struct mctp *m,
 	struct mctp_ctrl_msg *msg,
@@ -90,20 +277,23 @@ struct mctp_action *submit_ctrl(
 	void (*fn_failed)(struct mctp *m, struct mctp_action *a)
 	)
 {
+	struct mctp_action *ma;
 	struct timespec delta;
+	int tag;
 
 	// Initialize variables
 	delta.tv_sec = JKLN_CMD_TIMEOUT_SEC;
 	delta.tv_nsec = JKLN_CMD_TIMEOUT_NSEC;
+	tag = (fn_completed == NULL) ? cmd_tag_alloc(JKTG_CTRL) : msg->hdr.inst;
 
 	// Set MCTP Control Header fields 
 	msg->hdr.req = 1;
 	msg->hdr.datagram = 0;
-	msg->hdr.inst = 0;
+	msg->hdr.inst = tag;
 	msg->len = mctp_len_ctrl((__u8*)&msg->hdr);
 
 	// Submit to MCTP library 
-	return mctp_submit(
+	ma = mctp_submit(
 		m,						// struct mctp*
 		MCMT_CONTROL,			// [MCMT] 
 		msg, 					// void* to mctp payload 
@@ -115,8 +305,18 @@ struct mctp_action *submit_ctrl(
  		fn_completed, 			// fn_completed 
 		fn_failed 				// fn_failed 	
 		);
+
+	if (fn_completed == NULL)
+		ma = tag_finish(m, ma, JKTG_CTRL, tag);
+
+	return ma;
 }
 
+/**
+ * Submit an EM API Message
+ *
+ * @see submit_ctrl()
+ */
 struct mctp_action *submit_emapi(
 	struct mctp *m,
 	struct emapi_msg *msg,
@@ -127,25 +327,27 @@ struct mctp_action *submit_emapi(
 	void (*fn_failed)(struct mctp *m, struct mctp_action *a)
 	)
 {
-	int len;
+	int len, tag;
+	struct mctp_action *ma;
 	struct emapi_buf buf;
 	struct timespec delta;
 
 	// Initialize variables
 	delta.tv_sec = JKLN_CMD_TIMEOUT_SEC;
 	delta.tv_nsec = JKLN_CMD_TIMEOUT_NSEC;
+	tag = (fn_completed == NULL) ? cmd_tag_alloc(JKTG_EMAPI) : msg->hdr.tag;
 
 	// Serialize payload 
 	len = emapi_serialize((__u8*)&buf.payload, &msg->obj, emapi_emob_req(msg->hdr.opcode), NULL);
 
 	// Set EM API message category as a request
-	emapi_fill_hdr(&msg->hdr, EMMT_REQ, 0, 0, msg->hdr.opcode, len, msg->hdr.a, msg->hdr.b);
+	emapi_fill_hdr(&msg->hdr, EMMT_REQ, tag, 0, msg->hdr.opcode, len, msg->hdr.a, msg->hdr.b);
 
 	// Serialize EM API Header into buffer
 	emapi_serialize((__u8*)&buf.hdr, &msg->hdr, EMOB_HDR, NULL);
 
 	// Submit to MCTP library 
-	return mctp_submit(
+	ma = mctp_submit(
 		m,						// struct mctp*
 		MCMT_CSE,				// [MCMT] 
 		&buf, 					// void* to mctp payload 
@@ -157,8 +359,18 @@ struct mctp_action *submit_emapi(
  		fn_completed, 			// fn_completed 
 		fn_failed 				// fn_failed 	
 		);
+
+	if (fn_completed == NULL)
+		ma = tag_finish(m, ma, JKTG_EMAPI, tag);
+
+	return ma;
 }
 
+/**
+ * Submit an FM API Message
+ *
+ * @see submit_ctrl()
+ */
 struct mctp_action *submit_fmapi(
 	struct mctp *m,
 	struct fmapi_msg *msg,
@@ -169,25 +381,27 @@ struct mctp_action *submit_fmapi(
 	void (*fn_failed)(struct mctp *m, struct mctp_action *a)
 	)
 {
-	int len;
+	int len, tag;
+	struct mctp_action *ma;
 	struct fmapi_buf buf;
 	struct timespec delta;
 
 	// Initialize variables
 	delta.tv_sec = JKLN_CMD_TIMEOUT_SEC;
 	delta.tv_nsec = JKLN_CMD_TIMEOUT_NSEC;
+	tag = (fn_completed == NULL) ? cmd_tag_alloc(JKTG_FMAPI) : msg->hdr.tag;
 
 	// Serialize Object
 	len = fmapi_serialize((__u8*)&buf.payload, &msg->obj, fmapi_fmob_req(msg->hdr.opcode));
 
 	// Fill Header 
-	fmapi_fill_hdr(&msg->hdr, FMMT_REQ, 0, msg->hdr.opcode, 0, len, 0, 0);
+	fmapi_fill_hdr(&msg->hdr, FMMT_REQ, tag, msg->hdr.opcode, 0, len, 0, 0);
 
 	// Serialize Header 
 	fmapi_serialize((__u8*)&buf.hdr, &msg->hdr, FMOB_HDR);
 
 	// Submit to MCTP library 
-	return mctp_submit(
+	ma = mctp_submit(
 		m,						// struct mctp*
 		MCMT_CXLFMAPI,			// [MCMT] 
 		&buf, 					// void* to mctp payload 
@@ -199,6 +413,375 @@ struct mctp_action *submit_fmapi(
  		fn_completed, 			// fn_completed 
 		fn_failed 				// fn_failed 	
 		);
+
+	if (fn_completed == NULL)
+		ma = tag_finish(m, ma, JKTG_FMAPI, tag);
+
+	return ma;
+}
+
+/**
+ * Return the max number of requests to keep in flight set with --window
+ */
+int cmd_window_size()
+{
+	if (opts[CLOP_WINDOW].set && opts[CLOP_WINDOW].u16 > 0)
+		return opts[CLOP_WINDOW].u16;
+	return JKLN_CMD_WINDOW;
+}
+
+/**
+ * Initialize an in-flight window
+ *
+ * @param w 	struct cmd_window* to initialize
+ * @param max 	Max number of requests in flight. Clamped to 1..JKLN_CMD_WINDOW_MAX
+ * @return 		0 upon success, non-zero otherwise
+ */
+int cmd_window_init(struct cmd_window *w, int max)
+{
+	memset(w, 0, sizeof(*w));
+
+	if (max < 1)
+		max = 1;
+	if (max > JKLN_CMD_WINDOW_MAX)
+		max = JKLN_CMD_WINDOW_MAX;
+	w->max = max;
+
+	if (pthread_mutex_init(&w->mtx, NULL))
+		return 1;
+	if (pthread_cond_init(&w->cond, NULL))
+	{
+		pthread_mutex_destroy(&w->mtx);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Change the max number of requests in flight of a window
+ *
+ * Requests already in flight are not affected. Clamped to 1 and to the
+ * smaller of JKLN_CMD_WINDOW_MAX and the tag space
+ */
+void cmd_window_resize(struct cmd_window *w, int max)
+{
+	if (max < 1)
+		max = 1;
+	if (max > JKLN_CMD_WINDOW_MAX)
+		max = JKLN_CMD_WINDOW_MAX;
+	if (max > JKLN_TAGS)
+		max = JKLN_TAGS;
+
+	pthread_mutex_lock(&w->mtx);
+	w->max = max;
+	pthread_cond_broadcast(&w->cond);
+	pthread_mutex_unlock(&w->mtx);
+}
+
+/**
+ * Wait for every request in a window to complete or fail
+ *
+ * Returns once the callbacks of every request have returned
+ *
+ * @param w 			struct cmd_window* to wait on
+ * @param timeout_sec 	Seconds to wait without any progress before giving up
+ * @return 				0 if the window drained, ETIMEDOUT otherwise
+ */
+int cmd_window_wait(struct cmd_window *w, int timeout_sec)
+{
+	struct timespec ts;
+	unsigned progress;
+	int rv;
+
+	rv = 0;
+
+	pthread_mutex_lock(&w->mtx);
+	while (w->inflight > 0)
+	{
+		progress = w->completed + w->failed;
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += timeout_sec;
+		rv = pthread_cond_timedwait(&w->cond, &w->mtx, &ts);
+
+		// Only give up when nothing has completed for the whole timeout 
+		if (rv == ETIMEDOUT && progress == w->completed + w->failed)
+			break;
+		rv = 0;
+	}
+	pthread_mutex_unlock(&w->mtx);
+
+	return rv;
+}
+
+/**
+ * Free resources of an in-flight window
+ *
+ * The window must be drained with cmd_window_wait() first, or the caller must
+ * know that every callback has run. Slots are released after their callback 
+ * returned, so this waits for the last releases
+ */
+void cmd_window_free(struct cmd_window *w)
+{
+	pthread_mutex_lock(&w->mtx);
+	while (w->inflight > 0)
+		pthread_cond_wait(&w->cond, &w->mtx);
+	pthread_mutex_unlock(&w->mtx);
+
+	pthread_cond_destroy(&w->cond);
+	pthread_mutex_destroy(&w->mtx);
+}
+
+/**
+ * Reserve a slot in the window, blocking while it is full
+ */
+static void window_acquire(struct cmd_window *w)
+{
+	pthread_mutex_lock(&w->mtx);
+	while (w->inflight >= w->max)
+		pthread_cond_wait(&w->cond, &w->mtx);
+	w->inflight++;
+	w->submitted++;
+	pthread_mutex_unlock(&w->mtx);
+}
+
+/**
+ * Release a slot in the window and the tag of the request
+ */
+static void window_release(struct cmd_window *w, int space, int tag, int failed)
+{
+	cmd_tag_release(space, tag);
+
+	pthread_mutex_lock(&w->mtx);
+	w->inflight--;
+	if (failed)
+		w->failed++;
+	else
+		w->completed++;
+	pthread_cond_broadcast(&w->cond);
+	pthread_mutex_unlock(&w->mtx);
+}
+
+/**
+ * Take ownership of the context of an asynchronous action
+ *
+ * The first of window_completed() and window_failed() to get here clears 
+ * both callbacks, so the other one returns without touching the context
+ *
+ * @param fn 	The callback that is calling
+ * @return 		struct cmd_ctx* of the action, or NULL if it was already claimed
+ */
+static struct cmd_ctx *window_claim(struct mctp_action *ma, void (*fn)(struct mctp *m, struct mctp_action *a))
+{
+	struct cmd_ctx *ctx;
+
+	ctx = NULL;
+
+	pthread_mutex_lock(&claim_mtx);
+	if (ma->fn_completed == fn || ma->fn_failed == fn)
+	{
+		ctx = ma->user_data;
+		ma->fn_completed = NULL;
+		ma->fn_failed = NULL;
+	}
+	pthread_mutex_unlock(&claim_mtx);
+
+	return ctx;
+}
+
+/**
+ * Hand an action back to the caller of the asynchronous submission
+ *
+ * Restores the caller's user_data and calls its callback. The window slot is
+ * released only after the callback returned, so cmd_window_wait() does not 
+ * return while a callback still uses the caller's state
+ */
+static void window_finish(struct mctp *m, struct mctp_action *ma, struct cmd_ctx *ctx, int failed)
+{
+	void (*fn)(struct mctp *m, struct mctp_action *a);
+	struct cmd_window *w;
+	int space, tag;
+
+	fn = failed ? ctx->fn_failed : ctx->fn_completed;
+	w = ctx->w;
+	space = ctx->space;
+	tag = ctx->tag;
+	ma->user_data = ctx->user_data;
+	free(ctx);
+
+	if (fn != NULL)
+		fn(m, ma);
+	else
+		mctp_retire(m, ma);
+
+	window_release(w, space, tag, failed);
+}
+
+/**
+ * fn_completed of an asynchronous request. Safe to call more than once
+ */
+static void window_completed(struct mctp *m, struct mctp_action *ma)
+{
+	struct cmd_ctx *ctx;
+
+	ctx = window_claim(ma, window_completed);
+	if (ctx == NULL)
+		return;
+
+	// A response carrying another request's tag is handled as a failure 
+	window_finish(m, ma, ctx, tag_check(ma, ctx->tag));
+}
+
+/**
+ * fn_failed of an asynchronous request. Safe to call more than once
+ */
+static void window_failed(struct mctp *m, struct mctp_action *ma)
+{
+	struct cmd_ctx *ctx;
+
+	ctx = window_claim(ma, window_failed);
+	if (ctx == NULL)
+		return;
+
+	window_finish(m, ma, ctx, 1);
+}
+
+/**
+ * Allocate the context for an asynchronous request and reserve a window slot
+ */
+static struct cmd_ctx *ctx_alloc(
+	struct cmd_window *w,
+	int space,
+	void *user_data,
+	void (*fn_completed)(struct mctp *m, struct mctp_action *a),
+	void (*fn_failed)(struct mctp *m, struct mctp_action *a)
+	)
+{
+	struct cmd_ctx *ctx;
+
+	ctx = calloc(1, sizeof(struct cmd_ctx));
+	if (ctx == NULL)
+		return NULL;
+
+	ctx->w = w;
+	ctx->space = space;
+	ctx->user_data = user_data;
+	ctx->fn_completed = fn_completed;
+	ctx->fn_failed = fn_failed;
+
+	window_acquire(w);
+	ctx->tag = cmd_tag_alloc(space);
+
+	return ctx;
+}
+
+/**
+ * Undo ctx_alloc() when the MCTP library rejected the submission
+ */
+static void ctx_abort(struct cmd_ctx *ctx)
+{
+	struct cmd_window *w = ctx->w;
+
+	cmd_tag_release(ctx->space, ctx->tag);
+
+	pthread_mutex_lock(&w->mtx);
+	w->inflight--;
+	w->submitted--;
+	pthread_cond_broadcast(&w->cond);
+	pthread_mutex_unlock(&w->mtx);
+
+	free(ctx);
+}
+
+/**
+ * Submit an MCTP Control Message without waiting for the response
+ *
+ * Blocks while the window is full. fn_completed is called from an MCTP thread
+ * with the response in ma->rsp and owns the mctp_action. If fn_completed or 
+ * fn_failed is NULL the mctp_action is retired
+ *
+ * @return struct mctp_action* upon success, NULL if submission failed
+ */
+struct mctp_action *submit_ctrl_async(
+	struct mctp *m,
+	struct cmd_window *w,
+	struct mctp_ctrl_msg *msg,
+	void *user_data,
+	void (*fn_completed)(struct mctp *m, struct mctp_action *a),
+	void (*fn_failed)(struct mctp *m, struct mctp_action *a)
+	)
+{
+	struct mctp_action *ma;
+	struct cmd_ctx *ctx;
+
+	ctx = ctx_alloc(w, JKTG_CTRL, user_data, fn_completed, fn_failed);
+	if (ctx == NULL)
+		return NULL;
+
+	msg->hdr.inst = ctx->tag;
+	ma = submit_ctrl(m, msg, 0, ctx, NULL, window_completed, window_failed);
+	if (ma == NULL)
+		ctx_abort(ctx);
+
+	return ma;
+}
+
+/**
+ * Submit an EM API Message without waiting for the response
+ *
+ * @see submit_ctrl_async()
+ */
+struct mctp_action *submit_emapi_async(
+	struct mctp *m,
+	struct cmd_window *w,
+	struct emapi_msg *msg,
+	void *user_data,
+	void (*fn_completed)(struct mctp *m, struct mctp_action *a),
+	void (*fn_failed)(struct mctp *m, struct mctp_action *a)
+	)
+{
+	struct mctp_action *ma;
+	struct cmd_ctx *ctx;
+
+	ctx = ctx_alloc(w, JKTG_EMAPI, user_data, fn_completed, fn_failed);
+	if (ctx == NULL)
+		return NULL;
+
+	msg->hdr.tag = ctx->tag;
+	ma = submit_emapi(m, msg, 0, ctx, NULL, window_completed, window_failed);
+	if (ma == NULL)
+		ctx_abort(ctx);
+
+	return ma;
+}
+
+/**
+ * Submit an FM API Message without waiting for the response
+ *
+ * @see submit_ctrl_async()
+ */
+struct mctp_action *submit_fmapi_async(
+	struct mctp *m,
+	struct cmd_window *w,
+	struct fmapi_msg *msg,
+	void *user_data,
+	void (*fn_completed)(struct mctp *m, struct mctp_action *a),
+	void (*fn_failed)(struct mctp *m, struct mctp_action *a)
+	)
+{
+	struct mctp_action *ma;
+	struct cmd_ctx *ctx;
+
+	ctx = ctx_alloc(w, JKTG_FMAPI, user_data, fn_completed, fn_failed);
+	if (ctx == NULL)
+		return NULL;
+
+	msg->hdr.tag = ctx->tag;
+	ma = submit_fmapi(m, msg, 0, ctx, NULL, window_completed, window_failed);
+	if (ma == NULL)
+		ctx_abort(ctx);
+
+	return ma;
 }
 
 /**
@@ -16,6 +16,11 @@
 #ifndef _CMD_ENCODER_H
 #define _CMD_ENCODER_H
 
+/* pthread_mutex_t
+ * pthread_cond_t
+ */
+#include <pthread.h>
+
 /* mctp_state
  * mctp_msg
  */
@@ -23,10 +28,51 @@
 
 /* MACROS ====================================================================*/
 
+#define JKLN_CMD_TIMEOUT_SEC	10
+#define JKLN_CMD_TIMEOUT_NSEC	0
+
+#define JKLN_CMD_WINDOW 		8 		//!< Default number of requests in flight
+#define JKLN_CMD_WINDOW_MAX 	256 	//!< Max number of requests in flight
+
+#define JKLN_TAGS 				256 	//!< Number of FM API / EM API message tags
+#define JKLN_TAGS_CTRL 			32 		//!< Number of MCTP Control instance IDs
+
 /* ENUMERATIONS ==============================================================*/
 
+/**
+ * Request tag spaces (TG)
+ *
+ * Each message type has its own tag / instance ID field and is allocated 
+ * independently
+ */
+enum _JKTG
+{
+	JKTG_CTRL 		= 0,	//!< MCTP Control Instance ID (5 bits)
+	JKTG_FMAPI 		= 1,	//!< FM API Message Tag (8 bits)
+	JKTG_EMAPI 		= 2,	//!< EM API Message Tag (8 bits)
+	JKTG_MAX
+};
+
 /* STRUCTS ===================================================================*/
 
+/**
+ * In-flight window for asynchronous request submission
+ *
+ * Submitting to a full window blocks the caller until a request completes.
+ * Completion callbacks run on an MCTP thread and must not submit to the same
+ * window, as that thread is needed to drain it
+ */
+struct cmd_window
+{
+	pthread_mutex_t mtx;
+	pthread_cond_t 	cond;
+	int 			max;		//!< Max number of requests in flight
+	int 			inflight;	//!< Number of requests in flight
+	unsigned 		submitted;	//!< Total number of requests submitted
+	unsigned 		completed;	//!< Total number of requests that received a response
+	unsigned 		failed;		//!< Total number of requests that failed
+};
+
 /* PROTOTYPES ================================================================*/
 
 struct mctp_action *submit_ctrl(
@@ -59,6 +105,49 @@ struct mctp_action *submit_fmapi(
 	void (*fn_failed)(struct mctp *m, struct mctp_action *a)
 	);
 
+int cmd_tag_alloc(int space);
+
+void cmd_tag_release(int space, int tag);
+
+int cmd_tag_inflight(int space);
+
+int cmd_window_size();
+
+int cmd_window_init(struct cmd_window *w, int max);
+
+void cmd_window_resize(struct cmd_window *w, int max);
+
+int cmd_window_wait(struct cmd_window *w, int timeout_sec);
+
+void cmd_window_free(struct cmd_window *w);
+
+struct mctp_action *submit_ctrl_async(
+	struct mctp *m,
+	struct cmd_window *w,
+	struct mctp_ctrl_msg *msg,
+	void *user_data,
+	void (*fn_completed)(struct mctp *m, struct mctp_action *a),
+	void (*fn_failed)(struct mctp *m, struct mctp_action *a)
+	);
+
+struct mctp_action *submit_emapi_async(
+	struct mctp *m,
+	struct cmd_window *w,
+	struct emapi_msg *msg,
+	void *user_data,
+	void (*fn_completed)(struct mctp *m, struct mctp_action *a),
+	void (*fn_failed)(struct mctp *m, struct mctp_action *a)
+	);
+
+struct mctp_action *submit_fmapi_async(
+	struct mctp *m,
+	struct cmd_window *w,
+	struct fmapi_msg *msg,
+	void *user_data,
+	void (*fn_completed)(struct mctp *m, struct mctp_action *a),
+	void (*fn_failed)(struct mctp *m, struct mctp_action *a)
+	);
+
 struct mctp_action *submit_cli_request(struct mctp *m, void *user_data);
 
 /* GLOBAL VARIABLES ==========================================================*/
@@ -9,17 +9,22 @@ _jack_completions()
 
 	if [ $COMP_CWORD -eq 1 ] ; then 
 
-		COMPREPLY=($(compgen -W "aer ld mctp port set show" -- $cur))
+		COMPREPLY=($(compgen -W "aer batch daemon events ld mctp port regs set show watch" -- $cur))
 
 	elif [ $COMP_CWORD -eq 2 ] ; then 
 
 		case $prev in 
 			aer) 	;;
-			ld) 	COMPREPLY=($(compgen -W "config mem" -- $cur)) ;;
+			batch) 	COMPREPLY=($(compgen -f -- $cur)) ;;
+			daemon) ;;
+			events) COMPREPLY=($(compgen -W "--follow --count" -- $cur)) ;;
+			ld) 	COMPREPLY=($(compgen -W "caps config dump mem snapshot test" -- $cur)) ;;
 		 	mctp) 	;;
-		 	port) 	COMPREPLY=($(compgen -W "bind config connect control disconnect unbind" -- $cur)) ;;
+		 	port) 	COMPREPLY=($(compgen -W "bind caps config connect control disconnect unbind" -- $cur)) ;;
+		 	regs) 	COMPREPLY=($(compgen -W "run" -- $cur)) ;;
 		 	set) 	COMPREPLY=($(compgen -W "ld limit qos" -- $cur)) ;;
-		 	show) 	COMPREPLY=($(compgen -W "bos identity ld limit port qos switch vcs" -- $cur)) ;;
+		 	show) 	COMPREPLY=($(compgen -W "binding bos identity ld limit port qos switch vcs" -- $cur)) ;;
+		 	watch) 	COMPREPLY=($(compgen -W "port qos vcs" -- $cur)) ;;
 			*)		;;
 		esac
 
@@ -39,6 +44,8 @@ _jack_completions()
 				qos) 	COMPREPLY=($(compgen -W "allocated control limit status" -- $cur)) ;;	
 				*)		;;
 			esac
+		elif [ $pprev = "regs" ] ; then 
+			COMPREPLY=($(compgen -f -- $cur))
 		fi
 	fi
 }
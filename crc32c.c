@@ -0,0 +1,227 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		crc32c.c
+ *
+ * @brief 		Code file for the CRC32C (Castagnoli) checksum
+ *
+ * Uses the CRC32 instruction of SSE4.2 on x86-64 when the CPU has it, or of
+ * the ARMv8 CRC extension when the build targets it. Otherwise falls back to
+ * a slice-by-8 table. All implementations produce the same value, so digests
+ * can be compared between hosts
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* memcpy()
+ */
+#include <string.h>
+
+/* le32toh()
+ */
+#include <endian.h>
+
+/* pthread_once()
+ */
+#include <pthread.h>
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+ #include <arm_acle.h>
+#endif
+
+#include "crc32c.h"
+
+/* MACROS ====================================================================*/
+
+#define CRPL_POLY 			0x82F63B78 	//!< Reflected Castagnoli polynomial
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * Slice-by-8 tables of the software implementation
+ */
+static __u32 crc_table[8][256];
+
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Implementation picked on first use 
+ */
+static __u32 (*crc_fn)(__u32 crc, const __u8 *p, size_t len);
+
+static const char *crc_name;
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Software CRC32C, 8 bytes per step
+ */
+static __u32 crc_sw(__u32 crc, const __u8 *p, size_t len)
+{
+	__u32 lo, hi;
+
+	while (len > 0 && ((unsigned long) p & 7))
+	{
+		crc = crc_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+		len--;
+	}
+
+	while (len >= 8)
+	{
+		memcpy(&lo, p, 4);
+		memcpy(&hi, p + 4, 4);
+		lo = le32toh(lo) ^ crc;
+		hi = le32toh(hi);
+		crc = crc_table[7][lo & 0xFF] ^ crc_table[6][(lo >> 8) & 0xFF] ^ 
+		      crc_table[5][(lo >> 16) & 0xFF] ^ crc_table[4][lo >> 24] ^
+		      crc_table[3][hi & 0xFF] ^ crc_table[2][(hi >> 8) & 0xFF] ^ 
+		      crc_table[1][(hi >> 16) & 0xFF] ^ crc_table[0][hi >> 24];
+		p += 8;
+		len -= 8;
+	}
+
+	while (len-- > 0)
+		crc = crc_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+#if defined(__x86_64__)
+/**
+ * CRC32C with the SSE4.2 CRC32 instruction
+ */
+__attribute__((target("sse4.2")))
+static __u32 crc_hw(__u32 crc, const __u8 *p, size_t len)
+{
+	unsigned long long c, v;
+
+	c = crc;
+
+	while (len > 0 && ((unsigned long) p & 7))
+	{
+		c = __builtin_ia32_crc32qi(c, *p++);
+		len--;
+	}
+
+	while (len >= 8)
+	{
+		memcpy(&v, p, 8);
+		c = __builtin_ia32_crc32di(c, v);
+		p += 8;
+		len -= 8;
+	}
+
+	while (len-- > 0)
+		c = __builtin_ia32_crc32qi(c, *p++);
+
+	return c;
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+/**
+ * CRC32C with the ARMv8 CRC32C instructions
+ */
+static __u32 crc_hw(__u32 crc, const __u8 *p, size_t len)
+{
+	__u64 v;
+
+	while (len > 0 && ((unsigned long) p & 7))
+	{
+		crc = __crc32cb(crc, *p++);
+		len--;
+	}
+
+	while (len >= 8)
+	{
+		memcpy(&v, p, 8);
+		crc = __crc32cd(crc, v);
+		p += 8;
+		len -= 8;
+	}
+
+	while (len-- > 0)
+		crc = __crc32cb(crc, *p++);
+
+	return crc;
+}
+#endif
+
+/**
+ * Pick the implementation and build the tables of the software one
+ */
+static void crc_init()
+{
+	__u32 c;
+	int i, j;
+
+	for ( i = 0 ; i < 256 ; i++ )
+	{
+		c = i;
+		for ( j = 0 ; j < 8 ; j++ )
+			c = (c >> 1) ^ ((c & 1) ? CRPL_POLY : 0);
+		crc_table[0][i] = c;
+	}
+
+	for ( i = 0 ; i < 256 ; i++ )
+		for ( j = 1 ; j < 8 ; j++ )
+			crc_table[j][i] = (crc_table[j-1][i] >> 8) ^ crc_table[0][crc_table[j-1][i] & 0xFF];
+
+	crc_fn = crc_sw;
+	crc_name = "software";
+
+#if defined(__x86_64__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.2"))
+	{
+		crc_fn = crc_hw;
+		crc_name = "sse4.2";
+	}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+	crc_fn = crc_hw;
+	crc_name = "armv8-crc";
+#endif
+}
+
+/**
+ * Update a CRC32C with more data
+ *
+ * @param crc 	Value returned by the previous call, or 0 to start
+ * @return 		CRC32C of all the data so far
+ */
+__u32 crc32c(__u32 crc, const void *buf, size_t len)
+{
+	pthread_once(&crc_once, crc_init);
+
+	return ~crc_fn(~crc, buf, len);
+}
+
+/**
+ * Update a CRC32C with the software implementation regardless of the CPU
+ *
+ * Used to cross check the hardware implementation
+ */
+__u32 crc32c_sw(__u32 crc, const void *buf, size_t len)
+{
+	pthread_once(&crc_once, crc_init);
+
+	return ~crc_sw(~crc, buf, len);
+}
+
+/**
+ * Return the name of the implementation in use
+ */
+const char *crc32c_impl()
+{
+	pthread_once(&crc_once, crc_init);
+
+	return crc_name;
+}
@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		crc32c.h
+ *
+ * @brief 		Header file for the CRC32C (Castagnoli) checksum
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _CRC32C_H
+#define _CRC32C_H
+
+/* size_t
+ */
+#include <stddef.h>
+
+/* __u32
+ */
+#include <linux/types.h>
+
+/* MACROS ====================================================================*/
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+__u32 crc32c(__u32 crc, const void *buf, size_t len);
+__u32 crc32c_sw(__u32 crc, const void *buf, size_t len);
+
+const char *crc32c_impl();
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_CRC32C_H
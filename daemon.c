@@ -0,0 +1,621 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		daemon.c
+ *
+ * @brief 		Code file for the jack daemon and its local socket client
+ *
+ * The daemon holds one MCTP connection and one cached copy of the remote
+ * switch state. Each jack invocation forwards its argv over a Unix socket
+ * and the daemon executes the command on the existing session, returning the
+ * text the command printed along with its return value.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* gettid()
+ */
+#define _GNU_SOURCE
+
+/* printf()
+ * tmpfile()
+ * fwrite()
+ */
+#include <stdio.h>
+
+/* malloc()
+ * free()
+ */
+#include <stdlib.h>
+
+/* memset()
+ * strnlen()
+ */
+#include <string.h>
+
+/* read()
+ * write()
+ * ftruncate()
+ * dup()
+ * dup2()
+ * getcwd()
+ * chdir()
+ */
+#include <unistd.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+
+/* inet_ntop()
+ */
+#include <arpa/inet.h>
+
+/* socket()
+ * setsockopt()
+ * sockaddr_un
+ */
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+/* struct timeval
+ */
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "daemon.h"
+#include "options.h"
+
+/* MACROS ====================================================================*/
+
+#ifdef JACK_VERBOSE
+ #define INIT 			unsigned step = 0;
+ #define ENTER 					if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_THREADS) 	printf("%d:%s Enter\n", 				gettid(), __FUNCTION__);
+ #define STEP 			step++; if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_STEPS) 		printf("%d:%s STEP: %u\n", 				gettid(), __FUNCTION__, step);
+ #define EXIT(rc) 				if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_THREADS)	printf("%d:%s Exit: %d\n", 				gettid(), __FUNCTION__,rc);
+#else
+ #define INIT
+ #define ENTER
+ #define STEP
+ #define EXIT(rc)
+#endif
+
+#define JKLN_DAEMON_IO_BUF 		4096
+#define JKLN_DAEMON_POLL_MS 	1000
+#define JKLN_DAEMON_IO_SEC 		5 				//!< Max time a client may stall a read or write
+#define JKLN_DAEMON_OUT_MAX 	0xFFFFFFFFULL 	//!< Max output of a command, the response header lengths are 32 bit
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * Set by the signal handler to request the daemon to stop
+ */
+static volatile sig_atomic_t daemon_stop;
+
+/* FUNCTIONS =================================================================*/
+
+static void daemon_signal(int sig)
+{
+	daemon_stop = sig;
+}
+
+/**
+ * Read exactly len bytes from a file descriptor
+ *
+ * @return 0 upon success, -1 on error or early end of file
+ */
+static int read_full(int fd, void *buf, size_t len)
+{
+	__u8 *p = buf;
+	ssize_t n;
+
+	while (len > 0)
+	{
+		n = read(fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/**
+ * Write exactly len bytes to a file descriptor
+ *
+ * @return 0 upon success, -1 on error
+ */
+static int write_full(int fd, const void *buf, size_t len)
+{
+	const __u8 *p = buf;
+	ssize_t n;
+
+	while (len > 0)
+	{
+		n = write(fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/**
+ * Copy len bytes from a file descriptor to a stream
+ *
+ * @return 0 upon success, -1 on error or early end of file
+ */
+static int copy_in(int fd, size_t len, FILE *fp)
+{
+	char buf[JKLN_DAEMON_IO_BUF];
+	size_t n;
+
+	while (len > 0)
+	{
+		n = len < sizeof(buf) ? len : sizeof(buf);
+		if (read_full(fd, buf, n))
+			return -1;
+		fwrite(buf, 1, n, fp);
+		len -= n;
+	}
+	fflush(fp);
+
+	return 0;
+}
+
+/**
+ * Copy the whole content of a temporary file to a file descriptor
+ *
+ * @return 0 upon success, -1 on error
+ */
+static int copy_out(int fd, FILE *tmp)
+{
+	char buf[JKLN_DAEMON_IO_BUF];
+	ssize_t n;
+
+	lseek(fileno(tmp), 0, SEEK_SET);
+	while ( (n = read(fileno(tmp), buf, sizeof(buf))) > 0 )
+		if (write_full(fd, buf, n))
+			return -1;
+
+	return n < 0 ? -1 : 0;
+}
+
+/**
+ * Return the length of a temporary file
+ */
+static off_t file_len(FILE *tmp)
+{
+	off_t len;
+
+	len = lseek(fileno(tmp), 0, SEEK_END);
+
+	return len < 0 ? 0 : len;
+}
+
+/**
+ * Fill a sockaddr_un with the path of the daemon socket
+ *
+ * @return 0 upon success, -1 if the path is too long
+ */
+static int fill_addr(struct sockaddr_un *sa, const char *path)
+{
+	memset(sa, 0, sizeof(*sa));
+	sa->sun_family = AF_UNIX;
+	if (strnlen(path, sizeof(sa->sun_path)) >= sizeof(sa->sun_path))
+		return -1;
+	strcpy(sa->sun_path, path);
+	return 0;
+}
+
+/**
+ * Build the default daemon socket path for an endpoint
+ *
+ * One daemon serves one endpoint, so the path is keyed by address and port
+ *
+ * @param buf 		Buffer to store the path in
+ * @param len 		Length of the buffer
+ * @param address 	IPv4 address of the endpoint in network byte order
+ * @param port 		TCP port of the endpoint
+ * @return 			buf
+ */
+char *daemon_path(char *buf, size_t len, __u32 address, __u16 port)
+{
+	char addr[INET_ADDRSTRLEN];
+
+	if (inet_ntop(AF_INET, &address, addr, sizeof(addr)) == NULL)
+		strcpy(addr, "0.0.0.0");
+
+	snprintf(buf, len, "/tmp/jack-%s-%u.sock", addr, port);
+
+	return buf;
+}
+
+/**
+ * Forward a command to a running daemon and print its output
+ *
+ * @param path 	Filename of the daemon Unix socket
+ * @param argc 	Number of CLI parameters
+ * @param argv 	Array of string pointers to CLI parameters
+ * @param rv 	Return value of the command as executed by the daemon
+ * @return 		0 if the daemon handled the command, -1 if no daemon could be
+ * 				reached and the caller should execute the command directly
+ *
+ * STEPS
+ * 1: Connect to daemon socket
+ * 2: Serialize current directory and argv
+ * 3: Send request
+ * 4: Receive response header
+ * 5: Copy command output to stdout and stderr
+ */
+int daemon_client(const char *path, int argc, char **argv, int *rv)
+{
+	struct sockaddr_un sa;
+	struct daemon_hdr hdr;
+	char cwd[4096];
+	char *payload;
+	size_t len, n;
+	int fd, i, ret;
+
+	ret = -1;
+	payload = NULL;
+
+	// STEP 1: Connect to daemon socket
+	if (fill_addr(&sa, path) != 0)
+		goto end;
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		goto end;
+
+	if (connect(fd, (struct sockaddr*) &sa, sizeof(sa)) != 0)
+		goto close;
+
+	// Once connected the daemon owns the command. Errors past this point
+	// are reported instead of falling back to a second execution
+	ret = 0;
+	*rv = 1;
+
+	// STEP 2: Serialize current directory and argv
+	if (getcwd(cwd, sizeof(cwd)) == NULL)
+		strcpy(cwd, "/");
+
+	len = strlen(cwd) + 1;
+	for ( i = 0 ; i < argc ; i++ )
+		len += strlen(argv[i]) + 1;
+
+	if (len > JKLN_DAEMON_MAX_LEN)
+	{
+		printf("Error: Command too long for jack daemon\n");
+		goto close;
+	}
+
+	payload = malloc(len);
+	if (payload == NULL)
+		goto close;
+
+	n = 0;
+	n += sprintf(&payload[n], "%s", cwd) + 1;
+	for ( i = 0 ; i < argc ; i++ )
+		n += sprintf(&payload[n], "%s", argv[i]) + 1;
+
+	// STEP 3: Send request
+	hdr.magic = JKLN_DAEMON_MAGIC;
+	hdr.val = 0;
+	hdr.num = argc;
+	hdr.len = len;
+	if (write_full(fd, &hdr, sizeof(hdr)) || write_full(fd, payload, len))
+	{
+		printf("Error: Could not send command to jack daemon\n");
+		goto close;
+	}
+
+	// STEP 4: Receive response header
+	if (read_full(fd, &hdr, sizeof(hdr)) || hdr.magic != JKLN_DAEMON_MAGIC)
+	{
+		printf("Error: Invalid response from jack daemon\n");
+		goto close;
+	}
+
+	// STEP 5: Copy command output to stdout and stderr
+	if (copy_in(fd, hdr.len, stdout) || copy_in(fd, hdr.num, stderr))
+	{
+		fprintf(stderr, "Error: Truncated response from jack daemon\n");
+		goto close;
+	}
+
+	*rv = hdr.val;
+
+close:
+
+	close(fd);
+
+end:
+
+	free(payload);
+
+	return ret;
+}
+
+/**
+ * Execute one request received on an accepted connection
+ *
+ * Output the command writes to stdout and stderr is captured in two 
+ * temporary files and returned to the client after the command completes
+ *
+ * @return 0 upon success, non zero otherwise
+ *
+ * STEPS
+ * 1: Receive request header
+ * 2: Receive payload
+ * 3: Split payload into cwd and argv
+ * 4: Redirect stdout & stderr to temporary files
+ * 5: Execute command
+ * 6: Restore stdout & stderr
+ * 7: Send response
+ */
+static int serve_one(struct mctp *m, int fd, int (*fn)(struct mctp *m, int argc, char **argv))
+{
+	INIT
+	struct daemon_hdr hdr;
+	char *payload, **argv, *p, *cwd;
+	FILE *tmp, *tmp_err;
+	int rv, i, out, err, home;
+
+	ENTER
+
+	rv = 1;
+	payload = NULL;
+	argv = NULL;
+	tmp = NULL;
+	tmp_err = NULL;
+
+	STEP // 1: Receive request header
+	if (read_full(fd, &hdr, sizeof(hdr)) || hdr.magic != JKLN_DAEMON_MAGIC)
+		goto end;
+	if (hdr.len == 0 || hdr.len > JKLN_DAEMON_MAX_LEN || hdr.num == 0 || hdr.num > hdr.len)
+		goto end;
+
+	STEP // 2: Receive payload
+	payload = malloc(hdr.len + 1);
+	argv = calloc(hdr.num + 1, sizeof(char*));
+	if (payload == NULL || argv == NULL)
+		goto end;
+	if (read_full(fd, payload, hdr.len))
+		goto end;
+	payload[hdr.len] = 0;
+
+	STEP // 3: Split payload into cwd and argv
+	p = payload;
+	cwd = p;
+	p += strlen(p) + 1;
+	for ( i = 0 ; i < (int) hdr.num ; i++ )
+	{
+		if (p >= payload + hdr.len)
+			goto end;
+		argv[i] = p;
+		p += strlen(p) + 1;
+	}
+
+	STEP // 4: Redirect stdout & stderr to temporary files
+	tmp = tmpfile();
+	tmp_err = tmpfile();
+	if (tmp == NULL || tmp_err == NULL)
+		goto end;
+
+	home = open(".", O_RDONLY | O_CLOEXEC);
+	if (chdir(cwd) != 0)
+		printf("Warning: jack daemon could not change to directory %s\n", cwd);
+
+	fflush(stdout);
+	fflush(stderr);
+	out = dup(STDOUT_FILENO);
+	err = dup(STDERR_FILENO);
+	dup2(fileno(tmp), STDOUT_FILENO);
+	dup2(fileno(tmp_err), STDERR_FILENO);
+
+	STEP // 5: Execute command
+	hdr.val = fn(m, hdr.num, argv);
+
+	STEP // 6: Restore stdout & stderr
+	fflush(stdout);
+	fflush(stderr);
+	dup2(out, STDOUT_FILENO);
+	dup2(err, STDERR_FILENO);
+	close(out);
+	close(err);
+
+	if (home >= 0)
+	{
+		if (fchdir(home) != 0)
+			printf("Warning: jack daemon could not restore working directory\n");
+		close(home);
+	}
+
+	STEP // 7: Send response
+
+	// Output that does not fit the response header is dropped, not truncated
+	if ((unsigned long long) file_len(tmp) > JKLN_DAEMON_OUT_MAX)
+	{
+		file_len(tmp_err);
+		dprintf(fileno(tmp_err), "Error: Output is too large to forward, run the command without jack daemon\n");
+		if (ftruncate(fileno(tmp), 0) != 0)
+			goto end;
+		hdr.val = 1;
+	}
+
+	hdr.magic = JKLN_DAEMON_MAGIC;
+	hdr.num = file_len(tmp_err);
+	hdr.len = file_len(tmp);
+	if (write_full(fd, &hdr, sizeof(hdr)))
+		goto end;
+
+	if (copy_out(fd, tmp) || copy_out(fd, tmp_err))
+		goto end;
+
+	rv = 0;
+
+end:
+
+	if (tmp != NULL)
+		fclose(tmp);
+	if (tmp_err != NULL)
+		fclose(tmp_err);
+	free(argv);
+	free(payload);
+
+	EXIT(rv)
+
+	return rv;
+}
+
+/**
+ * Listen on a Unix socket and execute forwarded commands until signaled
+ *
+ * Requests are executed one at a time on the calling thread so that a single
+ * MCTP session and switch cache is shared by every client. A client that
+ * sends or reads nothing for JKLN_DAEMON_IO_SEC seconds is dropped
+ *
+ * @param m 	struct mctp* that is already connected to the endpoint
+ * @param path 	Filename of the Unix socket to create
+ * @param fn 	Function to execute one command line
+ * @return 		0 upon success, non zero otherwise
+ *
+ * STEPS
+ * 1: Install signal handlers
+ * 2: Refuse to start if another daemon owns the socket
+ * 3: Create socket
+ * 4: Accept and serve requests
+ * 5: Remove socket
+ */
+int daemon_serve(struct mctp *m, const char *path, int (*fn)(struct mctp *m, int argc, char **argv))
+{
+	INIT
+	struct sockaddr_un sa;
+	struct sigaction act;
+	struct pollfd pfd;
+	struct timeval tv;
+	mode_t mask;
+	int rv, fd, cfd;
+
+	ENTER
+
+	rv = 1;
+	fd = -1;
+
+	STEP // 1: Install signal handlers
+	memset(&act, 0, sizeof(act));
+	act.sa_handler = daemon_signal;
+	sigemptyset(&act.sa_mask);
+	sigaction(SIGINT, &act, NULL);
+	sigaction(SIGTERM, &act, NULL);
+	signal(SIGPIPE, SIG_IGN);
+	daemon_stop = 0;
+
+	if (fill_addr(&sa, path) != 0)
+	{
+		printf("Error: Socket path too long: %s\n", path);
+		goto end;
+	}
+
+	STEP // 2: Refuse to start if another daemon owns the socket
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		goto end;
+	if (connect(fd, (struct sockaddr*) &sa, sizeof(sa)) == 0)
+	{
+		printf("Error: A jack daemon is already listening on %s\n", path);
+		goto close;
+	}
+	close(fd);
+
+	// Remove stale socket left by a daemon that did not exit cleanly
+	unlink(path);
+
+	STEP // 3: Create socket
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		goto end;
+
+	mask = umask(0077);
+	rv = bind(fd, (struct sockaddr*) &sa, sizeof(sa));
+	umask(mask);
+	if (rv != 0)
+	{
+		printf("Error: Could not bind %s: %s\n", path, strerror(errno));
+		rv = 1;
+		goto close;
+	}
+
+	if (listen(fd, JKLN_DAEMON_BACKLOG) != 0)
+	{
+		printf("Error: Could not listen on %s: %s\n", path, strerror(errno));
+		rv = 1;
+		goto unlink;
+	}
+
+	printf("jack daemon listening on %s\n", path);
+	fflush(stdout);
+
+	STEP // 4: Accept and serve requests
+	while (!daemon_stop)
+	{
+		// The signal may be delivered to an MCTP thread, so wake up
+		// periodically to check the stop flag
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, JKLN_DAEMON_POLL_MS) <= 0)
+			continue;
+
+		cfd = accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+		if (cfd < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			printf("Error: accept() failed: %s\n", strerror(errno));
+			break;
+		}
+
+		// Clients are served one at a time, so a client that stalls
+		// must not block the others
+		tv.tv_sec = JKLN_DAEMON_IO_SEC;
+		tv.tv_usec = 0;
+		if (setsockopt(cfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0
+		 && setsockopt(cfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) == 0)
+			serve_one(m, cfd, fn);
+		close(cfd);
+	}
+
+	rv = 0;
+
+unlink:
+
+	STEP // 5: Remove socket
+	unlink(path);
+
+close:
+
+	close(fd);
+
+end:
+
+	EXIT(rv)
+
+	return rv;
+}
@@ -0,0 +1,74 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		daemon.h
+ *
+ * @brief 		Header file for the jack daemon and its local socket client
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _DAEMON_H
+#define _DAEMON_H
+
+/* size_t
+ */
+#include <stddef.h>
+
+/* __u16
+ * __u32
+ */
+#include <linux/types.h>
+
+/* struct mctp
+ */
+#include <mctp.h>
+
+/* MACROS ====================================================================*/
+
+#define JKLN_DAEMON_MAGIC 		0x4A4B4432 	//!< "JKD2"
+#define JKLN_DAEMON_MAX_LEN 	65536 		//!< Max length of a request payload
+#define JKLN_DAEMON_PATH_LEN 	108 		//!< sizeof(sockaddr_un.sun_path)
+#define JKLN_DAEMON_BACKLOG 	16
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * Header sent in both directions over the daemon socket
+ *
+ * Request:  val = 0,  num = argc, len = bytes of cwd + argv that follow
+ * Response: val = rv, num = bytes of stderr, len = bytes of stdout
+ *
+ * Strings in the request payload are NUL terminated and concatenated. The
+ * response payload is the stdout of the command followed by its stderr, kept
+ * apart so that binary output on stdout is not mixed with messages
+ */
+struct daemon_hdr
+{
+	__u32 magic;	//!< JKLN_DAEMON_MAGIC
+	__s32 val;		//!< Return value of the command (response only)
+	__u32 num;		//!< Number of argv strings, or bytes of stderr (response)
+	__u32 len;		//!< Length of the payload that follows
+};
+
+/* PROTOTYPES ================================================================*/
+
+char *daemon_path(char *buf, size_t len, __u32 address, __u16 port);
+
+int daemon_client(const char *path, int argc, char **argv, int *rv);
+
+int daemon_serve(
+	struct mctp *m,
+	const char *path,
+	int (*fn)(struct mctp *m, int argc, char **argv)
+	);
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_DAEMON_H
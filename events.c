@@ -0,0 +1,310 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		events.c
+ *
+ * @brief 		Code file for unsolicited EM API event notifications
+ *
+ * Events are posted from the MCTP handler thread into a small queue. A
+ * consumer (the events command, or a thread of the daemon) takes them off the
+ * queue and refreshes only the port and VCSs that each event affects, so
+ * hot-plug is picked up without polling every port.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* gettid()
+ */
+#define _GNU_SOURCE
+
+/* printf()
+ */
+#include <stdio.h>
+
+/* memset()
+ */
+#include <string.h>
+
+#include <unistd.h>
+
+/* pthread_mutex_t
+ * pthread_cond_t
+ */
+#include <pthread.h>
+
+/* sigaction()
+ */
+#include <signal.h>
+
+/* clock_gettime()
+ * localtime_r()
+ */
+#include <time.h>
+
+#include <fmapi.h>
+#include <emapi.h>
+#include <cxlstate.h>
+
+#include "events.h"
+#include "fmapi_handler.h"
+#include "view.h"
+
+/* MACROS ====================================================================*/
+
+#ifdef JACK_VERBOSE
+ #define INIT 			unsigned step = 0;
+ #define ENTER 					if (m->verbose & MCTP_VERBOSE_THREADS) 	printf("%d:%s Enter\n", 				gettid(), __FUNCTION__);
+ #define STEP 			step++; if (m->verbose & MCTP_VERBOSE_STEPS) 	printf("%d:%s STEP: %u\n", 				gettid(), __FUNCTION__, step);
+ #define EXIT(rc) 				if (m->verbose & MCTP_VERBOSE_THREADS)	printf("%d:%s Exit: %d\n", 				gettid(), __FUNCTION__,rc);
+#else
+ #define INIT
+ #define ENTER
+ #define STEP
+ #define EXIT(rc)
+#endif // JACK_VERBOSE
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * Queue of received events
+ */
+struct event_queue
+{
+	pthread_mutex_t mtx;
+	pthread_cond_t 	cond;
+	unsigned 		head;		//!< Index of the oldest event
+	unsigned 		num;		//!< Number of events queued
+	unsigned 		dropped;	//!< Events dropped since the last wait
+	__u64 			seq;		//!< Number of events received
+	struct jack_event list[JKLN_EVENTS];
+};
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+static struct event_queue queue = {
+	.mtx 	= PTHREAD_MUTEX_INITIALIZER,
+	.cond 	= PTHREAD_COND_INITIALIZER,
+};
+
+/**
+ * Set to request the consumer to stop. Also set from a signal handler
+ */
+static volatile sig_atomic_t events_stopped;
+
+/* FUNCTIONS =================================================================*/
+
+static void events_signal(int sig)
+{
+	events_stopped = sig;
+}
+
+/**
+ * Queue an unsolicited EM API message if it is an event notification
+ *
+ * Called on the MCTP handler thread. The message is not consumed
+ *
+ * @return 0 if an event was queued, non zero otherwise
+ */
+int events_post(struct mctp_msg *mm)
+{
+	struct emapi_hdr hdr;
+	struct jack_event *e;
+	struct emapi_buf *buf;
+
+	buf = (struct emapi_buf*) mm->payload;
+	if (emapi_deserialize(&hdr, buf->hdr, EMOB_HDR, NULL) == 0)
+		return 1;
+
+	if (hdr.opcode != EMOP_EVENT)
+		return 1;
+
+	pthread_mutex_lock(&queue.mtx);
+
+	// Drop the oldest event when full. The newest state is what matters
+	if (queue.num == JKLN_EVENTS)
+	{
+		queue.head = (queue.head + 1) % JKLN_EVENTS;
+		queue.num--;
+		queue.dropped++;
+	}
+
+	e = &queue.list[(queue.head + queue.num) % JKLN_EVENTS];
+	memset(e, 0, sizeof(*e));
+	e->seq 		= queue.seq++;
+	e->ppid 	= hdr.a;
+	e->opcode 	= hdr.b;
+	clock_gettime(CLOCK_REALTIME, &e->ts);
+	queue.num++;
+
+	pthread_cond_signal(&queue.cond);
+	pthread_mutex_unlock(&queue.mtx);
+
+	return 0;
+}
+
+/**
+ * Wait for the next queued event
+ *
+ * @param e 			Filled with the event
+ * @param timeout_ms 	Max time to wait
+ * @return 				0 if an event was returned, 1 on timeout, -1 if stopped
+ */
+int events_wait(struct jack_event *e, int timeout_ms)
+{
+	struct timespec ts;
+	int rv;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec 	+= timeout_ms / 1000;
+	ts.tv_nsec 	+= (timeout_ms % 1000) * 1000000L;
+	if (ts.tv_nsec >= 1000000000L)
+	{
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000L;
+	}
+
+	rv = 1;
+
+	pthread_mutex_lock(&queue.mtx);
+
+	while (queue.num == 0 && !events_stopped)
+		if (pthread_cond_timedwait(&queue.cond, &queue.mtx, &ts) != 0)
+			break;
+
+	if (events_stopped)
+		rv = -1;
+	else if (queue.num > 0)
+	{
+		*e = queue.list[queue.head];
+		queue.head = (queue.head + 1) % JKLN_EVENTS;
+		queue.num--;
+		e->dropped = queue.dropped;
+		queue.dropped = 0;
+		rv = 0;
+	}
+
+	pthread_mutex_unlock(&queue.mtx);
+
+	return rv;
+}
+
+/**
+ * Request the consumer of the event queue to stop
+ */
+void events_stop()
+{
+	pthread_mutex_lock(&queue.mtx);
+	events_stopped = 1;
+	pthread_cond_broadcast(&queue.cond);
+	pthread_mutex_unlock(&queue.mtx);
+}
+
+/**
+ * Return a string for the opcode of an event
+ */
+const char *events_str(int opcode)
+{
+	switch (opcode)
+	{
+		case EMOP_CONN_DEV: 	return "connect";
+		case EMOP_DISCON_DEV: 	return "disconnect";
+		default: 				return "unknown";
+	}
+}
+
+/**
+ * Print an event and the refreshed state of its port
+ */
+static void print_event(struct jack_event *e)
+{
+	const struct cxl_view *view;
+	const struct snap_port *p;
+	unsigned token;
+	struct tm tm;
+
+	if (e->dropped > 0)
+		printf("Warning: %u events were dropped\n", e->dropped);
+
+	localtime_r(&e->ts.tv_sec, &tm);
+	printf("%02d:%02d:%02d.%03ld %-10s port %u", tm.tm_hour, tm.tm_min, tm.tm_sec, e->ts.tv_nsec / 1000000, events_str(e->opcode), e->ppid);
+
+	view = view_acquire(&token);
+	if (view != NULL && e->ppid < view->num_ports)
+	{
+		p = &view->ports[e->ppid];
+		printf(" state: %s", fmps(p->state));
+		if (p->prsnt)
+			printf(" type: %s ltssm: %s", fmdt(p->dt), fmls(p->ltssm));
+	}
+	view_release(token);
+
+	printf("\n");
+	fflush(stdout);
+}
+
+/**
+ * Consume events and refresh the state each one affects
+ *
+ * @param m 	struct mctp* that is already connected to the endpoint
+ * @param fn 	Function to refresh the cached state of a port and its VCSs
+ * @param count Stop after this many events. 0 to run until stopped
+ * @param print Print each event. Set for the foreground command, which also
+ * 				stops on SIGINT / SIGTERM
+ * @return 		0 upon success. Non zero otherwise
+ *
+ * STEPS
+ * 1: Install signal handlers
+ * 2: Wait for an event, refresh & print until stopped
+ */
+int events_run(struct mctp *m, int (*fn)(struct mctp *m, int ppid), unsigned count, int print)
+{
+	INIT
+	struct sigaction act;
+	struct jack_event e;
+	unsigned n;
+	int rv;
+
+	ENTER
+
+	n = 0;
+
+	STEP // 1: Install signal handlers
+	if (print)
+	{
+		memset(&act, 0, sizeof(act));
+		act.sa_handler = events_signal;
+		sigemptyset(&act.sa_mask);
+		sigaction(SIGINT, &act, NULL);
+		sigaction(SIGTERM, &act, NULL);
+	}
+
+	STEP // 2: Wait for an event, refresh & print until stopped
+	while (count == 0 || n < count)
+	{
+		rv = events_wait(&e, JKLN_EVENT_WAIT_MS);
+		if (rv < 0)
+			break;
+		if (rv > 0)
+			continue;
+
+		if (e.ppid < cxls->num_ports && fn(m, e.ppid) != 0 && print)
+			printf("Error: Could not refresh port %u\n", e.ppid);
+
+		if (print)
+			print_event(&e);
+
+		n++;
+	}
+
+	EXIT(0)
+
+	return 0;
+}
@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		events.h
+ *
+ * @brief 		Header file for unsolicited EM API event notifications
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ * An EMOP_EVENT message carries the port in hdr.a and the EM API opcode of
+ * the change (EMOP_CONN_DEV / EMOP_DISCON_DEV) in hdr.b
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _EVENTS_H
+#define _EVENTS_H
+
+/* __u8
+ * __u64
+ */
+#include <linux/types.h>
+
+/* struct timespec
+ */
+#include <time.h>
+
+/* struct mctp
+ * struct mctp_msg
+ */
+#include <mctp.h>
+
+/* MACROS ====================================================================*/
+
+#define JKLN_EVENTS 		64 		//!< Max events queued before the oldest is dropped
+#define JKLN_EVENT_WAIT_MS 	250 	//!< Max time to block before checking for a stop request
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * One received event
+ */
+struct jack_event
+{
+	__u64 seq;				//!< Sequence number of the event since start up
+	struct timespec ts;		//!< Time the event was received (CLOCK_REALTIME)
+	__u8 opcode;			//!< EM API opcode of the change [EMOP]
+	__u8 ppid;				//!< Physical port the event is for
+	unsigned dropped;		//!< Number of events dropped before this one
+};
+
+/* PROTOTYPES ================================================================*/
+
+int events_post(struct mctp_msg *mm);
+
+int events_wait(struct jack_event *e, int timeout_ms);
+
+void events_stop();
+
+const char *events_str(int opcode);
+
+int events_run(struct mctp *m, int (*fn)(struct mctp *m, int ppid), unsigned count, int print);
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_EVENTS_H
@@ -0,0 +1,333 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		filter.c
+ *
+ * @brief 		Code file for filters and field selection of show commands
+ *
+ * A --where expression is a ',' separated list of terms of the form
+ * <field><op><value>, e.g. "state=dsp,type=t3,width>=8". The value can be a
+ * number or the name the show command prints for the field. A --fields list
+ * is a ',' separated list of column names
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* printf()
+ */
+#include <stdio.h>
+
+/* strtoul()
+ */
+#include <stdlib.h>
+
+/* strlen()
+ * strncpy()
+ */
+#include <string.h>
+
+/* strcasecmp()
+ */
+#include <strings.h>
+
+#include "filter.h"
+
+/* MACROS ====================================================================*/
+
+#define FTLN_TOKEN 			64 		//!< Max length of one term or field name
+#define FTLN_NAMES 			16 		//!< Enumeration values searched for a name
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * String representation of FTFD Enumeration
+ */
+static char *STR_FTFD[] = {
+	"ppid",
+	"present",
+	"state",
+	"type",
+	"ld",
+	"ltssm",
+	"width",
+	"mlw",
+	"speed",
+	"mls"
+};
+
+/**
+ * String representation of FTCL Enumeration
+ */
+static char *STR_FTCL[] = {
+	"ppid",
+	"present",
+	"state",
+	"type",
+	"ld",
+	"ver",
+	"cxl",
+	"mlw",
+	"nlw",
+	"mls",
+	"cls",
+	"speeds",
+	"ltssm",
+	"lane",
+	"flags"
+};
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Return the name the show command prints for a value of a field
+ *
+ * @return Name or NULL if the field has no names
+ */
+static const char *value_str(int field, unsigned val)
+{
+	switch (field)
+	{
+		case FTFD_STATE: 	return fmps(val);
+		case FTFD_TYPE: 	return fmdt(val);
+		case FTFD_LTSSM: 	return fmls(val);
+		case FTFD_SPEED:
+		case FTFD_MLS: 		return fmms(val);
+		default: 			return NULL;
+	}
+}
+
+/**
+ * Return the value of a field of a port
+ */
+static unsigned port_value(int field, struct fmapi_psc_port_info *p)
+{
+	switch (field)
+	{
+		case FTFD_PPID: 	return p->ppid;
+		case FTFD_PRESENT: 	return p->prsnt;
+		case FTFD_STATE: 	return p->state;
+		case FTFD_TYPE: 	return p->dt;
+		case FTFD_LD: 		return p->num_ld;
+		case FTFD_LTSSM: 	return p->ltssm;
+		case FTFD_WIDTH: 	return p->nlw ? p->nlw : p->mlw;
+		case FTFD_MLW: 		return p->mlw;
+		case FTFD_SPEED: 	return p->cls;
+		case FTFD_MLS: 		return p->mls;
+		default: 			return 0;
+	}
+}
+
+/**
+ * Copy the next ',' separated token of a list without surrounding spaces
+ *
+ * @return Pointer to the rest of the list, or NULL if the token is too long
+ */
+static const char *next_token(char *buf, const char *str)
+{
+	int len;
+
+	while (*str == ' ')
+		str++;
+
+	len = 0;
+	while (str[len] != 0 && str[len] != ',')
+		len++;
+
+	if (len >= FTLN_TOKEN)
+		return NULL;
+
+	memcpy(buf, str, len);
+	while (len > 0 && buf[len-1] == ' ')
+		len--;
+	buf[len] = 0;
+
+	str += strcspn(str, ",");
+	if (*str == ',')
+		str++;
+
+	return str;
+}
+
+/**
+ * Parse one <field><op><value> term
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+static int parse_term(struct filter_term *t, char *s)
+{
+	const char *name;
+	char *val, *end;
+	unsigned v;
+	int i, len;
+
+	// Field
+	len = strcspn(s, "=!<>");
+	if (len == 0 || s[len] == 0)
+		return 1;
+
+	for ( i = 0 ; i < FTFD_MAX ; i++ )
+		if (strlen(STR_FTFD[i]) == (size_t) len && strncasecmp(s, STR_FTFD[i], len) == 0)
+			break;
+	if (i == FTFD_MAX)
+		return 1;
+	t->field = i;
+
+	// Operator
+	val = &s[len];
+	if 		(!strncmp(val, "==", 2)) 	{ t->op = FTOP_EQ; val += 2; }
+	else if (!strncmp(val, "!=", 2)) 	{ t->op = FTOP_NE; val += 2; }
+	else if (!strncmp(val, "<=", 2)) 	{ t->op = FTOP_LE; val += 2; }
+	else if (!strncmp(val, ">=", 2)) 	{ t->op = FTOP_GE; val += 2; }
+	else if (*val == '=') 				{ t->op = FTOP_EQ; val += 1; }
+	else if (*val == '<') 				{ t->op = FTOP_LT; val += 1; }
+	else if (*val == '>') 				{ t->op = FTOP_GT; val += 1; }
+	else
+		return 1;
+
+	while (*val == ' ')
+		val++;
+	if (*val == 0)
+		return 1;
+
+	// Value by name
+	for ( v = 0 ; v < FTLN_NAMES ; v++ )
+	{
+		name = value_str(t->field, v);
+		if (name != NULL && strcasecmp(name, val) == 0)
+		{
+			t->val = v;
+			return 0;
+		}
+	}
+
+	if (t->field == FTFD_PRESENT && (!strcasecmp(val, "yes") || !strcasecmp(val, "no")))
+	{
+		t->val = !strcasecmp(val, "yes");
+		return 0;
+	}
+
+	// Value by number
+	t->val = strtoul(val, &end, 0);
+	if (*end != 0)
+		return 1;
+
+	return 0;
+}
+
+/**
+ * Parse a --where expression
+ *
+ * @param f 	struct port_filter* to fill
+ * @param str 	Expression. NULL or empty matches every port
+ * @return 		0 upon success. Non zero otherwise
+ */
+int filter_parse(struct port_filter *f, const char *str)
+{
+	char buf[FTLN_TOKEN];
+
+	f->num = 0;
+
+	while (str != NULL && *str != 0)
+	{
+		str = next_token(buf, str);
+		if (str == NULL || f->num >= FTLN_TERMS || parse_term(&f->terms[f->num], buf))
+		{
+			printf("Error: Invalid --where term: %s\n", str ? buf : "too long");
+			return 1;
+		}
+		f->num++;
+	}
+
+	return 0;
+}
+
+/**
+ * Return 1 if a port matches every term of a filter
+ */
+int filter_match(struct port_filter *f, struct fmapi_psc_port_info *p)
+{
+	struct filter_term *t;
+	unsigned v;
+	int i, rv;
+
+	for ( i = 0 ; i < f->num ; i++ )
+	{
+		t = &f->terms[i];
+		v = port_value(t->field, p);
+
+		switch (t->op)
+		{
+			case FTOP_EQ: 	rv = v == t->val; 	break;
+			case FTOP_NE: 	rv = v != t->val; 	break;
+			case FTOP_LT: 	rv = v <  t->val; 	break;
+			case FTOP_LE: 	rv = v <= t->val; 	break;
+			case FTOP_GT: 	rv = v >  t->val; 	break;
+			case FTOP_GE: 	rv = v >= t->val; 	break;
+			default: 		rv = 0; 			break;
+		}
+
+		if (!rv)
+			return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * Parse a --fields list into the columns to print
+ *
+ * @param list 	Filled with the selected columns [FTCL] in the given order
+ * @param max 	Number of entries in list
+ * @param str 	Field list. NULL or empty selects every column
+ * @return 		Number of columns selected, or -1 if a name is invalid
+ */
+int filter_fields(int *list, int max, const char *str)
+{
+	char buf[FTLN_TOKEN];
+	int i, n;
+
+	n = 0;
+
+	if (str == NULL || *str == 0)
+	{
+		for ( n = 0 ; n < FTCL_MAX && n < max ; n++ )
+			list[n] = n;
+		return n;
+	}
+
+	while (*str != 0)
+	{
+		str = next_token(buf, str);
+		if (str == NULL)
+			break;
+
+		for ( i = 0 ; i < FTCL_MAX ; i++ )
+			if (strcasecmp(buf, STR_FTCL[i]) == 0)
+				break;
+
+		if (i == FTCL_MAX || n >= max)
+		{
+			printf("Error: Invalid --fields name: %s\n", buf);
+			return -1;
+		}
+		list[n++] = i;
+	}
+
+	if (str == NULL)
+	{
+		printf("Error: Invalid --fields name\n");
+		return -1;
+	}
+
+	return n;
+}
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		filter.h
+ *
+ * @brief 		Header file for filters and field selection of show commands
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _FILTER_H
+#define _FILTER_H
+
+/* struct fmapi_psc_port_info
+ */
+#include <fmapi.h>
+
+/* MACROS ====================================================================*/
+
+#define FTLN_TERMS 			16 		//!< Max terms of a --where expression
+
+/* ENUMERATIONS ==============================================================*/
+
+/**
+ * Port fields a --where term can test (FD)
+ */
+enum _FTFD
+{
+	FTFD_PPID 		= 0,
+	FTFD_PRESENT 	= 1,
+	FTFD_STATE 		= 2,	//!< [FMPS]
+	FTFD_TYPE 		= 3,	//!< [FMDT]
+	FTFD_LD 		= 4,
+	FTFD_LTSSM 		= 5,	//!< [FMLS]
+	FTFD_WIDTH 		= 6,	//!< Negotiated width, or max width if not negotiated
+	FTFD_MLW 		= 7,
+	FTFD_SPEED 		= 8,	//!< Current link speed [FMMS]
+	FTFD_MLS 		= 9,	//!< Max link speed [FMMS]
+	FTFD_MAX
+};
+
+/**
+ * Comparison of a --where term (OP)
+ */
+enum _FTOP
+{
+	FTOP_EQ 		= 0,
+	FTOP_NE 		= 1,
+	FTOP_LT 		= 2,
+	FTOP_LE 		= 3,
+	FTOP_GT 		= 4,
+	FTOP_GE 		= 5,
+	FTOP_MAX
+};
+
+/**
+ * Columns of show port that --fields can select (CL)
+ */
+enum _FTCL
+{
+	FTCL_PPID 		= 0,
+	FTCL_PRESENT 	= 1,
+	FTCL_STATE 		= 2,
+	FTCL_TYPE 		= 3,
+	FTCL_LD 		= 4,
+	FTCL_VER 		= 5,
+	FTCL_CXL 		= 6,
+	FTCL_MLW 		= 7,
+	FTCL_NLW 		= 8,
+	FTCL_MLS 		= 9,
+	FTCL_CLS 		= 10,
+	FTCL_SPEEDS 	= 11,
+	FTCL_LTSSM 		= 12,
+	FTCL_LANE 		= 13,
+	FTCL_FLAGS 		= 14,
+	FTCL_MAX
+};
+
+/* STRUCTS ===================================================================*/
+
+struct filter_term
+{
+	int field;				//!< [FTFD]
+	int op;					//!< [FTOP]
+	unsigned val;
+};
+
+/**
+ * Parsed --where expression. Terms are separated by ',' and all must match
+ */
+struct port_filter
+{
+	int num;
+	struct filter_term terms[FTLN_TERMS];
+};
+
+/* PROTOTYPES ================================================================*/
+
+int filter_parse(struct port_filter *f, const char *str);
+
+int filter_match(struct port_filter *f, struct fmapi_psc_port_info *p);
+
+int filter_fields(int *list, int max, const char *str);
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_FILTER_H
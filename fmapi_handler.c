@@ -43,8 +43,13 @@
  */
 #include <mctp.h>
 
+#include "binding.h"
+#include "cfgdump.h"
+#include "filter.h"
 #include "fmapi_handler.h"
 #include "options.h"
+#include "snapshot.h"
+#include "view.h"
 
 /* MACROS ====================================================================*/
 
@@ -66,6 +71,8 @@
  #define EXIT(rc)
 #endif // JACK_VERBOSE
 
+#define JKLN_LDS(a) 	(sizeof(a) / sizeof((a)[0])) 	//!< Entries of a per LD array of struct cxl_mld
+
 /* ENUMERATIONS ==============================================================*/
 
 /* STRUCTS ===================================================================*/
@@ -90,6 +97,9 @@ struct col
 	char *title;
 };
 
+/**
+ * Columns of show port. Indexed by [FTCL]
+ */
 struct col cols[] = 
 {
 	{3, "#"},
@@ -110,258 +120,207 @@ struct col cols[] =
 	{0,0}
 };
 
-#define SHOW_PORT_BUF_LEN 110
-void print_ports(struct fmapi_psc_port_rsp *o)
+#define SHOW_PORT_CELL_LEN 32
+
+/**
+ * Fill the text of one column of a show port row
+ */
+static void port_cell(char *s, struct fmapi_psc_port_info *p, int col)
 {
-	int i, k;
-	struct fmapi_psc_port_info *p;
-	char buf[SHOW_PORT_BUF_LEN+1];
-	struct col *col;
+	char c;
 
-	memset(buf, ' ', SHOW_PORT_BUF_LEN);
-	buf[SHOW_PORT_BUF_LEN] = 0;
+	s[0] = 0;
 
-	// Print header
+	switch (col)
 	{
-		col = &cols[0];
-	 	i = 0;
+		// Port number
+		case FTCL_PPID:
+			sprintf(s, "%d", p->ppid);
+			break;
 
-		while (col->width != 0)
-		{
-			memcpy(&buf[i], col->title, strlen(col->title));
-			i += (col->width + 2);
-			col++;
-		}
-		buf[i] = 0;
-		printf("%s\n", buf);
-	}
+		// Present bit 
+		case FTCL_PRESENT:
+			sprintf(s, "%c", p->prsnt ? '+' : '-');
+			break;
 
-	// Reset buffer
-	memset(buf, ' ', SHOW_PORT_BUF_LEN);
+		// Port state
+		case FTCL_STATE:
+			sprintf(s, "%s", fmps(p->state));
+			break;
 
-	// Print header line 
-	{
-		col = &cols[0];
-	 	i = 0;
+		// Type 
+		case FTCL_TYPE:
+			if (!p->prsnt)
+				sprintf(s, "-");
+			else 
+				sprintf(s, "%s", fmdt(p->dt));
+			break;
 
-		while (col->width != 0)
-		{
-			memset(&buf[i], '-', col->width);
-			i += (col->width + 2);
-			col++;
-		}
-		buf[i] = 0;
-		printf("%s\n", buf);
-	}
+		// LD
+		case FTCL_LD:
+			if (!p->prsnt || (p->dt != FMDT_CXL_TYPE_3 && p->dt != FMDT_CXL_TYPE_3_POOLED) )
+				sprintf(s, "-");
+			else 
+				sprintf(s, "%d", p->num_ld);
+			break;
 
-	// Print port rows 
+		// Ver
+		case FTCL_VER:
+			if (!p->prsnt)
+				sprintf(s, "-");
+			else 
+				sprintf(s, "%s", fmdv(p->dv));
+			break;
 
-	for ( int j = 0 ; j < o->num ; j++ ) 
-	{
-		p = &o->list[j];
-		i = 0;
-		k = 0;
-
-		// Reset buffer 
-		memset(buf, ' ', SHOW_PORT_BUF_LEN);
-		buf[SHOW_PORT_BUF_LEN] = 0;
-
-		// COL 0: Port number
-		sprintf(&buf[i],   "%d", p->ppid);
-		i += (cols[k++].width + 2);
-
-		// COL 1: Present bit 
-		if (p->prsnt) 
-			buf[i] = '+';
-		else 
-			buf[i] = '-';
-		i += (cols[k++].width + 2);
-
-		// COL 2: Port state
-		//if (!p->prsnt)
-		//	sprintf(&buf[i], "-");
-		//else
-			sprintf(&buf[i], "%s", fmps(p->state));
-		i += (cols[k++].width + 2);
-
-		// COL 3: Type 
-		if (!p->prsnt)
-			sprintf(&buf[i], "-");
-		else 
-			sprintf(&buf[i], "%s", fmdt(p->dt));
-		i += (cols[k++].width + 2);
-
-		// COL 4: LD
-		if (!p->prsnt || (p->dt != FMDT_CXL_TYPE_3 && p->dt != FMDT_CXL_TYPE_3_POOLED) )
-			sprintf(&buf[i], "-");
-		else 
-			sprintf(&buf[i], "%d", p->num_ld);
-		i += (cols[k++].width + 2);
-
-		// COL 5: Ver
-		if (!p->prsnt)
-			sprintf(&buf[i], "-");
-		else 
-			sprintf(&buf[i], "%s", fmdv(p->dv));
-		i += (cols[k++].width + 2);
-
-		// COL 6: CXL Versions 
-		if (!p->prsnt)
-			sprintf(&buf[i], "-");
-		else 
-		{
-			char c = 'A';
-			for ( int v = 0 ; v < 8 ; v++ )
+		// CXL Versions 
+		case FTCL_CXL:
+			if (!p->prsnt)
+				sprintf(s, "-");
+			else 
 			{
-				if ((p->cv >> v) & 0x01)
-					buf[i+v] = c;
-				else 
-					buf[i+v] = ' ';
-				c++;
+				c = 'A';
+				for ( int v = 0 ; v < 8 ; v++, c++ )
+					s[v] = ((p->cv >> v) & 0x01) ? c : ' ';
+				s[8] = 0;
 			}
-		}
-		i += (cols[k++].width + 2);
+			break;
 
-		// COL 7: MLW
-		sprintf(&buf[i], "%d", p->mlw);
-		i += (cols[k++].width + 2);
+		// MLW
+		case FTCL_MLW:
+			sprintf(s, "%d", p->mlw);
+			break;
 
-		// COL 8: NLW
-		if (!p->prsnt)
-			sprintf(&buf[i], "-");
-		else 
-		{
-			if (p->nlw == 0)
-				sprintf(&buf[i], "%d", p->mlw);
+		// NLW
+		case FTCL_NLW:
+			if (!p->prsnt)
+				sprintf(s, "-");
+			else if (p->nlw == 0)
+				sprintf(s, "%d", p->mlw);
+			else 
+				sprintf(s, "%d", p->nlw);
+			break;
+
+		// MLS 
+		case FTCL_MLS:
+			sprintf(s, "%s", fmms(p->mls));
+			break;
+
+		// CLS 
+		case FTCL_CLS:
+			if (!p->prsnt)
+				sprintf(s, "-");
+			else 
+				sprintf(s, "%s", fmms(p->cls));
+			break;
+
+		// Dev Speeds 
+		case FTCL_SPEEDS:
+			if (!p->prsnt)
+				sprintf(s, "-");
 			else 
-				sprintf(&buf[i], "%d", p->nlw);
-		}
-		i += (cols[k++].width + 2);
-
-		// COL 9: MLS 
-		sprintf(&buf[i], "%s", fmms(p->mls));
-		i += (cols[k++].width + 2);
-
-		// COL 10: CLS 
-		if (!p->prsnt)
-			sprintf(&buf[i], "-");
-		else 
-			sprintf(&buf[i], "%s", fmms(p->cls));
-		i += (cols[k++].width + 2);
-
-		// COL 11: Dev Speeds 
-		if (!p->prsnt)
-			sprintf(&buf[i], "-");
-		else 
-		{
-			char c = '1';
-			for ( int v = 0 ; v < 8 ; v++ )
 			{
-				if ((p->speeds >> v) & 0x01)
-					buf[i+v] = c;
-				else 
-					buf[i+v] = ' ';
-				c++;
+				c = '1';
+				for ( int v = 0 ; v < 8 ; v++, c++ )
+					s[v] = ((p->speeds >> v) & 0x01) ? c : ' ';
+				s[8] = 0;
 			}
-		}
-		i += (cols[k++].width + 2);
-
-		// COL 12: LTSSM
-		if (!p->prsnt)
-			sprintf(&buf[i], "-");
-		else 
-			sprintf(&buf[i], "%s", fmls(p->ltssm));
-		i += (cols[k++].width + 2);
-
-		// COL 13: First Lane 
-		if (!p->prsnt)
-			sprintf(&buf[i], "-");
-		else 
-			sprintf(&buf[i], "%d", p->lane);
-		i += (cols[k++].width + 2);
-
-		// COL 14: Flags
-		if (p->lane_rev)
-			buf[i+0] = 'L';
-		if (p->perst)
-			buf[i+1] = 'R';
-		if (p->prsnt)
-			buf[i+2] = 'P';
-		if (p->pwrctrl)
-			buf[i+3] = 'W';
-		i += (cols[k++].width + 2);
-
-		// Unset null termination zeros 
-		for ( int k = 0 ; k < SHOW_PORT_BUF_LEN ; k++) 
-		{
-			if (buf[k] == 0)
-				buf[k] = ' ';
-		}
-		buf[SHOW_PORT_BUF_LEN] = 0;
-	
-		printf("%s\n", buf);
+			break;
+
+		// LTSSM
+		case FTCL_LTSSM:
+			if (!p->prsnt)
+				sprintf(s, "-");
+			else 
+				sprintf(s, "%s", fmls(p->ltssm));
+			break;
+
+		// First Lane 
+		case FTCL_LANE:
+			if (!p->prsnt)
+				sprintf(s, "-");
+			else 
+				sprintf(s, "%d", p->lane);
+			break;
+
+		// Flags
+		case FTCL_FLAGS:
+			sprintf(s, "%c%c%c%c", 
+				p->lane_rev ? 'L' : ' ', 
+				p->perst 	? 'R' : ' ', 
+				p->prsnt 	? 'P' : ' ', 
+				p->pwrctrl 	? 'W' : ' ');
+			break;
 	}
 }
 
 /**
- * Handle Responses of Tunneled CXL FM API MLD Component Command Set Messages
+ * Print a Get Physical Port State response as a table
  *
- * @return 0 upon success. Non zero otherwise.
- *
- * STEPS
- * 1: Set buffer pointers 
- * 2: Deserialize Header
- * 3: Verify Response 
- * 4: Deserialize Object
- * 5: Handle opcode
+ * Only the ports that match the --where expression are printed, with the 
+ * columns selected by --fields 
  */
-int cci_handler(struct mctp *m, __u8 *payload)
+void print_ports(struct fmapi_psc_port_rsp *o)
 {
-	INIT
-	struct fmapi_msg msg;
-	int rv;
-
-	ENTER 
-
-	// Initialize variables 
-	rv = 1;
+	struct fmapi_psc_port_info *p;
+	struct port_filter filter;
+	char cell[SHOW_PORT_CELL_LEN];
+	int list[FTCL_MAX];
+	int i, j, n;
 
-	STEP // 1: Set buffer pointers 
-	msg.buf = (struct fmapi_buf*) payload;
+	if (filter_parse(&filter, opts[CLOP_WHERE].str))
+		return;
 
-	STEP // 2: Deserialize Header
-	fmapi_deserialize(&msg.hdr, msg.buf->hdr, FMOB_HDR, NULL);
+	n = filter_fields(list, FTCL_MAX, opts[CLOP_FIELDS].str);
+	if (n < 0)
+		return;
 
-	STEP // 3: Verify Response 
+	// Print header
+	for ( i = 0 ; i < n ; i++ )
+		printf("%-*s", cols[list[i]].width + 2, cols[list[i]].title);
+	printf("\n");
 
-	// Verify msg category 
-	if (msg.hdr.category != FMMT_RESP) 
+	// Print header line 
+	for ( i = 0 ; i < n ; i++ )
 	{
-		printf("Error: Received a tunneled FM API message that was not a response: %s\n", fmmt(msg.hdr.category));
-		rv = 1;
-		goto end;
+		memset(cell, '-', cols[list[i]].width);
+		cell[cols[list[i]].width] = 0;
+		printf("%-*s", cols[list[i]].width + 2, cell);
 	}
+	printf("\n");
 
-	// Verify msg return code
-	if (msg.hdr.return_code != FMRC_SUCCESS && msg.hdr.return_code != FMRC_BACKGROUND_OP_STARTED) 
+	// Print port rows 
+	for ( j = 0 ; j < o->num ; j++ ) 
 	{
-		printf("Error: %s\n", fmrc(msg.hdr.return_code));
-		rv = msg.hdr.return_code;
-		goto end;
-	}
+		p = &o->list[j];
+		if (!filter_match(&filter, p))
+			continue;
 
-	STEP // 4: Deserialize Object
-	fmapi_deserialize(&msg.obj, msg.buf->payload, fmapi_fmob_rsp(msg.hdr.opcode), NULL);
+		// Text wider than a column is cut at the start of the next column
+		for ( i = 0 ; i < n ; i++ )
+		{
+			port_cell(cell, p, list[i]);
+			printf("%-*.*s", cols[list[i]].width + 2, cols[list[i]].width + 2, cell);
+		}
+		printf("\n");
+	}
+}
 
-	STEP // 5: Handle opcode
-	switch(msg.hdr.opcode)
+/**
+ * Print a Tunneled CXL FM API MLD Component Command Set Response object
+ *
+ * @param msg 	struct fmapi_msg* with a deserialized header and object
+ * @return 		0 upon success. Non zero if the opcode is not supported
+ */
+int cci_print(struct fmapi_msg *msg)
+{
+	switch(msg->hdr.opcode)
 	{
 		case FMOP_MCC_INFO:
 		{			
-			struct fmapi_mcc_info_rsp *o = &msg.obj.mcc_info_rsp;
+			struct fmapi_mcc_info_rsp *o = &msg->obj.mcc_info_rsp;
 			double size;
 
-			size = msg.obj.mcc_info_rsp.size / (double) (1024*1024*1024);	
+			size = msg->obj.mcc_info_rsp.size / (double) (1024*1024*1024);	
 
 			printf("Memory Size                 : 0x%llx - %.1f GiB\n", o->size, size);
 			printf("LD Count                    : %d\n", o->num);
@@ -372,7 +331,7 @@ int cci_handler(struct mctp *m, __u8 *payload)
 
 		case FMOP_MCC_ALLOC_GET:
 		{			
-			struct fmapi_mcc_alloc_get_rsp *o = &msg.obj.mcc_alloc_get_rsp;
+			struct fmapi_mcc_alloc_get_rsp *o = &msg->obj.mcc_alloc_get_rsp;
 
 			printf("Total LDs on Device: %u\n", 		o->total);
 			printf("Memory Granularity : %d - %s\n", 	o->granularity, fmmg(o->granularity));
@@ -389,7 +348,7 @@ int cci_handler(struct mctp *m, __u8 *payload)
 
 		case FMOP_MCC_ALLOC_SET:
 		{			
-			struct fmapi_mcc_alloc_set_rsp *o = &msg.obj.mcc_alloc_set_rsp;
+			struct fmapi_mcc_alloc_set_rsp *o = &msg->obj.mcc_alloc_set_rsp;
 
 			printf("Number of LDs      : %u\n", o->num);
 			printf("Starting LD ID     : %u\n", o->start);
@@ -405,7 +364,7 @@ int cci_handler(struct mctp *m, __u8 *payload)
 		case FMOP_MCC_QOS_CTRL_GET:
 		case FMOP_MCC_QOS_CTRL_SET:
 		{			
-			struct fmapi_mcc_qos_ctrl *o = &msg.obj.mcc_qos_ctrl;
+			struct fmapi_mcc_qos_ctrl *o = &msg->obj.mcc_qos_ctrl;
 
 			printf("Port Congestion                : %d\n", o->epc_en);
 			printf("Temporary BW Reduction         : %d\n", o->ttr_en);
@@ -419,7 +378,7 @@ int cci_handler(struct mctp *m, __u8 *payload)
 
 		case FMOP_MCC_QOS_STAT:
 		{			
-			struct fmapi_mcc_qos_stat_rsp *o = &msg.obj.mcc_qos_stat_rsp;
+			struct fmapi_mcc_qos_stat_rsp *o = &msg->obj.mcc_qos_stat_rsp;
 
 			printf("Backpressure Avg Pcnt :  %d\n", o->bp_avg_pcnt);
 		}
@@ -428,7 +387,7 @@ int cci_handler(struct mctp *m, __u8 *payload)
 		case FMOP_MCC_QOS_BW_ALLOC_GET:
 		case FMOP_MCC_QOS_BW_ALLOC_SET:
 		{			
-			struct fmapi_mcc_qos_bw_alloc *o = &msg.obj.mcc_qos_bw_alloc;
+			struct fmapi_mcc_qos_bw_alloc *o = &msg->obj.mcc_qos_bw_alloc;
 
 			printf("LDID  Val        PCNT\n");
 			printf("----  ---------- ------\n");
@@ -441,7 +400,7 @@ int cci_handler(struct mctp *m, __u8 *payload)
 		case FMOP_MCC_QOS_BW_LIMIT_GET:
 		case FMOP_MCC_QOS_BW_LIMIT_SET:
 		{			
-			struct fmapi_mcc_qos_bw_limit *o = &msg.obj.mcc_qos_bw_limit;
+			struct fmapi_mcc_qos_bw_limit *o = &msg->obj.mcc_qos_bw_limit;
 
 			printf("LDID  Val        PCNT\n");
 			printf("----  ---------- ------\n");
@@ -451,10 +410,64 @@ int cci_handler(struct mctp *m, __u8 *payload)
 		}
 			break;
 
-		default: rv = 1; break;
+		default: return 1;
 	}
 
-	rv = 0;
+	return 0;
+}
+
+/**
+ * Handle Responses of Tunneled CXL FM API MLD Component Command Set Messages
+ *
+ * @return 0 upon success. Non zero otherwise.
+ *
+ * STEPS
+ * 1: Set buffer pointers 
+ * 2: Deserialize Header
+ * 3: Verify Response 
+ * 4: Deserialize Object
+ * 5: Handle opcode
+ */
+int cci_handler(struct mctp *m, __u8 *payload)
+{
+	INIT
+	struct fmapi_msg msg;
+	int rv;
+
+	ENTER 
+
+	// Initialize variables 
+	rv = 1;
+
+	STEP // 1: Set buffer pointers 
+	msg.buf = (struct fmapi_buf*) payload;
+
+	STEP // 2: Deserialize Header
+	fmapi_deserialize(&msg.hdr, msg.buf->hdr, FMOB_HDR, NULL);
+
+	STEP // 3: Verify Response 
+
+	// Verify msg category 
+	if (msg.hdr.category != FMMT_RESP) 
+	{
+		printf("Error: Received a tunneled FM API message that was not a response: %s\n", fmmt(msg.hdr.category));
+		rv = 1;
+		goto end;
+	}
+
+	// Verify msg return code
+	if (msg.hdr.return_code != FMRC_SUCCESS && msg.hdr.return_code != FMRC_BACKGROUND_OP_STARTED) 
+	{
+		printf("Error: %s\n", fmrc(msg.hdr.return_code));
+		rv = msg.hdr.return_code;
+		goto end;
+	}
+
+	STEP // 4: Deserialize Object
+	fmapi_deserialize(&msg.obj, msg.buf->payload, fmapi_fmob_rsp(msg.hdr.opcode), NULL);
+
+	STEP // 5: Handle opcode
+	rv = cci_print(&msg);
 
 end:
 
@@ -518,6 +531,15 @@ int cci_update(struct mctp *m, unsigned ppid, __u8 *payload)
 	fmapi_deserialize(&msg.obj, msg.buf->payload, fmapi_fmob_rsp(msg.hdr.opcode), NULL);
 
 	STEP // 5: Handle opcode
+
+	// Only the MCC info response allocates the MLD object of the port 
+	if (mld == NULL && msg.hdr.opcode != FMOP_MCC_INFO)
+	{
+		printf("Error: Received an MCC response for port %u before its MCC info\n", ppid);
+		rv = 1;
+		goto end;
+	}
+
 	switch(msg.hdr.opcode)
 	{
 		case FMOP_MCC_INFO:
@@ -537,9 +559,9 @@ int cci_update(struct mctp *m, unsigned ppid, __u8 *payload)
 			mld->ttr 			= o->ttr;
 
 			// Allocate memory for the PCI Config Space for each LD if needed 
-			for (int i = 0 ; i < o->num ; i++)
+			for (int i = 0 ; i < o->num && i < (int) JKLN_LDS(mld->cfgspace) ; i++)
 				if (mld->cfgspace[i] == NULL)
-					mld->cfgspace[i] = calloc(1, sizeof(PCLN_CFG));
+					mld->cfgspace[i] = calloc(1, PCLN_CFG);
 		}
 			break;
 
@@ -548,7 +570,7 @@ int cci_update(struct mctp *m, unsigned ppid, __u8 *payload)
 			struct fmapi_mcc_alloc_get_rsp *o = &msg.obj.mcc_alloc_get_rsp;
 
 			mld->granularity 	= o->granularity;
-			for ( int i = 0 ; i < o->num ; i++ ) 
+			for ( int i = 0 ; i < o->num && i+o->start < (int) JKLN_LDS(mld->rng1) ; i++ ) 
 			{
 				mld->rng1[i+o->start] = o->list[i].rng1;
 				mld->rng2[i+o->start] = o->list[i].rng2;
@@ -560,7 +582,7 @@ int cci_update(struct mctp *m, unsigned ppid, __u8 *payload)
 		{			
 			struct fmapi_mcc_alloc_set_rsp *o = &msg.obj.mcc_alloc_set_rsp;
 
-			for ( int i = 0 ; i < o->num ; i++) 
+			for ( int i = 0 ; i < o->num && i+o->start < (int) JKLN_LDS(mld->rng1) ; i++) 
 			{
 				mld->rng1[i+o->start] = o->list[i].rng1;
 				mld->rng2[i+o->start] = o->list[i].rng2;
@@ -595,7 +617,7 @@ int cci_update(struct mctp *m, unsigned ppid, __u8 *payload)
 		{			
 			struct fmapi_mcc_qos_bw_alloc *o = &msg.obj.mcc_qos_bw_alloc;
 
-			for ( int i = 0 ; i < o->num ; i++ )
+			for ( int i = 0 ; i < o->num && i+o->start < (int) JKLN_LDS(mld->alloc_bw) ; i++ )
 				mld->alloc_bw[i+o->start] = o->list[i];
 		}
 			break;
@@ -605,7 +627,7 @@ int cci_update(struct mctp *m, unsigned ppid, __u8 *payload)
 		{			
 			struct fmapi_mcc_qos_bw_limit *o = &msg.obj.mcc_qos_bw_limit;
 
-			for ( int i = 0 ; i < o->num ; i++ )
+			for ( int i = 0 ; i < o->num && i+o->start < (int) JKLN_LDS(mld->bw_limit) ; i++ )
 				mld->bw_limit[i+o->start] = o->list[i];
 		}
 			break;
@@ -613,6 +635,8 @@ int cci_update(struct mctp *m, unsigned ppid, __u8 *payload)
 		default: rv = 1; break;
 	}
 
+	snapshot_touch(JKSN_MLDS);
+
 	rv = 0;
 
 end:
@@ -623,74 +647,25 @@ end:
 }
 
 /**
- * Handle Responses to FM API Messages
+ * Print an FM API Response object
  *
- * @return 0 upon success. Non zero otherwise.
+ * Tunneled responses (FMOP_MPC_TMC) are printed with cci_print()
  *
- * STEPS:
- * 1: Set buffer pointers 
- * 2: Deserialize Request Header
- * 3: Deserialize Request Object 
- * 4: Deserialize Response Header
- * 5: Verify Response 
- * 6: Deserialize Response Payload using object from request
- * 7: Handle opcode 
+ * @param msg 	struct fmapi_msg* with a deserialized header and object
+ * @return 		0 upon success. Non zero if the opcode is not supported
  */
-int fmapi_handler(struct mctp *m, struct mctp_msg *mr, struct mctp_msg *mm)
+int fmapi_print(struct fmapi_msg *msg)
 {
-	INIT 
-	int rv; 
-	struct fmapi_msg req, rsp;
-
-	ENTER 
-
-	// Initialize varialbes
-	rv = 1;
-
-	STEP // 1: Set buffer pointers 
-	req.buf = (struct fmapi_buf*) mm->payload;
-	rsp.buf = (struct fmapi_buf*) mr->payload;
-	
-	STEP // 2: Deserialize Request Header
-	fmapi_deserialize(&req.hdr, req.buf->hdr, FMOB_HDR, NULL);
-
-	STEP // 3: Deserialize Request Object 
-	fmapi_deserialize(&req.obj, req.buf->payload, fmapi_fmob_req(req.hdr.opcode), NULL);
-
-	STEP // 4: Deserialize Response Header
-	fmapi_deserialize(&rsp.hdr, rsp.buf->hdr, FMOB_HDR, NULL);
-
-	STEP // 5: Verify Response 
-
-	// Verify msg category 
-	if (rsp.hdr.category != FMMT_RESP) 
-	{
-		printf("Error: Received an FM API message that was not a response: %s\n", fmmt(rsp.hdr.category));
-		goto end;
-	}
-	
-	// Verify return code
-	if (rsp.hdr.return_code != FMRC_SUCCESS && rsp.hdr.return_code != FMRC_BACKGROUND_OP_STARTED) 
-	{
-		printf("Error: %s\n", fmrc(rsp.hdr.return_code));
-		rv = rsp.hdr.return_code;
-		goto end;
-	}
-
-	STEP // 6: Deserialize Response Payload using object from request
-	fmapi_deserialize(&rsp.obj, rsp.buf->payload, fmapi_fmob_rsp(rsp.hdr.opcode), &req.obj);
-
-	STEP // 7: Handle opcode 
-	switch(rsp.hdr.opcode)
+	switch(msg->hdr.opcode)
 	{
 		case FMOP_ISC_BOS:
 	 	{
-			struct fmapi_isc_bos *o = &rsp.obj.isc_bos;
+			struct fmapi_isc_bos *o = &msg->obj.isc_bos;
 
 			printf("Show Background Operation Status:\n");
 			printf("Background Op. Running:   %d\n",          o->running);
 			printf("Percent Complete:         %d%%\n",        o->pcnt);
-			printf("Command Opcode:           0x%04x - %s\n", o->opcode, fmop(rsp.hdr.opcode));
+			printf("Command Opcode:           0x%04x - %s\n", o->opcode, fmop(msg->hdr.opcode));
 			printf("Return Code:              0x%04x - %s\n", o->rc, fmrc(o->rc));
 			printf("Vendor Specific Status:   0x%04x\n",      o->ext);
 		}
@@ -698,7 +673,7 @@ int fmapi_handler(struct mctp *m, struct mctp_msg *mr, struct mctp_msg *mm)
 
 		case FMOP_ISC_ID:
 		{
-			struct fmapi_isc_id_rsp *o = &rsp.obj.isc_id_rsp;
+			struct fmapi_isc_id_rsp *o = &msg->obj.isc_id_rsp;
 
 			printf("Show Identity:\n");
 			printf("PCIe Vendor ID:           0x%04x\n", 	o->vid);
@@ -713,7 +688,7 @@ int fmapi_handler(struct mctp *m, struct mctp_msg *mr, struct mctp_msg *mm)
 		case FMOP_ISC_MSG_LIMIT_GET:
 		case FMOP_ISC_MSG_LIMIT_SET:
 		{
-			struct fmapi_isc_msg_limit *o = &rsp.obj.isc_msg_limit;
+			struct fmapi_isc_msg_limit *o = &msg->obj.isc_msg_limit;
 
 			printf("Response Msg Limit (n of 2^n):  %d - %d B\n", o->limit, 1 << o->limit);
 		}
@@ -721,7 +696,7 @@ int fmapi_handler(struct mctp *m, struct mctp_msg *mr, struct mctp_msg *mm)
 
 		case FMOP_PSC_ID:
 		{	
-			struct fmapi_psc_id_rsp *o = &rsp.obj.psc_id_rsp;
+			struct fmapi_psc_id_rsp *o = &msg->obj.psc_id_rsp;
 			int active_ports, active_vcss;
 
 			// Count number of active ports
@@ -752,7 +727,7 @@ int fmapi_handler(struct mctp *m, struct mctp_msg *mr, struct mctp_msg *mm)
 
 		case FMOP_PSC_PORT:
 		{
-			struct fmapi_psc_port_rsp *o = &rsp.obj.psc_port_rsp;
+			struct fmapi_psc_port_rsp *o = &msg->obj.psc_port_rsp;
 			print_ports(o);
 		}
 			break;
@@ -765,14 +740,14 @@ int fmapi_handler(struct mctp *m, struct mctp_msg *mr, struct mctp_msg *mm)
 
 		case FMOP_PSC_CFG:
 		{
-			struct fmapi_psc_cfg_rsp *o = &rsp.obj.psc_cfg_rsp;
+			struct fmapi_psc_cfg_rsp *o = &msg->obj.psc_cfg_rsp;
 			printf("Data: 0x%02x%02x%02x%02x\n", o->data[3], o->data[2], o->data[1], o->data[0]);
 		}
 			break;
 
 		case FMOP_VSC_INFO:
 		{
-			struct fmapi_vsc_info_rsp *o = &rsp.obj.vsc_info_rsp;
+			struct fmapi_vsc_info_rsp *o = &msg->obj.vsc_info_rsp;
 			struct fmapi_vsc_info_blk *v;
 			struct fmapi_vsc_ppb_stat_blk *b;
 			int i, k;
@@ -834,7 +809,7 @@ int fmapi_handler(struct mctp *m, struct mctp_msg *mr, struct mctp_msg *mm)
 
 		case FMOP_VSC_BIND:
 		{
-			if (rsp.hdr.return_code == FMRC_BACKGROUND_OP_STARTED) 
+			if (msg->hdr.return_code == FMRC_BACKGROUND_OP_STARTED) 
 			{
 				//printf("Bind operation started in the background\n");
 			}
@@ -843,7 +818,7 @@ int fmapi_handler(struct mctp *m, struct mctp_msg *mr, struct mctp_msg *mm)
 
 		case FMOP_VSC_UNBIND:
 		{
-			if (rsp.hdr.return_code == FMRC_BACKGROUND_OP_STARTED) 
+			if (msg->hdr.return_code == FMRC_BACKGROUND_OP_STARTED) 
 			{
 				//printf("Unbind operation started in the background\n");
 			}
@@ -853,39 +828,100 @@ int fmapi_handler(struct mctp *m, struct mctp_msg *mr, struct mctp_msg *mm)
 		case FMOP_VSC_AER:
 			break;
 
-		case FMOP_MPC_TMC:
-		{
-			struct fmapi_mpc_tmc_rsp *o = &rsp.obj.mpc_tmc_rsp;
-
-			if (o->type != MCMT_CXLCCI)
-			{
-				printf("Error: Tunneled command had incorrect MCTP Message Type: 0x%02x\n", o->type);
-				goto end;
-			}
-
-			rv = cci_handler(m, o->msg);	
-		}
-			break;
-
 		case FMOP_MPC_CFG:
 		{
-			struct fmapi_mpc_cfg_rsp *o = &rsp.obj.mpc_cfg_rsp;
+			struct fmapi_mpc_cfg_rsp *o = &msg->obj.mpc_cfg_rsp;
 			printf("Data: 0x%02x%02x%02x%02x\n", o->data[0], o->data[1], o->data[2], o->data[3]);
 		}
 			break;
 
 		case FMOP_MPC_MEM:
 		{
-			struct fmapi_mpc_mem_rsp *o = &rsp.obj.mpc_mem_rsp;
+			struct fmapi_mpc_mem_rsp *o = &msg->obj.mpc_mem_rsp;
 			autl_prnt_buf(o->data, o->len, 4, 0);
 		}
 			break;
 
 		default: 
-			goto end;
+			return 1;
 	}
 
-	rv = 0;
+	return 0;
+}
+
+/**
+ * Handle Responses to FM API Messages
+ *
+ * @return 0 upon success. Non zero otherwise.
+ *
+ * STEPS:
+ * 1: Set buffer pointers 
+ * 2: Deserialize Request Header
+ * 3: Deserialize Request Object 
+ * 4: Deserialize Response Header
+ * 5: Verify Response 
+ * 6: Deserialize Response Payload using object from request
+ * 7: Handle opcode 
+ */
+int fmapi_handler(struct mctp *m, struct mctp_msg *mr, struct mctp_msg *mm)
+{
+	INIT 
+	int rv; 
+	struct fmapi_msg req, rsp;
+
+	ENTER 
+
+	// Initialize varialbes
+	rv = 1;
+
+	STEP // 1: Set buffer pointers 
+	req.buf = (struct fmapi_buf*) mm->payload;
+	rsp.buf = (struct fmapi_buf*) mr->payload;
+	
+	STEP // 2: Deserialize Request Header
+	fmapi_deserialize(&req.hdr, req.buf->hdr, FMOB_HDR, NULL);
+
+	STEP // 3: Deserialize Request Object 
+	fmapi_deserialize(&req.obj, req.buf->payload, fmapi_fmob_req(req.hdr.opcode), NULL);
+
+	STEP // 4: Deserialize Response Header
+	fmapi_deserialize(&rsp.hdr, rsp.buf->hdr, FMOB_HDR, NULL);
+
+	STEP // 5: Verify Response 
+
+	// Verify msg category 
+	if (rsp.hdr.category != FMMT_RESP) 
+	{
+		printf("Error: Received an FM API message that was not a response: %s\n", fmmt(rsp.hdr.category));
+		goto end;
+	}
+	
+	// Verify return code
+	if (rsp.hdr.return_code != FMRC_SUCCESS && rsp.hdr.return_code != FMRC_BACKGROUND_OP_STARTED) 
+	{
+		printf("Error: %s\n", fmrc(rsp.hdr.return_code));
+		rv = rsp.hdr.return_code;
+		goto end;
+	}
+
+	STEP // 6: Deserialize Response Payload using object from request
+	fmapi_deserialize(&rsp.obj, rsp.buf->payload, fmapi_fmob_rsp(rsp.hdr.opcode), &req.obj);
+
+	STEP // 7: Handle opcode 
+	if (rsp.hdr.opcode == FMOP_MPC_TMC)
+	{
+		struct fmapi_mpc_tmc_rsp *o = &rsp.obj.mpc_tmc_rsp;
+
+		if (o->type != MCMT_CXLCCI)
+		{
+			printf("Error: Tunneled command had incorrect MCTP Message Type: 0x%02x\n", o->type);
+			goto end;
+		}
+
+		rv = cci_handler(m, o->msg);	
+	}
+	else 
+		rv = fmapi_print(&rsp);
 
 end:
 
@@ -898,7 +934,99 @@ end:
 }
 
 /**
- * Update cached switch state from Responses to FM API Messages
+ * Size the cached switch state for the number of ports and VCSs it reports
+ *
+ * Must be called with s->mtx held. The state of ports and VCSs that exist 
+ * both before and after is kept. Config space of a port is only allocated 
+ * once the port is present, so the new ports start without one. The vPPBs 
+ * of a VCS never exceed vppbs
+ *
+ * @param s 	struct cxl_switch* cache to size
+ * @param ports Number of physical ports
+ * @param vcss 	Number of VCSs
+ * @param vppbs Number of vPPBs
+ * @return 		0 upon success. Non zero otherwise
+ */
+int fmapi_resize(struct cxl_switch *s, unsigned ports, unsigned vcss, unsigned vppbs)
+{
+	struct cxl_switch *n;
+	struct cxl_port port, *p;
+	struct cxl_vcs vcs, *v;
+	struct cxl_vppb *b;
+	unsigned i, kept, num;
+
+	if (ports == s->num_ports && vcss == s->num_vcss && vppbs == s->num_vppbs)
+		return 0;
+
+	// Let the library allocate the arrays so cxls_free() can release them 
+	n = cxls_init(ports, vcss, vppbs);
+	if (n == NULL)
+		return 1;
+
+	// Move the kept entries into the new arrays and the unused new entries
+	// into the old ones, which are then freed with the temporary switch 
+	kept = ports < s->num_ports ? ports : s->num_ports;
+	for ( i = 0 ; i < kept ; i++ )
+	{
+		port 			= n->ports[i];
+		n->ports[i] 	= s->ports[i];
+		s->ports[i] 	= port;
+	}
+
+	for ( i = kept ; i < ports ; i++ )
+	{
+		free(n->ports[i].cfgspace);
+		n->ports[i].cfgspace = NULL;
+	}
+
+	// The vPPB arrays of the new entries are sized for vppbs, so a kept VCS
+	// takes the new array and its vPPBs are copied into it
+	kept = vcss < s->num_vcss ? vcss : s->num_vcss;
+	num = vppbs < s->num_vppbs ? vppbs : s->num_vppbs;
+	for ( i = 0 ; i < kept ; i++ )
+	{
+		b 					= n->vcss[i].vppbs;
+		memcpy(b, s->vcss[i].vppbs, num * sizeof(struct cxl_vppb));
+		n->vcss[i].vppbs 	= s->vcss[i].vppbs;
+		s->vcss[i].vppbs 	= b;
+
+		vcs 			= n->vcss[i];
+		n->vcss[i] 		= s->vcss[i];
+		s->vcss[i] 		= vcs;
+
+		if (n->vcss[i].num > vppbs)
+			n->vcss[i].num = vppbs;
+	}
+
+	p 					= s->ports;
+	v 					= s->vcss;
+	s->ports 			= n->ports;
+	s->vcss 			= n->vcss;
+	n->ports 			= p;
+	n->vcss 			= v;
+
+	n->num_ports 		= s->num_ports;
+	n->num_vcss 		= s->num_vcss;
+	n->num_vppbs 		= s->num_vppbs;
+	s->num_ports 		= ports;
+	s->num_vcss 		= vcss;
+	s->num_vppbs 		= vppbs;
+
+	cxls_free(n);
+
+	cfgdump_reset(ports);
+
+	return binding_rebuild(s);
+}
+
+/**
+ * Apply a Response to an FM API Message to the cached switch state
+ *
+ * Read responses copy the returned state into the cache. Successful writes 
+ * (bind, unbind, port control and config writes) update the cached entries 
+ * they changed from the request so the cache stays correct without 
+ * rediscovery. Use fmapi_refresh() to obtain requests that read back the 
+ * entries whose final state is only known to the switch
  *
  * @return 0 upon success. Non zero otherwise.
  *
@@ -909,9 +1037,11 @@ end:
  * 4: Deserialize Response Header
  * 5: Verify Response 
  * 6: Deserialize Response Payload using object from request
- * 7: Handle opcode 
+ * 7: Obtain lock on switch state 
+ * 8: Handle opcode 
+ * 9: Release lock on switch state 
  */
-int fmapi_update(struct mctp *m, struct mctp_action *ma)
+int fmapi_apply(struct mctp *m, struct mctp_action *ma)
 {
 	INIT 
 	int rv; 
@@ -955,10 +1085,10 @@ int fmapi_update(struct mctp *m, struct mctp_action *ma)
 	STEP // 6: Deserialize Response Payload using object from request
 	fmapi_deserialize(&rsp.obj, rsp.buf->payload, fmapi_fmob_rsp(rsp.hdr.opcode), &req.obj);
 
-	STEP // 8: Obtain lock on switch state 
+	STEP // 7: Obtain lock on switch state 
 	pthread_mutex_lock(&cxls->mtx);
 
-	STEP // 7: Handle opcode 
+	STEP // 8: Handle opcode 
 	switch(rsp.hdr.opcode)
 	{
 		case FMOP_ISC_BOS:
@@ -969,6 +1099,7 @@ int fmapi_update(struct mctp *m, struct mctp_action *ma)
 			cxls->bos_running   = o->running;
 			cxls->bos_pcnt 		= o->pcnt;
 			cxls->bos_ext 		= o->ext;
+			snapshot_touch(JKSN_SWITCH);
 		}
 			break;
 
@@ -981,6 +1112,7 @@ int fmapi_update(struct mctp *m, struct mctp_action *ma)
 			cxls->ssid 				= o->ssid;
 			cxls->sn 				= o->sn;
 			cxls->max_msg_size_n 	= o->size;
+			snapshot_touch(JKSN_SWITCH);
 		}
 			break;
 
@@ -989,18 +1121,22 @@ int fmapi_update(struct mctp *m, struct mctp_action *ma)
 		{
 			struct fmapi_isc_msg_limit *o = &rsp.obj.isc_msg_limit;
 			cxls->msg_rsp_limit_n = o->limit;
+			snapshot_touch(JKSN_SWITCH);
 		}
 			break;
 
 		case FMOP_PSC_ID:
 		{	
 			struct fmapi_psc_id_rsp *o = &rsp.obj.psc_id_rsp;
+			if (fmapi_resize(cxls, o->num_ports, o->num_vcss, o->num_vppbs))
+			{
+				printf("Error: Could not allocate state for %u ports\n", o->num_ports);
+				break;
+			}
 			cxls->ingress_port 	= o->ingress_port;
-			cxls->num_ports 	= o->num_ports;
-			cxls->num_vcss 		= o->num_vcss;
-			cxls->num_vppbs 	= o->num_vppbs;
 			cxls->active_vppbs 	= o->active_vppbs;
 			cxls->num_decoders 	= o->num_decoders;
+			snapshot_touch(JKSN_SWITCH);
 		}
 			break;
 
@@ -1013,6 +1149,9 @@ int fmapi_update(struct mctp *m, struct mctp_action *ma)
 			for ( int i = 0 ; i < o->num ; i++ )
 			{
 				x = &o->list[i];
+				if (x->ppid >= cxls->num_ports)
+					continue;
+
 				p = &cxls->ports[x->ppid];
 				p->state		= x->state;
     			p->dv			= x->dv;
@@ -1030,67 +1169,135 @@ int fmapi_update(struct mctp *m, struct mctp_action *ma)
 				p->prsnt		= x->prsnt;
 				p->pwrctrl		= x->pwrctrl;
     			p->ld			= x->num_ld;
+
+				// Config space is allocated once a device is present 
+				if (p->prsnt && p->cfgspace == NULL)
+					p->cfgspace = calloc(1, PCLN_CFG);
 			}
+			snapshot_touch(JKSN_PORTS);
 		}
 			break;
 
 		case FMOP_PSC_PORT_CTRL:
+		{
+			struct fmapi_psc_port_ctrl_req *o = &req.obj.psc_port_ctrl_req;
+
+			if (o->ppid >= cxls->num_ports)
+				break;
+
+			// A PPB reset changes link state the switch must be asked for
+			if (o->opcode == FMPO_ASSERT_PERST)
+				cxls->ports[o->ppid].perst = 1;
+			else if (o->opcode == FMPO_DEASSERT_PERST)
+				cxls->ports[o->ppid].perst = 0;
+			snapshot_touch(JKSN_PORTS);
+		}
 			break;
 
 		case FMOP_PSC_CFG:
 		{
+			struct fmapi_psc_cfg_req *q = &req.obj.psc_cfg_req;
 			struct fmapi_psc_cfg_rsp *o = &rsp.obj.psc_cfg_rsp;
-
-			if (req.obj.psc_cfg_req.type == FMCT_READ )
-			{
-				struct cxl_port *p = &cxls->ports[req.obj.psc_cfg_req.ppid];
-				unsigned reg = (req.obj.psc_cfg_req.ext << 8) | req.obj.psc_cfg_req.reg;
-
-				if (req.obj.psc_cfg_req.fdbe & 0x01)
-					p->cfgspace[reg] = o->data[0];
-				if (req.obj.psc_cfg_req.fdbe & 0x02)
-					p->cfgspace[reg] = o->data[1];
-				if (req.obj.psc_cfg_req.fdbe & 0x04)
-					p->cfgspace[reg] = o->data[2];
-				if (req.obj.psc_cfg_req.fdbe & 0x08)
-					p->cfgspace[reg] = o->data[3];
-			}
+			struct cxl_port *p;
+			unsigned reg;
+			__u8 *data;
+
+			if (q->ppid >= cxls->num_ports)
+				break;
+
+			p = &cxls->ports[q->ppid];
+			if (p->cfgspace == NULL)
+				p->cfgspace = calloc(1, PCLN_CFG);
+			if (p->cfgspace == NULL)
+				break;
+			reg = (q->ext << 8) | q->reg;
+			data = (q->type == FMCT_READ) ? o->data : q->data;
+
+			// Update only the enabled bytes of the dword
+			for ( int n = 0 ; n < 4 ; n++ )
+				if ((q->fdbe >> n) & 0x01 && reg + n < PCLN_CFG)
+					p->cfgspace[reg + n] = data[n];
+
+			// A written value may not read back the same
+			cfgdump_mark(q->ppid, -1, reg, q->type == FMCT_READ && q->fdbe == 0xF && (reg & 3) == 0);
+			snapshot_touch(JKSN_CFGSPACE);
 		}
 			break;
 
 		case FMOP_VSC_INFO:
 		{
+			struct fmapi_vsc_info_req *q = &req.obj.vsc_info_req;
 			struct fmapi_vsc_info_rsp *o = &rsp.obj.vsc_info_rsp;
 			struct cxl_vcs *v;
 			struct fmapi_vsc_info_blk *x;
 			struct fmapi_vsc_ppb_stat_blk *b;
-			int i, k;
+			int i, k, n;
 
 			for ( i = 0 ; i < o->num ; i++ ) 
 			{
 				x = &o->list[i];
+				if (x->vcsid >= cxls->num_vcss)
+					continue;
+
 				v = &cxls->vcss[x->vcsid];
 
 				v->vcsid = x->vcsid;
 				v->state = x->state;
 				v->uspid = x->uspid;
-				v->num   = x->num;
+				v->num   = x->num < cxls->num_vppbs ? x->num : cxls->num_vppbs;
 
-				for ( k = 0 ; k < v->num ; k++)
+				// The list holds the vPPBs from the requested start vPPB
+				n = x->num - q->vppbid_start;
+				if (n > q->vppbid_limit)
+					n = q->vppbid_limit;
+
+				for ( k = 0 ; k < n ; k++)
 				{
 					b = &x->list[k];
-					v->vppbs[k].bind_status = b->status;
-					v->vppbs[k].ppid 		= b->ppid;
-					v->vppbs[k].ldid 		= b->ldid;
+					binding_update(v, q->vppbid_start + k, b->status, b->ppid, b->ldid);
 				}
 			}
+			snapshot_touch(JKSN_VCSS);
 		}
 			break;
 
 		case FMOP_VSC_BIND:
+		{
+			struct fmapi_vsc_bind_req *q = &req.obj.vsc_bind_req;
+			int status;
+
+			if (q->vcsid >= cxls->num_vcss || q->vppbid >= cxls->vcss[q->vcsid].num)
+				break;
+
+			if (rsp.hdr.return_code == FMRC_BACKGROUND_OP_STARTED)
+				status = FMBS_INPROGRESS;
+			else if (q->ldid == 0xFFFF)
+				status = FMBS_BOUND_PORT;
+			else
+				status = FMBS_BOUND_LD;
+			binding_update(&cxls->vcss[q->vcsid], q->vppbid, status, q->ppid, q->ldid);
+			snapshot_touch(JKSN_VCSS);
+		}
 			break;
 
 		case FMOP_VSC_UNBIND:
+		{
+			struct fmapi_vsc_unbind_req *q = &req.obj.vsc_unbind_req;
+			struct cxl_vppb *b;
+			int status;
+
+			if (q->vcsid >= cxls->num_vcss || q->vppbid >= cxls->vcss[q->vcsid].num)
+				break;
+
+			// Keep the ppid so the unbound port can be refreshed
+			b = &cxls->vcss[q->vcsid].vppbs[q->vppbid];
+			if (rsp.hdr.return_code == FMRC_BACKGROUND_OP_STARTED)
+				status = FMBS_INPROGRESS;
+			else
+				status = FMBS_UNBOUND;
+			binding_update(&cxls->vcss[q->vcsid], q->vppbid, status, b->ppid, b->ldid);
+			snapshot_touch(JKSN_VCSS);
+		}
 			break;
 
 		case FMOP_VSC_AER:
@@ -1103,33 +1310,45 @@ int fmapi_update(struct mctp *m, struct mctp_action *ma)
 			if (o->type != MCMT_CXLCCI)
 			{
 				printf("Error: Tunneled command had incorrect MCTP Message Type: 0x%02x\n", o->type);
-				goto end;
+				goto unlock;
 			}
 
+			if (req.obj.mpc_tmc_req.ppid >= cxls->num_ports)
+				goto unlock;
+
 			rv = cci_update(m, req.obj.mpc_tmc_req.ppid, o->msg);	
+			goto unlock;
 		}
 			break;
 
 		case FMOP_MPC_CFG:
 		{
+			struct fmapi_mpc_cfg_req *q = &req.obj.mpc_cfg_req;
 			struct fmapi_mpc_cfg_rsp *o = &rsp.obj.mpc_cfg_rsp;
-
-			if (req.obj.mpc_cfg_req.type == FMCT_READ )
-			{
-				struct cxl_port *p = &cxls->ports[req.obj.mpc_cfg_req.ppid];
-				struct cxl_mld *m = p->mld;
-				unsigned ldid = req.obj.mpc_cfg_req.ldid;
-				unsigned reg = (req.obj.mpc_cfg_req.ext << 8) | req.obj.mpc_cfg_req.reg;
-
-				if (req.obj.mpc_cfg_req.fdbe & 0x01)
-					m->cfgspace[ldid][reg] = o->data[0];
-				if (req.obj.mpc_cfg_req.fdbe & 0x02)
-					m->cfgspace[ldid][reg] = o->data[1];
-				if (req.obj.mpc_cfg_req.fdbe & 0x04)
-					m->cfgspace[ldid][reg] = o->data[2];
-				if (req.obj.mpc_cfg_req.fdbe & 0x08)
-					m->cfgspace[ldid][reg] = o->data[3];
-			}
+			struct cxl_mld *mld;
+			unsigned reg;
+			__u8 *data;
+
+			if (q->ppid >= cxls->num_ports)
+				break;
+
+			mld = cxls->ports[q->ppid].mld;
+			if (mld == NULL || q->ldid >= mld->num || q->ldid >= JKLN_LDS(mld->cfgspace))
+				break;
+			if (mld->cfgspace[q->ldid] == NULL)
+				break;
+
+			reg = (q->ext << 8) | q->reg;
+			data = (q->type == FMCT_READ) ? o->data : q->data;
+
+			// Update only the enabled bytes of the dword
+			for ( int n = 0 ; n < 4 ; n++ )
+				if ((q->fdbe >> n) & 0x01 && reg + n < PCLN_CFG)
+					mld->cfgspace[q->ldid][reg + n] = data[n];
+
+			// A written value may not read back the same
+			cfgdump_mark(q->ppid, q->ldid, reg, q->type == FMCT_READ && q->fdbe == 0xF && (reg & 3) == 0);
+			snapshot_touch(JKSN_CFGSPACE);
 		}
 			break;
 
@@ -1137,21 +1356,107 @@ int fmapi_update(struct mctp *m, struct mctp_action *ma)
 			break;
 
 		default: 
-			goto end;
+			goto unlock;
 	}
 
+	// Let lock free readers see the change 
+	view_publish(cxls);
+
 	rv = 0;
 
-end:
+unlock:
 
-	STEP // Release lock on switch state 
+	STEP // 9: Release lock on switch state 
 	pthread_mutex_unlock(&cxls->mtx);
 
-	// Return mctp_msg to free pool
-	mctp_retire(m, ma);
+end:
 
 	EXIT(rv)
 
 	return rv;
 }
 
+/**
+ * Update cached switch state from Responses to FM API Messages
+ *
+ * Used as the completion function of asynchronous requests. The action is 
+ * returned to the free pool
+ *
+ * @return 0 upon success. Non zero otherwise.
+ */
+int fmapi_update(struct mctp *m, struct mctp_action *ma)
+{
+	int rv;
+
+	rv = fmapi_apply(m, ma);
+
+	// Return mctp_msg to free pool
+	mctp_retire(m, ma);
+
+	return rv;
+}
+
+/**
+ * Prepare requests that read back the cached entries changed by a request
+ *
+ * A bind or unbind changes one vPPB and the state of the physical port 
+ * behind it. A port control request changes the link state of one port. 
+ * The requests read back only those entries
+ *
+ * @param ma 	struct mctp_action* of a completed FM API request
+ * @param list 	Array of struct fmapi_msg to fill with read requests
+ * @param max 	Number of entries in list
+ * @return 		Number of requests filled in list
+ */
+int fmapi_refresh(struct mctp_action *ma, struct fmapi_msg *list, int max)
+{
+	struct fmapi_msg req;
+	int n, ppid;
+
+	n = 0;
+	ppid = -1;
+
+	req.buf = (struct fmapi_buf*) ma->req->payload;
+	fmapi_deserialize(&req.hdr, req.buf->hdr, FMOB_HDR, NULL);
+	fmapi_deserialize(&req.obj, req.buf->payload, fmapi_fmob_req(req.hdr.opcode), NULL);
+
+	switch (req.hdr.opcode)
+	{
+		case FMOP_VSC_BIND:
+		{
+			struct fmapi_vsc_bind_req *q = &req.obj.vsc_bind_req;
+
+			if (n < max)
+				fmapi_fill_vsc_get_vcs(&list[n++], q->vcsid, q->vppbid, 1);
+			ppid = q->ppid;
+		}
+			break;
+
+		case FMOP_VSC_UNBIND:
+		{
+			struct fmapi_vsc_unbind_req *q = &req.obj.vsc_unbind_req;
+
+			if (n < max)
+				fmapi_fill_vsc_get_vcs(&list[n++], q->vcsid, q->vppbid, 1);
+
+			// Port that was bound to the vPPB 
+			pthread_mutex_lock(&cxls->mtx);
+			if (q->vcsid < cxls->num_vcss && q->vppbid < cxls->vcss[q->vcsid].num)
+				ppid = cxls->vcss[q->vcsid].vppbs[q->vppbid].ppid;
+			pthread_mutex_unlock(&cxls->mtx);
+		}
+			break;
+
+		case FMOP_PSC_PORT_CTRL:
+			ppid = req.obj.psc_port_ctrl_req.ppid;
+			break;
+
+		default:
+			break;
+	}
+
+	if (ppid >= 0 && n < max)
+		fmapi_fill_psc_get_port(&list[n++], ppid);
+
+	return n;
+}
@@ -20,6 +20,14 @@
  */
 #include <mctp.h>
 
+/* struct fmapi_msg
+ */
+#include <fmapi.h>
+
+/* struct cxl_switch
+ */
+#include <cxlstate.h>
+
 /* MACROS ====================================================================*/
 
 /* ENUMERATIONS ==============================================================*/
@@ -30,6 +38,11 @@
 
 int fmapi_handler(struct mctp *m, struct mctp_msg *mm, struct mctp_msg *req);
 int fmapi_update(struct mctp *m, struct mctp_action *ma);
+int fmapi_apply(struct mctp *m, struct mctp_action *ma);
+int fmapi_refresh(struct mctp_action *ma, struct fmapi_msg *list, int max);
+int fmapi_resize(struct cxl_switch *s, unsigned ports, unsigned vcss, unsigned vppbs);
+int fmapi_print(struct fmapi_msg *msg);
+int cci_print(struct fmapi_msg *msg);
 
 /* GLOBAL VARIABLES ==========================================================*/
 
@@ -0,0 +1,1284 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		ldmem.c
+ *
+ * @brief 		Code file for chunked, pipelined LD memory transfers
+ *
+ * A transfer is split into chunks that fit in one FM API message as sized by
+ * the negotiated message limits of the switch. Up to a window of chunks are
+ * kept in flight. Responses are held in a ring of slots and delivered to the
+ * caller in offset order so the output does not depend on completion order
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* gettid()
+ */
+#define _GNU_SOURCE
+
+/* printf()
+ */
+#include <stdio.h>
+
+/* calloc()
+ * free()
+ */
+#include <stdlib.h>
+
+/* memcpy()
+ * memset()
+ * strerror()
+ */
+#include <string.h>
+
+/* write()
+ * close()
+ * lseek()
+ * ftruncate()
+ */
+#include <unistd.h>
+
+/* open()
+ */
+#include <fcntl.h>
+
+/* mmap()
+ * munmap()
+ * madvise()
+ */
+#include <sys/mman.h>
+
+/* fstat()
+ * mkdir()
+ */
+#include <sys/stat.h>
+
+#include <errno.h>
+
+/* pthread_mutex_t
+ * pthread_cond_t
+ */
+#include <pthread.h>
+
+/* clock_gettime()
+ */
+#include <time.h>
+
+/* autl_prnt_buf()
+ */
+#include <arrayutils.h>
+
+#include <fmapi.h>
+#include <emapi.h>
+
+#include "ldmem.h"
+#include "crc32c.h"
+#include "ldsnap.h"
+#include "cmd_encoder.h"
+#include "fmapi_handler.h"
+#include "options.h"
+#include "snapshot.h"
+
+/* MACROS ====================================================================*/
+
+#ifdef JACK_VERBOSE
+ #define INIT 			unsigned step = 0;
+ #define ENTER 					if (m->verbose & MCTP_VERBOSE_THREADS) 	printf("%d:%s Enter\n", 				gettid(), __FUNCTION__);
+ #define STEP 			step++; if (m->verbose & MCTP_VERBOSE_STEPS) 	printf("%d:%s STEP: %u\n", 				gettid(), __FUNCTION__, step);
+ #define EXIT(rc) 				if (m->verbose & MCTP_VERBOSE_THREADS)	printf("%d:%s Exit: %d\n", 				gettid(), __FUNCTION__,rc);
+#else
+ #define INIT
+ #define ENTER
+ #define STEP
+ #define EXIT(rc)
+#endif
+
+#define LMLN_OUTBUF 		(1 << 20) 	//!< Bytes of binary output buffered per write
+#define LMLN_JOBS 			16 			//!< Max LDs dumped at the same time
+#define LMLN_LDS 			16 			//!< Max LDs per MLD
+#define LMLN_GRANULARITY 	(256ULL << 20) 	//!< Bytes of allocation granularity 0 [FMMG]
+#define LMLN_PATH 			256 		//!< Max length of a dump file name
+#define LMLN_RANGES 		32 			//!< Max mismatching ranges printed by --verify
+
+/* ENUMERATIONS ==============================================================*/
+
+/**
+ * State of a slot of the ring (ST)
+ */
+enum _LMST
+{
+	LMST_FREE 		= 0,
+	LMST_BUSY 		= 1,	//!< Request in flight
+	LMST_DONE 		= 2,	//!< Response received, not yet delivered
+	LMST_FAILED 	= 3,
+	LMST_MAX
+};
+
+/* STRUCTS ===================================================================*/
+
+struct ldmem_ring;
+
+/**
+ * One chunk of a transfer
+ */
+struct ldmem_slot
+{
+	struct ldmem_ring *r;
+	__u64 offset;
+	unsigned len;
+	int state;				//!< [LMST]
+	__u8 *data;
+	struct timespec sent;	//!< Time the request was submitted
+	__u64 ns;				//!< Nanoseconds from submission to response
+};
+
+/**
+ * Slots of the chunks in flight. Shared with the completion functions
+ */
+struct ldmem_ring
+{
+	pthread_mutex_t mtx;
+	pthread_cond_t 	cond;
+	unsigned 		pending;	//!< Slots whose completion function has not run
+	struct ldmem_slot *slots;
+};
+
+/**
+ * Source of the data of a write from the command line
+ */
+struct ldmem_src
+{
+	__u64 base;				//!< Offset of the first byte of the transfer
+	__u8 *buf;
+	__u64 len;
+	__u32 pattern;
+};
+
+/**
+ * Destination of binary read data from the command line
+ *
+ * A sparse sink seeks past all zero chunks instead of writing them so they
+ * become holes in the file, and can list the non-zero extents in a map file
+ */
+struct ldmem_sink
+{
+	int fd;
+	__u8 *buf;
+	size_t used;
+	int sparse;
+	__u64 pos;				//!< Bytes delivered to the sink
+	__u64 hole;				//!< Zero bytes not yet seeked past
+	__u64 written;			//!< Bytes written to the file
+	FILE *map;				//!< Extent map or NULL
+	__u64 ext_off;			//!< Start of the open non-zero extent
+	__u64 ext_len;
+};
+
+/**
+ * Checks of a read from the command line. Nothing is retained but the 
+ * digest and the mismatching range being extended
+ */
+struct ldmem_check
+{
+	__u64 base;				//!< Offset of the first byte of the transfer
+	__u8 *ref;				//!< Mapped --verify file
+	__u64 ref_len;
+	int verify;
+	int checksum;
+	__u32 crc;
+	__u64 bad_off;			//!< Start of the open mismatching range
+	__u64 bad_len;
+	__u64 bad_bytes;
+	unsigned ranges;
+};
+
+/**
+ * Dump of the memory of one LD
+ */
+struct ldmem_job
+{
+	int ppid;
+	int ldid;
+	__u64 len;				//!< Allocated bytes of the LD
+	int rv;
+	__u64 bytes;
+	__u64 written;			//!< Bytes written, less than bytes if sparse
+	unsigned requests;
+	char path[LMLN_PATH];
+};
+
+/**
+ * LD dumps shared by the worker threads
+ */
+struct ldmem_pool
+{
+	struct mctp *m;
+	struct cmd_window *w;
+	pthread_mutex_t mtx;
+	struct ldmem_job *jobs;
+	int num;
+	int next;				//!< Next job to start
+	unsigned chunk;
+	int window;
+};
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Return the number of data bytes of one LD memory request
+ *
+ * The data of a read is carried in the response and the data of a write in
+ * the request, so the smaller of the two negotiated limits is used
+ *
+ * @param s 	struct cxl_switch* holding the negotiated limits
+ * @return 		Multiple of 4 bytes, at most CLMR_MAX_LD_MEM_LEN
+ */
+unsigned ldmem_chunk(struct cxl_switch *s)
+{
+	unsigned n, len;
+
+	n = s->msg_rsp_limit_n;
+	if (s->max_msg_size_n != 0 && (n == 0 || s->max_msg_size_n < n))
+		n = s->max_msg_size_n;
+
+	// No limit was negotiated
+	if (n == 0)
+		return CLMR_MAX_LD_MEM_LEN;
+
+	len = (1u << n) > 2 * LMLN_OVERHEAD ? (1u << n) - LMLN_OVERHEAD : LMLN_OVERHEAD;
+	if (len > CLMR_MAX_LD_MEM_LEN)
+		len = CLMR_MAX_LD_MEM_LEN;
+
+	return len & ~3u;
+}
+
+/**
+ * Mark a slot as finished and wake up the submitting thread
+ */
+static void slot_finish(struct ldmem_slot *s, int state)
+{
+	struct ldmem_ring *r = s->r;
+
+	pthread_mutex_lock(&r->mtx);
+	s->state = state;
+	r->pending--;
+	pthread_cond_broadcast(&r->cond);
+	pthread_mutex_unlock(&r->mtx);
+}
+
+/**
+ * fn_completed of a chunk. Called from an MCTP thread
+ *
+ * Copies the data of a read into the slot of the chunk
+ */
+static void mem_completed(struct mctp *m, struct mctp_action *ma)
+{
+	struct ldmem_slot *s = ma->user_data;
+	struct fmapi_msg req, rsp;
+	struct timespec now;
+	int state;
+
+	state = LMST_FAILED;
+
+	req.buf = (struct fmapi_buf*) ma->req->payload;
+	rsp.buf = (struct fmapi_buf*) ma->rsp->payload;
+
+	fmapi_deserialize(&req.hdr, req.buf->hdr, FMOB_HDR, NULL);
+	fmapi_deserialize(&req.obj, req.buf->payload, fmapi_fmob_req(req.hdr.opcode), NULL);
+	fmapi_deserialize(&rsp.hdr, rsp.buf->hdr, FMOB_HDR, NULL);
+
+	if (rsp.hdr.category != FMMT_RESP || rsp.hdr.return_code != FMRC_SUCCESS)
+	{
+		fprintf(stderr, "Error: LD mem offset 0x%llx: %s\n", s->offset, fmrc(rsp.hdr.return_code));
+		goto end;
+	}
+
+	fmapi_deserialize(&rsp.obj, rsp.buf->payload, fmapi_fmob_rsp(rsp.hdr.opcode), &req.obj);
+
+	if (req.obj.mpc_mem_req.type == FMCT_READ)
+	{
+		if (rsp.obj.mpc_mem_rsp.len < s->len)
+		{
+			fprintf(stderr, "Error: LD mem offset 0x%llx: Short read of %u bytes\n", s->offset, rsp.obj.mpc_mem_rsp.len);
+			goto end;
+		}
+		memcpy(s->data, rsp.obj.mpc_mem_rsp.data, s->len);
+	}
+
+	state = LMST_DONE;
+
+end:
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	s->ns = (now.tv_sec - s->sent.tv_sec) * 1000000000ULL + now.tv_nsec - s->sent.tv_nsec;
+
+	mctp_retire(m, ma);
+	slot_finish(s, state);
+}
+
+/**
+ * fn_failed of a chunk. Called from an MCTP thread
+ */
+static void mem_failed(struct mctp *m, struct mctp_action *ma)
+{
+	struct ldmem_slot *s = ma->user_data;
+
+	fprintf(stderr, "Error: LD mem offset 0x%llx: No response\n", s->offset);
+
+	mctp_retire(m, ma);
+	slot_finish(s, LMST_FAILED);
+}
+
+/**
+ * Run a chunked LD memory transfer
+ *
+ * Chunks are submitted while fewer than x->window of them are waiting to be
+ * delivered. The caller thread then waits for the oldest chunk, passes it to
+ * x->fn and reuses its slot. The byte enables of the caller apply to the
+ * first and last DWord of the whole transfer. Every DWord in between is
+ * fully enabled
+ *
+ * @param x 	struct ldmem_xfer* describing the transfer. The results are
+ * 				stored back into it
+ * @return 		0 upon success. Non zero otherwise
+ */
+int ldmem_run(struct mctp *m, struct ldmem_xfer *x)
+{
+	INIT
+	struct ldmem_ring ring;
+	struct ldmem_slot *s;
+	struct cmd_window own, *w;
+	struct fmapi_msg msg;
+	struct timespec start, stop;
+	__u64 n, sub, del, pos;
+	__u8 *data;
+	int rv, win, i, fdbe, ldbe, halt;
+
+	ENTER
+
+	rv = 1;
+	halt = 0;
+	sub = 0;
+	del = 0;
+	x->bytes = 0;
+	x->requests = 0;
+	x->seconds = 0;
+	x->lat_sum = 0;
+	x->lat_max = 0;
+
+	STEP // 1: Size the transfer
+	if (x->chunk == 0 || x->len == 0)
+		goto end;
+
+	n = (x->len + x->chunk - 1) / x->chunk;
+
+	win = x->window;
+	if (win < 1)
+		win = 1;
+	if (win > JKLN_CMD_WINDOW_MAX)
+		win = JKLN_CMD_WINDOW_MAX;
+	if ((__u64) win > n)
+		win = n;
+	x->window = win;
+
+	STEP // 2: Allocate the ring
+	memset(&ring, 0, sizeof(ring));
+	ring.slots = calloc(win, sizeof(struct ldmem_slot));
+	if (ring.slots == NULL)
+		goto end;
+
+	for ( i = 0 ; i < win ; i++ )
+	{
+		ring.slots[i].r = &ring;
+		ring.slots[i].data = calloc(1, x->chunk);
+		if (ring.slots[i].data == NULL)
+			goto slots;
+	}
+
+	pthread_mutex_init(&ring.mtx, NULL);
+	pthread_cond_init(&ring.cond, NULL);
+
+	// Concurrent transfers share the in-flight budget of one window 
+	w = x->w;
+	if (w == NULL)
+	{
+		w = &own;
+		if (cmd_window_init(w, win))
+			goto destroy;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	STEP // 3: Keep the window full and deliver chunks in order
+	while (del < sub || (sub < n && !halt))
+	{
+		// Submit
+		while (sub < n && sub - del < (__u64) win && !halt)
+		{
+			s = &ring.slots[sub % win];
+			s->offset = x->offset + sub * x->chunk;
+			s->len = (sub == n - 1) ? x->len - sub * x->chunk : x->chunk;
+
+			// Write data comes from the source buffer without a copy when it
+			// holds the whole chunk
+			data = s->data;
+			pos = sub * x->chunk;
+			if (x->write && x->src != NULL && pos + s->len <= x->src_len)
+				data = &x->src[pos];
+			else if (x->write && x->fn(x->arg, s->offset, s->data, s->len))
+			{
+				halt = 1;
+				break;
+			}
+
+			fdbe = (sub == 0) ? x->fdbe : 0xF;
+			ldbe = (sub == n - 1) ? x->ldbe : 0xF;
+			fmapi_fill_mpc_mem(&msg, x->ppid, x->ldid, s->offset, s->len, fdbe, ldbe,
+				x->write ? FMCT_WRITE : FMCT_READ, data);
+
+			pthread_mutex_lock(&ring.mtx);
+			s->state = LMST_BUSY;
+			ring.pending++;
+			pthread_mutex_unlock(&ring.mtx);
+
+			clock_gettime(CLOCK_MONOTONIC, &s->sent);
+
+			if (submit_fmapi_async(m, w, &msg, s, mem_completed, mem_failed) == NULL)
+			{
+				pthread_mutex_lock(&ring.mtx);
+				s->state = LMST_FREE;
+				ring.pending--;
+				pthread_mutex_unlock(&ring.mtx);
+
+				fprintf(stderr, "Error: Could not submit LD mem request\n");
+				halt = 1;
+				break;
+			}
+			sub++;
+		}
+
+		if (del == sub)
+			break;
+
+		// Wait for the oldest chunk. The MCTP library fails a request once
+		// its own timeout expires, so this does not wait forever
+		s = &ring.slots[del % win];
+		pthread_mutex_lock(&ring.mtx);
+		while (s->state == LMST_BUSY)
+			pthread_cond_wait(&ring.cond, &ring.mtx);
+		pthread_mutex_unlock(&ring.mtx);
+
+		// Deliver
+		if (s->state == LMST_FAILED)
+			halt = 1;
+		else if (!halt)
+		{
+			if (!x->write && x->fn(x->arg, s->offset, s->data, s->len))
+				halt = 1;
+			x->bytes += s->len;
+			x->requests++;
+			x->lat_sum += s->ns;
+			if (s->ns > x->lat_max)
+				x->lat_max = s->ns;
+		}
+
+		s->state = LMST_FREE;
+		del++;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+	x->seconds = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+
+	if (!halt && del == n)
+		rv = 0;
+
+	STEP // 4: Drain. Completion functions still reference the ring, so the
+	// ring is only done once pending drops to zero
+	pthread_mutex_lock(&ring.mtx);
+	while (ring.pending > 0)
+		pthread_cond_wait(&ring.cond, &ring.mtx);
+	pthread_mutex_unlock(&ring.mtx);
+
+	if (w == &own)
+		cmd_window_free(w);
+
+destroy:
+
+	pthread_cond_destroy(&ring.cond);
+	pthread_mutex_destroy(&ring.mtx);
+
+slots:
+
+	for ( i = 0 ; i < win ; i++ )
+		free(ring.slots[i].data);
+	free(ring.slots);
+
+end:
+
+	EXIT(rv)
+
+	return rv;
+}
+
+/**
+ * Print the throughput of a finished transfer
+ *
+ * @param fp 	Stream to print to. stderr when stdout carries binary data
+ */
+void ldmem_summary(struct ldmem_xfer *x, FILE *fp)
+{
+	double sec;
+
+	sec = x->seconds > 0 ? x->seconds : 1e-9;
+
+	fprintf(fp, "LD mem: %llu bytes in %u requests of %u bytes, %d in flight, in %.3f s: %.2f MB/s %.0f req/s\n",
+		x->bytes, x->requests, x->chunk, x->window, x->seconds,
+		x->bytes / sec / 1e6, x->requests / sec);
+}
+
+/**
+ * Return 1 if a buffer is all zero
+ *
+ * It is if the first byte is zero and every byte equals the next one, which
+ * lets the vectorized memcmp() of libc do the scan
+ */
+static int all_zero(const __u8 *p, size_t len)
+{
+	return len == 0 || (p[0] == 0 && memcmp(p, p + 1, len - 1) == 0);
+}
+
+/**
+ * Sink of a read from the command line. Prints the data
+ */
+static int print_chunk(void *arg, __u64 offset, __u8 *data, unsigned len)
+{
+	(void) arg;
+	(void) offset;
+
+	autl_prnt_buf(data, len, 4, 0);
+
+	return 0;
+}
+
+/**
+ * Write the buffered binary output
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+static int sink_flush(struct ldmem_sink *k)
+{
+	size_t pos;
+	ssize_t rv;
+
+	pos = 0;
+	while (pos < k->used)
+	{
+		rv = write(k->fd, &k->buf[pos], k->used - pos);
+		if (rv < 0 && errno == EINTR)
+			continue;
+		if (rv <= 0)
+		{
+			fprintf(stderr, "Error: Could not write output: %s\n", strerror(errno));
+			return 1;
+		}
+		pos += rv;
+	}
+	k->written += k->used;
+	k->used = 0;
+
+	return 0;
+}
+
+/**
+ * Add the open non-zero extent to the map
+ */
+static void sink_extent(struct ldmem_sink *k)
+{
+	if (k->map != NULL && k->ext_len > 0)
+		fprintf(k->map, "0x%010llx 0x%010llx\n", k->ext_off, k->ext_len);
+	k->ext_len = 0;
+}
+
+/**
+ * Set up the options of a sink that writes to a file
+ *
+ * Only regular files can hold holes. Others, e.g. pipes, are written in full
+ *
+ * @param path 	Name of the output file. The map is written to <path>.map
+ * @return 		0 upon success. Non zero otherwise
+ */
+static int sink_open(struct ldmem_sink *k, const char *path)
+{
+	char name[LMLN_PATH + 8];
+	struct stat st;
+
+	k->sparse = fstat(k->fd, &st) == 0 && S_ISREG(st.st_mode);
+
+	if (opts[CLOP_SPARSE_MAP].set)
+	{
+		snprintf(name, sizeof(name), "%s.map", path);
+		k->map = fopen(name, "w");
+		if (k->map == NULL)
+		{
+			printf("Error: Could not open %s: %s\n", name, strerror(errno));
+			return 1;
+		}
+		fprintf(k->map, "# Non-zero extents of %s: <offset> <length>\n", path);
+	}
+
+	return 0;
+}
+
+/**
+ * Write what is left in a sink and extend the file over a trailing hole
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+static int sink_close(struct ldmem_sink *k)
+{
+	int rv;
+
+	rv = sink_flush(k);
+
+	if (rv == 0 && k->hole > 0 && ftruncate(k->fd, k->pos) != 0)
+	{
+		fprintf(stderr, "Error: Could not write output: %s\n", strerror(errno));
+		rv = 1;
+	}
+
+	if (k->map != NULL)
+	{
+		sink_extent(k);
+		fclose(k->map);
+		k->map = NULL;
+	}
+
+	return rv;
+}
+
+/**
+ * Sink of a read to --outfile or --raw. Chunks arrive in offset order and
+ * are appended to the output in large writes
+ */
+static int write_chunk(void *arg, __u64 offset, __u8 *data, unsigned len)
+{
+	struct ldmem_sink *k = arg;
+
+	(void) offset;
+
+	// Leave all zero chunks as a hole. The data before it is written first
+	if (k->sparse && all_zero(data, len))
+	{
+		if (k->used > 0 && sink_flush(k))
+			return 1;
+
+		sink_extent(k);
+		k->hole += len;
+		k->pos += len;
+		return 0;
+	}
+
+	if (k->hole > 0)
+	{
+		if (lseek(k->fd, k->hole, SEEK_CUR) < 0)
+		{
+			fprintf(stderr, "Error: Could not seek output: %s\n", strerror(errno));
+			return 1;
+		}
+		k->hole = 0;
+	}
+
+	if (k->ext_len == 0)
+		k->ext_off = k->pos;
+	k->ext_len += len;
+	k->pos += len;
+
+	if (k->used + len > LMLN_OUTBUF && sink_flush(k))
+		return 1;
+
+	memcpy(&k->buf[k->used], data, len);
+	k->used += len;
+
+	return 0;
+}
+
+/**
+ * Close the open mismatching range of a verify and print it
+ */
+static void check_close(struct ldmem_check *c)
+{
+	if (c->bad_len == 0)
+		return;
+
+	if (c->ranges < LMLN_RANGES)
+		printf("Mismatch: 0x%010llx - 0x%010llx (%llu bytes)\n", 
+			c->bad_off, c->bad_off + c->bad_len - 1, c->bad_len);
+	else if (c->ranges == LMLN_RANGES)
+		printf("Mismatch: ...\n");
+
+	c->ranges++;
+	c->bad_bytes += c->bad_len;
+	c->bad_len = 0;
+}
+
+/**
+ * Compare bytes byte by byte against a reference. NULL compares against 0
+ */
+static void check_bytes(struct ldmem_check *c, __u64 offset, __u8 *data, const __u8 *ref, unsigned len)
+{
+	unsigned i;
+
+	for ( i = 0 ; i < len ; i++ )
+	{
+		if (data[i] == (ref != NULL ? ref[i] : 0))
+			continue;
+
+		if (c->bad_len > 0 && c->bad_off + c->bad_len == offset + i)
+		{
+			c->bad_len++;
+			continue;
+		}
+
+		check_close(c);
+		c->bad_off = offset + i;
+		c->bad_len = 1;
+	}
+}
+
+/**
+ * Sink of a read with --verify or --checksum
+ *
+ * Updates the CRC32C and compares the chunk against the --verify file, zero
+ * padded past its end. Matching chunks take the memcmp() fast path 
+ */
+static int check_chunk(void *arg, __u64 offset, __u8 *data, unsigned len)
+{
+	struct ldmem_check *c = arg;
+	__u64 pos;
+	unsigned k;
+
+	if (c->checksum)
+		c->crc = crc32c(c->crc, data, len);
+
+	if (!c->verify)
+		return 0;
+
+	pos = offset - c->base;
+	k = 0;
+	if (pos < c->ref_len)
+		k = (c->ref_len - pos < len) ? c->ref_len - pos : len;
+
+	if (k > 0 && memcmp(data, &c->ref[pos], k) != 0)
+		check_bytes(c, offset, data, &c->ref[pos], k);
+
+	if (k < len && !all_zero(&data[k], len - k))
+		check_bytes(c, offset + k, &data[k], NULL, len - k);
+
+	return 0;
+}
+
+/**
+ * Source of a write from the command line
+ *
+ * Copies from the input file, zero padded past its end, or repeats the
+ * 32 bit immediate data
+ */
+static int fill_chunk(void *arg, __u64 offset, __u8 *data, unsigned len)
+{
+	struct ldmem_src *src = arg;
+	__u64 pos;
+	unsigned i, k;
+
+	pos = offset - src->base;
+
+	if (src->buf != NULL)
+	{
+		k = 0;
+		if (pos < src->len)
+			k = (src->len - pos < len) ? src->len - pos : len;
+		memcpy(data, &src->buf[pos < src->len ? pos : 0], k);
+		memset(&data[k], 0, len - k);
+		return 0;
+	}
+
+	for ( i = 0 ; i < len ; i++ )
+		data[i] = ((__u8*) &src->pattern)[(pos + i) % 4];
+
+	return 0;
+}
+
+/**
+ * Run an ld mem command from the CLI options
+ *
+ * @param fn 	Function to read sections of the switch state with. Used to
+ * 				negotiate the message limit if it is not known yet
+ * @return 		0 upon success. Non zero otherwise
+ */
+int ldmem_cmd(struct mctp *m, int (*fn)(struct mctp *m, unsigned mask))
+{
+	struct ldmem_xfer x;
+	struct ldmem_src src;
+	struct ldmem_sink sink;
+	struct ldmem_check chk;
+	struct ldsnap snap;
+	struct stat st;
+	FILE *fp;
+	int rv, fd;
+
+	rv = 1;
+	fd = -1;
+	fp = stdout;
+
+	// The chunk size depends on the negotiated message limit
+	if (cxls->msg_rsp_limit_n == 0 && fn(m, JKSN_BIT(JKSN_SWITCH)) != 0)
+		fprintf(opts[CLOP_RAW].set ? stderr : stdout, "Warning: Could not read message limit, using %u byte requests\n", CLMR_MAX_LD_MEM_LEN);
+
+	memset(&x, 0, sizeof(x));
+	memset(&src, 0, sizeof(src));
+	memset(&sink, 0, sizeof(sink));
+	memset(&chk, 0, sizeof(chk));
+	memset(&snap, 0, sizeof(snap));
+	sink.fd = -1;
+
+	x.ppid 		= opts[CLOP_PPID].u8;
+	x.ldid 		= opts[CLOP_LDID].set ? opts[CLOP_LDID].u16 : 0;
+	x.write 	= opts[CLOP_WRITE].set;
+	x.fdbe 		= opts[CLOP_FDBE].set ? opts[CLOP_FDBE].u8 : 0xF;
+	x.ldbe 		= opts[CLOP_LDBE].set ? opts[CLOP_LDBE].u8 : 0xF;
+	x.offset 	= opts[CLOP_OFFSET].set ? opts[CLOP_OFFSET].u64 : 0;
+	x.len 		= opts[CLOP_LEN].len;
+	x.window 	= cmd_window_size();
+
+	pthread_mutex_lock(&cxls->mtx);
+	x.chunk = ldmem_chunk(cxls);
+	pthread_mutex_unlock(&cxls->mtx);
+
+	if (x.write)
+	{
+		src.base = x.offset;
+		src.pattern = opts[CLOP_DATA].u32;
+
+		// Map the input file so it is never staged in a heap copy 
+		if (opts[CLOP_INFILE].set)
+		{
+			fd = open(opts[CLOP_INFILE].str, O_RDONLY);
+			if (fd < 0 || fstat(fd, &st) != 0)
+			{
+				printf("Error: Could not open %s: %s\n", opts[CLOP_INFILE].str, strerror(errno));
+				goto end;
+			}
+
+			if (st.st_size > 0)
+			{
+				src.buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (src.buf == MAP_FAILED)
+				{
+					src.buf = NULL;
+					printf("Error: Could not map %s: %s\n", opts[CLOP_INFILE].str, strerror(errno));
+					goto end;
+				}
+				src.len = st.st_size;
+				madvise(src.buf, src.len, MADV_SEQUENTIAL);
+			}
+			else 
+				src.buf = (__u8*) "";
+
+			x.src = src.buf;
+			x.src_len = src.len;
+		}
+		x.fn = fill_chunk;
+		x.arg = &src;
+	}
+	else if (opts[CLOP_VERIFY].set || opts[CLOP_CHECKSUM].set)
+	{
+		chk.base = x.offset;
+		chk.verify = opts[CLOP_VERIFY].set;
+		chk.checksum = opts[CLOP_CHECKSUM].set;
+
+		// Map the reference file so it is paged in and out as it is compared
+		if (chk.verify)
+		{
+			fd = open(opts[CLOP_VERIFY].str, O_RDONLY);
+			if (fd < 0 || fstat(fd, &st) != 0)
+			{
+				printf("Error: Could not open %s: %s\n", opts[CLOP_VERIFY].str, strerror(errno));
+				goto end;
+			}
+
+			if (st.st_size > 0)
+			{
+				chk.ref = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (chk.ref == MAP_FAILED)
+				{
+					chk.ref = NULL;
+					printf("Error: Could not map %s: %s\n", opts[CLOP_VERIFY].str, strerror(errno));
+					goto end;
+				}
+				chk.ref_len = st.st_size;
+				madvise(chk.ref, chk.ref_len, MADV_SEQUENTIAL);
+			}
+
+			// Verify the length of the file if no length was given
+			if (!opts[CLOP_LEN].set)
+				x.len = chk.ref_len;
+			if (x.len == 0)
+			{
+				printf("Error: %s is empty\n", opts[CLOP_VERIFY].str);
+				goto end;
+			}
+		}
+		x.fn = check_chunk;
+		x.arg = &chk;
+	}
+	else if (opts[CLOP_STORE].set)
+	{
+		if (ldsnap_open(&snap, opts[CLOP_STORE].str, opts[CLOP_NAME].str, &x))
+			goto end;
+		x.fn = ldsnap_chunk;
+		x.arg = &snap;
+	}
+	else if (opts[CLOP_OUTFILE].set || opts[CLOP_RAW].set)
+	{
+		sink.buf = malloc(LMLN_OUTBUF);
+		if (sink.buf == NULL)
+			goto end;
+
+		if (opts[CLOP_RAW].set)
+		{
+			// Text already printed must not land inside the binary data
+			fflush(stdout);
+			sink.fd = STDOUT_FILENO;
+			fp = stderr;
+		}
+		else
+		{
+			sink.fd = open(opts[CLOP_OUTFILE].str, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (sink.fd < 0)
+			{
+				printf("Error: Could not open %s: %s\n", opts[CLOP_OUTFILE].str, strerror(errno));
+				goto end;
+			}
+			if (sink_open(&sink, opts[CLOP_OUTFILE].str))
+				goto end;
+		}
+		x.fn = write_chunk;
+		x.arg = &sink;
+	}
+	else
+		x.fn = print_chunk;
+
+	rv = ldmem_run(m, &x);
+
+	// Keep the data that was read even if the transfer stopped early
+	if (sink.buf != NULL && sink_close(&sink))
+		rv = 1;
+
+	// Only a complete read is published as a snapshot
+	if (snap.mf != NULL)
+	{
+		if (ldsnap_close(&snap, rv == 0))
+			rv = 1;
+		else if (rv == 0)
+			printf("Snapshot %s: %u blocks, %u new (%llu bytes stored)\n", snap.path, snap.blocks, snap.stored, snap.stored_bytes);
+	}
+
+	if (x.requests > 1)
+		ldmem_summary(&x, fp);
+
+	// Results of the checks only cover complete transfers
+	if (rv == 0 && chk.checksum)
+		printf("CRC32C: 0x%08x (%llu bytes at 0x%llx, %s)\n", chk.crc, x.bytes, x.offset, crc32c_impl());
+
+	if (rv == 0 && chk.verify)
+	{
+		check_close(&chk);
+		if (chk.ranges == 0)
+			printf("Verify: %llu bytes match %s\n", x.bytes, opts[CLOP_VERIFY].str);
+		else
+		{
+			printf("Verify: %llu bytes in %u ranges differ from %s\n", chk.bad_bytes, chk.ranges, opts[CLOP_VERIFY].str);
+			rv = 1;
+		}
+	}
+
+end:
+
+	if (snap.mf != NULL)
+		ldsnap_close(&snap, 0);
+	if (sink.map != NULL)
+		fclose(sink.map);
+	if (sink.fd >= 0 && sink.fd != STDOUT_FILENO)
+		close(sink.fd);
+	free(sink.buf);
+
+	if (src.len > 0)
+		munmap(src.buf, src.len);
+	if (chk.ref_len > 0)
+		munmap(chk.ref, chk.ref_len);
+	if (fd >= 0)
+		close(fd);
+
+	return rv;
+}
+
+/**
+ * Read the allocated memory of one LD into its dump file
+ */
+static void dump_one(struct ldmem_pool *pool, struct ldmem_job *j)
+{
+	struct ldmem_xfer x;
+	struct ldmem_sink sink;
+
+	j->rv = 1;
+
+	memset(&x, 0, sizeof(x));
+	memset(&sink, 0, sizeof(sink));
+
+	sink.buf = malloc(LMLN_OUTBUF);
+	if (sink.buf == NULL)
+		return;
+
+	sink.fd = open(j->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (sink.fd < 0)
+	{
+		printf("Error: Could not open %s: %s\n", j->path, strerror(errno));
+		goto free;
+	}
+	if (sink_open(&sink, j->path))
+		goto close;
+
+	x.ppid 		= j->ppid;
+	x.ldid 		= j->ldid;
+	x.fdbe 		= 0xF;
+	x.ldbe 		= 0xF;
+	x.len 		= j->len;
+	x.chunk 	= pool->chunk;
+	x.window 	= pool->window;
+	x.w 		= pool->w;
+	x.fn 		= write_chunk;
+	x.arg 		= &sink;
+
+	j->rv = ldmem_run(pool->m, &x);
+	if (sink_close(&sink))
+		j->rv = 1;
+
+	j->bytes = x.bytes;
+	j->written = sink.written;
+	j->requests = x.requests;
+
+close:
+
+	if (sink.map != NULL)
+		fclose(sink.map);
+	close(sink.fd);
+
+free:
+
+	free(sink.buf);
+}
+
+/**
+ * Worker thread of an LD dump. Takes the next job until none are left
+ */
+static void *dump_worker(void *arg)
+{
+	struct ldmem_pool *pool = arg;
+	int i;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&pool->mtx);
+		i = pool->next++;
+		pthread_mutex_unlock(&pool->mtx);
+
+		if (i >= pool->num)
+			break;
+
+		dump_one(pool, &pool->jobs[i]);
+	}
+
+	return NULL;
+}
+
+/**
+ * Fill the dump jobs of the allocated LDs selected by the CLI options
+ *
+ * Must be called with cxls->mtx held
+ *
+ * @return Number of jobs, or -1 if the selected port is not an MLD
+ */
+static int dump_jobs(struct ldmem_job *jobs, int max, const char *dir)
+{
+	struct cxl_port *p;
+	struct cxl_mld *mld;
+	__u64 gran;
+	int i, k, n;
+
+	n = 0;
+
+	if (!opts[CLOP_ALL].set && opts[CLOP_PPID].u8 >= cxls->num_ports)
+	{
+		printf("Error: Invalid port: %u\n", opts[CLOP_PPID].u8);
+		return -1;
+	}
+
+	for ( i = 0 ; i < cxls->num_ports ; i++ )
+	{
+		if (!opts[CLOP_ALL].set && i != opts[CLOP_PPID].u8)
+			continue;
+
+		p = &cxls->ports[i];
+		mld = p->mld;
+		if (p->dt != FMDT_CXL_TYPE_3_POOLED || mld == NULL)
+		{
+			if (opts[CLOP_ALL].set)
+				continue;
+			printf("Error: Port %d is not an MLD\n", i);
+			return -1;
+		}
+
+		gran = LMLN_GRANULARITY << mld->granularity;
+
+		for ( k = 0 ; k < mld->num && k < LMLN_LDS && n < max ; k++ )
+		{
+			if (opts[CLOP_LDID].set && k != opts[CLOP_LDID].u16)
+				continue;
+
+			jobs[n].ppid = i;
+			jobs[n].ldid = k;
+			jobs[n].len = (mld->rng1[k] + mld->rng2[k]) * gran;
+			if (jobs[n].len == 0)
+				continue;
+
+			snprintf(jobs[n].path, LMLN_PATH, "%s/ld-p%d-l%d.bin", dir, i, k);
+			n++;
+		}
+	}
+
+	return n;
+}
+
+/**
+ * Dump the allocated memory of LDs to one file per LD
+ *
+ * The LDs are enumerated from the cached MCC Info and LD Allocations of each
+ * MLD. Up to LMLN_JOBS LDs are read at the same time. All of them share one
+ * window so the total number of requests in flight stays within --window
+ *
+ * @param fn 	Function to read sections of the switch state with. Used if
+ * 				the MLD state is not cached yet
+ * @return 		0 upon success. Non zero otherwise
+ */
+int ldmem_dump(struct mctp *m, int (*fn)(struct mctp *m, unsigned mask))
+{
+	struct ldmem_pool pool;
+	struct ldmem_xfer sum;
+	struct cmd_window w;
+	struct timespec start, stop;
+	pthread_t threads[LMLN_JOBS];
+	const char *dir;
+	int rv, i, n, max;
+
+	rv = 1;
+	n = 0;
+
+	memset(&pool, 0, sizeof(pool));
+	memset(&sum, 0, sizeof(sum));
+
+	dir = opts[CLOP_OUTDIR].set ? opts[CLOP_OUTDIR].str : ".";
+	if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+	{
+		printf("Error: Could not create %s: %s\n", dir, strerror(errno));
+		goto end;
+	}
+
+	// The LDs and their allocations come from the MLD section of the cache 
+	if (snapshot_generation(JKSN_MLDS) == 0 
+		&& fn(m, JKSN_BIT(JKSN_SWITCH) | JKSN_BIT(JKSN_PORTS) | JKSN_BIT(JKSN_MLDS)) != 0)
+	{
+		printf("Error: Could not read MLD state\n");
+		goto end;
+	}
+
+	pthread_mutex_lock(&cxls->mtx);
+	max = cxls->num_ports * LMLN_LDS;
+	pool.jobs = calloc(max + 1, sizeof(struct ldmem_job));
+	if (pool.jobs != NULL)
+	{
+		pool.num = dump_jobs(pool.jobs, max, dir);
+		pool.chunk = ldmem_chunk(cxls);
+	}
+	pthread_mutex_unlock(&cxls->mtx);
+
+	if (pool.jobs == NULL || pool.num < 0)
+		goto end;
+
+	if (pool.num == 0)
+	{
+		printf("No allocated LDs to dump\n");
+		rv = 0;
+		goto end;
+	}
+
+	pool.m = m;
+	pool.w = &w;
+	pool.window = cmd_window_size();
+	pthread_mutex_init(&pool.mtx, NULL);
+
+	if (cmd_window_init(&w, pool.window))
+		goto destroy;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	// Run the jobs on a pool of threads 
+	for ( n = 0 ; n < pool.num && n < LMLN_JOBS ; n++ )
+		if (pthread_create(&threads[n], NULL, dump_worker, &pool) != 0)
+			break;
+
+	// With no thread the jobs run here
+	if (n == 0)
+		dump_worker(&pool);
+
+	for ( i = 0 ; i < n ; i++ )
+		pthread_join(threads[i], NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	cmd_window_free(&w);
+
+	// Report 
+	rv = 0;
+	for ( i = 0 ; i < pool.num ; i++ )
+	{
+		printf("Port %3d LD %2d: %llu bytes (%llu non-zero) to %s%s\n", pool.jobs[i].ppid, pool.jobs[i].ldid, 
+			pool.jobs[i].bytes, pool.jobs[i].written, pool.jobs[i].path, pool.jobs[i].rv ? " (incomplete)" : "");
+		sum.bytes += pool.jobs[i].bytes;
+		sum.requests += pool.jobs[i].requests;
+		if (pool.jobs[i].rv)
+			rv = 1;
+	}
+
+	sum.chunk = pool.chunk;
+	sum.window = w.max;
+	sum.seconds = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+	ldmem_summary(&sum, stdout);
+
+destroy:
+
+	pthread_mutex_destroy(&pool.mtx);
+
+end:
+
+	free(pool.jobs);
+
+	return rv;
+}
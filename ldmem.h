@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		ldmem.h
+ *
+ * @brief 		Header file for chunked, pipelined LD memory transfers
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _LDMEM_H
+#define _LDMEM_H
+
+/* FILE
+ */
+#include <stdio.h>
+
+/* __u8
+ * __u64
+ */
+#include <linux/types.h>
+
+/* struct mctp
+ */
+#include <mctp.h>
+
+/* struct cxl_switch
+ */
+#include <cxlstate.h>
+
+/* struct cmd_window
+ */
+#include "cmd_encoder.h"
+
+/* MACROS ====================================================================*/
+
+#define LMLN_OVERHEAD 		64 		//!< Bytes of a message that are not memory data
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * One LD memory transfer split into chunks
+ */
+struct ldmem_xfer
+{
+	int ppid;
+	int ldid;
+	int write;				//!< Write (1) or read (0)
+	int fdbe;				//!< Byte enable of the first DWord of the transfer
+	int ldbe;				//!< Byte enable of the last DWord of the transfer
+	__u64 offset;			//!< Start offset in the memory of the LD
+	__u64 len;				//!< Length in bytes
+	unsigned chunk;			//!< Bytes per request
+	int window;				//!< Requests in flight
+	struct cmd_window *w;	//!< Window shared by concurrent transfers. NULL for a private one
+
+	/**
+	 * Called on the caller thread once per chunk in offset order. Reads pass
+	 * the data that was read. Writes fill data with the bytes to write
+	 *
+	 * @return 0 upon success. Non zero stops the transfer
+	 */
+	int (*fn)(void *arg, __u64 offset, __u8 *data, unsigned len);
+	void *arg;
+
+	/**
+	 * Data of a write, e.g. a mapped file. Chunks that lie within it are
+	 * serialized straight from it. fn is only called for chunks past its end
+	 */
+	__u8 *src;
+	__u64 src_len;
+
+	__u64 bytes;			//!< Bytes transferred
+	unsigned requests;		//!< Requests that completed
+	double seconds;			//!< Elapsed time of the transfer
+	__u64 lat_sum;			//!< Sum of nanoseconds from submission to response
+	__u64 lat_max;			//!< Max nanoseconds from submission to response
+};
+
+/* PROTOTYPES ================================================================*/
+
+unsigned ldmem_chunk(struct cxl_switch *s);
+
+int ldmem_run(struct mctp *m, struct ldmem_xfer *x);
+
+void ldmem_summary(struct ldmem_xfer *x, FILE *fp);
+
+int ldmem_cmd(struct mctp *m, int (*fn)(struct mctp *m, unsigned mask));
+
+int ldmem_dump(struct mctp *m, int (*fn)(struct mctp *m, unsigned mask));
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_LDMEM_H
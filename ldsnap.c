@@ -0,0 +1,532 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		ldsnap.c
+ *
+ * @brief 		Code file for deduplicated LD memory snapshots
+ *
+ * A snapshot splits the memory read from an LD into fixed size blocks and
+ * stores each block once, in a file named by its SHA-256. The manifest of a
+ * snapshot lists the hash of each block in offset order, so snapshots that
+ * share blocks only add the blocks that changed, and two snapshots can be
+ * compared from their manifests alone
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* printf()
+ * snprintf()
+ * rename()
+ */
+#include <stdio.h>
+
+/* malloc()
+ * free()
+ */
+#include <stdlib.h>
+
+/* memcpy()
+ * strchr()
+ * strerror()
+ */
+#include <string.h>
+
+/* access()
+ * unlink()
+ * write()
+ * getpid()
+ */
+#include <unistd.h>
+
+/* open()
+ */
+#include <fcntl.h>
+
+/* mkdir()
+ */
+#include <sys/stat.h>
+
+#include <errno.h>
+
+/* time()
+ * strftime()
+ */
+#include <time.h>
+
+#include <fmapi.h>
+#include <emapi.h>
+
+#include "ldsnap.h"
+#include "ldmem.h"
+#include "sha256.h"
+
+/* MACROS ====================================================================*/
+
+#define LSLN_HEX 			(2 * SHLN_DIGEST) 	//!< Chars of a hash in hex
+#define LSLN_LINE 			128 				//!< Max length of a manifest line
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * Manifest loaded for a diff
+ */
+struct ldsnap_manifest
+{
+	char path[LSLN_PATH];
+	int ppid;
+	int ldid;
+	__u64 offset;
+	__u64 len;
+	unsigned block;
+	unsigned num;			//!< Hashes in hash[]
+	__u8 (*hash)[SHLN_DIGEST];
+};
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Create a directory unless it exists
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+static int make_dir(const char *path)
+{
+	if (mkdir(path, 0755) == 0 || errno == EEXIST)
+		return 0;
+
+	printf("Error: Could not create %s: %s\n", path, strerror(errno));
+	return 1;
+}
+
+/**
+ * Write a buffer to a new file. The file only appears under its name once 
+ * it is complete, so an interrupted snapshot never leaves a torn block
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+static int write_file(const char *path, __u8 *data, unsigned len)
+{
+	char tmp[LSLN_PATH + 16];
+	unsigned pos;
+	ssize_t rv;
+	int fd;
+
+	snprintf(tmp, sizeof(tmp), "%s.%d", path, getpid());
+
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		goto fail;
+
+	pos = 0;
+	while (pos < len)
+	{
+		rv = write(fd, &data[pos], len - pos);
+		if (rv < 0 && errno == EINTR)
+			continue;
+		if (rv <= 0)
+			break;
+		pos += rv;
+	}
+
+	if (close(fd) != 0 || pos < len || rename(tmp, path) != 0)
+	{
+		unlink(tmp);
+		goto fail;
+	}
+
+	return 0;
+
+fail:
+
+	printf("Error: Could not write %s: %s\n", path, strerror(errno));
+	return 1;
+}
+
+/**
+ * Hash a block, add it to the manifest and to the store if it is new
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+static int put_block(struct ldsnap *s, __u8 *data, unsigned len)
+{
+	char hex[LSLN_HEX + 1], path[LSLN_PATH];
+	__u8 digest[SHLN_DIGEST];
+	int i;
+
+	sha256(data, len, digest);
+	for ( i = 0 ; i < SHLN_DIGEST ; i++ )
+		sprintf(&hex[2*i], "%02x", digest[i]);
+
+	fprintf(s->mf, "%s\n", hex);
+	s->blocks++;
+
+	snprintf(path, sizeof(path), "%s/blocks/%.2s/%s", s->dir, hex, &hex[2]);
+	if (access(path, F_OK) == 0)
+		return 0;
+
+	snprintf(path, sizeof(path), "%s/blocks/%.2s", s->dir, hex);
+	if (make_dir(path))
+		return 1;
+
+	snprintf(path, sizeof(path), "%s/blocks/%.2s/%s", s->dir, hex, &hex[2]);
+	if (write_file(path, data, len))
+		return 1;
+
+	s->stored++;
+	s->stored_bytes += len;
+
+	return 0;
+}
+
+/**
+ * Start a snapshot of the range of a read
+ *
+ * @param dir 	Store directory. Created if needed
+ * @param name 	Name of the manifest. NULL for ld-p<ppid>-l<ldid>-<time>
+ * @param x 	Transfer that fills the snapshot
+ * @return 		0 upon success. Non zero otherwise
+ */
+int ldsnap_open(struct ldsnap *s, const char *dir, const char *name, struct ldmem_xfer *x)
+{
+	char def[64], path[LSLN_PATH];
+	time_t now;
+
+	memset(s, 0, sizeof(*s));
+	s->dir = dir;
+
+	now = time(NULL);
+	if (name == NULL)
+	{
+		snprintf(def, sizeof(def), "ld-p%d-l%d-", x->ppid, x->ldid);
+		strftime(&def[strlen(def)], sizeof(def) - strlen(def), "%Y%m%d-%H%M%S", localtime(&now));
+		name = def;
+	}
+
+	if (make_dir(dir))
+		return 1;
+	snprintf(path, sizeof(path), "%s/blocks", dir);
+	if (make_dir(path))
+		return 1;
+	snprintf(path, sizeof(path), "%s/manifests", dir);
+	if (make_dir(path))
+		return 1;
+
+	// Snapshots are never replaced 
+	snprintf(s->path, sizeof(s->path), "%s/manifests/%s", dir, name);
+	snprintf(s->tmp, sizeof(s->tmp), "%s/manifests/.%s.tmp", dir, name);
+	if (access(s->path, F_OK) == 0)
+	{
+		printf("Error: Snapshot %s already exists\n", s->path);
+		return 1;
+	}
+
+	s->block = malloc(LSLN_BLOCK);
+	if (s->block == NULL)
+		return 1;
+
+	s->mf = fopen(s->tmp, "w");
+	if (s->mf == NULL)
+	{
+		printf("Error: Could not open %s: %s\n", s->tmp, strerror(errno));
+		free(s->block);
+		s->block = NULL;
+		return 1;
+	}
+
+	fprintf(s->mf, "# jack ld snapshot\n");
+	fprintf(s->mf, "version %d\n", LSLN_VERSION);
+	fprintf(s->mf, "ppid %d\n", x->ppid);
+	fprintf(s->mf, "ldid %d\n", x->ldid);
+	fprintf(s->mf, "offset 0x%llx\n", x->offset);
+	fprintf(s->mf, "length 0x%llx\n", x->len);
+	fprintf(s->mf, "block %u\n", LSLN_BLOCK);
+	fprintf(s->mf, "time %lld\n", (long long) now);
+
+	return 0;
+}
+
+/**
+ * Sink of a read into a snapshot. Chunks arrive in offset order
+ */
+int ldsnap_chunk(void *arg, __u64 offset, __u8 *data, unsigned len)
+{
+	struct ldsnap *s = arg;
+	unsigned k;
+
+	(void) offset;
+
+	while (len > 0)
+	{
+		k = LSLN_BLOCK - s->used;
+		if (k > len)
+			k = len;
+
+		memcpy(&s->block[s->used], data, k);
+		s->used += k;
+		data += k;
+		len -= k;
+
+		if (s->used == LSLN_BLOCK)
+		{
+			if (put_block(s, s->block, s->used))
+				return 1;
+			s->used = 0;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Finish a snapshot
+ *
+ * @param keep 	Publish the manifest. Zero discards it, e.g. when the read 
+ * 				failed. Blocks already stored are kept for later snapshots
+ * @return 		0 upon success. Non zero otherwise
+ */
+int ldsnap_close(struct ldsnap *s, int keep)
+{
+	int rv;
+
+	rv = 0;
+
+	if (s->mf == NULL)
+		return 1;
+
+	if (keep && s->used > 0 && put_block(s, s->block, s->used))
+		rv = 1;
+
+	if (fclose(s->mf) != 0)
+		rv = 1;
+	s->mf = NULL;
+
+	if (keep && rv == 0 && rename(s->tmp, s->path) != 0)
+	{
+		printf("Error: Could not write %s: %s\n", s->path, strerror(errno));
+		rv = 1;
+	}
+
+	if (!keep || rv != 0)
+		unlink(s->tmp);
+
+	free(s->block);
+	s->block = NULL;
+
+	return rv;
+}
+
+/**
+ * Parse a hash written in hex
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+static int parse_hash(__u8 *digest, const char *hex)
+{
+	unsigned v;
+	int i;
+
+	for ( i = 0 ; i < SHLN_DIGEST ; i++ )
+	{
+		if (sscanf(&hex[2*i], "%2x", &v) != 1)
+			return 1;
+		digest[i] = v;
+	}
+
+	return hex[LSLN_HEX] == 0 || hex[LSLN_HEX] == '\n' ? 0 : 1;
+}
+
+/**
+ * Load a manifest
+ *
+ * @param dir 	Store to look up a name without a '/' in. May be NULL
+ * @param name 	Path or name of the manifest
+ * @return 		0 upon success. Non zero otherwise
+ */
+static int load_manifest(struct ldsnap_manifest *m, const char *dir, const char *name)
+{
+	char line[LSLN_LINE];
+	unsigned long long v;
+	unsigned max;
+	FILE *fp;
+	int rv;
+
+	rv = 1;
+	memset(m, 0, sizeof(*m));
+
+	if (dir != NULL && strchr(name, '/') == NULL)
+		snprintf(m->path, sizeof(m->path), "%s/manifests/%s", dir, name);
+	else
+		snprintf(m->path, sizeof(m->path), "%s", name);
+
+	fp = fopen(m->path, "r");
+	if (fp == NULL)
+	{
+		printf("Error: Could not open %s: %s\n", m->path, strerror(errno));
+		return 1;
+	}
+
+	max = 0;
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+
+		if 		(sscanf(line, "version %llu", &v) == 1) { if (v != LSLN_VERSION) goto invalid; }
+		else if (sscanf(line, "ppid %llu", &v) == 1) 	m->ppid = v;
+		else if (sscanf(line, "ldid %llu", &v) == 1) 	m->ldid = v;
+		else if (sscanf(line, "offset %llx", &v) == 1) 	m->offset = v;
+		else if (sscanf(line, "length %llx", &v) == 1) 	m->len = v;
+		else if (sscanf(line, "block %llu", &v) == 1) 	m->block = v;
+		else if (sscanf(line, "time %llu", &v) == 1) 	;
+		else 
+		{
+			// Block hashes follow the header 
+			if (m->block == 0)
+				goto invalid;
+
+			if (m->hash == NULL)
+			{
+				max = (m->len + m->block - 1) / m->block;
+				m->hash = calloc(max ? max : 1, SHLN_DIGEST);
+				if (m->hash == NULL)
+					goto end;
+			}
+
+			if (m->num >= max || parse_hash(m->hash[m->num], line))
+				goto invalid;
+			m->num++;
+		}
+	}
+
+	if (m->block == 0 || m->num != (m->len + m->block - 1) / m->block)
+		goto invalid;
+
+	rv = 0;
+	goto end;
+
+invalid:
+
+	printf("Error: Invalid snapshot manifest %s\n", m->path);
+
+end:
+
+	fclose(fp);
+	if (rv != 0)
+	{
+		free(m->hash);
+		m->hash = NULL;
+	}
+
+	return rv;
+}
+
+/**
+ * Print a range of LD memory that differs
+ */
+static void print_range(const char *what, __u64 start, __u64 end, __u64 bsz)
+{
+	printf("%-9s 0x%010llx - 0x%010llx (%llu blocks)\n", what, start, end - 1, (end - start + bsz - 1) / bsz);
+}
+
+/**
+ * Compare two snapshots from their manifests without reading any block
+ *
+ * The snapshots are lined up by LD offset. Ranges covered by only one of 
+ * them are reported as such
+ *
+ * @param dir 	Store to look up names in. May be NULL
+ * @return 		0 upon success. Non zero otherwise
+ */
+int ldsnap_diff(const char *dir, const char *a, const char *b)
+{
+	struct ldsnap_manifest ma, mb;
+	__u64 start, end, addr, run, bsz, changed, n;
+	unsigned i, j, total, diff;
+	int rv;
+
+	rv = 1;
+
+	if (load_manifest(&ma, dir, a))
+		return 1;
+	if (load_manifest(&mb, dir, b))
+		goto free_a;
+
+	printf("A: %s  port %d LD %d 0x%llx + 0x%llx\n", ma.path, ma.ppid, ma.ldid, ma.offset, ma.len);
+	printf("B: %s  port %d LD %d 0x%llx + 0x%llx\n", mb.path, mb.ppid, mb.ldid, mb.offset, mb.len);
+
+	bsz = ma.block;
+	if (ma.block != mb.block || (ma.offset > mb.offset ? ma.offset - mb.offset : mb.offset - ma.offset) % bsz)
+	{
+		printf("Error: Snapshots do not use the same blocks\n");
+		goto free_b;
+	}
+
+	// Ranges covered by one snapshot only
+	start = ma.offset > mb.offset ? ma.offset : mb.offset;
+	end = (ma.offset + ma.len) < (mb.offset + mb.len) ? (ma.offset + ma.len) : (mb.offset + mb.len);
+	if (end < start)
+		end = start;
+
+	if (ma.offset < start)
+		print_range("Only A:", ma.offset, start < ma.offset + ma.len ? start : ma.offset + ma.len, bsz);
+	if (mb.offset < start)
+		print_range("Only B:", mb.offset, start < mb.offset + mb.len ? start : mb.offset + mb.len, bsz);
+
+	// Blocks covered by both, coalesced into ranges
+	total = 0;
+	diff = 0;
+	changed = 0;
+	run = 0;
+	n = 0;
+	for ( addr = start ; addr < end ; addr += bsz )
+	{
+		i = (addr - ma.offset) / bsz;
+		j = (addr - mb.offset) / bsz;
+		total++;
+
+		if (memcmp(ma.hash[i], mb.hash[j], SHLN_DIGEST) == 0)
+		{
+			if (n > 0)
+				print_range("Changed:", run, addr, bsz);
+			n = 0;
+			continue;
+		}
+
+		if (n == 0)
+			run = addr;
+		n++;
+		diff++;
+		changed += (end - addr < bsz) ? end - addr : bsz;
+	}
+	if (n > 0)
+		print_range("Changed:", run, end, bsz);
+
+	if (ma.offset + ma.len > end)
+		print_range("Only A:", end > ma.offset ? end : ma.offset, ma.offset + ma.len, bsz);
+	if (mb.offset + mb.len > end)
+		print_range("Only B:", end > mb.offset ? end : mb.offset, mb.offset + mb.len, bsz);
+
+	printf("Diff: %u of %u common blocks differ (%llu bytes)\n", diff, total, changed);
+
+	rv = 0;
+
+free_b:
+
+	free(mb.hash);
+
+free_a:
+
+	free(ma.hash);
+
+	return rv;
+}
@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		ldsnap.h
+ *
+ * @brief 		Header file for deduplicated LD memory snapshots
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ * Store layout
+ *
+ *   <store>/blocks/<2 hex>/<62 hex> 	Blocks named by their SHA-256
+ *   <store>/manifests/<name> 			One text manifest per snapshot
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _LDSNAP_H
+#define _LDSNAP_H
+
+/* FILE
+ */
+#include <stdio.h>
+
+/* __u8
+ * __u64
+ */
+#include <linux/types.h>
+
+/* MACROS ====================================================================*/
+
+#define LSLN_BLOCK 			(64 << 10) 	//!< Bytes per block
+#define LSLN_PATH 			512 		//!< Max length of a path in the store
+#define LSLN_VERSION 		1
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+struct ldmem_xfer;
+
+/**
+ * Snapshot being taken. Filled by ldmem_run() through ldsnap_chunk()
+ */
+struct ldsnap
+{
+	const char *dir;		//!< Store directory
+	char path[LSLN_PATH];	//!< Manifest 
+	char tmp[LSLN_PATH];	//!< Manifest until the snapshot is complete
+	FILE *mf;
+	__u8 *block;			//!< Block being filled
+	unsigned used;
+	unsigned blocks;		//!< Blocks in the manifest
+	unsigned stored;		//!< Blocks that were not in the store yet
+	__u64 stored_bytes;
+};
+
+/* PROTOTYPES ================================================================*/
+
+int ldsnap_open(struct ldsnap *s, const char *dir, const char *name, struct ldmem_xfer *x);
+
+int ldsnap_chunk(void *arg, __u64 offset, __u8 *data, unsigned len);
+
+int ldsnap_close(struct ldsnap *s, int keep);
+
+int ldsnap_diff(const char *dir, const char *a, const char *b);
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_LDSNAP_H
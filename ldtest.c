@@ -0,0 +1,350 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		ldtest.c
+ *
+ * @brief 		Code file for the LD memory pattern and bandwidth test
+ *
+ * A test fills a range of LD memory with a pattern in one pipelined write
+ * pass and reads it back in one pipelined read pass, comparing each chunk 
+ * as it arrives. The passes are repeated for each requested chunk size so
+ * the throughput and latency of the FM API memory path can be compared.
+ * Every pattern is a function of the offset of each DWord, so any chunk can
+ * be generated on its own
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* printf()
+ */
+#include <stdio.h>
+
+/* calloc()
+ * free()
+ * strtoul()
+ */
+#include <stdlib.h>
+
+/* memcmp()
+ * memcpy()
+ * memset()
+ */
+#include <string.h>
+
+/* strcasecmp()
+ */
+#include <strings.h>
+
+#include <pthread.h>
+
+#include <fmapi.h>
+#include <emapi.h>
+
+#include "ldtest.h"
+#include "ldmem.h"
+#include "fmapi_handler.h"
+#include "options.h"
+#include "snapshot.h"
+
+/* MACROS ====================================================================*/
+
+#define LTLN_MISMATCHES 	8 		//!< Mismatches printed per test
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * State of one test shared with the chunk source and sink
+ */
+struct ldtest_ctx
+{
+	int pattern;			//!< [LTPT]
+	__u64 seed;
+	__u64 base;				//!< Offset of the first DWord of the test
+	__u8 *expect;			//!< Scratch buffer of one chunk
+	__u64 mismatches;		//!< DWords that did not match in this read pass
+	__u64 printed;			//!< Mismatches printed in all read passes
+};
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * String representation of LTPT Enumeration
+ */
+static const char *STR_LTPT[] = {
+	"zeros",
+	"ones",
+	"addr",
+	"prng"
+};
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Return the pattern [LTPT] of a name, or -1 if the name is not valid
+ */
+int ldtest_pattern(const char *name)
+{
+	int i;
+
+	for ( i = 0 ; i < LTPT_MAX ; i++ )
+		if (strcasecmp(name, STR_LTPT[i]) == 0)
+			return i;
+
+	return -1;
+}
+
+/**
+ * Return the name of a pattern [LTPT]
+ */
+const char *ldtest_pattern_name(int pattern)
+{
+	if (pattern < 0 || pattern >= LTPT_MAX)
+		return NULL;
+	return STR_LTPT[pattern];
+}
+
+/**
+ * Return the value of the DWord at an offset
+ */
+static __u32 pattern_dword(struct ldtest_ctx *c, __u64 offset)
+{
+	__u64 i, z;
+
+	i = (offset - c->base) / 4;
+
+	switch (c->pattern)
+	{
+		case LTPT_ONES: 	return 1u << (i % 32);
+		case LTPT_ADDR: 	return (__u32) offset;
+		case LTPT_PRNG:
+			// splitmix64 of the DWord index
+			z = c->seed + (i + 1) * 0x9E3779B97F4A7C15ULL;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return (__u32) (z ^ (z >> 31));
+		default: 			return 0;
+	}
+}
+
+/**
+ * Fill a buffer with the pattern of the DWords starting at an offset
+ */
+static void pattern_fill(struct ldtest_ctx *c, __u64 offset, __u8 *data, unsigned len)
+{
+	__u32 v;
+	unsigned i;
+
+	if (c->pattern == LTPT_ZEROS)
+	{
+		memset(data, 0, len);
+		return;
+	}
+
+	for ( i = 0 ; i + 4 <= len ; i += 4 )
+	{
+		v = pattern_dword(c, offset + i);
+		memcpy(&data[i], &v, 4);
+	}
+}
+
+/**
+ * Source of the write pass
+ */
+static int fill_chunk(void *arg, __u64 offset, __u8 *data, unsigned len)
+{
+	pattern_fill(arg, offset, data, len);
+	return 0;
+}
+
+/**
+ * Sink of the read pass. Compares a chunk with the pattern
+ *
+ * The whole chunk is compared with memcmp() and is only walked DWord by 
+ * DWord if it differs
+ */
+static int check_chunk(void *arg, __u64 offset, __u8 *data, unsigned len)
+{
+	struct ldtest_ctx *c = arg;
+	__u32 want, got;
+	unsigned i;
+
+	pattern_fill(c, offset, c->expect, len);
+
+	if (memcmp(data, c->expect, len) == 0)
+		return 0;
+
+	for ( i = 0 ; i + 4 <= len ; i += 4 )
+	{
+		if (memcmp(&data[i], &c->expect[i], 4) == 0)
+			continue;
+
+		c->mismatches++;
+		if (c->printed++ >= LTLN_MISMATCHES)
+			continue;
+
+		memcpy(&want, &c->expect[i], 4);
+		memcpy(&got, &data[i], 4);
+		printf("Mismatch at 0x%llx: expected 0x%08x read 0x%08x\n", offset + i, want, got);
+	}
+
+	return 0;
+}
+
+/**
+ * Parse the --chunk list into chunk sizes
+ *
+ * Sizes are rounded down to a multiple of 4 and limited to max
+ *
+ * @return Number of chunk sizes
+ */
+static int parse_chunks(unsigned *list, const char *str, unsigned max)
+{
+	char *end;
+	unsigned long v;
+	int n;
+
+	n = 0;
+
+	while (str != NULL && *str != 0 && n < LTLN_CHUNKS)
+	{
+		v = strtoul(str, &end, 0);
+		if (end == str)
+			break;
+
+		v &= ~3UL;
+		if (v > max)
+		{
+			printf("Warning: Chunk size %lu exceeds the message limit, using %u\n", v, max);
+			v = max;
+		}
+		if (v > 0)
+			list[n++] = v;
+
+		str = (*end == ',') ? end + 1 : end;
+	}
+
+	if (n == 0)
+		list[n++] = max;
+
+	return n;
+}
+
+/**
+ * Run an ld test command from the CLI options
+ *
+ * @param fn 	Function to read sections of the switch state with. Used to
+ * 				negotiate the message limit if it is not known yet
+ * @return 		0 if every pass completed without a mismatch. Non zero otherwise
+ */
+int ldtest_run(struct mctp *m, int (*fn)(struct mctp *m, unsigned mask))
+{
+	struct ldtest_ctx c;
+	struct ldmem_xfer wr, rd;
+	unsigned chunks[LTLN_CHUNKS], max;
+	__u64 errors;
+	double ws, rs;
+	int rv, i, n;
+
+	rv = 1;
+	errors = 0;
+
+	// The chunk size depends on the negotiated message limit
+	if (cxls->msg_rsp_limit_n == 0 && fn(m, JKSN_BIT(JKSN_SWITCH)) != 0)
+		printf("Warning: Could not read message limit, using %u byte requests\n", CLMR_MAX_LD_MEM_LEN);
+
+	pthread_mutex_lock(&cxls->mtx);
+	max = ldmem_chunk(cxls);
+	pthread_mutex_unlock(&cxls->mtx);
+
+	n = parse_chunks(chunks, opts[CLOP_CHUNK].str, max);
+
+	memset(&c, 0, sizeof(c));
+	memset(&wr, 0, sizeof(wr));
+
+	c.pattern 	= opts[CLOP_PATTERN].set ? opts[CLOP_PATTERN].val : LTPT_ADDR;
+	c.seed 		= opts[CLOP_SEED].u64;
+	c.base 		= opts[CLOP_OFFSET].u64;
+	c.expect 	= calloc(1, max);
+	if (c.expect == NULL)
+		goto end;
+
+	wr.ppid 	= opts[CLOP_PPID].u8;
+	wr.ldid 	= opts[CLOP_LDID].set ? opts[CLOP_LDID].u16 : 0;
+	wr.fdbe 	= 0xF;
+	wr.ldbe 	= 0xF;
+	wr.offset 	= opts[CLOP_OFFSET].u64;
+	wr.len 		= opts[CLOP_LEN].len;
+	wr.window 	= cmd_window_size();
+	wr.arg 		= &c;
+
+	printf("LD test: port %d LD %d offset 0x%llx length 0x%llx pattern %s", 
+		wr.ppid, wr.ldid, wr.offset, wr.len, ldtest_pattern_name(c.pattern));
+	if (c.pattern == LTPT_PRNG)
+		printf(" seed 0x%llx", c.seed);
+	printf(" window %d\n", wr.window);
+
+	printf("\n");
+	printf(" Chunk    Write MB/s  Write req/s  Write lat us    Read MB/s   Read req/s   Read lat us   Errors\n");
+	printf("------  ------------ ------------ ------------- ------------ ------------ ------------- --------\n");
+
+	rv = 0;
+	for ( i = 0 ; i < n ; i++ )
+	{
+		// Write pass
+		wr.write 	= 1;
+		wr.chunk 	= chunks[i];
+		wr.fn 		= fill_chunk;
+
+		// ldmem_run() clamps the window to the chunks of the pass
+		wr.window 	= cmd_window_size();
+		if (ldmem_run(m, &wr))
+		{
+			printf("Error: Write pass with %u byte chunks failed at 0x%llx\n", chunks[i], wr.offset + wr.bytes);
+			rv = 1;
+			break;
+		}
+
+		// Read back pass
+		rd 			= wr;
+		rd.write 	= 0;
+		rd.fn 		= check_chunk;
+		c.mismatches = 0;
+		if (ldmem_run(m, &rd))
+		{
+			printf("Error: Read pass with %u byte chunks failed at 0x%llx\n", chunks[i], rd.offset + rd.bytes);
+			rv = 1;
+			break;
+		}
+
+		ws = wr.seconds > 0 ? wr.seconds : 1e-9;
+		rs = rd.seconds > 0 ? rd.seconds : 1e-9;
+
+		printf("%6u  %12.2f %12.0f %6.0f/%6.0f %12.2f %12.0f %6.0f/%6.0f %8llu\n", chunks[i],
+			wr.bytes / ws / 1e6, wr.requests / ws, 
+			wr.requests ? wr.lat_sum / 1e3 / wr.requests : 0, wr.lat_max / 1e3, 
+			rd.bytes / rs / 1e6, rd.requests / rs, 
+			rd.requests ? rd.lat_sum / 1e3 / rd.requests : 0, rd.lat_max / 1e3, 
+			c.mismatches);
+
+		errors += c.mismatches;
+	}
+
+	printf("\nLatency is avg/max per request. %llu DWords did not match\n", errors);
+
+	if (errors)
+		rv = 1;
+
+end:
+
+	free(c.expect);
+
+	return rv;
+}
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		ldtest.h
+ *
+ * @brief 		Header file for the LD memory pattern and bandwidth test
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _LDTEST_H
+#define _LDTEST_H
+
+/* struct mctp
+ */
+#include <mctp.h>
+
+/* MACROS ====================================================================*/
+
+#define LTLN_CHUNKS 		8 		//!< Max chunk sizes of one test
+
+/* ENUMERATIONS ==============================================================*/
+
+/**
+ * Fill pattern of an LD memory test (PT)
+ */
+enum _LTPT
+{
+	LTPT_ZEROS 		= 0,
+	LTPT_ONES 		= 1,	//!< Walking ones: DWord i holds 1 << (i % 32)
+	LTPT_ADDR 		= 2,	//!< Each DWord holds its own offset
+	LTPT_PRNG 		= 3,	//!< Seeded pseudo random data
+	LTPT_MAX
+};
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+int ldtest_pattern(const char *name);
+
+const char *ldtest_pattern_name(int pattern);
+
+int ldtest_run(struct mctp *m, int (*fn)(struct mctp *m, unsigned mask));
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_LDTEST_H
@@ -33,6 +33,15 @@
 
 #include <errno.h>
 
+/* pthread_create()
+ * pthread_join()
+ */
+#include <pthread.h>
+
+/* clock_gettime()
+ */
+#include <time.h>
+
 /* autl_prnt_buf()
  */
 #include <arrayutils.h>
@@ -52,8 +61,22 @@
 #include "ctrl_handler.h"
 #include "emapi_handler.h"
 #include "fmapi_handler.h"
+#include "batch.h"
+#include "binding.h"
 #include "cmd_encoder.h"
+#include "daemon.h"
+#include "events.h"
+#include "ldmem.h"
+#include "ldtest.h"
+#include "ldsnap.h"
+#include "cfgdump.h"
+#include "caps.h"
+#include "regs.h"
+#include "offline.h"
 #include "options.h"
+#include "snapshot.h"
+#include "view.h"
+#include "watch.h"
 
 /* MACROS ====================================================================*/
 
@@ -85,10 +108,11 @@
  #define EXIT(rc)
 #endif // JACK_VERBOSE
 
-#define JKLN_PORTS 			32
-#define JKLN_VCSS 			32
-#define JKLN_VPPBS  		256
+#define JKLN_VCSIDS 		256 	//!< VCS IDs are 8 bit
 #define JKLN_RSP_MSG_N 		13
+#define JKLN_PORTS_PER_MSG 	128 	//!< Port info blocks (16B) per 2^JKLN_RSP_MSG_N response
+#define JKLN_CACHE_AGE 		300 	//!< Default max age in seconds of a snapshot section
+#define JKLN_REFRESH 		4 		//!< Max read back requests after one command
 
 /* ENUMERATIONS ==============================================================*/
 
@@ -101,156 +125,546 @@
 
 struct cxl_switch *cxls;
 
+/**
+ * Apply the result of each command to the cached switch state
+ *
+ * Set in daemon and batch mode where the cache outlives a single command
+ */
+static int writeback;
+
 /* FUNCTIONS =================================================================*/
 
 
+/**
+ * Handler for responses to all message types
+ *
+ * Blocking submissions are woken up with their semaphore. Asynchronous 
+ * submissions have their completion function called on this thread. 
+ * Unsolicited messages from the endpoint arrive in an action of their own 
+ * with the message in ma->req. EM API event notifications are queued for the 
+ * events consumer and the action is retired
+ */
 int simple_handler(struct mctp *m, struct mctp_action *ma)
 {
 	m->dummy = 0;
 	if (ma->sem != NULL)
 		sem_post(ma->sem);
+	else if (ma->fn_completed != NULL)
+		ma->fn_completed(m, ma);
+	else 
+	{
+		if (ma->req != NULL && ma->req->type == MCMT_CSE)
+			events_post(ma->req);
+		mctp_retire(m, ma);
+	}
 	return 0;
 }
 
+/**
+ * Completion function to apply an async FM API response to the cached state
+ */
+static void update_completed(struct mctp *m, struct mctp_action *ma)
+{
+	fmapi_update(m, ma);
+}
+
+/**
+ * Size the window of a discovery stage to the number of its requests
+ *
+ * The requests of a stage are independent, so all of them are kept in
+ * flight unless --window sets a limit. cmd_window_resize() caps the window
+ * at the FM API tag space
+ */
+static void stage_window(struct cmd_window *w, int n)
+{
+	if (!opts[CLOP_WINDOW].set)
+		cmd_window_resize(w, n);
+}
 
-int init_switch(struct mctp *m)
+/**
+ * Return the snapshot sections [JKSN] that are older than age seconds
+ *
+ * A section that others are discovered from marks those stale as well
+ *
+ * @return Bitmask of JKSN_BIT() values
+ */
+static unsigned stale_sections(__u64 age)
+{
+	unsigned mask;
+	int i;
+
+	mask = 0;
+	for ( i = 0 ; i < JKSN_MAX ; i++ )
+		if (snapshot_age(i) > age)
+			mask |= JKSN_BIT(i);
+
+	if (mask & JKSN_BIT(JKSN_SWITCH))
+		mask = JKSN_ALL;
+	if (mask & JKSN_BIT(JKSN_PORTS))
+		mask |= JKSN_BIT(JKSN_CFGSPACE) | JKSN_BIT(JKSN_MLDS);
+
+	return mask;
+}
+
+/**
+ * Fetch sections of the state of the remote switch into the cached copy
+ *
+ * Discovery is a pipeline of stages. Requests within a stage do not depend on
+ * each other and are all kept in flight through one window. Each stage waits
+ * only for the responses it needs from the previous stage:
+ *
+ * Stage 1: ISC Identity, Set Msg Limit, BOS and PSC Identity 
+ * Stage 2: Port status of every port and status of every VCS. Needs the 
+ *          number of ports and VCSs from stage 1
+ * Stage 3: Config space header of every present port and the MCC info of 
+ *          every MLD. Needs the port status from stage 2
+ * Stage 4: LD allocations and QoS state of every MLD. Needs the MLD object 
+ *          that the MCC info response of stage 3 allocates
+ *
+ * Each stage takes about one round trip per JKLN_CMD_WINDOW_MAX requests, 
+ * e.g. stage 3 of a 32 port switch with 16 MLDs sends ~530 requests and takes
+ * three round trips
+ *
+ * Only the requests that fill the sections in mask are sent. The sections 
+ * that are skipped must already be present in the cache (e.g. from a 
+ * snapshot) since later stages depend on them
+ *
+ * @param w 		Window to keep the requests in flight through
+ * @param mask 	Bitmask of JKSN_BIT() values of the sections to refresh
+ * @return 		0 upon success. Non zero otherwise
+ */
+static int discover(struct mctp *m, struct cmd_window *w, unsigned mask)
 {
 	INIT
-	struct mctp_action *ma;
 	struct cxl_port *p;
 	struct fmapi_msg msg, sub;
+	__u8 ppids[JKLN_PORTS_PER_MSG];
+	int rv, i, k, n, num;
 
 	ENTER 
 
-	int rv;
-
 	rv = 1;
-	ma = NULL;
 
-	STEP // 1: ISC - Identity 
+	STEP // 1: Identity, message limit & background operation status
+	if (!(mask & JKSN_BIT(JKSN_SWITCH)))
+		goto ports;
+
+	stage_window(w, 4);
+
 	fmapi_fill_isc_id(&msg);
-	if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL)
-		goto fail;
-	fmapi_update(m, ma);
-	
-	STEP // 2: ISC - Set msg limit 
+	if (submit_fmapi_async(m, w, &msg, NULL, update_completed, NULL) == NULL)
+		goto end;
+
 	fmapi_fill_isc_set_msg_limit(&msg, JKLN_RSP_MSG_N);
-	if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL)
-		goto fail;
+	if (submit_fmapi_async(m, w, &msg, NULL, update_completed, NULL) == NULL)
+		goto end;
 
-	STEP // 3: ISC - BOS 
 	fmapi_fill_isc_bos(&msg);
-	if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL)
-		goto fail;
-	fmapi_update(m, ma);
+	if (submit_fmapi_async(m, w, &msg, NULL, update_completed, NULL) == NULL)
+		goto end;
 
-	STEP // 4: PSC - Identify Switch Device
 	fmapi_fill_psc_id(&msg);
-	if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL)
-		goto fail;
-	fmapi_update(m, ma);
+	if (submit_fmapi_async(m, w, &msg, NULL, update_completed, NULL) == NULL)
+		goto end;
+
+	if (cmd_window_wait(w, JKLN_CMD_TIMEOUT_SEC) || w->failed)
+		goto end;
+
+ports:
 
-	STEP // 5: PSC - Get Port Status 
-	for ( int i = 0 ; i < cxls->num_ports ; i++)
+	STEP // 2: Status of all ports & all VCSs 
+	num = (mask & JKSN_BIT(JKSN_VCSS)) ? cxls->num_vcss : 0;
+	if (mask & JKSN_BIT(JKSN_PORTS))
+		num += (cxls->num_ports + JKLN_PORTS_PER_MSG - 1) / JKLN_PORTS_PER_MSG;
+	stage_window(w, num);
+
+	if (!(mask & JKSN_BIT(JKSN_PORTS)))
+		goto vcss;
+
+	if (cxls->num_ports <= JKLN_PORTS_PER_MSG)
 	{
-		fmapi_fill_psc_get_port(&msg, i);
-		if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL)
-			goto fail;
-		fmapi_update(m, ma);
+		fmapi_fill_psc_get_all_ports(&msg);
+		if (submit_fmapi_async(m, w, &msg, NULL, update_completed, NULL) == NULL)
+			goto end;
+	}
+	else
+	{
+		// Split the port list so each response fits the message limit 
+		for ( i = 0 ; i < cxls->num_ports ; i += n )
+		{
+			n = cxls->num_ports - i;
+			if (n > JKLN_PORTS_PER_MSG)
+				n = JKLN_PORTS_PER_MSG;
+			for ( k = 0 ; k < n ; k++ )
+				ppids[k] = i + k;
+			fmapi_fill_psc_get_ports(&msg, n, ppids);
+			if (submit_fmapi_async(m, w, &msg, NULL, update_completed, NULL) == NULL)
+				goto end;
+		}
 	}
 
-	STEP // 6: VSC - Get VCS Status 
-	for ( int i = 0 ; i < cxls->num_vcss ; i++)
+vcss:
+
+	for ( i = 0 ; i < cxls->num_vcss && (mask & JKSN_BIT(JKSN_VCSS)) ; i++ )
 	{
 		fmapi_fill_vsc_get_vcs(&msg, i, 0, 255);
-		if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL)
-			goto fail;
-		fmapi_update(m, ma);
+		if (submit_fmapi_async(m, w, &msg, NULL, update_completed, NULL) == NULL)
+			goto end;
 	}
 
-	STEP // 7; PCI Config Space - For each port, get first 64 Bytes of config space
-	for ( int i = 0 ; i < cxls->num_ports ; i++)
+	// Only the port status is needed by the next stage, but the VCS requests 
+	// are already in flight and share the same window
+	if (cmd_window_wait(w, JKLN_CMD_TIMEOUT_SEC))
+		goto end;
+
+	STEP // 3: Config space header of present ports & MCC info of MLDs
+	num = 0;
+	for ( i = 0 ; i < cxls->num_ports ; i++ )
+	{
+		p = &cxls->ports[i];
+		if (p->prsnt && (mask & JKSN_BIT(JKSN_CFGSPACE)))
+			num += 16;
+		if (p->prsnt && p->dt == FMDT_CXL_TYPE_3_POOLED && (mask & JKSN_BIT(JKSN_MLDS)))
+			num += 1;
+	}
+	stage_window(w, num);
+
+	for ( i = 0 ; i < cxls->num_ports ; i++ )
 	{
 		p = &cxls->ports[i];
 
 		if (!p->prsnt)
 			continue;
 
-		for ( int k = 0 ; k < 64 ; k+=4)
+		for ( k = 0 ; k < 64 && (mask & JKSN_BIT(JKSN_CFGSPACE)) ; k += 4 )
 		{
 			fmapi_fill_psc_cfg(&msg, i, k, 0, 0xF, FMCT_READ, NULL);
-			if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL) 
-				goto fail;
-			fmapi_update(m, ma);
+			if (submit_fmapi_async(m, w, &msg, NULL, update_completed, NULL) == NULL)
+				goto end;
 		}
+
+		if (p->dt != FMDT_CXL_TYPE_3_POOLED || !(mask & JKSN_BIT(JKSN_MLDS)))
+			continue;
+
+		fmapi_fill_mcc_get_info(&sub);
+		fmapi_fill_mpc_tmc(&msg, i, MCMT_CXLCCI, &sub);
+		if (submit_fmapi_async(m, w, &msg, NULL, update_completed, NULL) == NULL)
+			goto end;
 	}
 
-	STEP // 8: MCC - For each port, if an MLD device, fetch MCC data
-	for ( int i = 0 ; i < cxls->num_ports ; i++)
+	// The MCC info response allocates the MLD object the next stage fills 
+	if (cmd_window_wait(w, JKLN_CMD_TIMEOUT_SEC))
+		goto end;
+
+	STEP // 4: Allocation & QoS state of MLDs
+	if (!(mask & JKSN_BIT(JKSN_MLDS)))
+		goto done;
+
+	num = 0;
+	for ( i = 0 ; i < cxls->num_ports ; i++ )
 	{
 		p = &cxls->ports[i];
+		if (p->prsnt && p->dt == FMDT_CXL_TYPE_3_POOLED && p->mld != NULL)
+			num += 5;
+	}
+	stage_window(w, num);
 
-		if (p->dt != FMDT_CXL_TYPE_3_POOLED)
+	for ( i = 0 ; i < cxls->num_ports ; i++ )
+	{
+		p = &cxls->ports[i];
+
+		if (!p->prsnt || p->dt != FMDT_CXL_TYPE_3_POOLED || p->mld == NULL)
 			continue;
 
-		// MCC - Get Info 
-		fmapi_fill_mcc_get_info(&sub);
-		fmapi_fill_mpc_tmc(&msg, i, MCMT_CXLCCI, &sub);
-		if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL) 
-			goto fail;
-		fmapi_update(m, ma);
+		for ( k = 0 ; k < 5 ; k++ )
+		{
+			switch (k)
+			{
+				case 0: fmapi_fill_mcc_get_alloc(&sub, 0, 0);		break; // MCC - Get LD Alloc 
+				case 1: fmapi_fill_mcc_get_qos_ctrl(&sub);			break; // MCC - Get QoS Control
+				case 2: fmapi_fill_mcc_get_qos_alloc(&sub, 0, 0);	break; // MCC - Get QoS BW Alloc
+				case 3: fmapi_fill_mcc_get_qos_limit(&sub, 0, 0);	break; // MCC - Get QoS BW Limit
+				case 4: fmapi_fill_mcc_get_qos_status(&sub);		break; // MCC - Get QoS Status 
+			}
+			fmapi_fill_mpc_tmc(&msg, i, MCMT_CXLCCI, &sub);
+			if (submit_fmapi_async(m, w, &msg, NULL, update_completed, NULL) == NULL)
+				goto end;
+		}
+	}
 
-		// MCC - Get LD Alloc 
-		fmapi_fill_mcc_get_alloc(&sub, 0, 0);
-		fmapi_fill_mpc_tmc(&msg, i, MCMT_CXLCCI, &sub);
-		if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL) 
-			goto fail;
-		fmapi_update(m, ma);
+	if (cmd_window_wait(w, JKLN_CMD_TIMEOUT_SEC))
+		goto end;
 
-		// MCC - Get QoS Control
-		fmapi_fill_mcc_get_qos_ctrl(&sub);
-		fmapi_fill_mpc_tmc(&msg, i, MCMT_CXLCCI, &sub);
-		if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL) 
-			goto fail;
-		fmapi_update(m, ma);
-		
-		// MCC - Get QoS BW Alloc
-		fmapi_fill_mcc_get_qos_alloc(&sub, 0, 0);
-		fmapi_fill_mpc_tmc(&msg, i, MCMT_CXLCCI, &sub);
-		if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL) 
-			goto fail;
-		fmapi_update(m, ma);
+done:
 
-		// MCC - Get QoS BW Limit
-		fmapi_fill_mcc_get_qos_limit(&sub, 0, 0);
-		fmapi_fill_mpc_tmc(&msg, i, MCMT_CXLCCI, &sub);
-		if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL) 
-			goto fail;
-		fmapi_update(m, ma);
+	rv = w->failed ? 1 : 0;
 
-		// MCC- - Get QoS Status 
-		fmapi_fill_mcc_get_qos_status(&sub);
-		fmapi_fill_mpc_tmc(&msg, i, MCMT_CXLCCI, &sub);
-		if ( (ma = submit_fmapi(m, &msg, 0, NULL, NULL, NULL, NULL)) == NULL) 
-			goto fail;
-		fmapi_update(m, ma);
+end:
+
+	EXIT(rv)
+	
+	return rv;
+}
+
+/**
+ * Discover the remote switch into the cached copy and print a summary 
+ *
+ * @param mask 	Bitmask of JKSN_BIT() values of the sections to refresh
+ * @return 		0 upon success. Non zero otherwise
+ */
+int init_switch(struct mctp *m, unsigned mask)
+{
+	struct cmd_window w;
+	struct timespec start, stop;
+	int rv;
+
+	rv = 1;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	if (cmd_window_init(&w, cmd_window_size()))
+		goto end;
+
+	rv = discover(m, &w, mask);
+	if (rv != 0)
+	{
+		printf("ERR: Switch discovery failed. Submitted: %u Completed: %u Failed: %u\n", w.submitted, w.completed, w.failed);
+
+		// Requests still in flight reference the window, so it must drain 
+		// before it goes out of scope. The MCTP library fails each request 
+		// once its own timeout expires
+		while (cmd_window_wait(&w, JKLN_CMD_TIMEOUT_SEC))
+			;
+	}
+	else 
+	{
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+		printf("Switch discovery: %u ports %u VCSs %u requests %u failed in %.3f ms\n", 
+			cxls->num_ports, cxls->num_vcss, w.submitted, w.failed,
+			((stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec)) / 1e6);
+	}
+
+	cmd_window_free(&w);
+
+end:
+
+	return rv;
+}
+
+/**
+ * Refresh sections of the cached copy of the remote switch without output
+ *
+ * Used by watch mode on every poll
+ *
+ * @param mask 	Bitmask of JKSN_BIT() values of the sections to refresh
+ * @return 		0 upon success. Non zero otherwise
+ */
+int poll_switch(struct mctp *m, unsigned mask)
+{
+	struct cmd_window w;
+	int rv;
+
+	if (cmd_window_init(&w, cmd_window_size()))
+		return 1;
+
+	rv = discover(m, &w, mask);
+
+	while (cmd_window_wait(&w, JKLN_CMD_TIMEOUT_SEC))
+		;
+
+	cmd_window_free(&w);
+
+	return rv;
+}
+
+/**
+ * Refresh the cached state of one port and of the VCSs it is part of
+ *
+ * Used for event notifications. Runs on the events thread of a daemon, so 
+ * the global options must not be used
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+int refresh_port(struct mctp *m, int ppid)
+{
+	struct cmd_window w;
+	struct fmapi_msg msg;
+	const struct cxl_view *view;
+	const struct snap_vcs *v;
+	__u8 vcss[JKLN_VCSIDS];
+	__u8 p;
+	unsigned token;
+	int rv, i, k, n;
+
+	rv = 1;
+	n = 0;
+	p = ppid;
+
+	// Find the VCSs with the port as USP or bound to a vPPB 
+	view = view_acquire(&token);
+	for ( i = 0 ; view != NULL && i < (int) view->num_vcss && n < JKLN_VCSIDS ; i++ )
+	{
+		v = &view->vcss[i];
+		for ( k = 0 ; k < v->num ; k++ )
+			if (v->vppbs[k].bind_status != FMBS_UNBOUND && v->vppbs[k].ppid == p)
+				break;
+		if (v->uspid == p || k < v->num)
+			vcss[n++] = i;
+	}
+	view_release(token);
+
+	if (cmd_window_init(&w, JKLN_REFRESH))
+		goto end;
+
+	fmapi_fill_psc_get_ports(&msg, 1, &p);
+	if (submit_fmapi_async(m, &w, &msg, NULL, update_completed, NULL) == NULL)
+		goto drain;
+
+	for ( i = 0 ; i < n ; i++ )
+	{
+		fmapi_fill_vsc_get_vcs(&msg, vcss[i], 0, 255);
+		if (submit_fmapi_async(m, &w, &msg, NULL, update_completed, NULL) == NULL)
+			goto drain;
 	}
 
 	rv = 0;
 
-	goto end;
+drain:
 
-fail:
-	
-	printf("ERR: submit_fmapi() returned NULL. rv: %d\n", rv);
+	// Requests in flight reference the window, so it must drain 
+	while (cmd_window_wait(&w, JKLN_CMD_TIMEOUT_SEC))
+		;
+
+	if (w.failed)
+		rv = 1;
+
+	cmd_window_free(&w);
 
 end:
 
-	EXIT(rv)
-	
 	return rv;
 }
 
+/**
+ * Thread of the daemon that applies event notifications to the cache
+ */
+static void *events_thread(void *arg)
+{
+	events_run((struct mctp*) arg, refresh_port, 0, 0);
+	return NULL;
+}
+
+/**
+ * Initialize the cached copy of the remote switch state 
+ *
+ * If a snapshot file was given, it is loaded first and only the sections 
+ * older than the max cache age are fetched from the switch. The snapshot is 
+ * rewritten after a successful refresh
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+int load_switch(struct mctp *m)
+{
+	__u64 age;
+	unsigned mask;
+	int rv, i;
+
+	mask = JKSN_ALL;
+
+	if (opts[CLOP_CACHE].set && snapshot_load(cxls, opts[CLOP_CACHE].str) == 0)
+	{
+		age = opts[CLOP_CACHE_AGE].set ? opts[CLOP_CACHE_AGE].u32 : JKLN_CACHE_AGE;
+		mask = stale_sections(age);
+
+		printf("Switch snapshot: loaded %s, refreshing:", opts[CLOP_CACHE].str);
+		for ( i = 0 ; i < JKSN_MAX ; i++ )
+			if (mask & JKSN_BIT(i))
+				printf(" %s", snapshot_section(i));
+		printf("%s\n", mask ? "" : " none");
+
+		// Readers see the loaded state even if nothing is refreshed
+		pthread_mutex_lock(&cxls->mtx);
+		view_publish(cxls);
+		pthread_mutex_unlock(&cxls->mtx);
+	}
+
+	if (mask == 0)
+		return 0;
+
+	rv = init_switch(m, mask);
+	if (rv == 0 && opts[CLOP_CACHE].set)
+		snapshot_save(cxls, opts[CLOP_CACHE].str);
+
+	return rv;
+}
+
+/**
+ * Apply a completed FM API command to the cached switch state
+ *
+ * The entries the command changed are updated in place and then read back 
+ * from the switch so the cache holds their final state
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+int fmapi_writeback(struct mctp *m, struct mctp_action *ma)
+{
+	struct cmd_window w;
+	struct fmapi_hdr hdr;
+	struct fmapi_msg *list;
+	int rv, i, n;
+
+	rv = 1;
+	list = NULL;
+
+	// Failed commands did not change the switch 
+	fmapi_deserialize(&hdr, ((struct fmapi_buf*) ma->rsp->payload)->hdr, FMOB_HDR, NULL);
+	if (hdr.return_code != FMRC_SUCCESS && hdr.return_code != FMRC_BACKGROUND_OP_STARTED)
+		goto end;
+
+	if (fmapi_apply(m, ma) != 0)
+		goto end;
+
+	list = calloc(JKLN_REFRESH, sizeof(struct fmapi_msg));
+	if (list == NULL)
+		goto end;
+
+	n = fmapi_refresh(ma, list, JKLN_REFRESH);
+	if (n == 0)
+	{
+		rv = 0;
+		goto end;
+	}
+
+	if (cmd_window_init(&w, n))
+		goto end;
+
+	for ( i = 0 ; i < n ; i++ )
+		if (submit_fmapi_async(m, &w, &list[i], NULL, update_completed, NULL) == NULL)
+			break;
+
+	// Requests in flight reference the window, so it must drain 
+	while (cmd_window_wait(&w, JKLN_CMD_TIMEOUT_SEC))
+		;
+
+	rv = (i < n || w.failed) ? 1 : 0;
+
+	cmd_window_free(&w);
+
+end:
+
+	free(list);
+
+	return rv;
+}
+
+/**
+ * Return non zero if cmd [CLCM] runs until interrupted (watch & events)
+ */
+static int is_monitor(int cmd)
+{
+	return cmd == CLCM_WATCH_PORT || cmd == CLCM_WATCH_VCS || cmd == CLCM_WATCH_QOS || cmd == CLCM_EVENTS;
+}
+
 void list(struct mctp *m)
 {
 	m->dummy = 0;
@@ -259,13 +673,17 @@ void list(struct mctp *m)
 
 /**
  * The Jack main run function 
+ *
+ * @return 0 upon success. Non zero otherwise
  */
-void run(struct mctp *m)
+int run(struct mctp *m)
 {
 	struct mctp_action *ma;
+	int rv;
 
 	// Initialize variables
 	ma = NULL;
+	rv = 1;
 
 	// 1: If no command then exit 
 	if ( !opts[CLOP_CMD].set )
@@ -276,7 +694,32 @@ void run(struct mctp *m)
 	//	init_switch(m);
 
 	if (opts[CLOP_CMD].val == CLCM_LIST)
+	{
 		list(m);
+		rv = 0;
+	}
+	else if (opts[CLOP_CMD].val == CLCM_DAEMON || opts[CLOP_CMD].val == CLCM_BATCH || is_monitor(opts[CLOP_CMD].val))
+		printf("Error: Command cannot be nested in a daemon or batch\n");
+	else if (opts[CLOP_CMD].val == CLCM_SHOW_BINDING)
+	{
+		// Read the VCSs only if the cache does not hold them yet 
+		if (snapshot_generation(JKSN_VCSS) == 0 && poll_switch(m, JKSN_BIT(JKSN_SWITCH) | JKSN_BIT(JKSN_VCSS)) != 0)
+			printf("Error: Could not read VCS state\n");
+		else
+			rv = binding_print(opts[CLOP_PPID].u8, opts[CLOP_LDID].set ? opts[CLOP_LDID].u16 : -1);
+	}
+	else if (opts[CLOP_CMD].val == CLCM_LD_MEM)
+		rv = ldmem_cmd(m, poll_switch);
+	else if (opts[CLOP_CMD].val == CLCM_LD_DUMP)
+		rv = ldmem_dump(m, poll_switch);
+	else if (opts[CLOP_CMD].val == CLCM_LD_TEST)
+		rv = ldtest_run(m, poll_switch);
+	else if ((opts[CLOP_CMD].val == CLCM_PORT_CONFIG || opts[CLOP_CMD].val == CLCM_LD_CONFIG) && opts[CLOP_DUMP].set)
+		rv = cfgdump_cmd(m, poll_switch);
+	else if (opts[CLOP_CMD].val == CLCM_PORT_CAPS || opts[CLOP_CMD].val == CLCM_LD_CAPS)
+		rv = caps_cmd(m, poll_switch);
+	else if (opts[CLOP_CMD].val == CLCM_REGS_RUN)
+		rv = regs_cmd(m);
 	else
 	{
 		// Submit Request 
@@ -289,20 +732,64 @@ void run(struct mctp *m)
 			goto end;
 		}
 
-		// Print out response 
+		// Print out response. The handler returns the message it consumed 
+		// to the free pool, so clear it before retiring the action
 		switch(ma->rsp->type)
 		{
-			case MCMT_CXLFMAPI:		fmapi_handler(m, ma->rsp, ma->req); break;
-			case MCMT_CSE:			emapi_handler(m, ma->rsp);			break;
-			case MCMT_CONTROL: 		ctrl_handler(m, ma->rsp);			break;
-			default:													break;
+			case MCMT_CXLFMAPI:
+				if (writeback)
+					fmapi_writeback(m, ma);
+				rv = fmapi_handler(m, ma->rsp, ma->req);
+				ma->req = NULL;
+				break;
+			case MCMT_CSE:			rv = emapi_handler(m, ma->rsp);				ma->rsp = NULL; break;
+			case MCMT_CONTROL: 		rv = ctrl_handler(m, ma->rsp);				ma->rsp = NULL; break;
+			default:																			break;
 		}
+
+		mctp_retire(m, ma);
 	}
 
 end:
 
-	return;
+	return rv;
+}
+
+/**
+ * Parse and run one command line on an existing MCTP session
+ *
+ * Used by the daemon to execute forwarded commands. The command line is 
+ * parsed into its own options array, which replaces the global one only once
+ * parsing is complete, since the events and MCTP threads read the verbosity 
+ * from it. The global options of the caller are restored after the call
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+int run_argv(struct mctp *m, int argc, char **argv)
+{
+	struct opt *saved, *o;
+	int rv;
+
+	// Parse options of this command line into a fresh options array
+	rv = options_parse_argv(&o, argc, argv, 0);
+	if (rv != 0)
+	{
+		printf("Error: Parse options failed:\n");
+		goto end;
+	}
+
+	saved = opts;
+	opts = o;
+
+	rv = run(m);
+
+	opts = saved;
+
+	options_free(o);
 
+end:
+
+	return rv;
 }
 
 /**
@@ -311,17 +798,22 @@ end:
  * STEPS 
  * 1: Parse CLI options
  * 2: Verify Command was requested 
- * 3: MCTP Init
- * 4: Configure MCTP 
- * 5: Run MCTP
- * 6: Free memory
+ * 3: Forward to daemon if one is running
+ * 4: MCTP Init
+ * 5: Configure MCTP 
+ * 6: Run MCTP
+ * 7: Free memory
  */
 int main(int argc, char* argv[]) 
 {
 	int rv;
 	struct mctp *m;
+	struct batch *b;
+	char path[JKLN_DAEMON_PATH_LEN];
+	char *sock;
 
 	rv = 1;
+	b = NULL;
 
 	// STEP 1: Parse CLI options
 	rv = options_parse(argc,argv);
@@ -331,9 +823,6 @@ int main(int argc, char* argv[])
 		goto end;
 	}
 
-	// Initialize global state 
-	cxls = cxls_init(JKLN_PORTS, JKLN_VCSS, JKLN_VPPBS);
-
 	// Verify Command was requested 
 	if (!opts[CLOP_CMD].set) 
 	{
@@ -342,6 +831,66 @@ int main(int argc, char* argv[])
 		goto end;
 	}
 
+	// Answer from a switch snapshot without connecting to the endpoint 
+	if (opts[CLOP_SNAPSHOT].set)
+	{
+		cxls = cxls_init(0, 0, 0);
+		rv = snapshot_load(cxls, opts[CLOP_SNAPSHOT].str);
+		if (rv != 0)
+			printf("Error: Could not load snapshot %s\n", opts[CLOP_SNAPSHOT].str);
+		else 
+			rv = offline_run(cxls);
+		cxls_free(cxls);
+		options_free(opts);
+		return rv;
+	}
+
+	// Snapshot diffs only read local manifests
+	if (opts[CLOP_CMD].val == CLCM_LD_SNAPSHOT_DIFF)
+	{
+		rv = ldsnap_diff(opts[CLOP_STORE].str, opts[CLOP_MANIFEST_A].str, opts[CLOP_MANIFEST_B].str);
+		options_free(opts);
+		return rv;
+	}
+
+	// Locate the daemon socket for this endpoint
+	sock = opts[CLOP_SOCKET].str;
+	if (sock == NULL)
+		sock = daemon_path(path, sizeof(path), opts[CLOP_TCP_ADDRESS].u32, opts[CLOP_TCP_PORT].u16);
+
+	// Forward the command to a running daemon if there is one. The command 
+	// line has already been validated by options_parse() above. Watch and 
+	// events run until interrupted so they keep their own session, as does
+	// a register script read from stdin. LD memory read to --raw or --outfile
+	// streams straight to its destination instead of being buffered whole 
+	// by the daemon
+	if (opts[CLOP_CMD].val != CLCM_DAEMON && opts[CLOP_CMD].val != CLCM_BATCH && opts[CLOP_CMD].val != CLCM_LIST && !is_monitor(opts[CLOP_CMD].val)
+		&& !(opts[CLOP_CMD].val == CLCM_REGS_RUN && !strcmp(opts[CLOP_INFILE].str, "-"))
+		&& !(opts[CLOP_CMD].val == CLCM_LD_MEM && (opts[CLOP_RAW].set || opts[CLOP_OUTFILE].set)))
+	{
+		if (daemon_client(sock, argc, argv, &rv) == 0)
+		{
+			options_free(opts);
+			return rv;
+		}
+	}
+
+	// Load and validate a batch file before connecting to the endpoint 
+	if (opts[CLOP_CMD].val == CLCM_BATCH)
+	{
+		b = batch_load(opts[CLOP_INFILE].str, argv[0]);
+		if (b == NULL || batch_check(b) != 0)
+		{
+			batch_free(b);
+			options_free(opts);
+			return 1;
+		}
+	}
+
+	// Initialize global state. It is sized from the Identify Switch Device
+	// response (or a loaded snapshot) once known 
+	cxls = cxls_init(0, 0, 0);
+
 	// MCTP Init
 	m = mctp_init();
 	if (m == NULL) 
@@ -369,17 +918,57 @@ int main(int argc, char* argv[])
 		goto stop;
 	}
 
+	// Keep the cache current across the commands of a daemon or batch 
+	writeback = (opts[CLOP_CMD].val == CLCM_DAEMON || opts[CLOP_CMD].val == CLCM_BATCH);
+
 	// Run Jack main sequence 
-	run(m);
+	if (opts[CLOP_CMD].val == CLCM_DAEMON)
+	{
+		pthread_t thread;
+		int threaded;
 
-	mctp_stop(m);
+		// Initialize cached copy of remote switch state 
+		if (opts[CLOP_NO_INIT].set == 0)
+			load_switch(m);
 
-	rv = 0;
+		// Apply event notifications to the cache while serving commands
+		threaded = (pthread_create(&thread, NULL, events_thread, m) == 0);
+
+		rv = daemon_serve(m, sock, run_argv);
+
+		if (threaded)
+		{
+			events_stop();
+			pthread_join(thread, NULL);
+		}
+
+		if (opts[CLOP_CACHE].set)
+			snapshot_save(cxls, opts[CLOP_CACHE].str);
+	}
+	else if (opts[CLOP_CMD].val == CLCM_BATCH)
+		rv = batch_run(m, b, run_argv);
+	else if (opts[CLOP_CMD].val == CLCM_EVENTS)
+	{
+		// Ports & VCS bindings are needed to target the refreshes
+		rv = poll_switch(m, JKSN_BIT(JKSN_SWITCH) | JKSN_BIT(JKSN_PORTS) | JKSN_BIT(JKSN_VCSS));
+		if (rv == 0)
+			rv = events_run(m, refresh_port, opts[CLOP_FOLLOW].set ? opts[CLOP_COUNT].u32 : 1, 1);
+	}
+	else if (is_monitor(opts[CLOP_CMD].val))
+		rv = watch_run(m, poll_switch);
+	else 
+		rv = run(m);
+
+	mctp_stop(m);
 
 stop:
 
-	// STEP 6: Free memory
+	// STEP 7: Free memory
+	batch_free(b);
 	mctp_free(m);
+	view_free();
+	binding_free();
+	cfgdump_free();
 	cxls_free(cxls);
 	options_free(opts);
 
@@ -0,0 +1,458 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		offline.c
+ *
+ * @brief 		Code file for answering show commands from a switch snapshot
+ *
+ * The response object a switch would have returned is built from the cached
+ * cxl_switch state and printed with the same functions used for live
+ * responses, so the output of a show command is identical online and
+ * offline. No MCTP connection is opened.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#define _GNU_SOURCE
+
+/* printf()
+ */
+#include <stdio.h>
+
+/* calloc()
+ * free()
+ */
+#include <stdlib.h>
+
+/* gettid()
+ */
+#include <unistd.h>
+
+#include <fmapi.h>
+#include <cxlstate.h>
+
+/* MCTP_VERBOSE_THREADS
+ */
+#include <mctp.h>
+
+#include "binding.h"
+#include "fmapi_handler.h"
+#include "offline.h"
+#include "options.h"
+#include "view.h"
+
+/* MACROS ====================================================================*/
+
+#ifdef JACK_VERBOSE
+ #define INIT 			unsigned step = 0;
+ #define ENTER 					if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_THREADS) 	printf("%d:%s Enter\n", 				gettid(), __FUNCTION__);
+ #define STEP 			step++; if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_STEPS) 		printf("%d:%s STEP: %u\n", 				gettid(), __FUNCTION__, step);
+ #define EXIT(rc) 				if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_THREADS)	printf("%d:%s Exit: %d\n", 				gettid(), __FUNCTION__,rc);
+#else
+ #define INIT
+ #define ENTER
+ #define STEP
+ #define EXIT(rc)
+#endif
+
+#define JKLN_LEN(a) 		(sizeof(a) / sizeof((a)[0]))
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Copy the cached state of one port into a Get Physical Port State entry
+ */
+static void fill_port(struct fmapi_psc_port_info *x, struct cxl_port *p, int ppid)
+{
+	x->ppid 	= ppid;
+	x->state 	= p->state;
+	x->dv 		= p->dv;
+	x->dt 		= p->dt;
+	x->cv 		= p->cv;
+	x->mlw 		= p->mlw;
+	x->nlw 		= p->nlw;
+	x->speeds 	= p->speeds;
+	x->mls 		= p->mls;
+	x->cls 		= p->cls;
+	x->ltssm 	= p->ltssm;
+	x->lane 	= p->lane;
+	x->lane_rev = p->lane_rev;
+	x->perst 	= p->perst;
+	x->prsnt 	= p->prsnt;
+	x->pwrctrl 	= p->pwrctrl;
+	x->num_ld 	= p->ld;
+}
+
+/**
+ * Build a response to a show command from the cached switch state
+ *
+ * @param s 	struct cxl_switch* cache to answer from
+ * @param msg 	struct fmapi_msg* to fill with the response header and object
+ * @return 		0 upon success, non zero otherwise
+ */
+static int fill_fmapi(struct cxl_switch *s, struct fmapi_msg *msg)
+{
+	int i, k, n, ppid;
+
+	switch (opts[CLOP_CMD].val)
+	{
+		case CLCM_SHOW_BOS:
+		{
+			struct fmapi_isc_bos *o = &msg->obj.isc_bos;
+
+			msg->hdr.opcode = FMOP_ISC_BOS;
+			o->running 	= s->bos_running;
+			o->pcnt 	= s->bos_pcnt;
+			o->opcode 	= s->bos_opcode;
+			o->rc 		= s->bos_rc;
+			o->ext 		= s->bos_ext;
+		}
+			break;
+
+		case CLCM_SHOW_IDENTITY:
+		{
+			struct fmapi_isc_id_rsp *o = &msg->obj.isc_id_rsp;
+
+			msg->hdr.opcode = FMOP_ISC_ID;
+			o->vid 	= s->vid;
+			o->did 	= s->did;
+			o->svid = s->svid;
+			o->ssid = s->ssid;
+			o->sn 	= s->sn;
+			o->size = s->max_msg_size_n;
+		}
+			break;
+
+		case CLCM_SHOW_MSG_LIMIT:
+		{
+			msg->hdr.opcode = FMOP_ISC_MSG_LIMIT_GET;
+			msg->obj.isc_msg_limit.limit = s->msg_rsp_limit_n;
+		}
+			break;
+
+		case CLCM_SHOW_SWITCH:
+		{
+			struct fmapi_psc_id_rsp *o = &msg->obj.psc_id_rsp;
+
+			msg->hdr.opcode = FMOP_PSC_ID;
+			o->ingress_port = s->ingress_port;
+			o->num_ports 	= s->num_ports;
+			o->num_vcss 	= s->num_vcss;
+			o->num_vppbs 	= s->num_vppbs;
+			o->active_vppbs = s->active_vppbs;
+			o->num_decoders = s->num_decoders;
+
+			for ( i = 0 ; i < s->num_ports && i / 8 < (int) JKLN_LEN(o->active_ports) ; i++ )
+				if (s->ports[i].state != FMPS_DISABLED)
+					o->active_ports[i/8] |= 1 << (i % 8);
+
+			for ( i = 0 ; i < s->num_vcss && i / 8 < (int) JKLN_LEN(o->active_vcss) ; i++ )
+				if (s->vcss[i].state == FMVS_ENABLED)
+					o->active_vcss[i/8] |= 1 << (i % 8);
+		}
+			break;
+
+		case CLCM_SHOW_PORT:
+		{
+			struct fmapi_psc_port_rsp *o = &msg->obj.psc_port_rsp;
+
+			msg->hdr.opcode = FMOP_PSC_PORT;
+
+			// Number of entries that fit in the response
+			n = JKLN_LEN(o->list);
+
+			if (opts[CLOP_PPID].set && opts[CLOP_PPID].num > 0)
+			{
+				for ( i = 0 ; i < (int) opts[CLOP_PPID].num && o->num < n ; i++ )
+				{
+					ppid = opts[CLOP_PPID].buf[i];
+					if (ppid < s->num_ports)
+						fill_port(&o->list[o->num++], &s->ports[ppid], ppid);
+				}
+			}
+			else if (opts[CLOP_PPID].set)
+			{
+				ppid = opts[CLOP_PPID].u8;
+				if (ppid >= s->num_ports)
+				{
+					printf("Error: Port %d is not in the snapshot\n", ppid);
+					return 1;
+				}
+				fill_port(&o->list[o->num++], &s->ports[ppid], ppid);
+			}
+			else if (opts[CLOP_ALL].set)
+			{
+				for ( i = 0 ; i < s->num_ports && o->num < n ; i++ )
+					fill_port(&o->list[o->num++], &s->ports[i], i);
+			}
+			else
+				return 1;
+		}
+			break;
+
+		case CLCM_SHOW_VCS:
+		{
+			struct fmapi_vsc_info_rsp *o = &msg->obj.vsc_info_rsp;
+			struct fmapi_vsc_info_blk *x;
+			struct cxl_vcs *v;
+			int vcsid;
+
+			msg->hdr.opcode = FMOP_VSC_INFO;
+
+			vcsid = 0;
+			if (opts[CLOP_VCSID].set)
+				vcsid = opts[CLOP_VCSID].u8;
+			if (vcsid >= s->num_vcss)
+			{
+				printf("Error: VCS %d is not in the snapshot\n", vcsid);
+				return 1;
+			}
+
+			v = &s->vcss[vcsid];
+			x = &o->list[0];
+			o->num 		= 1;
+			x->vcsid 	= vcsid;
+			x->state 	= v->state;
+			x->uspid 	= v->uspid;
+
+			n = v->num;
+			if (n > (int) JKLN_LEN(x->list))
+				n = JKLN_LEN(x->list);
+			x->num = n;
+			for ( k = 0 ; k < n ; k++ )
+			{
+				x->list[k].status 	= v->vppbs[k].bind_status;
+				x->list[k].ppid 	= v->vppbs[k].ppid;
+				x->list[k].ldid 	= v->vppbs[k].ldid;
+			}
+		}
+			break;
+
+		default:
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Build a tunneled MLD Component Command response from the cached switch state
+ *
+ * @param s 	struct cxl_switch* cache to answer from
+ * @param msg 	struct fmapi_msg* to fill with the response header and object
+ * @return 		0 upon success, non zero otherwise
+ */
+static int fill_cci(struct cxl_switch *s, struct fmapi_msg *msg)
+{
+	struct cxl_mld *mld;
+	int i, ppid, start, num, max;
+
+	ppid = opts[CLOP_PPID].u8;
+	if (ppid >= s->num_ports || s->ports[ppid].mld == NULL)
+	{
+		printf("Error: Port %d is not an MLD in the snapshot\n", ppid);
+		return 1;
+	}
+	mld = s->ports[ppid].mld;
+
+	// Number of LDs held in the cache
+	max = mld->num;
+	if (max > (int) JKLN_LEN(mld->alloc_bw))
+		max = JKLN_LEN(mld->alloc_bw);
+
+	// Range of LDs requested by the QoS commands
+	start = 0;
+	num = 255;
+	if (opts[CLOP_LDID].set)
+		start = opts[CLOP_LDID].u16;
+	if (opts[CLOP_NUM].set)
+		num = opts[CLOP_NUM].u8;
+	if (start > max)
+		start = max;
+	if (num > max - start)
+		num = max - start;
+
+	switch (opts[CLOP_CMD].val)
+	{
+		case CLCM_SHOW_LD_INFO:
+		{
+			struct fmapi_mcc_info_rsp *o = &msg->obj.mcc_info_rsp;
+
+			msg->hdr.opcode = FMOP_MCC_INFO;
+			o->size = mld->memory_size;
+			o->num 	= mld->num;
+			o->epc 	= mld->epc;
+			o->ttr 	= mld->ttr;
+		}
+			break;
+
+		case CLCM_SHOW_LD_ALLOCATIONS:
+		{
+			struct fmapi_mcc_alloc_get_rsp *o = &msg->obj.mcc_alloc_get_rsp;
+
+			msg->hdr.opcode = FMOP_MCC_ALLOC_GET;
+			o->total 		= mld->num;
+			o->granularity 	= mld->granularity;
+			o->start 		= 0;
+			o->num 			= max;
+			if (o->num > JKLN_LEN(o->list))
+				o->num = JKLN_LEN(o->list);
+			for ( i = 0 ; i < o->num ; i++ )
+			{
+				o->list[i].rng1 = mld->rng1[i];
+				o->list[i].rng2 = mld->rng2[i];
+			}
+		}
+			break;
+
+		case CLCM_SHOW_QOS_CONTROL:
+		{
+			struct fmapi_mcc_qos_ctrl *o = &msg->obj.mcc_qos_ctrl;
+
+			msg->hdr.opcode = FMOP_MCC_QOS_CTRL_GET;
+			o->epc_en 			= mld->epc_en;
+			o->ttr_en 			= mld->ttr_en;
+			o->egress_mod_pcnt 	= mld->egress_mod_pcnt;
+			o->egress_sev_pcnt 	= mld->egress_sev_pcnt;
+			o->sample_interval 	= mld->sample_interval;
+			o->rcb 				= mld->rcb;
+			o->comp_interval 	= mld->comp_interval;
+		}
+			break;
+
+		case CLCM_SHOW_QOS_STATUS:
+		{
+			msg->hdr.opcode = FMOP_MCC_QOS_STAT;
+			msg->obj.mcc_qos_stat_rsp.bp_avg_pcnt = mld->bp_avg_pcnt;
+		}
+			break;
+
+		case CLCM_SHOW_QOS_ALLOCATED:
+		{
+			struct fmapi_mcc_qos_bw_alloc *o = &msg->obj.mcc_qos_bw_alloc;
+
+			msg->hdr.opcode = FMOP_MCC_QOS_BW_ALLOC_GET;
+			o->start = start;
+			o->num = num;
+			for ( i = 0 ; i < num ; i++ )
+				o->list[i] = mld->alloc_bw[start + i];
+		}
+			break;
+
+		case CLCM_SHOW_QOS_LIMIT:
+		{
+			struct fmapi_mcc_qos_bw_limit *o = &msg->obj.mcc_qos_bw_limit;
+
+			msg->hdr.opcode = FMOP_MCC_QOS_BW_LIMIT_GET;
+			o->start = start;
+			o->num = num;
+			for ( i = 0 ; i < num ; i++ )
+				o->list[i] = mld->bw_limit[start + i];
+		}
+			break;
+
+		default:
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Answer a show command from the cached switch state
+ *
+ * @param s 	struct cxl_switch* cache, usually loaded from a snapshot
+ * @return 		0 upon success, non zero otherwise
+ *
+ * STEPS
+ * 1: Allocate response
+ * 2: Fill response from cache
+ * 3: Print response
+ */
+int offline_run(struct cxl_switch *s)
+{
+	INIT
+	struct fmapi_msg *msg;
+	int rv, cci;
+
+	ENTER
+
+	rv = 1;
+
+	STEP // 1: Allocate response
+	msg = calloc(1, sizeof(struct fmapi_msg));
+	if (msg == NULL)
+		goto end;
+
+	msg->hdr.category = FMMT_RESP;
+	msg->hdr.return_code = FMRC_SUCCESS;
+
+	STEP // 2: Fill response from cache
+	switch (opts[CLOP_CMD].val)
+	{
+		case CLCM_SHOW_LD_INFO:
+		case CLCM_SHOW_LD_ALLOCATIONS:
+		case CLCM_SHOW_QOS_CONTROL:
+		case CLCM_SHOW_QOS_STATUS:
+		case CLCM_SHOW_QOS_ALLOCATED:
+		case CLCM_SHOW_QOS_LIMIT:
+			cci = 1;
+			rv = fill_cci(s, msg);
+			break;
+
+		case CLCM_SHOW_BOS:
+		case CLCM_SHOW_IDENTITY:
+		case CLCM_SHOW_MSG_LIMIT:
+		case CLCM_SHOW_SWITCH:
+		case CLCM_SHOW_PORT:
+		case CLCM_SHOW_VCS:
+			cci = 0;
+			rv = fill_fmapi(s, msg);
+			break;
+
+		case CLCM_SHOW_BINDING:
+			// Bindings are read from a view of the snapshot
+			pthread_mutex_lock(&s->mtx);
+			rv = view_publish(s);
+			pthread_mutex_unlock(&s->mtx);
+			if (rv == 0)
+				rv = binding_print(opts[CLOP_PPID].u8, opts[CLOP_LDID].set ? opts[CLOP_LDID].u16 : -1);
+			view_free();
+			goto free;
+
+		default:
+			printf("Error: Command cannot be answered from a snapshot\n");
+			goto free;
+	}
+
+	if (rv != 0)
+		goto free;
+
+	STEP // 3: Print response
+	if (cci)
+		rv = cci_print(msg);
+	else
+		rv = fmapi_print(msg);
+
+free:
+
+	free(msg);
+
+end:
+
+	EXIT(rv)
+
+	return rv;
+}
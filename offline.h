@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		offline.h
+ *
+ * @brief 		Header file for answering show commands from a switch snapshot
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _OFFLINE_H
+#define _OFFLINE_H
+
+/* struct cxl_switch
+ */
+#include <cxlstate.h>
+
+/* MACROS ====================================================================*/
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+int offline_run(struct cxl_switch *s);
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_OFFLINE_H
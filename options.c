@@ -36,14 +36,30 @@
  */
 #include <argp.h>
 
+/* va_start()
+ */
+#include <stdarg.h>
+
+#include <errno.h>
+#include <stdio.h>
+
 /* autl_prnt_buf();
  */
 #include <arrayutils.h>
 
+#include "filter.h"
+#include "ldtest.h"
+#include "ldsnap.h"
 #include "options.h"
 
 /* MACROS ====================================================================*/
 
+/**
+ * Flags of a subcommand parser. ARGP_NO_EXIT and ARGP_NO_ERRS are passed on 
+ * from the parser of the command
+ */
+#define CLAP_FLAGS(state) 	(ARGP_IN_ORDER | ARGP_NO_HELP | ((state)->flags & (ARGP_NO_EXIT | ARGP_NO_ERRS)))
+
 /* ENUMERATIONS ==============================================================*/
 
 /* STRUCTS ===================================================================*/
@@ -70,6 +86,16 @@ static int pr_port(int key, char *arg, struct argp_state *state);
 static int pr_set(int key, char *arg, struct argp_state *state);
 static int pr_ld(int key, char *arg, struct argp_state *state);
 static int pr_aer(int key, char *arg, struct argp_state *state);
+static int pr_daemon(int key, char *arg, struct argp_state *state);
+static int pr_batch(int key, char *arg, struct argp_state *state);
+static int pr_regs(int key, char *arg, struct argp_state *state);
+static int pr_regs_run(int key, char *arg, struct argp_state *state);
+static int pr_watch(int key, char *arg, struct argp_state *state);
+static int pr_watch_port(int key, char *arg, struct argp_state *state);
+static int pr_watch_vcs(int key, char *arg, struct argp_state *state);
+static int pr_watch_qos(int key, char *arg, struct argp_state *state);
+static int pr_events(int key, char *arg, struct argp_state *state);
+static int pr_show_binding(int key, char *arg, struct argp_state *state);
 static int pr_show_bos(int key, char *arg, struct argp_state *state);
 static int pr_show_identity(int key, char *arg, struct argp_state *state);
 static int pr_show_limit(int key, char *arg, struct argp_state *state);
@@ -82,6 +108,7 @@ static int pr_show_ld(int key, char *arg, struct argp_state *state);
 static int pr_port_bind(int key, char *arg, struct argp_state *state);
 static int pr_port_unbind(int key, char *arg, struct argp_state *state);
 static int pr_port_config(int key, char *arg, struct argp_state *state);
+static int pr_port_caps(int key, char *arg, struct argp_state *state);
 static int pr_port_connect(int key, char *arg, struct argp_state *state);
 static int pr_port_disconnect(int key, char *arg, struct argp_state *state);
 static int pr_port_ctrl(int key, char *arg, struct argp_state *state);
@@ -89,7 +116,12 @@ static int pr_set_ld(int key, char *arg, struct argp_state *state);
 static int pr_set_limit(int key, char *arg, struct argp_state *state);
 static int pr_set_qos(int key, char *arg, struct argp_state *state);
 static int pr_ld_config(int key, char *arg, struct argp_state *state);
+static int pr_ld_caps(int key, char *arg, struct argp_state *state);
 static int pr_ld_mem(int key, char *arg, struct argp_state *state);
+static int pr_ld_dump(int key, char *arg, struct argp_state *state);
+static int pr_ld_test(int key, char *arg, struct argp_state *state);
+static int pr_ld_snapshot(int key, char *arg, struct argp_state *state);
+static int pr_ld_snapshot_diff(int key, char *arg, struct argp_state *state);
 static int pr_show_qos_allocated(int key, char *arg, struct argp_state *state);
 static int pr_show_qos_control(int key, char *arg, struct argp_state *state);
 static int pr_show_qos_limit(int key, char *arg, struct argp_state *state);
@@ -153,7 +185,34 @@ char *STR_CLOP[] = {
 	"OUTFILE",
 	"MCTP_VERBOSITY",
 	"CLOP_DEVICE",
-	"NUM"
+	"NUM",
+	"LIMIT",
+	"TCP_ADDRESS",
+	"NO_INIT",
+	"SOCKET",
+	"WINDOW",
+	"CACHE",
+	"CACHE_AGE",
+	"SNAPSHOT",
+	"INTERVAL",
+	"COUNT",
+	"FOLLOW",
+	"WHERE",
+	"FIELDS",
+	"RAW",
+	"ALL_LD",
+	"OUTDIR",
+	"PATTERN",
+	"SEED",
+	"CHUNK",
+	"VERIFY",
+	"CHECKSUM",
+	"SPARSE_MAP",
+	"STORE",
+	"NAME",
+	"MANIFEST_A",
+	"MANIFEST_B",
+	"DUMP"
 };
 
 /**
@@ -165,6 +224,8 @@ struct envopt envopts[] =
 	{'P', "JACK_TCP_PORT"},
 	{'X', "JACK_VERBOSITY"},
 	{'Z', "JACK_MCTP_VERBOSITY"},
+	{'S', "JACK_SOCKET"},
+	{'W', "JACK_WINDOW"},
 	{0,0}
 };
 
@@ -175,6 +236,11 @@ struct envopt envopts[] =
  */
 static char *app_name;
 
+/**
+ * Options array parsed by options_parse(). app_name is freed with it
+ */
+static struct opt *app_opts;
+
 /**
  *  CLAP_MAIN - Options for main level parser
  */
@@ -191,6 +257,8 @@ struct argp_option ao_main[] =
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  	'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"socket",      'S', "FILE", 0, "Jack daemon Unix socket", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -367,6 +435,248 @@ struct argp_option ao_aer[] =
 	{0,0,0,0,0,0} // Final option should be all null
 };
 
+/**
+ * CLAP_DAEMON - Options for: <app> daemon
+ */
+struct argp_option ao_daemon[] = 	
+{
+	{0,0,0,0,"Command Options",1}, // Group
+  	{"socket",    'S', "FILE", 0, "Filename of Unix socket to listen on", 0},
+  	{"no-init",   'N', NULL,   0, "Do not fetch switch state at start up", 0},	
+  	{"cache",     707, "FILE", 0, "Load and save switch state snapshot", 0},
+  	{"cache-age", 708, "SEC",  0, "Refresh snapshot sections older than SEC", 0},
+
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_BATCH - Options for: <app> batch
+ */
+struct argp_option ao_batch[] = 	
+{
+	{0,0,0,0,"Command Options",1}, // Group
+
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_REGS - Options for: <app> regs
+ */
+struct argp_option ao_regs[] = 	
+{
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"no-init",		  'N', NULL,  OPTION_HIDDEN, "Do not initialize local state at start up", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_REGS_RUN - Options for: <app> regs run
+ */
+struct argp_option ao_regs_run[] = 	
+{
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"no-init",		  'N', NULL,  OPTION_HIDDEN, "Do not initialize local state at start up", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_WATCH - Options for: <app> watch
+ */
+struct argp_option ao_watch[] = 	
+{
+	{0,0,0,0,"Command Options",1}, // Group
+
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_WATCH_PORT - Options for: <app> watch port
+ */
+struct argp_option ao_watch_port[] = 	
+{
+	{0,0,0,0,"Command Options",1}, // Group
+  	{"interval",  710, "MS",  0, "Poll interval in milliseconds (default 1000)", 0},
+  	{"count",     711, "INT", 0, "Stop after this many polls", 0},
+
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_WATCH_VCS - Options for: <app> watch vcs
+ */
+struct argp_option ao_watch_vcs[] = 	
+{
+	{0,0,0,0,"Command Options",1}, // Group
+  	{"interval",  710, "MS",  0, "Poll interval in milliseconds (default 1000)", 0},
+  	{"count",     711, "INT", 0, "Stop after this many polls", 0},
+
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_WATCH_QOS - Options for: <app> watch qos
+ */
+struct argp_option ao_watch_qos[] = 	
+{
+	{0,0,0,0,"Command Options",1}, // Group
+  	{"interval",  710, "MS",  0, "Poll interval in milliseconds (default 1000)", 0},
+  	{"count",     711, "INT", 0, "Stop after this many polls", 0},
+
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_EVENTS - Options for: <app> events
+ */
+struct argp_option ao_events[] = 	
+{
+	{0,0,0,0,"Command Options",1}, // Group
+  	{"follow",    712, NULL,  0, "Keep printing events until interrupted", 0},
+  	{"count",     711, "INT", 0, "With --follow, stop after this many events", 0},
+
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_SHOW_BINDING - Options for: <app> show binding
+ */
+struct argp_option ao_show_binding[] = 	
+{
+	{0,0,0,0,"Command Options",1}, // Group
+
+	{0,0,0,0,"Target Options",3}, 
+  	{"ppid",  'p', "INT", 0, "Physical Port ID", 0},
+  	{"ldid",  'l', "INT", 0, "LD ID. All LDs of the port if not set", 0},
+
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"no-init",		  'N', NULL,  OPTION_HIDDEN, "Do not initialize local state at start up", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
 /**
  * CLAP_SHOW_BOS - Options for: <app> show bos
  */
@@ -377,6 +687,7 @@ struct argp_option ao_show_bos[] =
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -400,6 +711,7 @@ struct argp_option ao_show_identity[] =
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -423,6 +735,7 @@ struct argp_option ao_show_limit[] =
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -446,6 +759,7 @@ struct argp_option ao_show_switch[] =
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -497,9 +811,14 @@ struct argp_option ao_show_port[] =
   	{"all",   'a',  NULL, 0, "All Physical Ports", 0},	
   	{"ppid",  'p', "INT", 0, "Physical Port ID", 0},
 
+	{0,0,0,0,"Output Options",4}, 
+  	{"where",  713, "EXPR", 0, "Only print ports that match, e.g. state=dsp,width>=8", 0},
+  	{"fields", 714, "LIST", 0, "Only print these columns, e.g. ppid,state,ltssm", 0},
+
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -527,6 +846,7 @@ struct argp_option ao_show_vcs[] =
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -663,12 +983,17 @@ struct argp_option ao_port_config[] =
   	{"write",        'w',   NULL, 0, "Perform a Write transaction", 0},
   	{"data",         703,  "HEX", 0, "Write Data (up to 4 bytes)", 0},
 
+	{0,0,0,0,"Dump Options",4}, 
+  	{"dump",         727,   NULL, 0, "Read the full 4 KiB config space", 0},
+  	{"outfile",      715, "FILE", 0, "Write the dump to FILE in lspci -F format", 0},
+
 	{0,0,0,0,"Target Options",3}, 
   	{"ppid",         'p', "INT", 0, "Physical Port ID", 0},
 
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -853,6 +1178,10 @@ struct argp_option ao_ld_config[] =
   	{"write",        'w',   NULL, 0, "Perform a Write transaction", 0},
   	{"data",         703,  "HEX", 0, "Write Data (up to 4 bytes)", 0},
 
+	{0,0,0,0,"Dump Options",4}, 
+  	{"dump",         727,   NULL, 0, "Read the full 4 KiB config space", 0},
+  	{"outfile",      715, "FILE", 0, "Write the dump to FILE in lspci -F format", 0},
+
 	{0,0,0,0,"Target Options",3}, 
   	{"ppid",         'p',  "INT", 0, "Physical Port ID", 0},
   	{"ldid",         'l',  "INT", 0, "LD-ID (for MLD devices)", 0},
@@ -860,6 +1189,7 @@ struct argp_option ao_ld_config[] =
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -874,26 +1204,17 @@ struct argp_option ao_ld_config[] =
 };
 
 /**
- * CLAP_LD_MEM - Options for: <app> ld mem
+ * CLAP_PORT_CAPS - Options for: <app> port caps
  */
-struct argp_option ao_ld_mem[] = 	
+struct argp_option ao_port_caps[] = 	
 {
-	{0,0,0,0,"Command Options",1}, 
-  	{"fdbe",    'f',   "INT", 0, "First Dword Byte Enable", 0},
-  	{"ldbe",    'd',   "INT", 0, "Last Dword Byte Enable", 0},
-  	{"length",  'n',   "INT", 0, "Transaction Data Length (up to 4KB)", 0},
-  	{"offset",  'o',   "INT", 0, "Transaction Offset in tareget's memory space", 0},
-  	{"write",   'w',   NULL,  0, "Perform a Write transaction", 0},
-  	{"data",    703,   "HEX", 0, "Write Data (up to 4 bytes)", 0},
-  	{"infile",  704,  "FILE", 0, "Filename for input data", 0},
-
 	{0,0,0,0,"Target Options",3}, 
   	{"ppid",    'p',   "INT", 0, "Physical Port ID", 0},
-  	{"ldid",    'l',   "INT", 0, "LD-ID (for MLD devices)", 0},
 
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -908,20 +1229,18 @@ struct argp_option ao_ld_mem[] =
 };
 
 /**
- * CLAP_SHOW_QOS_ALLOCATED - Options for: <app> show qos allocated
+ * CLAP_LD_CAPS - Options for: <app> ld caps
  */
-struct argp_option ao_show_qos_allocated[] = 	
+struct argp_option ao_ld_caps[] = 	
 {
-	{0,0,0,0,"Command Options",1}, // Group
-
 	{0,0,0,0,"Target Options",3}, 
-  	{"ppid",  'p', "INT", 0, "Physical Port ID", 0},
-  	{"ldid",  'l', "INT", 0, "Starting LD-ID (for MLD devices)", 0},
-  	{"num",   'n', "INT", 0, "Num LD IDs Requested", 0},
+  	{"ppid",    'p',   "INT", 0, "Physical Port ID", 0},
+  	{"ldid",    'l',   "INT", 0, "LD-ID (for MLD devices)", 0},
 
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -936,18 +1255,36 @@ struct argp_option ao_show_qos_allocated[] =
 };
 
 /**
- * CLAP_SHOW_QOS_CONTROL - Options for: <app> show qos control
+ * CLAP_LD_MEM - Options for: <app> ld mem
  */
-struct argp_option ao_show_qos_control[] = 	
+struct argp_option ao_ld_mem[] = 	
 {
-	{0,0,0,0,"Command Options",1}, // Group
+	{0,0,0,0,"Command Options",1}, 
+  	{"fdbe",    'f',   "INT", 0, "First Dword Byte Enable", 0},
+  	{"ldbe",    'd',   "INT", 0, "Last Dword Byte Enable", 0},
+  	{"length",  'n',   "INT", 0, "Transaction Data Length", 0},
+  	{"offset",  'o',   "INT", 0, "Transaction Offset in tareget's memory space", 0},
+  	{"write",   'w',   NULL,  0, "Perform a Write transaction", 0},
+  	{"data",    703,   "HEX", 0, "Write Data (4 bytes, repeated to fill length)", 0},
+  	{"infile",  704,  "FILE", 0, "Filename for input data", 0},
 
 	{0,0,0,0,"Target Options",3}, 
-  	{"ppid",  'p', "INT", 0, "Physical Port ID", 0},
+  	{"ppid",    'p',   "INT", 0, "Physical Port ID", 0},
+  	{"ldid",    'l',   "INT", 0, "LD-ID (for MLD devices)", 0},
+
+	{0,0,0,0,"Output Options",4}, 
+  	{"outfile", 715,  "FILE", 0, "Write read data to FILE in binary", 0},
+  	{"raw",     716,   NULL,  0, "Write read data to stdout in binary", 0},
+  	{"verify",  722,  "FILE", 0, "Compare read data against FILE and print the ranges that differ", 0},
+  	{"checksum",723,   NULL,  0, "Print the CRC32C of the read data", 0},
+  	{"sparse-map",724, NULL,  0, "List the non-zero extents of --outfile in <outfile>.map", 0},
+  	{"store",   725,   "DIR", 0, "Add the read data to the snapshot store in DIR", 0},
+  	{"name",    726,  "NAME", 0, "Name of the snapshot. Default is ld-p<ppid>-l<ldid>-<time>", 0},
 
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -962,20 +1299,179 @@ struct argp_option ao_show_qos_control[] =
 };
 
 /**
- * CLAP_SHOW_QOS_LIMIT - Options for: <app> show qos limit
+ * CLAP_LD_SNAPSHOT - Options for: <app> ld snapshot
  */
-struct argp_option ao_show_qos_limit[] = 	
+struct argp_option ao_ld_snapshot[] = 	
 {
-	{0,0,0,0,"Command Options",1}, // Group
-
-	{0,0,0,0,"Target Options",3}, 
-  	{"ppid",  'p', "INT", 0, "Physical Port ID", 0},
-  	{"ldid",  'l', "INT", 0, "Starting LD-ID (for MLD devices)", 0},
-  	{"num",   'n', "INT", 0, "Num LD IDs Requested", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_LD_SNAPSHOT_DIFF - Options for: <app> ld snapshot diff
+ */
+struct argp_option ao_ld_snapshot_diff[] = 	
+{
+	{0,0,0,0,"Command Options",1}, 
+  	{"store",   725,   "DIR", 0, "Snapshot store to look up names in", 0},
+
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_LD_TEST - Options for: <app> ld test
+ */
+struct argp_option ao_ld_test[] = 	
+{
+	{0,0,0,0,"Command Options",1}, 
+  	{"length",  'n',   "INT", 0, "Bytes to test. Multiple of 4", 0},
+  	{"offset",  'o',   "INT", 0, "Offset in the LD memory space. Multiple of 4", 0},
+  	{"pattern", 719,   "NAME", 0, "Fill pattern: zeros, ones (walking), addr (default), prng", 0},
+  	{"seed",    720,   "INT", 0, "Seed of the prng pattern", 0},
+  	{"chunk",   721,   "LIST", 0, "Comma separated chunk sizes to test. Default is the message limit", 0},
+
+	{0,0,0,0,"Target Options",3}, 
+  	{"ppid",    'p',   "INT", 0, "Physical Port ID", 0},
+  	{"ldid",    'l',   "INT", 0, "LD-ID (for MLD devices)", 0},
+
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"no-init",		  'N', NULL,  OPTION_HIDDEN, "Do not initialize local state at start up", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_LD_DUMP - Options for: <app> ld dump
+ */
+struct argp_option ao_ld_dump[] = 	
+{
+	{0,0,0,0,"Command Options",1}, 
+  	{"all",     'A',   NULL,  0, "Dump every LD of every MLD port", 0},
+  	{"all-ld",  717,   NULL,  0, "Dump every LD of the port", 0},
+
+	{0,0,0,0,"Target Options",3}, 
+  	{"ppid",    'p',   "INT", 0, "Physical Port ID", 0},
+  	{"ldid",    'l',   "INT", 0, "LD-ID (for MLD devices)", 0},
+
+	{0,0,0,0,"Output Options",4}, 
+  	{"outdir",  718,   "DIR", 0, "Directory to write ld-p<ppid>-l<ldid>.bin files to", 0},
+  	{"sparse-map",724, NULL,  0, "List the non-zero extents of each file in <file>.map", 0},
+
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"window",      'W', "INT", 0, "Max number of requests in flight across all LDs", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"no-init",		  'N', NULL,  OPTION_HIDDEN, "Do not initialize local state at start up", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_SHOW_QOS_ALLOCATED - Options for: <app> show qos allocated
+ */
+struct argp_option ao_show_qos_allocated[] = 	
+{
+	{0,0,0,0,"Command Options",1}, // Group
+
+	{0,0,0,0,"Target Options",3}, 
+  	{"ppid",  'p', "INT", 0, "Physical Port ID", 0},
+  	{"ldid",  'l', "INT", 0, "Starting LD-ID (for MLD devices)", 0},
+  	{"num",   'n', "INT", 0, "Num LD IDs Requested", 0},
+
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"no-init",		  'N', NULL,  OPTION_HIDDEN, "Do not initialize local state at start up", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_SHOW_QOS_CONTROL - Options for: <app> show qos control
+ */
+struct argp_option ao_show_qos_control[] = 	
+{
+	{0,0,0,0,"Command Options",1}, // Group
+
+	{0,0,0,0,"Target Options",3}, 
+  	{"ppid",  'p', "INT", 0, "Physical Port ID", 0},
+
+	{0,0,0,0, "Networking Options",7},	
+  	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
+  	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
+	{0,0,0,0, "Verbose Options",8},	// Group
+  	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
+  	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
+  	{"mctp-verbosity",'Z', "HEX", OPTION_HIDDEN, "Set all MCTP Verbosity Flags with hex value", 0},	
+  	{"no-init",		  'N', NULL,  OPTION_HIDDEN, "Do not initialize local state at start up", 0},	
+  	{"print-options", 706,  NULL, OPTION_HIDDEN, "Print CLI Options", 0},	
+	{0,0,0,0, "Help Options", 9}, // Group
+  	{"help",    'h', NULL, 0, "Display Help", 0},
+  	{"usage",   701, NULL, 0, "Display Usage", 0},	
+  	{"version", 702, NULL, 0, "Display Version", 0},
+	{0,0,0,0,0,0} // Final option should be all null
+};
+
+/**
+ * CLAP_SHOW_QOS_LIMIT - Options for: <app> show qos limit
+ */
+struct argp_option ao_show_qos_limit[] = 	
+{
+	{0,0,0,0,"Command Options",1}, // Group
+
+	{0,0,0,0,"Target Options",3}, 
+  	{"ppid",  'p', "INT", 0, "Physical Port ID", 0},
+  	{"ldid",  'l', "INT", 0, "Starting LD-ID (for MLD devices)", 0},
+  	{"num",   'n', "INT", 0, "Num LD IDs Requested", 0},
 
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -1002,6 +1498,7 @@ struct argp_option ao_show_qos_status[] =
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -1028,6 +1525,7 @@ struct argp_option ao_show_ld_allocations[] =
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -1054,6 +1552,7 @@ struct argp_option ao_show_ld_info[] =
 	{0,0,0,0, "Networking Options",7},	
   	{"tcp-port",  'P', "INT", 0, "Server TCP Port", 0},
   	{"tcp-address", 'T', "INT", 0, "Server TCP Address", 0},
+  	{"snapshot",    709, "FILE", 0, "Answer from a switch snapshot file offline", 0},
 	{0,0,0,0, "Verbose Options",8},	// Group
   	{"verbosity",     'V', "INT", 0, "Set Verbosity Flag", 0},	
   	{"verbosity-hex", 'X', "HEX", 0, "Set all Verbosity Flags with hex value", 0},	
@@ -1198,6 +1697,16 @@ struct argp ap_port 				= {ao_port 					, pr_port				, 0, 0, 0, 0, 0};
 struct argp ap_set  				= {ao_set  					, pr_set 				, 0, 0, 0, 0, 0};
 struct argp ap_ld   				= {ao_ld   					, pr_ld  				, 0, 0, 0, 0, 0};
 struct argp ap_aer  				= {ao_aer  					, pr_aer 				, 0, 0, 0, 0, 0};
+struct argp ap_daemon 				= {ao_daemon 				, pr_daemon				, 0, 0, 0, 0, 0};
+struct argp ap_batch 				= {ao_batch 				, pr_batch				, 0, 0, 0, 0, 0};
+struct argp ap_regs 				= {ao_regs 					, pr_regs				, 0, 0, 0, 0, 0};
+struct argp ap_regs_run 			= {ao_regs_run 				, pr_regs_run			, 0, 0, 0, 0, 0};
+struct argp ap_watch 				= {ao_watch 				, pr_watch				, 0, 0, 0, 0, 0};
+struct argp ap_watch_port 			= {ao_watch_port 			, pr_watch_port			, 0, 0, 0, 0, 0};
+struct argp ap_watch_vcs 			= {ao_watch_vcs 			, pr_watch_vcs			, 0, 0, 0, 0, 0};
+struct argp ap_watch_qos 			= {ao_watch_qos 			, pr_watch_qos			, 0, 0, 0, 0, 0};
+struct argp ap_events 				= {ao_events 				, pr_events				, 0, 0, 0, 0, 0};
+struct argp ap_show_binding  		= {ao_show_binding  	    , pr_show_binding 		, 0, 0, 0, 0, 0};
 struct argp ap_show_bos      		= {ao_show_bos      	    , pr_show_bos     		, 0, 0, 0, 0, 0};
 struct argp ap_show_identity		= {ao_show_identity		    , pr_show_identity		, 0, 0, 0, 0, 0};
 struct argp ap_show_limit   		= {ao_show_limit      	    , pr_show_limit   		, 0, 0, 0, 0, 0};
@@ -1212,12 +1721,18 @@ struct argp ap_port_connect         = {ao_port_connect       	, pr_port_connect
 struct argp ap_port_disconnect      = {ao_port_disconnect      	, pr_port_disconnect	, 0, 0, 0, 0, 0};
 struct argp ap_port_unbind          = {ao_port_unbind        	, pr_port_unbind 		, 0, 0, 0, 0, 0};
 struct argp ap_port_config          = {ao_port_config        	, pr_port_config 		, 0, 0, 0, 0, 0};
+struct argp ap_port_caps            = {ao_port_caps         	, pr_port_caps  		, 0, 0, 0, 0, 0};
 struct argp ap_port_ctrl            = {ao_port_ctrl         	, pr_port_ctrl  		, 0, 0, 0, 0, 0};
 struct argp ap_set_ld               = {ao_set_ld            	, pr_set_ld 			, 0, 0, 0, 0, 0};
 struct argp ap_set_limit            = {ao_set_limit         	, pr_set_limit			, 0, 0, 0, 0, 0};
 struct argp ap_set_qos              = {ao_set_qos           	, pr_set_qos     		, 0, 0, 0, 0, 0};
 struct argp ap_ld_config            = {ao_ld_config         	, pr_ld_config   		, 0, 0, 0, 0, 0};
+struct argp ap_ld_caps              = {ao_ld_caps           	, pr_ld_caps     		, 0, 0, 0, 0, 0};
 struct argp ap_ld_mem               = {ao_ld_mem            	, pr_ld_mem      		, 0, 0, 0, 0, 0};
+struct argp ap_ld_dump              = {ao_ld_dump           	, pr_ld_dump     		, 0, 0, 0, 0, 0};
+struct argp ap_ld_test              = {ao_ld_test           	, pr_ld_test     		, 0, 0, 0, 0, 0};
+struct argp ap_ld_snapshot          = {ao_ld_snapshot       	, pr_ld_snapshot 		, 0, 0, 0, 0, 0};
+struct argp ap_ld_snapshot_diff     = {ao_ld_snapshot_diff  	, pr_ld_snapshot_diff	, 0, 0, 0, 0, 0};
 struct argp ap_show_qos_allocated   = {ao_show_qos_allocated	, pr_show_qos_allocated , 0, 0, 0, 0, 0};
 struct argp ap_show_qos_control     = {ao_show_qos_control  	, pr_show_qos_control   , 0, 0, 0, 0, 0};
 struct argp ap_show_qos_limit       = {ao_show_qos_limit    	, pr_show_qos_limit     , 0, 0, 0, 0, 0};
@@ -1361,9 +1876,15 @@ int options_free(struct opt *opts)
 	// Free options array
 	free(opts);
 
-	// Free app Name 
-	if (app_name)
-		free(app_name);
+	// Free app Name with the options it was stored for. Arrays from 
+	// options_parse_argv() leave it for the command lines that follow
+	if (opts == app_opts)
+	{
+		if (app_name)
+			free(app_name);
+		app_name = NULL;
+		app_opts = NULL;
+	}
 
 	return 0;
 }
@@ -1656,6 +2177,16 @@ static void print_usage(int option, struct argp_option *o)
 		case CLAP_SET:					sprintf(str, "Usage: %s set ",  				app_name); break;
 		case CLAP_LD:                   sprintf(str, "Usage: %s ld ",   				app_name); break;
 		case CLAP_AER:                  sprintf(str, "Usage: %s aer ",  				app_name); break;
+		case CLAP_DAEMON:               sprintf(str, "Usage: %s daemon ",				app_name); break;
+		case CLAP_BATCH:                sprintf(str, "Usage: %s batch <file|-> ",		app_name); break;
+		case CLAP_REGS:                 sprintf(str, "Usage: %s regs ",					app_name); break;
+		case CLAP_REGS_RUN:             sprintf(str, "Usage: %s regs run <file|-> ",	app_name); break;
+		case CLAP_WATCH:                sprintf(str, "Usage: %s watch ",				app_name); break;
+		case CLAP_WATCH_PORT:           sprintf(str, "Usage: %s watch port ",			app_name); break;
+		case CLAP_WATCH_VCS:            sprintf(str, "Usage: %s watch vcs ",			app_name); break;
+		case CLAP_WATCH_QOS:            sprintf(str, "Usage: %s watch qos ",			app_name); break;
+		case CLAP_EVENTS:               sprintf(str, "Usage: %s events ",				app_name); break;
+		case CLAP_SHOW_BINDING:         sprintf(str, "Usage: %s show binding ", 		app_name); break;
 		case CLAP_SHOW_BOS:             sprintf(str, "Usage: %s show bos ", 			app_name); break;
 		case CLAP_SHOW_IDENTITY:        sprintf(str, "Usage: %s show identity ", 		app_name); break;
 		case CLAP_SHOW_MSG_LIMIT:       sprintf(str, "Usage: %s show limit ", 			app_name); break;
@@ -1667,12 +2198,18 @@ static void print_usage(int option, struct argp_option *o)
 		case CLAP_PORT_BIND:			sprintf(str, "Usage: %s port bind ",    		app_name); break;
 		case CLAP_PORT_UNBIND:          sprintf(str, "Usage: %s port unbind ",  		app_name); break;
 		case CLAP_PORT_CONFIG:          sprintf(str, "Usage: %s port config ", 			app_name); break;
+		case CLAP_PORT_CAPS:            sprintf(str, "Usage: %s port caps ", 			app_name); break;
 		case CLAP_PORT_CTRL:            sprintf(str, "Usage: %s port reset ", 			app_name); break;
 		case CLAP_SET_LD:               sprintf(str, "Usage: %s set ld ",      			app_name); break;
 		case CLAP_SET_MSG_LIMIT:        sprintf(str, "Usage: %s set limit ",   			app_name); break;
 		case CLAP_SET_QOS:              sprintf(str, "Usage: %s set qos ", 				app_name); break;
 		case CLAP_LD_CONFIG:            sprintf(str, "Usage: %s ld config ", 			app_name); break;
+		case CLAP_LD_CAPS:              sprintf(str, "Usage: %s ld caps ", 				app_name); break;
 		case CLAP_LD_MEM:               sprintf(str, "Usage: %s ld mem ", 				app_name); break;
+		case CLAP_LD_DUMP:              sprintf(str, "Usage: %s ld dump ", 				app_name); break;
+		case CLAP_LD_TEST:              sprintf(str, "Usage: %s ld test ", 				app_name); break;
+		case CLAP_LD_SNAPSHOT:          sprintf(str, "Usage: %s ld snapshot ", 			app_name); break;
+		case CLAP_LD_SNAPSHOT_DIFF:     sprintf(str, "Usage: %s ld snapshot diff ", 	app_name); break;
 		case CLAP_SHOW_QOS_ALLOCATED:   sprintf(str, "Usage: %s show qos allocated ",   app_name); break;
 		case CLAP_SHOW_QOS_CONTROL:     sprintf(str, "Usage: %s show qos control ", 	app_name); break;
 		case CLAP_SHOW_QOS_LIMIT:       sprintf(str, "Usage: %s show qos limit ", 		app_name); break;
@@ -1832,6 +2369,11 @@ Supported subcommands:\
   set          Configure a component\n\
   show         Obtain & display information from target\n\
   aer          Generate an AER event\n\
+  batch        Run a file of jack commands on one MCTP session\n\
+  daemon       Hold one MCTP session open and serve jack commands\n\
+  events       Print device connect & disconnect events from the endpoint\n\
+  regs         Run a script of config register reads and writes\n\
+  watch        Poll the switch and print only the state that changed\n\
 ");
 			print_options(ao_main);
 			printf("\n");
@@ -1853,6 +2395,7 @@ Usage: %s show [subcommand <options>]\n", app_name);
 printf("\n\
 Supported subcommands:\
 \n\
+  binding      vPPB a Physical Port or LD is bound to\n\
   bos          Background Operation Status\n\
   devices      Emulator Device profiles\n\
   identity     Component information\n\
@@ -1874,6 +2417,7 @@ printf("\n\
 Supported subcommands:\
 \n\
   bind         Bind Physical Port to vPPB\n\
+  caps         Walk PCIe capabilities and CXL DVSECs\n\
   config       Send PPB CXL.io Config Request\n\
   connect      Connect Emulator Device Profile\n\
   control      Control unbound physical port\n\
@@ -1918,8 +2462,12 @@ Usage: %s ld [subcommand <options>]\n", app_name);
 printf("\n\
 Supported subcommands:\
 \n\
+  caps         Walk PCIe capabilities and CXL DVSECs\n\
   config       Write to Logical Device Config Space\n\
+  dump         Dump the memory of Logical Devices to files\n\
   mem          Write to Logical Device Memory Space\n\
+  snapshot     Compare Logical Device Memory snapshots\n\
+  test         Fill, verify and benchmark Logical Device Memory\n\
 ");
 			print_options(ao_ld);
 			printf("\n");
@@ -1932,6 +2480,125 @@ Usage: %s aer <options>\n", app_name);
 			printf("\n");
 			break;
 
+		case CLAP_DAEMON:
+printf("\n\
+Usage: %s daemon <options>\n", app_name);
+printf("\n\
+Hold one MCTP session and cached switch state open and execute jack commands\n\
+forwarded over a local Unix socket. While a daemon is listening, other jack\n\
+invocations for the same address and port are sent to it automatically.\n\
+");
+			print_options(ao_daemon);
+			printf("\n");
+			break;
+
+		case CLAP_BATCH:
+printf("\n\
+Usage: %s batch <file|-> <options>\n", app_name);
+printf("\n\
+Execute each line of a file (or stdin when the file is -) as a jack command\n\
+using one MCTP session. Every line is parsed before any are executed. Blank\n\
+lines and lines starting with # are ignored.\n\
+");
+			print_options(ao_batch);
+			printf("\n");
+			break;
+
+		case CLAP_REGS:
+printf("\n\
+Usage: %s regs [subcommand <options>]\n", app_name);
+printf("\n\
+Supported subcommands:\
+\n\
+  run          Run a script of config register reads and writes\n\
+");
+			print_options(ao_regs);
+			printf("\n");
+			break;
+
+		case CLAP_REGS_RUN:
+printf("\n\
+Usage: %s regs run <file|-> <options>\n", app_name);
+printf("\n\
+Run each line of a file (or stdin when the file is -) as an operation on a\n\
+config space DWord of a port or LD, using one MCTP session:\n\
+\n\
+  read  TARGET REG\n\
+  write TARGET REG VALUE\n\
+  rmw   TARGET REG MASK VALUE         Write (old & ~MASK) | (VALUE & MASK)\n\
+  poll  TARGET REG MASK VALUE [MS]    Read until (data & MASK) == VALUE\n\
+  sync                                Wait for all earlier lines\n\
+\n\
+TARGET is PPID or PPID:LDID. REG is the byte offset of the DWord. Lines run\n\
+concurrently except that a line waits for earlier lines on the same DWord,\n\
+and poll and sync lines wait for all earlier lines and hold back later ones.\n\
+Every line is checked before any are run. Text after # is ignored.\n\
+");
+			print_options(ao_regs_run);
+			printf("\n");
+			break;
+
+		case CLAP_EVENTS:
+printf("\n\
+Usage: %s events <options>\n", app_name);
+printf("\n\
+Wait for an unsolicited device connect or disconnect event from the endpoint,\n\
+refresh the affected port and VCSs and print it. With --follow, keep printing\n\
+events until interrupted\n\
+");
+			print_options(ao_events);
+			printf("\n");
+			break;
+
+		case CLAP_WATCH:
+printf("\n\
+Usage: %s watch [subcommand <options>]\n", app_name);
+printf("\n\
+Poll the switch on one MCTP session and print only the entries that changed\n\
+since the previous poll\n\
+");
+printf("\n\
+Supported subcommands:\n\
+  port         Link state, LTSSM, width & speed of each physical port\n\
+  vcs          Binding status of each vPPB\n\
+  qos          QoS control, allocation, limit & status of each MLD\n\
+");
+			print_options(ao_watch);
+			printf("\n");
+			break;
+
+		case CLAP_WATCH_PORT:
+printf("\n\
+Usage: %s watch port <options>\n", app_name);
+			print_options(ao_watch_port);
+			printf("\n");
+			break;
+
+		case CLAP_WATCH_VCS:
+printf("\n\
+Usage: %s watch vcs <options>\n", app_name);
+			print_options(ao_watch_vcs);
+			printf("\n");
+			break;
+
+		case CLAP_WATCH_QOS:
+printf("\n\
+Usage: %s watch qos <options>\n", app_name);
+			print_options(ao_watch_qos);
+			printf("\n");
+			break;
+
+		case CLAP_SHOW_BINDING:
+printf("\n\
+Usage: %s show binding -p <ppid> [-l <ldid>] <options>\n", app_name);
+printf("\n\
+Print the VCS and vPPB that a physical port, or an LD of the port, is bound\n\
+to. The answer comes from the cached bindings of the switch\n\
+");
+			print_options(ao_show_binding);
+			printf("\n");
+			break;
+
 		case CLAP_SHOW_BOS:
 printf("\n\
 Usage: %s show bos <options>\n", app_name);
@@ -2053,6 +2720,13 @@ Defaults to a read operation unless the --write-data option is specified.\n\
 			printf("\n");
 			break;
 
+		case CLAP_PORT_CAPS:
+printf("\n\
+Usage: %s port caps <options>\n", app_name);
+			print_options(ao_port_caps);
+			printf("\n");
+			break;
+
 		case CLAP_PORT_CTRL:
 printf("\n\
 Usage: %s port control <options>\n", app_name);
@@ -2100,6 +2774,13 @@ Usage: %s ld config <options>\n", app_name);
 			printf("\n");
 			break;
 
+		case CLAP_LD_CAPS:
+printf("\n\
+Usage: %s ld caps <options>\n", app_name);
+			print_options(ao_ld_caps);
+			printf("\n");
+			break;
+
 		case CLAP_LD_MEM:
 printf("\n\
 Usage: %s ld mem <options>\n", app_name);
@@ -2107,6 +2788,41 @@ Usage: %s ld mem <options>\n", app_name);
 			printf("\n");
 			break;
 
+		case CLAP_LD_DUMP:
+printf("\n\
+Usage: %s ld dump <options>\n", app_name);
+			print_options(ao_ld_dump);
+			printf("\n");
+			break;
+
+		case CLAP_LD_TEST:
+printf("\n\
+Usage: %s ld test <options>\n", app_name);
+			print_options(ao_ld_test);
+			printf("\n");
+			break;
+
+		case CLAP_LD_SNAPSHOT:
+printf("\n\
+Usage: %s ld snapshot [subcommand <options>]\n", app_name);
+printf("\n\
+Supported subcommands:\
+\n\
+  diff         Compare two snapshots taken with ld mem --store\n\
+");
+			print_options(ao_ld_snapshot);
+			printf("\n");
+			break;
+
+		case CLAP_LD_SNAPSHOT_DIFF:
+printf("\n\
+Usage: %s ld snapshot diff <options> A B\n\
+\n\
+A and B are manifest files, or names of snapshots in --store\n", app_name);
+			print_options(ao_ld_snapshot_diff);
+			printf("\n");
+			break;
+
 		case CLAP_SHOW_QOS_ALLOCATED:
 printf("\n\
 Usage: %s show qos allocated <options>\n", app_name);
@@ -2182,6 +2898,42 @@ Usage: %s set qos limit <options>\n", app_name);
 	} // switch (option)
 }
 
+/**
+ * Leave the parse after help was printed or an invalid option was reported
+ *
+ * argp_parse() was asked not to exit with ARGP_NO_EXIT when a command line is
+ * only checked, so the parse is stopped through the returned error instead
+ *
+ * @param status 	Exit status of the process
+ * @return 			EINVAL when ARGP_NO_EXIT is set
+ */
+static int parse_exit(struct argp_state *state, int status)
+{
+	if (!(state->flags & ARGP_NO_EXIT))
+		exit(status);
+
+	return EINVAL;
+}
+
+/**
+ * Report an invalid option with argp_error() and leave the parse
+ *
+ * @see parse_exit()
+ */
+static int parse_error(struct argp_state *state, const char *fmt, ...)
+{
+	char buf[256];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	argp_error(state, "%s", buf);
+
+	return parse_exit(state, argp_err_exit_status);
+}
+
 /**
  * Common parse function 
  *
@@ -2193,7 +2945,8 @@ Usage: %s set qos limit <options>\n", app_name);
  * -N --no-init  		Do not initialize local state at start up
  * -T --tcp-address 	Server TCP Address
  * -P --tcp-port 		Server TCP Port
- * -T --tcp-address 	Server TCP Address
+ * -S --socket 			Jack daemon Unix socket
+ * -W --window 			Max number of requests in flight
  * -V --verbosity 		Set Verbosity Flag
  * -X --verbosity-hex	Set all Verbosity Flags with hex value
  * -A --all				All of collection 
@@ -2282,7 +3035,7 @@ static int pr_common(int key, char *arg, struct argp_state *state, int type, str
 		// Help
 		case 'h': 
 			print_help(type);
-			exit(0);
+			return parse_exit(state, 0);
 			break;
 
 		// Logical Device ID
@@ -2333,19 +3086,35 @@ static int pr_common(int key, char *arg, struct argp_state *state, int type, str
 			o->u16 = hexordec_to_ul(arg);
 			break;
 
-		// TCP Address
-		case 'T': 
-			o = &opts[CLOP_TCP_ADDRESS];
+		// Jack daemon Unix socket
+		case 'S': 
+			o = &opts[CLOP_SOCKET];
+			o->set = 1;
+			if (o->str)
+				free(o->str);
+			o->str = strdup(arg);
+			break;
+
+		// TCP Address
+		case 'T': 
+			o = &opts[CLOP_TCP_ADDRESS];
 			o->set = 1;
 			rv = inet_pton(AF_INET, arg, &o->u32);
 			if (rv != 1)
 			{
 				printf("Invalid TCP IP Address\n");
-				exit(rv);
+				return parse_exit(state, rv);
 			}
 			rv = 0;
 			break;
 
+		// Max number of requests in flight
+		case 'W': 
+			o = &opts[CLOP_WINDOW];
+			o->set = 1;
+			o->u16 = hexordec_to_ul(arg);
+			break;
+
 		// Verbosity
 		case 'V': 
 			o = &opts[CLOP_VERBOSITY];
@@ -2367,16 +3136,39 @@ static int pr_common(int key, char *arg, struct argp_state *state, int type, str
 			o->u64 = hexordec_to_ull(arg);
 			break;
 
+		// Switch snapshot file to answer from offline
+		case 709: 
+			o = &opts[CLOP_SNAPSHOT];
+			o->set = 1;
+			if (o->str)
+				free(o->str);
+			o->str = strdup(arg);
+			break;
+
+		// Poll interval in milliseconds
+		case 710: 
+			o = &opts[CLOP_INTERVAL];
+			o->set = 1;
+			o->u32 = hexordec_to_ul(arg);
+			break;
+
+		// Number of polls
+		case 711: 
+			o = &opts[CLOP_COUNT];
+			o->set = 1;
+			o->u32 = hexordec_to_ul(arg);
+			break;
+
 		// Usage 
 		case 701: 
 			print_usage(type, ao);
-			exit(0);
+			return parse_exit(state, 0);
 			break;
 
 		// Version
 		case 702: 
 			printf("%s\n", argp_program_version);
-			exit(0);
+			return parse_exit(state, 0);
 			break;
 
 		// print-options
@@ -2412,30 +3204,45 @@ static int pr_main(int key, char *arg, struct argp_state *state)
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
 			if (!strcmp(arg, "mctp")) 
-				rv = argp_parse(&ap_mctp, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_mctp, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "show")) 
-				rv = argp_parse(&ap_show, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_show, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "port") || !strcmp(arg, "pt")) 
-				rv = argp_parse(&ap_port, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_port, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 			
 			else if (!strcmp(arg, "set")) 
-				rv = argp_parse(&ap_set, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_set, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "ld")) 
-				rv = argp_parse(&ap_ld, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_ld, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "aer")) 
-				rv = argp_parse(&ap_aer, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_aer, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 			
+			else if (!strcmp(arg, "batch")) 
+				rv = argp_parse(&ap_batch, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else if (!strcmp(arg, "regs")) 
+				rv = argp_parse(&ap_regs, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else if (!strcmp(arg, "daemon")) 
+				rv = argp_parse(&ap_daemon, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else if (!strcmp(arg, "watch")) 
+				rv = argp_parse(&ap_watch, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else if (!strcmp(arg, "events")) 
+				rv = argp_parse(&ap_events, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
 			else if (!strcmp(arg, "list")) 
 			{
 				opts[CLOP_CMD].set = 1;
 				opts[CLOP_CMD].val = CLCM_LIST;
 			}
 			else 
-				argp_error (state, "Invalid subcommand"); 
+				return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -2456,7 +3263,7 @@ static int pr_main(int key, char *arg, struct argp_state *state)
 			// Help
 			if (!opts[CLOP_CMD].set) {
 				print_help(CLAP_MAIN);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -2532,7 +3339,7 @@ static int pr_mctp(int key, char *arg, struct argp_state *state)
 
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 			break;
 
 		// Last call. Verify parameters. Fill in missing values
@@ -2540,7 +3347,7 @@ static int pr_mctp(int key, char *arg, struct argp_state *state)
 			// Fail if no command is set 
 			if ( !opts[CLOP_CMD].set) {
 				print_help(CLAP_MCTP);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -2566,35 +3373,38 @@ static int pr_show(int key, char *arg, struct argp_state *state)
 	{
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			if (!strcmp(arg, "bos")) 
-				rv = argp_parse(&ap_show_bos, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+			if (!strcmp(arg, "binding")) 
+				rv = argp_parse(&ap_show_binding, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else if (!strcmp(arg, "bos")) 
+				rv = argp_parse(&ap_show_bos, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "identity") || !strcmp(arg, "id") ) 
-				rv = argp_parse(&ap_show_identity, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_show_identity, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "ld")) 
-				rv = argp_parse(&ap_show_ld, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_show_ld, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "limit")) 
-				rv = argp_parse(&ap_show_limit, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_show_limit, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "port") || !strcmp(arg, "ports")) 
-				rv = argp_parse(&ap_show_port, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_show_port, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "qos")) 
-				rv = argp_parse(&ap_show_qos, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_show_qos, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 			
 			else if (!strcmp(arg, "switch") || !strcmp(arg, "sw")) 
-				rv = argp_parse(&ap_show_switch, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_show_switch, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "vcs")) 
-				rv = argp_parse(&ap_show_vcs, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_show_vcs, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "device") ||!strcmp(arg, "devices") || !strcmp(arg, "dev")) 
-				rv = argp_parse(&ap_show_dev, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_show_dev, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else 
-				argp_error (state, "Invalid subcommand"); 
+				return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -2607,7 +3417,7 @@ static int pr_show(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SHOW);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -2634,25 +3444,28 @@ static int pr_port(int key, char *arg, struct argp_state *state)
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
 			if (!strcmp(arg, "bind")) 
-				rv = argp_parse(&ap_port_bind, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_port_bind, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else if (!strcmp(arg, "caps")) 
+				rv = argp_parse(&ap_port_caps, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "config") || !strcmp(arg, "cfg")) 
-				rv = argp_parse(&ap_port_config, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_port_config, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "control") || !strcmp(arg, "ctrl")) 
-				rv = argp_parse(&ap_port_ctrl, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_port_ctrl, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 			
 			else if (!strcmp(arg, "unbind")) 
-				rv = argp_parse(&ap_port_unbind, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_port_unbind, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "connect") || !strcmp(arg, "conn")) 
-				rv = argp_parse(&ap_port_connect, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_port_connect, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "disconnect") || !strcmp(arg, "dis")) 
-				rv = argp_parse(&ap_port_disconnect, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_port_disconnect, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else 
-				argp_error (state, "Invalid subcommand"); 
+				return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -2665,7 +3478,7 @@ static int pr_port(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_PORT);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -2692,16 +3505,16 @@ static int pr_set(int key, char *arg, struct argp_state *state)
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
 			if (!strcmp(arg, "ld")) 
-				rv = argp_parse(&ap_set_ld, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_set_ld, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "limit")) 
-				rv = argp_parse(&ap_set_limit, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_set_limit, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "qos")) 
-				rv = argp_parse(&ap_set_qos, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_set_qos, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else 
-				argp_error (state, "Invalid subcommand"); 
+				return parse_error(state, "Invalid subcommand"); 
 
 			state->next = state->argc; 	// Stop current parser
 			break;
@@ -2713,7 +3526,7 @@ static int pr_set(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SET);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -2739,14 +3552,26 @@ static int pr_ld(int key, char *arg, struct argp_state *state)
 	{
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			if (!strcmp(arg, "config") || !strcmp(arg, "cfg")) 
-				rv = argp_parse(&ap_ld_config, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+			if (!strcmp(arg, "caps")) 
+				rv = argp_parse(&ap_ld_caps, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else if (!strcmp(arg, "config") || !strcmp(arg, "cfg")) 
+				rv = argp_parse(&ap_ld_config, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "mem")) 
-				rv = argp_parse(&ap_ld_mem, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_ld_mem, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else if (!strcmp(arg, "dump")) 
+				rv = argp_parse(&ap_ld_dump, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else if (!strcmp(arg, "test")) 
+				rv = argp_parse(&ap_ld_test, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else if (!strcmp(arg, "snapshot") || !strcmp(arg, "snap")) 
+				rv = argp_parse(&ap_ld_snapshot, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else 
-				argp_error (state, "Invalid subcommand"); 
+				return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -2759,7 +3584,7 @@ static int pr_ld(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_LD);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -2807,15 +3632,14 @@ static int pr_aer(int key, char *arg, struct argp_state *state)
 			o->len = o->num *sizeof(__u8);
 
 			if (o->len != CLMR_AER_HEADER_LEN) {
-				argp_error (state, "Incorrect length of TLP Header"); 
-				exit(1);
+				return parse_error(state, "Incorrect length of TLP Header");
 			}
 		}		
 			break;
 
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -2829,7 +3653,7 @@ static int pr_aer(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_AER);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -2837,11 +3661,11 @@ static int pr_aer(int key, char *arg, struct argp_state *state)
 }
 
 /**
- * Parse function for: show bos
+ * Parse function for: daemon
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_show_bos(int key, char *arg, struct argp_state *state)
+static int pr_daemon(int key, char *arg, struct argp_state *state)
 {
 	struct opt *opts, *o;
 	int rv = 0;
@@ -2849,18 +3673,34 @@ static int pr_show_bos(int key, char *arg, struct argp_state *state)
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_SHOW_BOS, ao_show_bos);
+	rv = pr_common(key, arg, state, CLAP_DAEMON, ao_daemon);
 
 	// Set Command 
 	o = &opts[CLOP_CMD];
 	o->set = 1;
-	o->val = CLCM_SHOW_BOS;
+	o->val = CLCM_DAEMON;
 
 	switch (key)
 	{
+		// Filename of switch state snapshot
+		case 707: 
+			o = &opts[CLOP_CACHE];
+			o->set = 1;
+			if (o->str)
+				free(o->str);
+			o->str = strdup(arg);
+			break;
+
+		// Max age of a snapshot section
+		case 708: 
+			o = &opts[CLOP_CACHE_AGE];
+			o->set = 1;
+			o->u32 = hexordec_to_ul(arg);
+			break;
+
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -2874,11 +3714,11 @@ static int pr_show_bos(int key, char *arg, struct argp_state *state)
 }
 
 /**
- * Parse function for: show identity 
+ * Parse function for: batch
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_show_identity(int key, char *arg, struct argp_state *state)
+static int pr_batch(int key, char *arg, struct argp_state *state)
 {
 	struct opt *opts, *o;
 	int rv = 0;
@@ -2886,55 +3726,61 @@ static int pr_show_identity(int key, char *arg, struct argp_state *state)
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_SHOW_IDENTITY, ao_show_identity);
+	rv = pr_common(key, arg, state, CLAP_BATCH, ao_batch);
 
 	// Set Command 
 	o = &opts[CLOP_CMD];
 	o->set = 1;
-	o->val = CLCM_SHOW_IDENTITY;
+	o->val = CLCM_BATCH;
 
 	switch (key)
 	{
-		// Called for non option parameter
+		// Filename of batch file 
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
-
-			// Stop current parser
-			state->next = state->argc; 	
+			o = &opts[CLOP_INFILE];
+			if (o->set)
+				return parse_error(state, "Only one batch file may be specified"); 
+			o->set = 1;
+			o->str = strdup(arg);
 			break;
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
+			if (!opts[CLOP_INFILE].set) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_BATCH);
+				return parse_exit(state, 0);
+			}
 			break;
 	} 
 	return rv;	
 }
 
 /**
- * Parse function for: show limit
+ * Parse function for: regs
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_show_limit(int key, char *arg, struct argp_state *state)
+static int pr_regs(int key, char *arg, struct argp_state *state)
 {
-	struct opt *opts, *o;
+	struct opt *opts;
 	int rv = 0;
 
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_SHOW_IDENTITY, ao_show_identity);
-
-	// Set Command 
-	o = &opts[CLOP_CMD];
-	o->set = 1;
-	o->val = CLCM_SHOW_MSG_LIMIT;
+	rv = pr_common(key, arg, state, CLAP_REGS, ao_regs);
 
 	switch (key)
 	{
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			if (!strcmp(arg, "run")) 
+				rv = argp_parse(&ap_regs_run, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else 
+				return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -2942,17 +3788,24 @@ static int pr_show_limit(int key, char *arg, struct argp_state *state)
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
+			// Fail if no command is set 
+			if (!opts[CLOP_CMD].set) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_REGS);
+				return parse_exit(state, 0);
+			}
 			break;
 	} 
 	return rv;	
 }
 
 /**
- * Parse function for: show switch 
+ * Parse function for: regs run
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_show_switch(int key, char *arg, struct argp_state *state)
+static int pr_regs_run(int key, char *arg, struct argp_state *state)
 {
 	struct opt *opts, *o;
 	int rv = 0;
@@ -2960,113 +3813,92 @@ static int pr_show_switch(int key, char *arg, struct argp_state *state)
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_SHOW_SWITCH, ao_show_switch);
+	rv = pr_common(key, arg, state, CLAP_REGS_RUN, ao_regs_run);
 
 	// Set Command 
 	o = &opts[CLOP_CMD];
 	o->set = 1;
-	o->val = CLCM_SHOW_SWITCH;
+	o->val = CLCM_REGS_RUN;
 
 	switch (key)
 	{
-		// Called for non option parameter
+		// Filename of register script 
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
-
-			// Stop current parser
-			state->next = state->argc; 	
+			o = &opts[CLOP_INFILE];
+			if (o->set)
+				return parse_error(state, "Only one register script may be specified"); 
+			o->set = 1;
+			o->str = strdup(arg);
 			break;
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
+			if (!opts[CLOP_INFILE].set) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_REGS_RUN);
+				return parse_exit(state, 0);
+			}
 			break;
 	} 
 	return rv;	
 }
 
 /**
- * Parse function for: show dev
+ * Parse function for: watch
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_show_dev(int key, char *arg, struct argp_state *state)
+static int pr_watch(int key, char *arg, struct argp_state *state)
 {
-	struct opt *opts, *o;
+	struct opt *opts;
 	int rv = 0;
 
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_SHOW_DEV, ao_show_dev);
-
-	// Set Command 
-	o = &opts[CLOP_CMD];
-	o->set = 1;
-	o->val = CLCM_SHOW_DEV;
+	rv = pr_common(key, arg, state, CLAP_WATCH, ao_watch);
 
 	switch (key)
 	{
-		// Device ID 
-		case 'a': 
-			o = &opts[CLOP_ALL];
-			o->set = 1;
-			break;
-
-		// Device ID 
-		case 'd': 
-			o = &opts[CLOP_DEVICE];
-			o->set = 1;
-			o->u8 = hexordec_to_ul(arg);
-			break;
-
-		// Called for positional parameter
+		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-		{
-			int range, i, len;
+			if (!strcmp(arg, "port") || !strcmp(arg, "ports")) 
+				rv = argp_parse(&ap_watch_port, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
-			o = &opts[CLOP_DEVICE];
-			o->set = 1;
+			else if (!strcmp(arg, "vcs")) 
+				rv = argp_parse(&ap_watch_vcs, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
-			// Detect range 
-			range = 0;
-			len = strnlen(arg, 256);
-			for ( i = 0 ; i < len ; i++ )
-				if (arg[i] == ',' || arg[i] == '-')
-					range = 1;
+			else if (!strcmp(arg, "qos")) 
+				rv = argp_parse(&ap_watch_qos, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
-			// If there is a command or dash, convert to a range
-			if (range) 
-			{
-				o->buf = malloc(256);
-				memset(o->buf, 0, 256);
-				o->num = range_to_u8_array(o->buf, arg);
-				o->len = o->num * sizeof(__u8);
-			}
 			else 
-				o->u8 = hexordec_to_ul(arg);
-		}
+				return parse_error(state, "Invalid subcommand"); 
+
 			// Stop current parser
 			state->next = state->argc; 	
 			break;
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
-
-			// If no port id was set, select all
-			if (!opts[CLOP_DEVICE].set) 
-				opts[CLOP_ALL].set = 1;
-		
+			// Fail if no command is set 
+			if (!opts[CLOP_CMD].set) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_WATCH);
+				return parse_exit(state, 0);
+			}
 			break;
 	} 
 	return rv;	
 }
 
 /**
- * Parse function for: show port 
+ * Parse function for: watch port
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_show_port(int key, char *arg, struct argp_state *state)
+static int pr_watch_port(int key, char *arg, struct argp_state *state)
 {
 	struct opt *opts, *o;
 	int rv = 0;
@@ -3074,63 +3906,39 @@ static int pr_show_port(int key, char *arg, struct argp_state *state)
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_SHOW_PORT, ao_show_port);
+	rv = pr_common(key, arg, state, CLAP_WATCH_PORT, ao_watch_port);
 
 	// Set Command 
 	o = &opts[CLOP_CMD];
 	o->set = 1;
-	o->val = CLCM_SHOW_PORT;
+	o->val = CLCM_WATCH_PORT;
 
 	switch (key)
 	{
-		// Called for positional  parameter
+		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-		{
-			int range, i, len;
-
-			o = &opts[CLOP_PPID];
-			o->set = 1;
-
-			// Detect range 
-			range = 0;
-			len = strnlen(arg, 256);
-			for ( i = 0 ; i < len ; i++ )
-				if (arg[i] == ',' || arg[i] == '-')
-					range = 1;
+			return parse_error(state, "Invalid subcommand"); 
 
-			// If there is a command or dash, convert to a range
-			if (range) 
-			{
-				o->buf = malloc(256);
-				memset(o->buf, 0, 256);
-				o->num = range_to_u8_array(o->buf, arg);
-				o->len = o->num * sizeof(__u8);
-			}
-			else 
-				o->u8 = hexordec_to_ul(arg);
-		}
 			// Stop current parser
 			state->next = state->argc; 	
 			break;
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
-
-			// If no port id was set, select all
-			if (!opts[CLOP_PPID].set) 
-				opts[CLOP_ALL].set = 1;
-		
+			if (!opts[CLOP_INTERVAL].set || opts[CLOP_INTERVAL].u32 == 0)
+				opts[CLOP_INTERVAL].u32 = 1000;
+			opts[CLOP_INTERVAL].set = 1;
 			break;
 	} 
 	return rv;	
 }
 
 /**
- * Parse function for: show vcs
+ * Parse function for: watch vcs
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_show_vcs(int key, char *arg, struct argp_state *state)
+static int pr_watch_vcs(int key, char *arg, struct argp_state *state)
 {
 	struct opt *opts, *o;
 	int rv = 0;
@@ -3138,91 +3946,58 @@ static int pr_show_vcs(int key, char *arg, struct argp_state *state)
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_SHOW_VCS, ao_show_vcs);
+	rv = pr_common(key, arg, state, CLAP_WATCH_VCS, ao_watch_vcs);
 
 	// Set Command 
 	o = &opts[CLOP_CMD];
 	o->set = 1;
-	o->val = CLCM_SHOW_VCS;
+	o->val = CLCM_WATCH_VCS;
 
 	switch (key)
 	{
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-		{
-			int range, i, len;
-
-			o = &opts[CLOP_VCSID];
-			o->set = 1;
-
-			// Detect range 
-			range = 0;
-			len = strnlen(arg, 256);
-			for ( i = 0 ; i < len ; i++ )
-				if (arg[i] == ',' || arg[i] == '-')
-					range = 1;
-
-			// If there is a command or dash, convert to a range
-			if (range) 
-			{
-				o->buf = malloc(256);
-				memset(o->buf, 0, 256);
-				o->num = range_to_u8_array(o->buf, arg);
-				o->len = o->num * sizeof(__u8);
-			}
-			else 
-				o->u8 = hexordec_to_ul(arg);
-		}	
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
 			break;
 
-		// Last call. Verify parameters. Fill in missing values	
+		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
-			
-			// If a VCS ID was not specified, set all
-			if (!opts[CLOP_VCSID].set)
-				opts[CLOP_ALL].set = 1; 
-
+			if (!opts[CLOP_INTERVAL].set || opts[CLOP_INTERVAL].u32 == 0)
+				opts[CLOP_INTERVAL].u32 = 1000;
+			opts[CLOP_INTERVAL].set = 1;
 			break;
 	} 
 	return rv;	
 }
 
 /**
- * Parse function for: show qos
+ * Parse function for: watch qos
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_show_qos(int key, char *arg, struct argp_state *state)
+static int pr_watch_qos(int key, char *arg, struct argp_state *state)
 {
-	struct opt *opts;
+	struct opt *opts, *o;
 	int rv = 0;
 
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_SHOW_QOS, ao_show_qos);
+	rv = pr_common(key, arg, state, CLAP_WATCH_QOS, ao_watch_qos);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_WATCH_QOS;
 
 	switch (key)
 	{
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			if (!strcmp(arg, "allocated") || !strcmp(arg, "alloc")) 
-				rv = argp_parse(&ap_show_qos_allocated, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
-
-			else if (!strcmp(arg, "control") || !strcmp(arg, "ctrl")) 
-				rv = argp_parse(&ap_show_qos_control, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
-
-			else if (!strcmp(arg, "limit")) 
-				rv = argp_parse(&ap_show_qos_limit, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
-			
-			else if (!strcmp(arg, "status") || !strcmp(arg, "st")) 
-				rv = argp_parse(&ap_show_qos_status, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
-
-			else 
-				argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -3230,45 +4005,938 @@ static int pr_show_qos(int key, char *arg, struct argp_state *state)
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
-			// Fail if no command is set 
-			if ( !opts[CLOP_CMD].set) {
-				if (opts[CLOP_PRNT_OPTS].set)
-					print_options_array(opts);
-				print_help(CLAP_SHOW_QOS);
-				exit(0);
-			}
+			if (!opts[CLOP_INTERVAL].set || opts[CLOP_INTERVAL].u32 == 0)
+				opts[CLOP_INTERVAL].u32 = 1000;
+			opts[CLOP_INTERVAL].set = 1;
 			break;
 	} 
 	return rv;	
 }
 
 /**
- * Parse function for: show ld
+ * Parse function for: events
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_show_ld(int key, char *arg, struct argp_state *state)
+static int pr_events(int key, char *arg, struct argp_state *state)
 {
-	struct opt *opts;
+	struct opt *opts, *o;
 	int rv = 0;
 
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_SHOW_LD, ao_show_ld);
+	rv = pr_common(key, arg, state, CLAP_EVENTS, ao_events);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_EVENTS;
 
 	switch (key)
 	{
+		// Follow
+		case 712: 
+			o = &opts[CLOP_FOLLOW];
+			o->set = 1;
+			break;
+
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			if (!strcmp(arg, "allocations") || !strcmp(arg, "alloc")) 
-				rv = argp_parse(&ap_show_ld_allocations, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+			return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: show binding
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_show_binding(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_SHOW_BINDING, ao_show_binding);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_SHOW_BINDING;
+
+	switch (key)
+	{
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			// Fail if no port id was set
+			if (!opts[CLOP_PPID].set) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_SHOW_BINDING);
+				return parse_exit(state, 0);
+			}
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: show bos
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_show_bos(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_SHOW_BOS, ao_show_bos);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_SHOW_BOS;
+
+	switch (key)
+	{
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: show identity 
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_show_identity(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_SHOW_IDENTITY, ao_show_identity);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_SHOW_IDENTITY;
+
+	switch (key)
+	{
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: show limit
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_show_limit(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_SHOW_IDENTITY, ao_show_identity);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_SHOW_MSG_LIMIT;
+
+	switch (key)
+	{
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: show switch 
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_show_switch(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_SHOW_SWITCH, ao_show_switch);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_SHOW_SWITCH;
+
+	switch (key)
+	{
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: show dev
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_show_dev(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_SHOW_DEV, ao_show_dev);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_SHOW_DEV;
+
+	switch (key)
+	{
+		// Device ID 
+		case 'a': 
+			o = &opts[CLOP_ALL];
+			o->set = 1;
+			break;
+
+		// Device ID 
+		case 'd': 
+			o = &opts[CLOP_DEVICE];
+			o->set = 1;
+			o->u8 = hexordec_to_ul(arg);
+			break;
+
+		// Called for positional parameter
+		case ARGP_KEY_ARG: 				
+		{
+			int range, i, len;
+
+			o = &opts[CLOP_DEVICE];
+			o->set = 1;
+
+			// Detect range 
+			range = 0;
+			len = strnlen(arg, 256);
+			for ( i = 0 ; i < len ; i++ )
+				if (arg[i] == ',' || arg[i] == '-')
+					range = 1;
+
+			// If there is a command or dash, convert to a range
+			if (range) 
+			{
+				o->buf = malloc(256);
+				memset(o->buf, 0, 256);
+				o->num = range_to_u8_array(o->buf, arg);
+				o->len = o->num * sizeof(__u8);
+			}
+			else 
+				o->u8 = hexordec_to_ul(arg);
+		}
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+
+			// If no port id was set, select all
+			if (!opts[CLOP_DEVICE].set) 
+				opts[CLOP_ALL].set = 1;
+		
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: show port 
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_show_port(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	struct port_filter filter;
+	int fields[FTCL_MAX];
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_SHOW_PORT, ao_show_port);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_SHOW_PORT;
+
+	switch (key)
+	{
+		// Filter expression
+		case 713: 
+			o = &opts[CLOP_WHERE];
+			o->set = 1;
+			if (o->str)
+				free(o->str);
+			o->str = strdup(arg);
+			break;
+
+		// Columns to print
+		case 714: 
+			o = &opts[CLOP_FIELDS];
+			o->set = 1;
+			if (o->str)
+				free(o->str);
+			o->str = strdup(arg);
+			break;
+
+		// Called for positional  parameter
+		case ARGP_KEY_ARG: 				
+		{
+			int range, i, len;
+
+			o = &opts[CLOP_PPID];
+			o->set = 1;
+
+			// Detect range 
+			range = 0;
+			len = strnlen(arg, 256);
+			for ( i = 0 ; i < len ; i++ )
+				if (arg[i] == ',' || arg[i] == '-')
+					range = 1;
+
+			// If there is a command or dash, convert to a range
+			if (range) 
+			{
+				o->buf = malloc(256);
+				memset(o->buf, 0, 256);
+				o->num = range_to_u8_array(o->buf, arg);
+				o->len = o->num * sizeof(__u8);
+			}
+			else 
+				o->u8 = hexordec_to_ul(arg);
+		}
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+
+			// If no port id was set, select all
+			if (!opts[CLOP_PPID].set) 
+				opts[CLOP_ALL].set = 1;
+
+			// Validate the filter and field list before the request is sent
+			if (filter_parse(&filter, opts[CLOP_WHERE].str))
+				return parse_error(state, "Invalid --where expression");
+			if (filter_fields(fields, FTCL_MAX, opts[CLOP_FIELDS].str) < 0)
+				return parse_error(state, "Invalid --fields list");
+		
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: show vcs
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_show_vcs(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_SHOW_VCS, ao_show_vcs);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_SHOW_VCS;
+
+	switch (key)
+	{
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+		{
+			int range, i, len;
+
+			o = &opts[CLOP_VCSID];
+			o->set = 1;
+
+			// Detect range 
+			range = 0;
+			len = strnlen(arg, 256);
+			for ( i = 0 ; i < len ; i++ )
+				if (arg[i] == ',' || arg[i] == '-')
+					range = 1;
+
+			// If there is a command or dash, convert to a range
+			if (range) 
+			{
+				o->buf = malloc(256);
+				memset(o->buf, 0, 256);
+				o->num = range_to_u8_array(o->buf, arg);
+				o->len = o->num * sizeof(__u8);
+			}
+			else 
+				o->u8 = hexordec_to_ul(arg);
+		}	
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values	
+		case ARGP_KEY_END:				
+			
+			// If a VCS ID was not specified, set all
+			if (!opts[CLOP_VCSID].set)
+				opts[CLOP_ALL].set = 1; 
+
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: show qos
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_show_qos(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_SHOW_QOS, ao_show_qos);
+
+	switch (key)
+	{
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			if (!strcmp(arg, "allocated") || !strcmp(arg, "alloc")) 
+				rv = argp_parse(&ap_show_qos_allocated, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else if (!strcmp(arg, "control") || !strcmp(arg, "ctrl")) 
+				rv = argp_parse(&ap_show_qos_control, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else if (!strcmp(arg, "limit")) 
+				rv = argp_parse(&ap_show_qos_limit, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+			
+			else if (!strcmp(arg, "status") || !strcmp(arg, "st")) 
+				rv = argp_parse(&ap_show_qos_status, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else 
+				return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			// Fail if no command is set 
+			if ( !opts[CLOP_CMD].set) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_SHOW_QOS);
+				return parse_exit(state, 0);
+			}
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: show ld
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_show_ld(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_SHOW_LD, ao_show_ld);
+
+	switch (key)
+	{
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			if (!strcmp(arg, "allocations") || !strcmp(arg, "alloc")) 
+				rv = argp_parse(&ap_show_ld_allocations, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
 			else if (!strcmp(arg, "info")) 
-				rv = argp_parse(&ap_show_ld_info, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
+				rv = argp_parse(&ap_show_ld_info, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else 
+				return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			// Fail if no command is set 
+			if ( !opts[CLOP_CMD].set) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_SHOW_LD);
+				return parse_exit(state, 0);
+			}
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: port bind
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_port_bind(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_PORT_BIND, ao_port_bind);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_PORT_BIND;
+
+	switch (key)
+	{
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			// Fail if one of the required options isn't set
+			if ( !opts[CLOP_VCSID].set || !opts[CLOP_PPID].set || 
+				!opts[CLOP_VPPBID].set) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_PORT_BIND);
+				return parse_exit(state, 0);
+			}
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: port unbind
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_port_unbind(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_PORT_UNBIND, ao_port_unbind);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_PORT_UNBIND;
+
+	switch (key)
+	{
+		// Simulate Managed Hot-Remove
+		case 'm': 
+			o = &opts[CLOP_UNBIND_MODE];
+			o->set = 1;
+			o->val = CLPU_MANAGED;
+			break;
+
+		// Simulate Surpise Hot-Remove
+		case 's': 
+			o = &opts[CLOP_UNBIND_MODE];
+			o->set = 1;
+			o->val = CLPU_SURPRISE;
+			break;
+
+		// Wait for port link down before unbinding
+		case 'w': 
+			o = &opts[CLOP_UNBIND_MODE];
+			o->set = 1;
+			o->val = CLPU_WAIT;
+			break;
+
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			// Check for required parameters
+			if (!opts[CLOP_VCSID].set || !opts[CLOP_VPPBID].set) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_PORT_UNBIND);
+				return parse_exit(state, 0);
+			}
+			
+			// Default to Surprise hot plug if not specified
+			if (!opts[CLOP_UNBIND_MODE].set) {
+				opts[CLOP_UNBIND_MODE].set = 1;
+				opts[CLOP_UNBIND_MODE].val = CLPU_SURPRISE;
+			}
+
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: port config
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_port_config(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_PORT_CONFIG, ao_port_config);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_PORT_CONFIG;
+
+	switch (key)
+	{
+		// Extended Register Number
+		case 'e': 
+			o = &opts[CLOP_EXT_REGISTER];
+			o->set = 1;
+			o->u8 = hexordec_to_ul(arg);
+			break;
+
+		// First Dword Byte Enable
+		case 'f': 
+			o = &opts[CLOP_FDBE];
+			o->set = 1;
+			o->u8 = hexordec_to_ul(arg);
+			break;
+
+		// Register Number
+		case 'r': 
+			o = &opts[CLOP_REGISTER];
+			o->set = 1;
+			o->u8 = hexordec_to_ul(arg);
+			break;
+
+		// Perform a Write transaction
+		case 'w': 
+			o = &opts[CLOP_WRITE];
+			o->set = 1;
+			break;
+
+		// Immediate data for write transaction
+		case 703: 
+			o = &opts[CLOP_DATA];
+			o->set = 1;
+			o->u32 = hexordec_to_ul(arg);
+			break;
+
+		// Filename for output file
+		case 715: 
+			o = &opts[CLOP_OUTFILE];
+			o->set = 1;
+			o->str = strdup(arg);
+			break;
+
+		// Read the full config space
+		case 727: 
+			o = &opts[CLOP_DUMP];
+			o->set = 1;
+			break;
+
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			// Check for mandatory options
+			if ( !opts[CLOP_PPID].set ) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_PORT_CONFIG);
+				return parse_exit(state, 0);
+			}
+
+			// A dump reads every register
+			if (opts[CLOP_DUMP].set && (opts[CLOP_WRITE].set || opts[CLOP_REGISTER].set || opts[CLOP_EXT_REGISTER].set)) {
+				return parse_error(state, "--dump cannot be used with a write or a register");
+			}
+			if (opts[CLOP_OUTFILE].set && !opts[CLOP_DUMP].set) {
+				return parse_error(state, "--outfile requires --dump");
+			}
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: port connect
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_port_connect(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_PORT_CONN, ao_port_connect);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_PORT_CONN;
+
+	switch (key)
+	{
+		// Device ID 
+		case 'd': 
+			o = &opts[CLOP_DEVICE];
+			o->set = 1;
+			o->u8 = hexordec_to_ul(arg);
+			break;
+
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			// Check for mandatory options
+			if ( !opts[CLOP_PPID].set ) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_PORT_CONFIG);
+				return parse_exit(state, 0);
+			}
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: port disconnect
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_port_disconnect(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_PORT_DISCONN, ao_port_disconnect);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_PORT_DISCONN;
+
+	switch (key)
+	{
+		case 'a': 
+			opts[CLOP_ALL].set = 1;
+			break;
+
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+
+			opts[CLOP_PPID].set = 1;
+			opts[CLOP_PPID].u8 = hexordec_to_ul(arg);;
+
+			// Stop current parser
+			state->next = state->argc; 	
+			break;
+
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			// Check for mandatory options
+			if ( !opts[CLOP_PPID].set && !opts[CLOP_ALL].set) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_PORT_CONFIG);
+				return parse_exit(state, 0);
+			}
+			break;
+	} 
+	return rv;	
+}
+
+/**
+ * Parse function for: port control
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_port_ctrl(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
+
+	opts = (struct opt*) state->input;
+
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_PORT_CTRL, ao_port_ctrl);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_PORT_CTRL;
+
+	switch (key)
+	{
+		// Assert PERST
+		case 'a': 
+			o = &opts[CLOP_PORT_CONTROL];
+			o->set = 1;
+			o->val = CLPC_ASSERT;
+			break;
+
+		// Deassert PERST
+		case 'd': 
+			o = &opts[CLOP_PORT_CONTROL];
+			o->set = 1;
+			o->val = CLPC_DEASSERT;
+			break;
 
-			else 
-				argp_error (state, "Invalid subcommand"); 
+		// Reset PCIe-to-PCIe Bridge
+		case 'r': 
+			o = &opts[CLOP_PORT_CONTROL];
+			o->set = 1;
+			o->val = CLPC_RESET;
+			break;
+
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -3276,12 +4944,18 @@ static int pr_show_ld(int key, char *arg, struct argp_state *state)
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
-			// Fail if no command is set 
-			if ( !opts[CLOP_CMD].set) {
+			// Check for mandatory options
+			if ( !opts[CLOP_PPID].set ) {
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
-				print_help(CLAP_SHOW_LD);
-				exit(0);
+				print_help(CLAP_PORT_CTRL);
+				return parse_exit(state, 0);
+			}
+
+			// Default to reset action if opcode flag not provided 
+			if ( !opts[CLOP_PORT_CONTROL].set ) {
+				opts[CLOP_PORT_CONTROL].set = 1;
+				opts[CLOP_PORT_CONTROL].val = CLPC_RESET;
 			}
 			break;
 	} 
@@ -3289,30 +4963,29 @@ static int pr_show_ld(int key, char *arg, struct argp_state *state)
 }
 
 /**
- * Parse function for: port bind
+ * Parse function for: set ld
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_port_bind(int key, char *arg, struct argp_state *state)
+static int pr_set_ld(int key, char *arg, struct argp_state *state)
 {
-	struct opt *opts, *o;
+	struct opt *opts;
 	int rv = 0;
 
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_PORT_BIND, ao_port_bind);
-
-	// Set Command 
-	o = &opts[CLOP_CMD];
-	o->set = 1;
-	o->val = CLCM_PORT_BIND;
+	rv = pr_common(key, arg, state, CLAP_SET_LD, ao_set_ld);
 
 	switch (key)
 	{
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			if (!strcmp(arg, "allocations") || !strcmp(arg, "alloc")) 
+				rv = argp_parse(&ap_set_ld_allocations, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
+
+			else 
+				return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -3320,13 +4993,12 @@ static int pr_port_bind(int key, char *arg, struct argp_state *state)
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
-			// Fail if one of the required options isn't set
-			if ( !opts[CLOP_VCSID].set || !opts[CLOP_PPID].set || 
-				!opts[CLOP_VPPBID].set) {
+			// Fail if no command is set 
+			if ( !opts[CLOP_CMD].set) {
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
-				print_help(CLAP_PORT_BIND);
-				exit(0);
+				print_help(CLAP_SET_LD);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -3334,51 +5006,35 @@ static int pr_port_bind(int key, char *arg, struct argp_state *state)
 }
 
 /**
- * Parse function for: port unbind
+ * Parse function for: set qos
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_port_unbind(int key, char *arg, struct argp_state *state)
+static int pr_set_qos(int key, char *arg, struct argp_state *state)
 {
-	struct opt *opts, *o;
+	struct opt *opts;
 	int rv = 0;
 
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_PORT_UNBIND, ao_port_unbind);
-
-	// Set Command 
-	o = &opts[CLOP_CMD];
-	o->set = 1;
-	o->val = CLCM_PORT_UNBIND;
+	rv = pr_common(key, arg, state, CLAP_SET_QOS, ao_set_qos);
 
 	switch (key)
 	{
-		// Simulate Managed Hot-Remove
-		case 'm': 
-			o = &opts[CLOP_UNBIND_MODE];
-			o->set = 1;
-			o->val = CLPU_MANAGED;
-			break;
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			if (!strcmp(arg, "allocated") || !strcmp(arg, "alloc")) 
+				rv = argp_parse(&ap_set_qos_allocated, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
-		// Simulate Surpise Hot-Remove
-		case 's': 
-			o = &opts[CLOP_UNBIND_MODE];
-			o->set = 1;
-			o->val = CLPU_SURPRISE;
-			break;
+			else if (!strcmp(arg, "control") || !strcmp(arg, "ctrl")) 
+				rv = argp_parse(&ap_set_qos_control, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
-		// Wait for port link down before unbinding
-		case 'w': 
-			o = &opts[CLOP_UNBIND_MODE];
-			o->set = 1;
-			o->val = CLPU_WAIT;
-			break;
+			else if (!strcmp(arg, "limit")) 
+				rv = argp_parse(&ap_set_qos_limit, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
-		// Called for non option parameter
-		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			else 
+				return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -3386,31 +5042,24 @@ static int pr_port_unbind(int key, char *arg, struct argp_state *state)
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
-			// Check for required parameters
-			if (!opts[CLOP_VCSID].set || !opts[CLOP_VPPBID].set) {
+			// Fail if no command is set 
+			if ( !opts[CLOP_CMD].set) {
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
-				print_help(CLAP_PORT_UNBIND);
-				exit(0);
-			}
-			
-			// Default to Surprise hot plug if not specified
-			if (!opts[CLOP_UNBIND_MODE].set) {
-				opts[CLOP_UNBIND_MODE].set = 1;
-				opts[CLOP_UNBIND_MODE].val = CLPU_SURPRISE;
+				print_help(CLAP_SET_QOS);
+				return parse_exit(state, 0);
 			}
-
 			break;
 	} 
 	return rv;	
 }
 
 /**
- * Parse function for: port config
+ * Parse function for: ld config
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_port_config(int key, char *arg, struct argp_state *state)
+static int pr_ld_config(int key, char *arg, struct argp_state *state)
 {
 	struct opt *opts, *o;
 	int rv = 0;
@@ -3418,12 +5067,12 @@ static int pr_port_config(int key, char *arg, struct argp_state *state)
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_PORT_CONFIG, ao_port_config);
+	rv = pr_common(key, arg, state, CLAP_LD_CONFIG, ao_ld_config);
 
 	// Set Command 
 	o = &opts[CLOP_CMD];
 	o->set = 1;
-	o->val = CLCM_PORT_CONFIG;
+	o->val = CLCM_LD_CONFIG;
 
 	switch (key)
 	{
@@ -3448,22 +5097,35 @@ static int pr_port_config(int key, char *arg, struct argp_state *state)
 			o->u8 = hexordec_to_ul(arg);
 			break;
 
-		// Perform a Write transaction
+		// Write Data 
 		case 'w': 
 			o = &opts[CLOP_WRITE];
 			o->set = 1;
 			break;
 
 		// Immediate data for write transaction
-		case 703: 
+		case 703:
 			o = &opts[CLOP_DATA];
 			o->set = 1;
 			o->u32 = hexordec_to_ul(arg);
 			break;
 
+		// Filename for output file
+		case 715: 
+			o = &opts[CLOP_OUTFILE];
+			o->set = 1;
+			o->str = strdup(arg);
+			break;
+
+		// Read the full config space
+		case 727: 
+			o = &opts[CLOP_DUMP];
+			o->set = 1;
+			break;
+
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -3475,8 +5137,16 @@ static int pr_port_config(int key, char *arg, struct argp_state *state)
 			if ( !opts[CLOP_PPID].set ) {
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
-				print_help(CLAP_PORT_CONFIG);
-				exit(0);
+				print_help(CLAP_LD_CONFIG);
+				return parse_exit(state, 0);
+			}
+
+			// A dump reads every register
+			if (opts[CLOP_DUMP].set && (opts[CLOP_WRITE].set || opts[CLOP_REGISTER].set || opts[CLOP_EXT_REGISTER].set)) {
+				return parse_error(state, "--dump cannot be used with a write or a register");
+			}
+			if (opts[CLOP_OUTFILE].set && !opts[CLOP_DUMP].set) {
+				return parse_error(state, "--outfile requires --dump");
 			}
 			break;
 	} 
@@ -3484,11 +5154,11 @@ static int pr_port_config(int key, char *arg, struct argp_state *state)
 }
 
 /**
- * Parse function for: port connect
+ * Parse function for: ld mem
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_port_connect(int key, char *arg, struct argp_state *state)
+static int pr_ld_mem(int key, char *arg, struct argp_state *state)
 {
 	struct opt *opts, *o;
 	int rv = 0;
@@ -3496,88 +5166,180 @@ static int pr_port_connect(int key, char *arg, struct argp_state *state)
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_PORT_CONN, ao_port_connect);
+	rv = pr_common(key, arg, state, CLAP_LD_MEM, ao_ld_mem);
 
 	// Set Command 
 	o = &opts[CLOP_CMD];
 	o->set = 1;
-	o->val = CLCM_PORT_CONN;
+	o->val = CLCM_LD_MEM;
 
 	switch (key)
 	{
-		// Device ID 
+		// Last Dword Byte Enable
 		case 'd': 
-			o = &opts[CLOP_DEVICE];
+			o = &opts[CLOP_LDBE];
 			o->set = 1;
 			o->u8 = hexordec_to_ul(arg);
 			break;
 
-		// Called for non option parameter
-		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+		// First Dword Byte Enable
+		case 'f': 
+			o = &opts[CLOP_FDBE];
+			o->set = 1;
+			o->u8 = hexordec_to_ul(arg);
+			break;
 
-			// Stop current parser
-			state->next = state->argc; 	
+		// Transaction Data Length. Split into chunks when sent
+		case 'n': 
+			o = &opts[CLOP_LEN];
+			o->set = 1;
+			o->len = hexordec_to_ull(arg);
 			break;
 
-		// Last call. Verify parameters. Fill in missing values
-		case ARGP_KEY_END:				
-			// Check for mandatory options
-			if ( !opts[CLOP_PPID].set ) {
-				if (opts[CLOP_PRNT_OPTS].set)
-					print_options_array(opts);
-				print_help(CLAP_PORT_CONFIG);
-				exit(0);
-			}
+		// Transaction Offset in tareget's memory space
+		case 'o': 
+			o = &opts[CLOP_OFFSET];
+			o->set = 1;
+			o->u64 = hexordec_to_ull(arg);
 			break;
-	} 
-	return rv;	
-}
 
-/**
- * Parse function for: port disconnect
- *
- * @return 0 success, non-zero to indicate a problem 
- */
-static int pr_port_disconnect(int key, char *arg, struct argp_state *state)
-{
-	struct opt *opts, *o;
-	int rv = 0;
+		// Write Transacrtion
+		case 'w': 
+			o = &opts[CLOP_WRITE];
+			o->set = 1;
+			break;
 
-	opts = (struct opt*) state->input;
+		// Immediate data for write transaction
+		case 703: 
+			o = &opts[CLOP_DATA];
+			o->set = 1;
+			o->u32 = hexordec_to_ul(arg);
+			break;
 
-	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_PORT_DISCONN, ao_port_disconnect);
+		// Filename for input file
+		case 704: 
+			o = &opts[CLOP_INFILE];
+			o->set = 1;
+			o->str = strdup(arg);
+			break;
 
-	// Set Command 
-	o = &opts[CLOP_CMD];
-	o->set = 1;
-	o->val = CLCM_PORT_DISCONN;
+		// Filename for output file
+		case 715: 
+			o = &opts[CLOP_OUTFILE];
+			o->set = 1;
+			o->str = strdup(arg);
+			break;
 
-	switch (key)
-	{
-		case 'a': 
-			opts[CLOP_ALL].set = 1;
+		// Binary output to stdout
+		case 716: 
+			o = &opts[CLOP_RAW];
+			o->set = 1;
+			break;
+
+		// Compare read data against a file
+		case 722: 
+			o = &opts[CLOP_VERIFY];
+			o->set = 1;
+			o->str = strdup(arg);
+			break;
+
+		// CRC32C of read data
+		case 723: 
+			o = &opts[CLOP_CHECKSUM];
+			o->set = 1;
+			break;
+
+		// Map of the non-zero extents of the output file
+		case 724: 
+			o = &opts[CLOP_SPARSE_MAP];
+			o->set = 1;
+			break;
+
+		// Snapshot store
+		case 725: 
+			o = &opts[CLOP_STORE];
+			o->set = 1;
+			o->str = strdup(arg);
+			break;
+
+		// Snapshot name
+		case 726: 
+			o = &opts[CLOP_NAME];
+			o->set = 1;
+			o->str = strdup(arg);
+			if (strchr(arg, '/') != NULL || arg[0] == '.' || arg[0] == 0) {
+				return parse_error(state, "Invalid snapshot name: %s", arg);
+			}
 			break;
 
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-
-			opts[CLOP_PPID].set = 1;
-			opts[CLOP_PPID].u8 = hexordec_to_ul(arg);;
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
 			break;
 
-		// Last call. Verify parameters. Fill in missing values
-		case ARGP_KEY_END:				
-			// Check for mandatory options
-			if ( !opts[CLOP_PPID].set && !opts[CLOP_ALL].set) {
-				if (opts[CLOP_PRNT_OPTS].set)
-					print_options_array(opts);
-				print_help(CLAP_PORT_CONFIG);
-				exit(0);
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+
+			// Check for mandatory options. A verify defaults to the file length
+			if ( !opts[CLOP_PPID].set || (!opts[CLOP_LEN].set && !opts[CLOP_VERIFY].set) ) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_LD_MEM);
+				return parse_exit(state, 0);
+			}
+
+			// Validate len
+			if (opts[CLOP_LEN].set) {
+				if (opts[CLOP_LEN].len == 0) {
+					if (opts[CLOP_PRNT_OPTS].set)
+						print_options_array(opts);
+					return parse_error(state, "Length must be greater than zero.");
+				}
+			}
+
+			// Binary output is only produced by reads
+			if (opts[CLOP_WRITE].set && (opts[CLOP_OUTFILE].set || opts[CLOP_RAW].set)) {
+				return parse_error(state, "--outfile and --raw cannot be used with a write");
+			}
+			if (opts[CLOP_OUTFILE].set && opts[CLOP_RAW].set) {
+				return parse_error(state, "--outfile and --raw cannot be used together");
+			}
+			if (opts[CLOP_SPARSE_MAP].set && !opts[CLOP_OUTFILE].set) {
+				return parse_error(state, "--sparse-map requires --outfile");
+			}
+
+			// A snapshot is taken of read data instead of an output
+			if (opts[CLOP_STORE].set && (opts[CLOP_WRITE].set || opts[CLOP_OUTFILE].set || 
+			    opts[CLOP_RAW].set || opts[CLOP_VERIFY].set || opts[CLOP_CHECKSUM].set)) {
+				return parse_error(state, "--store cannot be used with a write, --outfile, --raw, --verify or --checksum");
+			}
+			if (opts[CLOP_NAME].set && !opts[CLOP_STORE].set) {
+				return parse_error(state, "--name requires --store");
+			}
+
+			// Checks consume the read data instead of an output
+			if ((opts[CLOP_VERIFY].set || opts[CLOP_CHECKSUM].set) && 
+			    (opts[CLOP_WRITE].set || opts[CLOP_OUTFILE].set || opts[CLOP_RAW].set)) {
+				return parse_error(state, "--verify and --checksum cannot be used with a write, --outfile or --raw");
+			}
+
+			// The input file is mapped when the transfer runs. Only check 
+			// that it can be opened here
+			o = &opts[CLOP_INFILE];
+			if (o->set) {
+				FILE *fd;
+
+				// Open File 
+				fd = fopen(o->str, "rb");
+				if (!fd) {
+					if (opts[CLOP_PRNT_OPTS].set)
+						print_options_array(opts);
+					return parse_error(state, "Could not open file");
+				}
+				fclose(fd);
 			}
 			break;
 	} 
@@ -3585,11 +5347,11 @@ static int pr_port_disconnect(int key, char *arg, struct argp_state *state)
 }
 
 /**
- * Parse function for: port control
+ * Parse function for: ld dump
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_port_ctrl(int key, char *arg, struct argp_state *state)
+static int pr_ld_dump(int key, char *arg, struct argp_state *state)
 {
 	struct opt *opts, *o;
 	int rv = 0;
@@ -3597,39 +5359,37 @@ static int pr_port_ctrl(int key, char *arg, struct argp_state *state)
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_PORT_CTRL, ao_port_ctrl);
+	rv = pr_common(key, arg, state, CLAP_LD_DUMP, ao_ld_dump);
 
 	// Set Command 
 	o = &opts[CLOP_CMD];
 	o->set = 1;
-	o->val = CLCM_PORT_CTRL;
+	o->val = CLCM_LD_DUMP;
 
 	switch (key)
 	{
-		// Assert PERST
-		case 'a': 
-			o = &opts[CLOP_PORT_CONTROL];
+		// Every LD of the port
+		case 717: 
+			o = &opts[CLOP_ALL_LD];
 			o->set = 1;
-			o->val = CLPC_ASSERT;
 			break;
 
-		// Deassert PERST
-		case 'd': 
-			o = &opts[CLOP_PORT_CONTROL];
+		// Directory for the dump files
+		case 718: 
+			o = &opts[CLOP_OUTDIR];
 			o->set = 1;
-			o->val = CLPC_DEASSERT;
+			o->str = strdup(arg);
 			break;
 
-		// Reset PCIe-to-PCIe Bridge
-		case 'r': 
-			o = &opts[CLOP_PORT_CONTROL];
+		// Map of the non-zero extents of each file
+		case 724: 
+			o = &opts[CLOP_SPARSE_MAP];
 			o->set = 1;
-			o->val = CLPC_RESET;
 			break;
 
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -3637,18 +5397,17 @@ static int pr_port_ctrl(int key, char *arg, struct argp_state *state)
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
+
 			// Check for mandatory options
-			if ( !opts[CLOP_PPID].set ) {
+			if ( !opts[CLOP_ALL].set && !(opts[CLOP_PPID].set && (opts[CLOP_ALL_LD].set || opts[CLOP_LDID].set)) ) {
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
-				print_help(CLAP_PORT_CTRL);
-				exit(0);
+				print_help(CLAP_LD_DUMP);
+				return parse_exit(state, 0);
 			}
 
-			// Default to reset action if opcode flag not provided 
-			if ( !opts[CLOP_PORT_CONTROL].set ) {
-				opts[CLOP_PORT_CONTROL].set = 1;
-				opts[CLOP_PORT_CONTROL].val = CLPC_RESET;
+			if (opts[CLOP_ALL].set && (opts[CLOP_PPID].set || opts[CLOP_LDID].set)) {
+				return parse_error(state, "--all cannot be used with a port or LD");
 			}
 			break;
 	} 
@@ -3656,29 +5415,30 @@ static int pr_port_ctrl(int key, char *arg, struct argp_state *state)
 }
 
 /**
- * Parse function for: set ld
+ * Parse function for: port caps
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_set_ld(int key, char *arg, struct argp_state *state)
+static int pr_port_caps(int key, char *arg, struct argp_state *state)
 {
-	struct opt *opts;
+	struct opt *opts, *o;
 	int rv = 0;
 
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_SET_LD, ao_set_ld);
+	rv = pr_common(key, arg, state, CLAP_PORT_CAPS, ao_port_caps);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_PORT_CAPS;
 
 	switch (key)
 	{
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			if (!strcmp(arg, "allocations") || !strcmp(arg, "alloc")) 
-				rv = argp_parse(&ap_set_ld_allocations, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
-
-			else 
-				argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -3686,12 +5446,13 @@ static int pr_set_ld(int key, char *arg, struct argp_state *state)
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
-			// Fail if no command is set 
-			if ( !opts[CLOP_CMD].set) {
+
+			// Check for mandatory options
+			if ( !opts[CLOP_PPID].set ) {
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
-				print_help(CLAP_SET_LD);
-				exit(0);
+				print_help(CLAP_PORT_CAPS);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -3699,35 +5460,30 @@ static int pr_set_ld(int key, char *arg, struct argp_state *state)
 }
 
 /**
- * Parse function for: set qos
+ * Parse function for: ld caps
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_set_qos(int key, char *arg, struct argp_state *state)
+static int pr_ld_caps(int key, char *arg, struct argp_state *state)
 {
-	struct opt *opts;
+	struct opt *opts, *o;
 	int rv = 0;
 
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_SET_QOS, ao_set_qos);
+	rv = pr_common(key, arg, state, CLAP_LD_CAPS, ao_ld_caps);
+
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_LD_CAPS;
 
 	switch (key)
 	{
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			if (!strcmp(arg, "allocated") || !strcmp(arg, "alloc")) 
-				rv = argp_parse(&ap_set_qos_allocated, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
-
-			else if (!strcmp(arg, "control") || !strcmp(arg, "ctrl")) 
-				rv = argp_parse(&ap_set_qos_control, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
-
-			else if (!strcmp(arg, "limit")) 
-				rv = argp_parse(&ap_set_qos_limit, state->argc-state->next+1, &state->argv[state->next-1], ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
-
-			else 
-				argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -3735,12 +5491,13 @@ static int pr_set_qos(int key, char *arg, struct argp_state *state)
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
-			// Fail if no command is set 
-			if ( !opts[CLOP_CMD].set) {
+
+			// Check for mandatory options
+			if ( !opts[CLOP_PPID].set || !opts[CLOP_LDID].set ) {
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
-				print_help(CLAP_SET_QOS);
-				exit(0);
+				print_help(CLAP_LD_CAPS);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -3748,11 +5505,11 @@ static int pr_set_qos(int key, char *arg, struct argp_state *state)
 }
 
 /**
- * Parse function for: ld config
+ * Parse function for: ld test
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_ld_config(int key, char *arg, struct argp_state *state)
+static int pr_ld_test(int key, char *arg, struct argp_state *state)
 {
 	struct opt *opts, *o;
 	int rv = 0;
@@ -3760,52 +5517,56 @@ static int pr_ld_config(int key, char *arg, struct argp_state *state)
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_LD_CONFIG, ao_ld_config);
+	rv = pr_common(key, arg, state, CLAP_LD_TEST, ao_ld_test);
 
 	// Set Command 
 	o = &opts[CLOP_CMD];
 	o->set = 1;
-	o->val = CLCM_LD_CONFIG;
+	o->val = CLCM_LD_TEST;
 
 	switch (key)
 	{
-		// Extended Register Number
-		case 'e': 
-			o = &opts[CLOP_EXT_REGISTER];
+		// Bytes to test
+		case 'n': 
+			o = &opts[CLOP_LEN];
 			o->set = 1;
-			o->u8 = hexordec_to_ul(arg);
+			o->len = hexordec_to_ull(arg);
 			break;
 
-		// First Dword Byte Enable
-		case 'f': 
-			o = &opts[CLOP_FDBE];
+		// Offset in the LD memory space
+		case 'o': 
+			o = &opts[CLOP_OFFSET];
 			o->set = 1;
-			o->u8 = hexordec_to_ul(arg);
+			o->u64 = hexordec_to_ull(arg);
 			break;
 
-		// Register Number
-		case 'r': 
-			o = &opts[CLOP_REGISTER];
+		// Fill pattern
+		case 719: 
+			o = &opts[CLOP_PATTERN];
 			o->set = 1;
-			o->u8 = hexordec_to_ul(arg);
+			o->val = ldtest_pattern(arg);
+			if (o->val < 0) {
+				return parse_error(state, "Invalid pattern: %s", arg);
+			}
 			break;
 
-		// Write Data 
-		case 'w': 
-			o = &opts[CLOP_WRITE];
+		// Seed of the prng pattern
+		case 720: 
+			o = &opts[CLOP_SEED];
 			o->set = 1;
+			o->u64 = hexordec_to_ull(arg);
 			break;
 
-		// Immediate data for write transaction
-		case 703:
-			o = &opts[CLOP_DATA];
+		// Chunk sizes
+		case 721: 
+			o = &opts[CLOP_CHUNK];
 			o->set = 1;
-			o->u32 = hexordec_to_ul(arg);
+			o->str = strdup(arg);
 			break;
 
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -3813,12 +5574,18 @@ static int pr_ld_config(int key, char *arg, struct argp_state *state)
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
+
 			// Check for mandatory options
-			if ( !opts[CLOP_PPID].set ) {
+			if ( !opts[CLOP_PPID].set || !opts[CLOP_LEN].set ) {
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
-				print_help(CLAP_LD_CONFIG);
-				exit(0);
+				print_help(CLAP_LD_TEST);
+				return parse_exit(state, 0);
+			}
+
+			// Patterns are made of whole DWords
+			if (opts[CLOP_LEN].len == 0 || opts[CLOP_LEN].len % 4 || opts[CLOP_OFFSET].u64 % 4) {
+				return parse_error(state, "Length and offset must be non zero multiples of 4");
 			}
 			break;
 	} 
@@ -3826,149 +5593,99 @@ static int pr_ld_config(int key, char *arg, struct argp_state *state)
 }
 
 /**
- * Parse function for: ld mem
+ * Parse function for: ld snapshot
  *
  * @return 0 success, non-zero to indicate a problem 
  */
-static int pr_ld_mem(int key, char *arg, struct argp_state *state)
+static int pr_ld_snapshot(int key, char *arg, struct argp_state *state)
 {
-	struct opt *opts, *o;
+	struct opt *opts;
 	int rv = 0;
 
 	opts = (struct opt*) state->input;
 
 	// Call common flag processing first
-	rv = pr_common(key, arg, state, CLAP_LD_MEM, ao_ld_mem);
-
-	// Set Command 
-	o = &opts[CLOP_CMD];
-	o->set = 1;
-	o->val = CLCM_LD_MEM;
+	rv = pr_common(key, arg, state, CLAP_LD_SNAPSHOT, ao_ld_snapshot);
 
 	switch (key)
 	{
-		// Last Dword Byte Enable
-		case 'd': 
-			o = &opts[CLOP_LDBE];
-			o->set = 1;
-			o->u8 = hexordec_to_ul(arg);
-			break;
+		// Called for non option parameter
+		case ARGP_KEY_ARG: 				
+			if (!strcmp(arg, "diff")) 
+				rv = argp_parse(&ap_ld_snapshot_diff, state->argc-state->next+1, &state->argv[state->next-1], CLAP_FLAGS(state), 0, opts);
 
-		// First Dword Byte Enable
-		case 'f': 
-			o = &opts[CLOP_FDBE];
-			o->set = 1;
-			o->u8 = hexordec_to_ul(arg);
+			else 
+				return parse_error(state, "Invalid subcommand"); 
+
+			// Stop current parser
+			state->next = state->argc; 	
 			break;
 
-		// Transaction Data Length (up to 4KB)
-		case 'n': 
-			o = &opts[CLOP_LEN];
-			o->set = 1;
-			o->len = hexordec_to_ul(arg);
-			
-			if (o->len > CLMR_MAX_LD_MEM_LEN ) {
-				argp_error(state, "Length exceeds maximum supported value: CLMR_MAX_LD_MEM_LEN\n");
-				exit(1);
+		// Last call. Verify parameters. Fill in missing values
+		case ARGP_KEY_END:				
+			// Fail if no command is set 
+			if (!opts[CLOP_CMD].set) {
+				if (opts[CLOP_PRNT_OPTS].set)
+					print_options_array(opts);
+				print_help(CLAP_LD_SNAPSHOT);
+				return parse_exit(state, 0);
 			}
 			break;
+	} 
+	return rv;	
+}
 
-		// Transaction Offset in tareget's memory space
-		case 'o': 
-			o = &opts[CLOP_OFFSET];
-			o->set = 1;
-			o->u64 = hexordec_to_ull(arg);
-			break;
+/**
+ * Parse function for: ld snapshot diff
+ *
+ * @return 0 success, non-zero to indicate a problem 
+ */
+static int pr_ld_snapshot_diff(int key, char *arg, struct argp_state *state)
+{
+	struct opt *opts, *o;
+	int rv = 0;
 
-		// Write Transacrtion
-		case 'w': 
-			o = &opts[CLOP_WRITE];
-			o->set = 1;
-			break;
+	opts = (struct opt*) state->input;
 
-		// Immediate data for write transaction
-		case 703: 
-			o = &opts[CLOP_DATA];
-			o->set = 1;
-			o->u32 = hexordec_to_ul(arg);
-			break;
+	// Call common flag processing first
+	rv = pr_common(key, arg, state, CLAP_LD_SNAPSHOT_DIFF, ao_ld_snapshot_diff);
 
-		// Filename for input file
-		case 704: 
-			o = &opts[CLOP_INFILE];
+	// Set Command 
+	o = &opts[CLOP_CMD];
+	o->set = 1;
+	o->val = CLCM_LD_SNAPSHOT_DIFF;
+
+	switch (key)
+	{
+		// Snapshot store
+		case 725: 
+			o = &opts[CLOP_STORE];
 			o->set = 1;
 			o->str = strdup(arg);
 			break;
 
-		// Called for non option parameter
+		// Snapshots to compare
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
-
-			// Stop current parser
-			state->next = state->argc; 	
+			if (!opts[CLOP_MANIFEST_A].set)
+				o = &opts[CLOP_MANIFEST_A];
+			else if (!opts[CLOP_MANIFEST_B].set)
+				o = &opts[CLOP_MANIFEST_B];
+			else {
+				return parse_error(state, "Too many snapshots");
+			}
+			o->set = 1;
+			o->str = strdup(arg);
 			break;
 
 		// Last call. Verify parameters. Fill in missing values
 		case ARGP_KEY_END:				
 
 			// Check for mandatory options
-			if ( !opts[CLOP_PPID].set || !opts[CLOP_LEN].set ) {
+			if ( !opts[CLOP_MANIFEST_A].set || !opts[CLOP_MANIFEST_B].set ) {
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
-				print_help(CLAP_LD_MEM);
-				exit(0);
-			}
-
-			// Validate len
-			if (opts[CLOP_LEN].set) {
-				if (opts[CLOP_LEN].len == 0) {
-					if (opts[CLOP_PRNT_OPTS].set)
-						print_options_array(opts);
-					argp_error(state, "Length must be greater than zero.");
-					exit(1);
-				}
-			}
-
-			// If input filename is provided, load into buffer in option
-			o = &opts[CLOP_INFILE];
-			if (o->set) {
-				int rv; 
-				FILE *fd;
-
-				// Open File 
-				fd = fopen(o->str, "rb");
-				if (!fd) {
-					if (opts[CLOP_PRNT_OPTS].set)
-						print_options_array(opts);
-					argp_error(state, "Could not open file");
-					exit(1);
-				}
-
-				// Allocate memory to read the file into 
-				o->buf = calloc(1, CLMR_MAX_LD_MEM_LEN);
-				if (!o->buf) {
-					if (opts[CLOP_PRNT_OPTS].set)
-						print_options_array(opts);
-					argp_error(state, "Could not allocation memory for file");
-					fclose(fd);
-					exit(1);
-				}
-
-				// Read in the file up to the max support buffer len
-				rv = fread(o->buf, sizeof(o->buf[0]), CLMR_MAX_LD_MEM_LEN, fd);
-				if (!rv) {
-					if (opts[CLOP_PRNT_OPTS].set)
-						print_options_array(opts);
-					argp_error(state, "Could not read file");
-					fclose(fd);
-					exit(1);
-				}
-				
-				// Close the file 
-				fclose(fd);
-
-				// Set the actual length of data in the buffer 
-				o->len = rv;
+				print_help(CLAP_LD_SNAPSHOT_DIFF);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -4005,7 +5722,7 @@ static int pr_show_qos_allocated(int key, char *arg, struct argp_state *state)
 
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -4018,7 +5735,7 @@ static int pr_show_qos_allocated(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SHOW_QOS_ALLOCATED);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -4049,7 +5766,7 @@ static int pr_show_qos_control(int key, char *arg, struct argp_state *state)
 	{
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -4062,7 +5779,7 @@ static int pr_show_qos_control(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SHOW_QOS_CONTROL);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -4099,7 +5816,7 @@ static int pr_show_qos_limit(int key, char *arg, struct argp_state *state)
 
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -4112,7 +5829,7 @@ static int pr_show_qos_limit(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SHOW_QOS_LIMIT);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -4143,7 +5860,7 @@ static int pr_show_qos_status(int key, char *arg, struct argp_state *state)
 	{
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -4156,7 +5873,7 @@ static int pr_show_qos_status(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SHOW_QOS_STATUS);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -4187,7 +5904,7 @@ static int pr_show_ld_allocations(int key, char *arg, struct argp_state *state)
 	{
 		// Called for non option parameterj
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -4200,7 +5917,7 @@ static int pr_show_ld_allocations(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SHOW_LD_ALLOCATIONS);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -4231,7 +5948,7 @@ static int pr_show_ld_info(int key, char *arg, struct argp_state *state)
 	{
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -4244,7 +5961,7 @@ static int pr_show_ld_info(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SHOW_LD_INFO);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -4305,7 +6022,7 @@ static int pr_set_ld_allocations(int key, char *arg, struct argp_state *state)
 
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -4318,14 +6035,14 @@ static int pr_set_ld_allocations(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SET_LD_ALLOCATIONS);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 
 			// Fail if no port id was set
 			if (!opts[CLOP_PPID].set) {
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
-				argp_error(state, "Insufficient Parameters");
+				return parse_error(state, "Insufficient Parameters");
 			}
 			break;
 	} 
@@ -4380,7 +6097,7 @@ static int pr_set_limit(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SET_MSG_LIMIT);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -4426,7 +6143,7 @@ static int pr_set_qos_allocated(int key, char *arg, struct argp_state *state)
 
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -4439,7 +6156,7 @@ static int pr_set_qos_allocated(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SET_QOS_ALLOCATED);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 
 			// Fail if no port id was set
@@ -4447,7 +6164,7 @@ static int pr_set_qos_allocated(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SET_QOS_ALLOCATED);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -4518,7 +6235,7 @@ static int pr_set_qos_control(int key, char *arg, struct argp_state *state)
 
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -4531,7 +6248,7 @@ static int pr_set_qos_control(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SET_QOS_CONTROL);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -4577,7 +6294,7 @@ static int pr_set_qos_limit(int key, char *arg, struct argp_state *state)
 
 		// Called for non option parameter
 		case ARGP_KEY_ARG: 				
-			argp_error (state, "Invalid subcommand"); 
+			return parse_error(state, "Invalid subcommand"); 
 
 			// Stop current parser
 			state->next = state->argc; 	
@@ -4590,7 +6307,7 @@ static int pr_set_qos_limit(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SET_QOS_LIMIT);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 
 			// Fail if no port id was set
@@ -4598,7 +6315,7 @@ static int pr_set_qos_limit(int key, char *arg, struct argp_state *state)
 				if (opts[CLOP_PRNT_OPTS].set)
 					print_options_array(opts);
 				print_help(CLAP_SET_QOS_LIMIT);
-				exit(0);
+				return parse_exit(state, 0);
 			}
 			break;
 	} 
@@ -4608,9 +6325,10 @@ static int pr_set_qos_limit(int key, char *arg, struct argp_state *state)
 /**
  * Obtain option defaults from environment if present 
  *
+ * @param opts 	Options array to store the defaults in
  * @return 	0 on Success, non zero otherwise
  */
-int options_getenv()
+int options_getenv(struct opt *opts)
 {
 	struct argp_state state;
 	int rv;
@@ -4619,6 +6337,7 @@ int options_getenv()
 
 	// Initialize variables
 	rv = 1;
+	memset(&state, 0, sizeof(state));
 	state.input = opts;
 	e = envopts;
 
@@ -4646,6 +6365,49 @@ end:
 	return rv;
 }
 
+/**
+ * Parse CLI options into a new options array 
+ *
+ * The global options array is not touched, so a command line can be parsed 
+ * while other threads still read the options in use
+ *
+ * @param o 		Set to the new options array upon success. Free with options_free()
+ * @param argc 	Number of CLI parameters 
+ * @param argv 	Array of string pointers to CLI parameters 
+ * @param flags 	Flags for argp_parse() in addition to ARGP_IN_ORDER | ARGP_NO_HELP
+ * @return 		0 upon success, non zero otherwise
+ *
+ * STEPS
+ * 1: Allocate and clear memory for options array
+ * 2: Obtain Option defaults from shell environment 
+ * 3: Parse options 
+ */ 
+int options_parse_argv(struct opt **o, int argc, char *argv[], unsigned flags)
+{
+	struct opt *n;
+	int rv;
+
+	// STEP 1: Allocate and clear memory for options array
+	n = calloc(CLOP_MAX, sizeof(struct opt));
+	if (n == NULL) 
+		return 1;
+
+	// STEP 2: Obtain Option defaults from shell environment 
+	options_getenv(n);
+
+	// STEP 3: Parse options 
+  	rv = argp_parse(&ap_main, argc, argv, ARGP_IN_ORDER | ARGP_NO_HELP | flags, 0, n);
+	if (rv != 0) 
+	{
+		free(n);
+		return rv;
+	}
+
+	*o = n;
+
+	return 0;
+}
+
 /**
  * Parse CLI options 
  *
@@ -4654,9 +6416,7 @@ end:
  * 
  * STEPS
  * 1: Store app name in global variable
- * 2: Allocate and clear memory for options array
- * 3: Obtain Option defaults from shell environment 
- * 4: Parse options 
+ * 2: Parse options into a new options array
  */ 
 int options_parse(int argc, char *argv[])
 {
@@ -4686,25 +6446,15 @@ int options_parse(int argc, char *argv[])
 	else 
 		app_name = default_name;
 
-	// STEP 2: Allocate and clear memory for options array
-	opts = calloc(CLOP_MAX, sizeof(struct opt));
-	if (opts == NULL) 
+	// STEP 2: Parse options into a new options array
+	rv = options_parse_argv(&opts, argc, argv, 0);
+	if (rv != 0) 
 		goto end_name;
 
-	// STEP 3: Obtain Option defaults from shell environment 
-	options_getenv();
-
-	// STEP 4: Parse options 
-  	rv = argp_parse(&ap_main, argc, argv, ARGP_IN_ORDER | ARGP_NO_HELP, 0, opts);
-	if (rv != 0) 
-		goto end_opt;
+	app_opts = opts;
 
 	return rv;
 
-end_opt:
-
-	free(opts);
-
 end_name:
 
 	if (app_name && app_name != default_name)
@@ -30,6 +30,8 @@
  * -w --write 			Perform a Write transaction
  * -n --length 			Length 
  * -o --offset 			Memory Offset
+ * -S --socket 			Jack daemon Unix socket path
+ * -W --window 			Max number of requests in flight
  *    --data 			Write Data (up to 4 bytes)
  *    --infile 			Filename for input data
  *    --outfile 		Filename for output data
@@ -138,6 +140,22 @@ enum _CLAP
 	CLAP_SHOW_MSG_LIMIT         = 34,
 	CLAP_SET_MSG_LIMIT          = 35,
 	CLAP_SHOW_BOS          		= 36,
+	CLAP_DAEMON          		= 37,
+	CLAP_BATCH          		= 38,
+	CLAP_WATCH          		= 39,
+	CLAP_WATCH_PORT        		= 40,
+	CLAP_WATCH_VCS         		= 41,
+	CLAP_WATCH_QOS         		= 42,
+	CLAP_EVENTS          		= 43,
+	CLAP_SHOW_BINDING      		= 44,
+	CLAP_LD_DUMP      			= 45,
+	CLAP_LD_TEST      			= 46,
+	CLAP_LD_SNAPSHOT   			= 47,
+	CLAP_LD_SNAPSHOT_DIFF		= 48,
+	CLAP_PORT_CAPS   			= 49,
+	CLAP_LD_CAPS   				= 50,
+	CLAP_REGS   				= 51,
+	CLAP_REGS_RUN   			= 52,
 
 	CLAP_MAX
 };
@@ -188,6 +206,19 @@ enum _CLCM
 	CLCM_SET_MSG_LIMIT      = 32,
 	CLCM_SHOW_BOS           = 33,
 	CLCM_LIST 				= 34,
+	CLCM_DAEMON				= 35,
+	CLCM_BATCH				= 36,
+	CLCM_WATCH_PORT			= 37,
+	CLCM_WATCH_VCS			= 38,
+	CLCM_WATCH_QOS			= 39,
+	CLCM_EVENTS				= 40,
+	CLCM_SHOW_BINDING		= 41,
+	CLCM_LD_DUMP			= 42,
+	CLCM_LD_TEST			= 43,
+	CLCM_LD_SNAPSHOT_DIFF	= 44,
+	CLCM_PORT_CAPS			= 45,
+	CLCM_LD_CAPS			= 46,
+	CLCM_REGS_RUN			= 47,
 
 	CLCM_MAX
 };
@@ -259,6 +290,30 @@ enum _CLOP
 	CLOP_LIMIT				= 39, 	//!< Message Response Limit <u8>
 	CLOP_TCP_ADDRESS		= 40,	//!< TCP Address to connect to <u32>
 	CLOP_NO_INIT			= 41,	//!< Do not initialize local state at start up
+	CLOP_SOCKET				= 42,	//!< Filename of jack daemon Unix socket <str>
+	CLOP_WINDOW				= 43,	//!< Max number of requests in flight <u16>
+	CLOP_CACHE				= 44,	//!< Filename of switch state snapshot <str>
+	CLOP_CACHE_AGE			= 45,	//!< Max age in seconds of a snapshot section <u32>
+	CLOP_SNAPSHOT			= 46,	//!< Filename of switch snapshot to answer from offline <str>
+	CLOP_INTERVAL			= 47,	//!< Poll interval in milliseconds <u32>
+	CLOP_COUNT				= 48,	//!< Number of polls or events to wait for <u32>
+	CLOP_FOLLOW				= 49,	//!< Keep streaming events until interrupted <set>
+	CLOP_WHERE				= 50,	//!< Filter expression for show port <str>
+	CLOP_FIELDS				= 51,	//!< Columns to print for show port <str>
+	CLOP_RAW				= 52,	//!< Write read data to stdout in binary <set>
+	CLOP_ALL_LD				= 53,	//!< Select every LD of a port <set>
+	CLOP_OUTDIR				= 54,	//!< Directory for output files <str>
+	CLOP_PATTERN			= 55,	//!< Fill pattern of an LD test [LTPT] <val>
+	CLOP_SEED				= 56,	//!< Seed of the PRNG pattern <u64>
+	CLOP_CHUNK				= 57,	//!< List of chunk sizes in bytes <str>
+	CLOP_VERIFY				= 58,	//!< File to compare read data against <str>
+	CLOP_CHECKSUM			= 59,	//!< Print the CRC32C of read data <set>
+	CLOP_SPARSE_MAP			= 60,	//!< Write the non-zero extents of output files <set>
+	CLOP_STORE				= 61,	//!< Directory of the LD snapshot store <str>
+	CLOP_NAME				= 62,	//!< Name of an LD snapshot <str>
+	CLOP_MANIFEST_A			= 63,	//!< First LD snapshot of a diff <str>
+	CLOP_MANIFEST_B			= 64,	//!< Second LD snapshot of a diff <str>
+	CLOP_DUMP				= 65,	//!< Read the full config space <set>
 	CLOP_MAX
 };
 
@@ -330,4 +385,9 @@ int options_free(struct opt *opts);
  */
 int options_parse(int argc, char *argv[]);
 
+/**
+ * Parse command line options into a new options array 
+ */
+int options_parse_argv(struct opt **o, int argc, char *argv[], unsigned flags);
+
 #endif //ifndef _OPTIONS_H
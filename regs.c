@@ -0,0 +1,791 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		regs.c
+ *
+ * @brief 		Code file for running scripts of config space register
+ * 				reads and writes
+ *
+ * Each line of a script is one operation on a DWord of the config space of
+ * a port or an LD:
+ *
+ * 	read  TARGET REG
+ * 	write TARGET REG VALUE
+ * 	rmw   TARGET REG MASK VALUE
+ * 	poll  TARGET REG MASK VALUE [TIMEOUT_MS]
+ * 	sync
+ *
+ * TARGET is a PPID, or PPID:LDID for an LD. REG is the byte offset of the
+ * DWord. A rmw line writes back (old & ~MASK) | (VALUE & MASK). A poll line
+ * reads until (data & MASK) == VALUE. Blank lines and text after '#' are
+ * ignored
+ *
+ * Lines run concurrently on one window of requests. A line only waits for
+ * the earlier lines on the same DWord. A poll or sync line waits for every
+ * earlier line, and every later line waits for it
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* gettid()
+ * getline()
+ */
+#define _GNU_SOURCE
+
+#include <unistd.h>
+
+/* printf()
+ */
+#include <stdio.h>
+
+/* calloc()
+ * realloc()
+ * strtoul()
+ */
+#include <stdlib.h>
+
+/* strcasecmp()
+ * strchr()
+ * strtok_r()
+ */
+#include <string.h>
+
+/* pthread_mutex_t
+ * pthread_cond_t
+ */
+#include <pthread.h>
+
+/* clock_gettime()
+ */
+#include <time.h>
+
+/* le32toh()
+ * htole32()
+ */
+#include <endian.h>
+
+/* PCLN_CFG
+ */
+#include <pciutils.h>
+
+#include <fmapi.h>
+#include <emapi.h>
+
+#include "regs.h"
+#include "cmd_encoder.h"
+#include "fmapi_handler.h"
+#include "options.h"
+
+/* MACROS ====================================================================*/
+
+#ifdef JACK_VERBOSE
+ #define INIT 			unsigned step = 0;
+ #define ENTER 					if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_THREADS) 	printf("%d:%s Enter\n", 				gettid(), __FUNCTION__);
+ #define STEP 			step++; if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_STEPS) 		printf("%d:%s STEP: %u\n", 				gettid(), __FUNCTION__, step);
+ #define EXIT(rc) 				if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_THREADS)	printf("%d:%s Exit: %d\n", 				gettid(), __FUNCTION__,rc);
+#else
+ #define INIT
+ #define ENTER
+ #define STEP
+ #define EXIT(rc)
+#endif
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * Lines in flight. Shared with the completion functions
+ */
+struct regs_ring
+{
+	pthread_mutex_t mtx;
+	pthread_cond_t 	cond;
+	unsigned 		pending;	//!< Lines whose completion function has not run
+	unsigned 		events;		//!< Responses since the caller last looked
+	unsigned 		requests;	//!< Requests that received a response
+};
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * String representation of RGOP Enumeration
+ */
+static char *STR_RGOP[] = {
+	"read",
+	"write",
+	"rmw",
+	"poll",
+	"sync"
+};
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Return time elapsed between two timespecs in seconds
+ */
+static double elapsed(struct timespec *start, struct timespec *stop)
+{
+	return (stop->tv_sec - start->tv_sec) + (stop->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Add microseconds to a timespec
+ */
+static void ts_add(struct timespec *ts, unsigned long us)
+{
+	ts->tv_sec += us / 1000000;
+	ts->tv_nsec += (us % 1000000) * 1000;
+	if (ts->tv_nsec >= 1000000000)
+	{
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000;
+	}
+}
+
+/**
+ * Return 1 if timespec a is not later than b
+ */
+static int ts_le(struct timespec *a, struct timespec *b)
+{
+	return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec <= b->tv_nsec);
+}
+
+/**
+ * Parse a number that must fill the whole word
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+static int parse_num(const char *s, unsigned long max, __u32 *val)
+{
+	unsigned long v;
+	char *end;
+
+	if (s == NULL || *s == 0 || *s == '-')
+		return 1;
+
+	v = strtoul(s, &end, 0);
+	if (*end != 0 || v > max)
+		return 1;
+
+	*val = v;
+	return 0;
+}
+
+/**
+ * Parse a PPID or PPID:LDID target
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+static int parse_target(char *s, struct regs_line *l)
+{
+	char *colon;
+	__u32 v;
+
+	colon = strchr(s, ':');
+	if (colon != NULL)
+		*colon = 0;
+
+	if (parse_num(s, 0xFF, &v))
+		return 1;
+	l->ppid = v;
+	l->ldid = -1;
+
+	if (colon != NULL)
+	{
+		if (parse_num(colon + 1, 0xFFFF, &v))
+			return 1;
+		l->ldid = v;
+	}
+
+	return 0;
+}
+
+/**
+ * Parse the words of one line
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+static int parse_line(struct regs_line *l, char **words, int n)
+{
+	__u32 v;
+	int args;
+
+	for ( l->op = 0 ; l->op < RGOP_MAX ; l->op++ )
+		if (!strcasecmp(words[0], STR_RGOP[l->op]))
+			break;
+
+	switch (l->op)
+	{
+		case RGOP_READ: 	args = 3; 	break;
+		case RGOP_WRITE: 	args = 4; 	break;
+		case RGOP_RMW: 		args = 5; 	break;
+		case RGOP_POLL: 	args = 5; 	break;
+		case RGOP_SYNC: 	args = 1; 	break;
+		default: 			return 1;
+	}
+
+	if (n != args && !(l->op == RGOP_POLL && n == args + 1))
+		return 1;
+
+	l->mask = 0xFFFFFFFF;
+	l->timeout = RGLN_POLL_MS;
+
+	if (l->op == RGOP_SYNC)
+		return 0;
+
+	if (parse_target(words[1], l))
+		return 1;
+
+	if (parse_num(words[2], PCLN_CFG - 4, &v) || (v & 3))
+		return 1;
+	l->reg = v;
+
+	switch (l->op)
+	{
+		case RGOP_WRITE:
+			if (parse_num(words[3], 0xFFFFFFFF, &l->value))
+				return 1;
+			break;
+
+		case RGOP_RMW:
+		case RGOP_POLL:
+			if (parse_num(words[3], 0xFFFFFFFF, &l->mask) || parse_num(words[4], 0xFFFFFFFF, &l->value))
+				return 1;
+			if (n > 5 && parse_num(words[5], 0xFFFFFFFF, &v))
+				return 1;
+			if (n > 5)
+				l->timeout = v;
+			break;
+	}
+
+	return 0;
+}
+
+/**
+ * Load a register script and work out the order its lines depend on
+ *
+ * @param path 	Filename of the script, or "-" for stdin
+ * @return 		struct regs* upon success, NULL otherwise
+ *
+ * STEPS
+ * 1: Open file
+ * 2: Parse each line
+ * 3: Find the lines each line waits for
+ */
+struct regs *regs_load(const char *path)
+{
+	struct regs *r;
+	struct regs_line *l, *p;
+	char *words[RGLN_MAX_WORDS + 1];
+	char *line, *save, *hash;
+	size_t cap;
+	FILE *fp;
+	int num, n, max, bad, i, k, barrier;
+
+	r = NULL;
+	line = NULL;
+	cap = 0;
+	num = 0;
+	max = 0;
+	bad = 0;
+
+	// STEP 1: Open file
+	if (!strcmp(path, "-"))
+		fp = stdin;
+	else
+		fp = fopen(path, "r");
+	if (fp == NULL)
+	{
+		printf("Error: Could not open register script %s\n", path);
+		return NULL;
+	}
+
+	r = calloc(1, sizeof(struct regs));
+	if (r == NULL)
+		goto close;
+
+	// STEP 2: Parse each line
+	while (getline(&line, &cap, fp) >= 0)
+	{
+		num++;
+
+		hash = strchr(line, '#');
+		if (hash != NULL)
+			*hash = 0;
+
+		n = 0;
+		for ( words[n] = strtok_r(line, " \t\r\n", &save) ; words[n] != NULL && n < RGLN_MAX_WORDS ; )
+			words[++n] = strtok_r(NULL, " \t\r\n", &save);
+		if (n == 0)
+			continue;
+
+		if (r->count == max)
+		{
+			max = max ? max * 2 : 64;
+			l = realloc(r->lines, max * sizeof(struct regs_line));
+			if (l == NULL)
+				goto fail;
+			r->lines = l;
+		}
+
+		l = &r->lines[r->count];
+		memset(l, 0, sizeof(*l));
+		l->num = num;
+
+		if (n == RGLN_MAX_WORDS || parse_line(l, words, n))
+		{
+			printf("Error: register script line %d: Invalid line\n", num);
+			bad++;
+			continue;
+		}
+		r->count++;
+	}
+
+	if (bad)
+		goto fail;
+
+	// STEP 3: Find the lines each line waits for
+	barrier = 0;
+	for ( i = 0 ; i < r->count ; i++ )
+	{
+		l = &r->lines[i];
+		l->prev = -1;
+		l->after = barrier;
+
+		if (l->op == RGOP_POLL || l->op == RGOP_SYNC)
+		{
+			l->after = i;
+			barrier = i + 1;
+			continue;
+		}
+
+		for ( k = i - 1 ; k >= barrier ; k-- )
+		{
+			p = &r->lines[k];
+			if (p->ppid == l->ppid && p->ldid == l->ldid && p->reg == l->reg)
+			{
+				l->prev = k;
+				break;
+			}
+		}
+	}
+
+	goto close;
+
+fail:
+
+	regs_free(r);
+	r = NULL;
+
+close:
+
+	free(line);
+	if (fp != stdin)
+		fclose(fp);
+
+	return r;
+}
+
+/**
+ * Mark a line as answered and wake up the submitting thread
+ */
+static void line_finish(struct regs_line *l, int state)
+{
+	struct regs_ring *ring = l->ring;
+
+	pthread_mutex_lock(&ring->mtx);
+	l->state = state;
+	ring->pending--;
+	ring->events++;
+	if (state == RGST_RESP)
+		ring->requests++;
+	pthread_cond_broadcast(&ring->cond);
+	pthread_mutex_unlock(&ring->mtx);
+}
+
+/**
+ * fn_completed of a request. Called from an MCTP thread
+ */
+static void line_completed(struct mctp *m, struct mctp_action *ma)
+{
+	struct regs_line *l = ma->user_data;
+	struct fmapi_msg req, rsp;
+	__u32 data;
+
+	req.buf = (struct fmapi_buf*) ma->req->payload;
+	rsp.buf = (struct fmapi_buf*) ma->rsp->payload;
+
+	fmapi_deserialize(&req.hdr, req.buf->hdr, FMOB_HDR, NULL);
+	fmapi_deserialize(&req.obj, req.buf->payload, fmapi_fmob_req(req.hdr.opcode), NULL);
+	fmapi_deserialize(&rsp.hdr, rsp.buf->hdr, FMOB_HDR, NULL);
+
+	if (rsp.hdr.category != FMMT_RESP || rsp.hdr.return_code != FMRC_SUCCESS)
+	{
+		mctp_retire(m, ma);
+		line_finish(l, RGST_FAILED);
+		return;
+	}
+
+	if (!l->writing)
+	{
+		fmapi_deserialize(&rsp.obj, rsp.buf->payload, fmapi_fmob_rsp(rsp.hdr.opcode), &req.obj);
+		if (req.hdr.opcode == FMOP_PSC_CFG)
+			memcpy(&data, rsp.obj.psc_cfg_rsp.data, 4);
+		else
+			memcpy(&data, rsp.obj.mpc_cfg_rsp.data, 4);
+		l->data = le32toh(data);
+	}
+
+	// Update the cached config space
+	fmapi_update(m, ma);
+
+	line_finish(l, RGST_RESP);
+}
+
+/**
+ * fn_failed of a request. Called from an MCTP thread
+ */
+static void line_failed(struct mctp *m, struct mctp_action *ma)
+{
+	struct regs_line *l = ma->user_data;
+
+	mctp_retire(m, ma);
+	line_finish(l, RGST_FAILED);
+}
+
+/**
+ * Submit the next request of a line
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+static int line_submit(struct mctp *m, struct cmd_window *w, struct regs_ring *ring, struct regs_line *l)
+{
+	struct fmapi_msg msg;
+	__u32 data;
+	int type;
+
+	l->writing = (l->op == RGOP_WRITE || (l->op == RGOP_RMW && l->state == RGST_NEXT));
+	type = l->writing ? FMCT_WRITE : FMCT_READ;
+	data = htole32(l->op == RGOP_WRITE ? l->value : l->data);
+
+	if (l->ldid < 0)
+		fmapi_fill_psc_cfg(&msg, l->ppid, l->reg & 0xFF, l->reg >> 8, 0xF, type, (__u8*) &data);
+	else
+		fmapi_fill_mpc_cfg(&msg, l->ppid, l->ldid, l->reg & 0xFF, l->reg >> 8, 0xF, type, (__u8*) &data);
+
+	pthread_mutex_lock(&ring->mtx);
+	l->ring = ring;
+	l->state = RGST_BUSY;
+	ring->pending++;
+	pthread_mutex_unlock(&ring->mtx);
+
+	if (submit_fmapi_async(m, w, &msg, l, line_completed, line_failed) == NULL)
+	{
+		pthread_mutex_lock(&ring->mtx);
+		l->state = RGST_FAILED;
+		ring->pending--;
+		pthread_mutex_unlock(&ring->mtx);
+		return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Take the next step of a line that received a response
+ *
+ * Called with the ring locked
+ */
+static void line_step(struct regs_line *l, struct timespec *now)
+{
+	struct timespec end;
+
+	switch (l->op)
+	{
+		case RGOP_RMW:
+			if (l->writing)
+				l->state = RGST_DONE;
+			else
+			{
+				l->old = l->data;
+				l->data = (l->old & ~l->mask) | (l->value & l->mask);
+				l->state = RGST_NEXT;
+			}
+			break;
+
+		case RGOP_POLL:
+			l->reads++;
+			end = l->start;
+			ts_add(&end, (unsigned long) l->timeout * 1000);
+			if ((l->data & l->mask) == l->value)
+				l->state = RGST_DONE;
+			else if (ts_le(&end, now))
+			{
+				l->timedout = 1;
+				l->state = RGST_FAILED;
+			}
+			else
+			{
+				l->next = *now;
+				ts_add(&l->next, RGLN_POLL_US);
+				l->state = RGST_NEXT;
+			}
+			break;
+
+		default:
+			l->state = RGST_DONE;
+			break;
+	}
+}
+
+/**
+ * Print the result of a line
+ */
+static void line_print(struct regs_line *l)
+{
+	char target[16];
+
+	if (l->ldid < 0)
+		sprintf(target, "%d", l->ppid);
+	else
+		sprintf(target, "%d:%d", l->ppid, l->ldid);
+
+	printf("[%4d] %-4s %-5s ", l->num, l->state == RGST_DONE ? "OK" : l->state == RGST_WAIT ? "SKIP" : "FAIL", STR_RGOP[l->op]);
+
+	if (l->op == RGOP_SYNC)
+	{
+		printf("\n");
+		return;
+	}
+
+	printf("%-7s 0x%03x ", target, l->reg);
+
+	if (l->state == RGST_WAIT)
+		printf("\n");
+	else if (l->state == RGST_NEXT)
+		printf("stopped\n");
+	else if (l->op == RGOP_POLL && l->timedout)
+		printf("0x%08x timed out after %u reads\n", l->data, l->reads);
+	else if (l->state != RGST_DONE)
+		printf("request failed\n");
+	else if (l->op == RGOP_RMW)
+		printf("0x%08x -> 0x%08x\n", l->old, l->data);
+	else if (l->op == RGOP_POLL)
+		printf("0x%08x after %u reads\n", l->data, l->reads);
+	else if (l->op == RGOP_WRITE)
+		printf("0x%08x\n", l->value);
+	else
+		printf("0x%08x\n", l->data);
+}
+
+/**
+ * Run a register script on one MCTP session
+ *
+ * A failed line stops lines that have not started yet. Lines in flight
+ * finish first
+ *
+ * @param m 		struct mctp* that is already connected to the endpoint
+ * @param window 	Requests in flight
+ * @return 			0 if every line succeeded, number of failed or skipped
+ * 					lines otherwise
+ *
+ * STEPS
+ * 1: Set up the ring and window
+ * 2: Take the next step of each line that is ready until all are finished
+ * 3: Drain
+ * 4: Print each line and a summary
+ */
+int regs_run(struct mctp *m, struct regs *r, int window)
+{
+	INIT
+	struct regs_ring ring;
+	struct cmd_window w;
+	struct regs_line *l;
+	struct timespec start, stop, now, wake, ts;
+	unsigned events;
+	long us;
+	int rv, i, low, halt, polls, failed;
+
+	ENTER
+
+	rv = r->count;
+	low = 0;
+	halt = 0;
+	failed = 0;
+
+	STEP // 1: Set up the ring and window
+	memset(&ring, 0, sizeof(ring));
+	if (pthread_mutex_init(&ring.mtx, NULL))
+		goto end;
+	if (pthread_cond_init(&ring.cond, NULL))
+		goto mutex;
+	if (cmd_window_init(&w, window))
+		goto cond;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	STEP // 2: Take the next step of each line that is ready until all are finished
+	while (low < r->count && !halt)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		// Process responses. Lines past the first barrier have not started
+		pthread_mutex_lock(&ring.mtx);
+		events = ring.events;
+		for ( i = low ; i < r->count && r->lines[i].after <= low ; i++ )
+		{
+			l = &r->lines[i];
+			if (l->state == RGST_RESP)
+				line_step(l, &now);
+			if (l->state == RGST_FAILED)
+				halt = 1;
+		}
+		while (low < r->count && r->lines[low].state == RGST_DONE)
+			low++;
+		pthread_mutex_unlock(&ring.mtx);
+
+		// Start lines and next steps that are ready
+		polls = 0;
+		wake = now;
+		ts_add(&wake, RGLN_POLL_US);
+		for ( i = low ; i < r->count && !halt && r->lines[i].after <= low ; i++ )
+		{
+			l = &r->lines[i];
+
+			if (l->state == RGST_NEXT && l->op == RGOP_POLL && !ts_le(&l->next, &now))
+			{
+				polls++;
+				if (!ts_le(&wake, &l->next))
+					wake = l->next;
+				continue;
+			}
+
+			if (l->state == RGST_WAIT)
+			{
+				if (l->prev >= 0 && r->lines[l->prev].state != RGST_DONE)
+					continue;
+
+				l->start = now;
+				if (l->op == RGOP_SYNC)
+				{
+					pthread_mutex_lock(&ring.mtx);
+					l->state = RGST_DONE;
+					pthread_mutex_unlock(&ring.mtx);
+					continue;
+				}
+			}
+			else if (l->state != RGST_NEXT)
+				continue;
+
+			if (line_submit(m, &w, &ring, l))
+			{
+				printf("Error: Could not submit register request\n");
+				halt = 1;
+			}
+		}
+
+		// Wait for a response, or until the next read of a poll line is due.
+		// The MCTP library fails a request once its own timeout expires, so
+		// this does not wait forever
+		pthread_mutex_lock(&ring.mtx);
+		if (ring.events == events && polls > 0)
+		{
+			us = (wake.tv_sec - now.tv_sec) * 1000000L + (wake.tv_nsec - now.tv_nsec) / 1000;
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts_add(&ts, us > 0 ? us : 0);
+			pthread_cond_timedwait(&ring.cond, &ring.mtx, &ts);
+		}
+		else 
+		{
+			while (ring.events == events && ring.pending > 0)
+				pthread_cond_wait(&ring.cond, &ring.mtx);
+		}
+		pthread_mutex_unlock(&ring.mtx);
+	}
+
+	STEP // 3: Drain. Completion functions still reference the ring
+	pthread_mutex_lock(&ring.mtx);
+	while (ring.pending > 0)
+		pthread_cond_wait(&ring.cond, &ring.mtx);
+	pthread_mutex_unlock(&ring.mtx);
+
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	cmd_window_free(&w);
+
+	STEP // 4: Print each line and a summary
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	for ( i = 0 ; i < r->count ; i++ )
+	{
+		l = &r->lines[i];
+
+		// Steps that were answered after the loop stopped
+		if (l->state == RGST_RESP)
+			line_step(l, &now);
+
+		if (l->state != RGST_DONE)
+			failed++;
+		line_print(l);
+	}
+
+	printf("Regs: %d lines, %d failed, %u requests, %.3f s elapsed\n", r->count, failed, ring.requests, elapsed(&start, &stop));
+
+	rv = failed;
+
+cond:
+
+	pthread_cond_destroy(&ring.cond);
+
+mutex:
+
+	pthread_mutex_destroy(&ring.mtx);
+
+end:
+
+	EXIT(rv)
+
+	return rv;
+}
+
+/**
+ * Free a register script
+ */
+void regs_free(struct regs *r)
+{
+	if (r == NULL)
+		return;
+
+	free(r->lines);
+	free(r);
+}
+
+/**
+ * Run a regs run command from the CLI options
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+int regs_cmd(struct mctp *m)
+{
+	struct regs *r;
+	int rv, window;
+
+	window = cmd_window_size();
+
+	// Every line is checked before any request is sent
+	r = regs_load(opts[CLOP_INFILE].str);
+	if (r == NULL)
+		return 1;
+
+	rv = regs_run(m, r, window);
+
+	regs_free(r);
+
+	return rv ? 1 : 0;
+}
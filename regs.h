@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		regs.h
+ *
+ * @brief 		Header file for running scripts of config space register
+ * 				reads and writes
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _REGS_H
+#define _REGS_H
+
+/* struct timespec
+ */
+#include <time.h>
+
+/* __u32
+ */
+#include <linux/types.h>
+
+/* struct mctp
+ */
+#include <mctp.h>
+
+/* MACROS ====================================================================*/
+
+#define RGLN_MAX_WORDS 		8 		//!< Max number of words on one line
+#define RGLN_POLL_MS 		1000 	//!< Default timeout of a poll line
+#define RGLN_POLL_US 		1000 	//!< Delay between the reads of a poll line
+
+/* ENUMERATIONS ==============================================================*/
+
+/**
+ * Operation of a line of a register script (OP)
+ */
+enum _RGOP
+{
+	RGOP_READ 		= 0,
+	RGOP_WRITE 		= 1,
+	RGOP_RMW 		= 2,	//!< Read, replace the bits in mask and write back
+	RGOP_POLL 		= 3,	//!< Read until (value & mask) matches
+	RGOP_SYNC 		= 4,	//!< Wait for all earlier lines
+	RGOP_MAX
+};
+
+/**
+ * State of a line of a register script (ST)
+ */
+enum _RGST
+{
+	RGST_WAIT 		= 0,	//!< Not started
+	RGST_BUSY 		= 1,	//!< Request in flight
+	RGST_RESP 		= 2,	//!< Response received, not processed yet
+	RGST_NEXT 		= 3,	//!< Started. Next request not submitted yet
+	RGST_DONE 		= 4,
+	RGST_FAILED 	= 5,
+	RGST_MAX
+};
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * One line of a register script
+ */
+struct regs_line
+{
+	int 	num;		//!< Line number in the file (1 based)
+	int 	op;			//!< [RGOP]
+	int 	ppid;
+	int 	ldid;		//!< LD-ID, or -1 for the port
+	unsigned reg;		//!< Byte offset of the DWord
+	__u32 	mask;
+	__u32 	value;
+	unsigned timeout;	//!< Milliseconds a poll line may take
+
+	int 	prev;		//!< Earlier line on the same DWord, or -1
+	int 	after;		//!< Lines before this index must finish first
+
+	int 	state;		//!< [RGST]
+	int 	writing;	//!< The request in flight is a write
+	int 	timedout;	//!< A poll line ran out of time
+	__u32 	data;		//!< Last value read
+	__u32 	old;		//!< Value a rmw line read
+	unsigned reads;		//!< Reads of a poll line
+	struct timespec start; 	//!< Time the line started
+	struct timespec next; 	//!< Time of the next read of a poll line
+	void 	*ring;		//!< Set while the line runs
+};
+
+/**
+ * A loaded register script
+ */
+struct regs
+{
+	int 				count;	//!< Number of lines
+	struct regs_line 	*lines;	//!< Array of lines
+};
+
+/* PROTOTYPES ================================================================*/
+
+struct regs *regs_load(const char *path);
+
+int regs_run(struct mctp *m, struct regs *r, int window);
+
+void regs_free(struct regs *r);
+
+int regs_cmd(struct mctp *m);
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_REGS_H
@@ -0,0 +1,444 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		selftest.c
+ *
+ * @brief 		Known answer checks of the code that does not need a switch
+ *
+ * Checks the CRC32C and SHA-256 implementations against published vectors,
+ * the --where / --fields parsers and a round trip through an LD snapshot
+ * store in a temporary directory. The CRC32C vectors run through both
+ * the implementation picked for this CPU (SSE4.2 or ARMv8 CRC when present)
+ * and the software one, at every alignment. Run with: make check
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* nftw()
+ */
+#define _GNU_SOURCE
+
+/* printf()
+ */
+#include <stdio.h>
+
+/* malloc()
+ * free()
+ */
+#include <stdlib.h>
+
+/* memcmp()
+ * memcpy()
+ * memset()
+ * strlen()
+ * strstr()
+ */
+#include <string.h>
+
+/* mkdtemp()
+ * dup()
+ * dup2()
+ */
+#include <unistd.h>
+
+/* nftw()
+ */
+#include <ftw.h>
+
+#include <fmapi.h>
+#include <emapi.h>
+
+#include "crc32c.h"
+#include "sha256.h"
+#include "filter.h"
+#include "ldmem.h"
+#include "ldsnap.h"
+
+/* MACROS ====================================================================*/
+
+#define STLN_RAND 			4099 	//!< Bytes of the random cross check buffer
+#define STLN_SNAP_BLOCKS 	4 		//!< Full blocks of the test snapshots
+#define STLN_OUTPUT 		4096 	//!< Bytes of captured output
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * One CRC32C known answer
+ */
+struct crc_vector
+{
+	const char *name;
+	__u8 fill;				//!< Byte value, or 0xAA for 0,1,2,...
+	unsigned len;
+	__u32 crc;
+};
+
+/**
+ * One SHA-256 known answer
+ */
+struct sha_vector
+{
+	const char *msg;
+	unsigned repeat;		//!< Times msg is hashed
+	const char *digest;		//!< Hex string
+};
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * Vectors of RFC 3720 B.4
+ */
+static struct crc_vector crc_vectors[] = {
+	{"32 bytes of zero", 		0x00, 32, 0x8A9136AA},
+	{"32 bytes of 0xFF", 		0xFF, 32, 0x62A8AB43},
+	{"32 incrementing bytes", 	0xAA, 32, 0x46DD794E},
+};
+
+/**
+ * Vectors of FIPS 180-2
+ */
+static struct sha_vector sha_vectors[] = {
+	{"", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+	{"abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+	{"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+	{"a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+};
+
+static int failures;
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Count and print a failed check
+ */
+static void check(int ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+/**
+ * Check a CRC32C value with both implementations at every alignment
+ */
+static void crc_check(const char *name, const __u8 *data, unsigned len, __u32 crc)
+{
+	char str[128];
+	__u8 *buf;
+	unsigned i, split;
+
+	buf = malloc(len + 8);
+	if (buf == NULL)
+	{
+		check(0, "malloc");
+		return;
+	}
+
+	for ( i = 0 ; i < 8 ; i++ )
+	{
+		memcpy(buf + i, data, len);
+
+		sprintf(str, "crc32c %s: %s offset %u", crc32c_impl(), name, i);
+		check(crc32c(0, buf + i, len) == crc, str);
+
+		sprintf(str, "crc32c software: %s offset %u", name, i);
+		check(crc32c_sw(0, buf + i, len) == crc, str);
+
+		// Same value when updated in two parts
+		split = len / 3;
+		sprintf(str, "crc32c %s: %s split at %u", crc32c_impl(), name, split);
+		check(crc32c(crc32c(0, buf + i, split), buf + i + split, len - split) == crc, str);
+	}
+
+	free(buf);
+}
+
+/**
+ * Check CRC32C against the known answers and cross check the implementations
+ */
+static void crc_checks()
+{
+	struct crc_vector *v;
+	__u8 data[64], *buf;
+	unsigned i, j, seed;
+
+	crc_check("123456789", (const __u8*) "123456789", 9, 0xE3069283);
+
+	for ( i = 0 ; i < sizeof(crc_vectors) / sizeof(crc_vectors[0]) ; i++ )
+	{
+		v = &crc_vectors[i];
+		for ( j = 0 ; j < v->len ; j++ )
+			data[j] = v->fill == 0xAA ? j : v->fill;
+		crc_check(v->name, data, v->len, v->crc);
+	}
+
+	// Every length up to the buffer must agree between implementations
+	buf = malloc(STLN_RAND);
+	if (buf == NULL)
+	{
+		check(0, "malloc");
+		return;
+	}
+
+	seed = 1;
+	for ( i = 0 ; i < STLN_RAND ; i++ )
+	{
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+
+	for ( i = 0 ; i < STLN_RAND ; i += (i < 64) ? 1 : 97 )
+		for ( j = 0 ; j < 8 && j < i ; j++ )
+			if (crc32c(0, buf + j, i - j) != crc32c_sw(0, buf + j, i - j))
+			{
+				printf("FAIL: crc32c %s and software differ: len %u offset %u\n", crc32c_impl(), i - j, j);
+				failures++;
+			}
+
+	free(buf);
+}
+
+/**
+ * Check SHA-256 against the known answers
+ */
+static void sha_checks()
+{
+	struct sha_vector *v;
+	struct sha256 c;
+	__u8 digest[SHLN_DIGEST], one[SHLN_DIGEST];
+	char hex[2 * SHLN_DIGEST + 1], str[128];
+	unsigned i, j, len;
+
+	for ( i = 0 ; i < sizeof(sha_vectors) / sizeof(sha_vectors[0]) ; i++ )
+	{
+		v = &sha_vectors[i];
+		len = strlen(v->msg);
+
+		sha256_init(&c);
+		for ( j = 0 ; j < v->repeat ; j++ )
+			sha256_update(&c, v->msg, len);
+		sha256_final(&c, digest);
+
+		for ( j = 0 ; j < SHLN_DIGEST ; j++ )
+			sprintf(&hex[2*j], "%02x", digest[j]);
+
+		sprintf(str, "sha256: \"%.16s\" x %u", v->msg, v->repeat);
+		check(strcmp(hex, v->digest) == 0, str);
+
+		// One shot and byte at a time updates must give the same digest
+		if (v->repeat == 1)
+		{
+			sha256(v->msg, len, one);
+			check(memcmp(one, digest, SHLN_DIGEST) == 0, "sha256: one shot");
+
+			sha256_init(&c);
+			for ( j = 0 ; j < len ; j++ )
+				sha256_update(&c, &v->msg[j], 1);
+			sha256_final(&c, one);
+			check(memcmp(one, digest, SHLN_DIGEST) == 0, "sha256: byte at a time");
+		}
+	}
+}
+
+/**
+ * Check the --where and --fields parsers
+ */
+static void filter_checks()
+{
+	struct port_filter f;
+	struct fmapi_psc_port_info p;
+	int list[FTCL_MAX];
+
+	memset(&p, 0, sizeof(p));
+	p.ppid = 3;
+	p.prsnt = 1;
+	p.mlw = 16;
+	p.nlw = 8;
+	p.num_ld = 4;
+
+	check(filter_parse(&f, NULL) == 0 && f.num == 0, "filter_parse: empty");
+	check(filter_match(&f, &p) == 1, "filter_match: empty matches");
+
+	check(filter_parse(&f, "ppid>=2, width=8,present=yes") == 0 && f.num == 3, "filter_parse: three terms");
+	check(f.terms[0].field == FTFD_PPID && f.terms[0].op == FTOP_GE && f.terms[0].val == 2, "filter_parse: ppid>=2");
+	check(f.terms[1].field == FTFD_WIDTH && f.terms[1].op == FTOP_EQ && f.terms[1].val == 8, "filter_parse: width=8");
+	check(f.terms[2].field == FTFD_PRESENT && f.terms[2].val == 1, "filter_parse: present=yes");
+	check(filter_match(&f, &p) == 1, "filter_match: matching port");
+
+	p.nlw = 0;
+	check(filter_match(&f, &p) == 0, "filter_match: width falls back to mlw");
+
+	check(filter_parse(&f, "ld!=0x4") == 0 && filter_match(&f, &p) == 0, "filter_parse: hex value");
+
+	printf("Expect two invalid --where errors:\n");
+	check(filter_parse(&f, "bogus=1") != 0, "filter_parse: unknown field");
+	check(filter_parse(&f, "ppid~1") != 0, "filter_parse: unknown operator");
+
+	check(filter_fields(list, FTCL_MAX, NULL) == FTCL_MAX, "filter_fields: default");
+	check(filter_fields(list, FTCL_MAX, "ltssm, ppid") == 2 && list[0] == FTCL_LTSSM && list[1] == FTCL_PPID, "filter_fields: order");
+
+	printf("Expect one invalid --fields error:\n");
+	check(filter_fields(list, FTCL_MAX, "ppid,nope") == -1, "filter_fields: unknown name");
+}
+
+/**
+ * nftw() callback that removes every entry of a tree
+ */
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+	(void) st;
+	(void) flag;
+	(void) ftw;
+
+	return remove(path);
+}
+
+/**
+ * Take a snapshot of a buffer, passed in chunks of an odd size
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+static int snap_take(struct ldsnap *s, const char *dir, const char *name, __u8 *data, unsigned len)
+{
+	struct ldmem_xfer x;
+	unsigned pos, k;
+
+	memset(&x, 0, sizeof(x));
+	x.ppid = 1;
+	x.len = len;
+
+	if (ldsnap_open(s, dir, name, &x))
+		return 1;
+
+	for ( pos = 0 ; pos < len ; pos += k )
+	{
+		k = len - pos < 3000 ? len - pos : 3000;
+		if (ldsnap_chunk(s, pos, &data[pos], k))
+		{
+			ldsnap_close(s, 0);
+			return 1;
+		}
+	}
+
+	return ldsnap_close(s, 1);
+}
+
+/**
+ * Run ldsnap_diff() and capture what it prints
+ *
+ * @return Return value of ldsnap_diff()
+ */
+static int snap_diff(const char *dir, const char *a, const char *b, char *out)
+{
+	FILE *fp;
+	size_t n;
+	int fd, rv;
+
+	out[0] = 0;
+
+	fp = tmpfile();
+	if (fp == NULL)
+		return 1;
+
+	fflush(stdout);
+	fd = dup(STDOUT_FILENO);
+	dup2(fileno(fp), STDOUT_FILENO);
+
+	rv = ldsnap_diff(dir, a, b);
+
+	fflush(stdout);
+	dup2(fd, STDOUT_FILENO);
+	close(fd);
+
+	rewind(fp);
+	n = fread(out, 1, STLN_OUTPUT - 1, fp);
+	out[n] = 0;
+	fclose(fp);
+
+	return rv;
+}
+
+/**
+ * Check that a snapshot store only grows by changed blocks and that two
+ * snapshots are compared block by block
+ */
+static void ldsnap_checks()
+{
+	struct ldsnap s;
+	char dir[] = "/tmp/jack-selftest-XXXXXX";
+	char out[STLN_OUTPUT];
+	__u8 *data;
+	unsigned i, len;
+
+	if (mkdtemp(dir) == NULL)
+	{
+		check(0, "ldsnap: mkdtemp");
+		return;
+	}
+
+	// Full blocks plus a partial one
+	len = STLN_SNAP_BLOCKS * LSLN_BLOCK + 100;
+	data = malloc(len);
+	if (data == NULL)
+	{
+		check(0, "malloc");
+		goto remove;
+	}
+	for ( i = 0 ; i < len ; i++ )
+		data[i] = i / LSLN_BLOCK + 1;
+
+	check(snap_take(&s, dir, "a", data, len) == 0, "ldsnap: take a");
+	check(s.blocks == STLN_SNAP_BLOCKS + 1 && s.stored == STLN_SNAP_BLOCKS + 1, "ldsnap: a stores every block");
+
+	printf("Expect one snapshot already exists error:\n");
+	check(snap_take(&s, dir, "a", data, len) != 0, "ldsnap: a is not replaced");
+
+	// Change one byte of the third block
+	data[2 * LSLN_BLOCK + 7] ^= 0xFF;
+	check(snap_take(&s, dir, "b", data, len) == 0, "ldsnap: take b");
+	check(s.blocks == STLN_SNAP_BLOCKS + 1 && s.stored == 1, "ldsnap: b only stores the changed block");
+
+	check(snap_diff(dir, "a", "b", out) == 0, "ldsnap: diff a b");
+	check(strstr(out, "Changed:  0x0000020000 - 0x000002ffff (1 blocks)") != NULL, "ldsnap: diff reports the changed block");
+	check(strstr(out, "Diff: 1 of 5 common blocks differ (65536 bytes)") != NULL, "ldsnap: diff summary");
+
+	check(snap_diff(dir, "a", "a", out) == 0 && strstr(out, "Diff: 0 of 5") != NULL, "ldsnap: diff a a");
+
+	check(snap_diff(dir, "a", "missing", out) != 0, "ldsnap: diff with a missing snapshot");
+
+	free(data);
+
+remove:
+
+	nftw(dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+int main()
+{
+	crc_checks();
+	sha_checks();
+	filter_checks();
+	ldsnap_checks();
+
+	printf("crc32c implementation: %s\n", crc32c_impl());
+
+	if (failures)
+	{
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+
+	printf("All checks passed\n");
+
+	return 0;
+}
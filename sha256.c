@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		sha256.c
+ *
+ * @brief 		Code file for the SHA-256 hash (FIPS 180-4)
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* memcpy()
+ * memset()
+ */
+#include <string.h>
+
+#include "sha256.h"
+
+/* MACROS ====================================================================*/
+
+#define ROR(x, n) 			(((x) >> (n)) | ((x) << (32 - (n))))
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * Round constants
+ */
+static const __u32 K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Hash one 64 byte block
+ */
+static void sha256_block(struct sha256 *c, const __u8 *p)
+{
+	__u32 w[64], a, b, d, e, f, g, h, cc, t1, t2;
+	int i;
+
+	for ( i = 0 ; i < 16 ; i++ )
+		w[i] = ((__u32) p[4*i] << 24) | ((__u32) p[4*i+1] << 16) | ((__u32) p[4*i+2] << 8) | p[4*i+3];
+
+	for ( i = 16 ; i < 64 ; i++ )
+		w[i] = w[i-16] + (ROR(w[i-15], 7) ^ ROR(w[i-15], 18) ^ (w[i-15] >> 3)) 
+		     + w[i-7]  + (ROR(w[i-2], 17) ^ ROR(w[i-2], 19) ^ (w[i-2] >> 10));
+
+	a = c->h[0]; b = c->h[1]; cc = c->h[2]; d = c->h[3];
+	e = c->h[4]; f = c->h[5]; g = c->h[6]; h = c->h[7];
+
+	for ( i = 0 ; i < 64 ; i++ )
+	{
+		t1 = h + (ROR(e, 6) ^ ROR(e, 11) ^ ROR(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+		t2 = (ROR(a, 2) ^ ROR(a, 13) ^ ROR(a, 22)) + ((a & b) ^ (a & cc) ^ (b & cc));
+		h = g; g = f; f = e; e = d + t1;
+		d = cc; cc = b; b = a; a = t1 + t2;
+	}
+
+	c->h[0] += a; c->h[1] += b; c->h[2] += cc; c->h[3] += d;
+	c->h[4] += e; c->h[5] += f; c->h[6] += g; c->h[7] += h;
+}
+
+/**
+ * Start a hash
+ */
+void sha256_init(struct sha256 *c)
+{
+	c->h[0] = 0x6a09e667; c->h[1] = 0xbb67ae85; c->h[2] = 0x3c6ef372; c->h[3] = 0xa54ff53a;
+	c->h[4] = 0x510e527f; c->h[5] = 0x9b05688c; c->h[6] = 0x1f83d9ab; c->h[7] = 0x5be0cd19;
+	c->len = 0;
+	c->used = 0;
+}
+
+/**
+ * Add data to a hash
+ */
+void sha256_update(struct sha256 *c, const void *data, size_t len)
+{
+	const __u8 *p = data;
+	unsigned k;
+
+	c->len += len;
+
+	if (c->used > 0)
+	{
+		k = SHLN_BLOCK - c->used;
+		if (k > len)
+			k = len;
+		memcpy(&c->buf[c->used], p, k);
+		c->used += k;
+		p += k;
+		len -= k;
+		if (c->used < SHLN_BLOCK)
+			return;
+		sha256_block(c, c->buf);
+		c->used = 0;
+	}
+
+	while (len >= SHLN_BLOCK)
+	{
+		sha256_block(c, p);
+		p += SHLN_BLOCK;
+		len -= SHLN_BLOCK;
+	}
+
+	memcpy(c->buf, p, len);
+	c->used = len;
+}
+
+/**
+ * Finish a hash
+ *
+ * @param digest 	Filled with SHLN_DIGEST bytes
+ */
+void sha256_final(struct sha256 *c, __u8 *digest)
+{
+	__u64 bits;
+	int i;
+
+	bits = c->len * 8;
+
+	c->buf[c->used++] = 0x80;
+	if (c->used > SHLN_BLOCK - 8)
+	{
+		memset(&c->buf[c->used], 0, SHLN_BLOCK - c->used);
+		sha256_block(c, c->buf);
+		c->used = 0;
+	}
+	memset(&c->buf[c->used], 0, SHLN_BLOCK - 8 - c->used);
+
+	for ( i = 0 ; i < 8 ; i++ )
+		c->buf[SHLN_BLOCK - 1 - i] = bits >> (8 * i);
+	sha256_block(c, c->buf);
+
+	for ( i = 0 ; i < 8 ; i++ )
+	{
+		digest[4*i]   = c->h[i] >> 24;
+		digest[4*i+1] = c->h[i] >> 16;
+		digest[4*i+2] = c->h[i] >> 8;
+		digest[4*i+3] = c->h[i];
+	}
+}
+
+/**
+ * Hash a buffer
+ *
+ * @param digest 	Filled with SHLN_DIGEST bytes
+ */
+void sha256(const void *data, size_t len, __u8 *digest)
+{
+	struct sha256 c;
+
+	sha256_init(&c);
+	sha256_update(&c, data, len);
+	sha256_final(&c, digest);
+}
@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		sha256.h
+ *
+ * @brief 		Header file for the SHA-256 hash
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _SHA256_H
+#define _SHA256_H
+
+/* size_t
+ */
+#include <stddef.h>
+
+/* __u8
+ * __u32
+ * __u64
+ */
+#include <linux/types.h>
+
+/* MACROS ====================================================================*/
+
+#define SHLN_DIGEST 		32 		//!< Bytes of a digest
+#define SHLN_BLOCK 			64 		//!< Bytes of a message block
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * Hash in progress
+ */
+struct sha256
+{
+	__u32 h[8];
+	__u64 len;				//!< Bytes hashed so far
+	__u8 buf[SHLN_BLOCK];	//!< Partial block
+	unsigned used;
+};
+
+/* PROTOTYPES ================================================================*/
+
+void sha256_init(struct sha256 *c);
+
+void sha256_update(struct sha256 *c, const void *data, size_t len);
+
+void sha256_final(struct sha256 *c, __u8 *digest);
+
+void sha256(const void *data, size_t len, __u8 *digest);
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_SHA256_H
@@ -0,0 +1,695 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		snapshot.c
+ *
+ * @brief 		Code file for the on-disk snapshot of the cached switch state
+ *
+ * A snapshot is a versioned binary file holding one section per group of
+ * cached state. Each section carries the generation and time of its last
+ * update so that a loader can refresh only the parts that are stale.
+ * Loading maps the file and copies the records into the cxl_switch cache
+ * without sending any FM API requests.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* printf()
+ * snprintf()
+ * rename()
+ */
+#include <stdio.h>
+
+/* calloc()
+ * free()
+ */
+#include <stdlib.h>
+
+/* memcpy()
+ * memset()
+ */
+#include <string.h>
+
+/* open()
+ */
+#include <fcntl.h>
+
+/* write()
+ * close()
+ * fsync()
+ */
+#include <unistd.h>
+
+/* time()
+ */
+#include <time.h>
+
+/* mmap()
+ * munmap()
+ */
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* PCLN_CFG
+ */
+#include <pciutils.h>
+
+#include "binding.h"
+#include "cfgdump.h"
+#include "fmapi_handler.h"
+#include "snapshot.h"
+
+/* MACROS ====================================================================*/
+
+#define SNLN_ALIGN(x) 		(((x) + 7) & ~((__u64) 7))
+#define SNLN_MIN(a, b) 		((a) < (b) ? (a) : (b))
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * Update tracking of one section of the cache
+ */
+struct snap_state
+{
+	__u64 generation;
+	__u64 timestamp;
+};
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * Update tracking of each section of the cache indexed by [JKSN]
+ *
+ * Protected by the mutex of the cxl_switch cache
+ */
+static struct snap_state sections[JKSN_MAX];
+
+/**
+ * String representation of JKSN Enumeration
+ */
+static const char *STR_JKSN[] = {
+	"switch",
+	"ports",
+	"vcss",
+	"mlds",
+	"cfgspace"
+};
+
+/**
+ * Record length of each section type indexed by [JKSN]
+ */
+static const __u32 rec_len[JKSN_MAX] = {
+	sizeof(struct snap_switch),
+	sizeof(struct snap_port),
+	sizeof(struct snap_vcs),
+	sizeof(struct snap_mld),
+	sizeof(struct snap_cfg)
+};
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Return a string representation of a snapshot section [JKSN]
+ */
+const char *snapshot_section(int section)
+{
+	if (section < 0 || section >= JKSN_MAX)
+		return NULL;
+	return STR_JKSN[section];
+}
+
+/**
+ * Record that a section of the cache was updated
+ *
+ * Caller must hold the mutex of the cxl_switch cache
+ */
+void snapshot_touch(int section)
+{
+	sections[section].generation++;
+	sections[section].timestamp = time(NULL);
+}
+
+/**
+ * Return the number of seconds since a section of the cache was updated
+ *
+ * @return Age in seconds, or ~0 if the section was never filled
+ */
+__u64 snapshot_age(int section)
+{
+	__u64 now;
+
+	if (sections[section].timestamp == 0)
+		return ~((__u64) 0);
+
+	now = time(NULL);
+	if (now < sections[section].timestamp)
+		return 0;
+
+	return now - sections[section].timestamp;
+}
+
+/**
+ * Return the generation of a section of the cache
+ */
+__u64 snapshot_generation(int section)
+{
+	return sections[section].generation;
+}
+
+/**
+ * Copy the cached state of one port into a JKSN_PORTS record
+ */
+void snapshot_port(struct snap_port *r, struct cxl_port *p, unsigned ppid)
+{
+	r->ppid 		= ppid;
+	r->state 		= p->state;
+	r->dv 			= p->dv;
+	r->dt 			= p->dt;
+	r->cv 			= p->cv;
+	r->mlw 			= p->mlw;
+	r->nlw 			= p->nlw;
+	r->speeds 		= p->speeds;
+	r->mls 			= p->mls;
+	r->cls 			= p->cls;
+	r->ltssm 		= p->ltssm;
+	r->lane 		= p->lane;
+	r->lane_rev 	= p->lane_rev;
+	r->perst 		= p->perst;
+	r->prsnt 		= p->prsnt;
+	r->pwrctrl 		= p->pwrctrl;
+	r->ld 			= p->ld;
+}
+
+/**
+ * Copy the cached state of one VCS into a JKSN_VCSS record
+ */
+void snapshot_vcs(struct snap_vcs *r, struct cxl_vcs *v, unsigned vcsid)
+{
+	unsigned k;
+
+	r->vcsid 	= vcsid;
+	r->state 	= v->state;
+	r->uspid 	= v->uspid;
+	r->num 		= v->num;
+	for ( k = 0 ; k < v->num && k < SNLN_VPPBS ; k++ )
+	{
+		r->vppbs[k].bind_status 	= v->vppbs[k].bind_status;
+		r->vppbs[k].ppid 			= v->vppbs[k].ppid;
+		r->vppbs[k].ldid 			= v->vppbs[k].ldid;
+	}
+}
+
+/**
+ * Count the config space records to store for a switch
+ */
+static unsigned count_cfg(struct cxl_switch *s)
+{
+	struct cxl_port *p;
+	unsigned n, i, k;
+
+	n = 0;
+	for ( i = 0 ; i < s->num_ports ; i++ )
+	{
+		p = &s->ports[i];
+		if (p->cfgspace != NULL)
+			n++;
+		if (p->mld == NULL)
+			continue;
+		for ( k = 0 ; k < SNLN_MIN(p->mld->num, SNLN_LDS) ; k++ )
+			if (p->mld->cfgspace[k] != NULL)
+				n++;
+	}
+	return n;
+}
+
+/**
+ * Serialize the cached state of a switch into a snapshot file
+ *
+ * The file is written under a temporary name and renamed into place so a
+ * reader never sees a partial snapshot
+ *
+ * @param s 	struct cxl_switch* cache to store
+ * @param path 	Filename of the snapshot
+ * @return 		0 upon success, non zero otherwise
+ *
+ * STEPS
+ * 1: Size sections
+ * 2: Allocate buffer
+ * 3: Fill header and section table
+ * 4: Fill records
+ * 5: Write temporary file and rename into place
+ */
+int snapshot_save(struct cxl_switch *s, const char *path)
+{
+	struct snap_hdr *hdr;
+	struct snap_sect *sect;
+	struct snap_switch *sw;
+	struct snap_port *sp;
+	struct snap_vcs *sv;
+	struct snap_mld *sm;
+	struct snap_cfg *sc;
+	struct cxl_port *p;
+	struct cxl_mld *m;
+	char tmp[4096];
+	__u8 *buf;
+	__u32 count[JKSN_MAX];
+	__u64 len, off;
+	unsigned i, k;
+	ssize_t n;
+	int rv, fd;
+
+	rv = 1;
+	buf = NULL;
+
+	pthread_mutex_lock(&s->mtx);
+
+	// STEP 1: Size sections
+	count[JKSN_SWITCH] = 1;
+	count[JKSN_PORTS] = s->num_ports;
+	count[JKSN_VCSS] = s->num_vcss;
+	count[JKSN_MLDS] = 0;
+	for ( i = 0 ; i < s->num_ports ; i++ )
+		if (s->ports[i].mld != NULL)
+			count[JKSN_MLDS]++;
+	count[JKSN_CFGSPACE] = count_cfg(s);
+
+	len = SNLN_ALIGN(sizeof(struct snap_hdr) + JKSN_MAX * sizeof(struct snap_sect));
+	for ( i = 0 ; i < JKSN_MAX ; i++ )
+		len += SNLN_ALIGN((__u64) count[i] * rec_len[i]);
+
+	// STEP 2: Allocate buffer
+	buf = calloc(1, len);
+	if (buf == NULL)
+		goto unlock;
+
+	// STEP 3: Fill header and section table
+	hdr = (struct snap_hdr*) buf;
+	hdr->magic = SNLN_MAGIC;
+	hdr->version = SNLN_VERSION;
+	hdr->num = JKSN_MAX;
+	hdr->created = time(NULL);
+	hdr->len = len;
+
+	sect = (struct snap_sect*) (buf + sizeof(struct snap_hdr));
+	off = SNLN_ALIGN(sizeof(struct snap_hdr) + JKSN_MAX * sizeof(struct snap_sect));
+	for ( i = 0 ; i < JKSN_MAX ; i++ )
+	{
+		sect[i].type = i;
+		sect[i].count = count[i];
+		sect[i].rec_len = rec_len[i];
+		sect[i].offset = off;
+		sect[i].generation = sections[i].generation;
+		sect[i].timestamp = sections[i].timestamp;
+		off += SNLN_ALIGN((__u64) count[i] * rec_len[i]);
+	}
+
+	// STEP 4: Fill records
+	sw = (struct snap_switch*) (buf + sect[JKSN_SWITCH].offset);
+	sw->sn 				= s->sn;
+	sw->vid 			= s->vid;
+	sw->did 			= s->did;
+	sw->svid 			= s->svid;
+	sw->ssid 			= s->ssid;
+	sw->bos_opcode 		= s->bos_opcode;
+	sw->bos_rc 			= s->bos_rc;
+	sw->bos_ext 		= s->bos_ext;
+	sw->num_vppbs 		= s->num_vppbs;
+	sw->active_vppbs 	= s->active_vppbs;
+	sw->num_decoders 	= s->num_decoders;
+	sw->max_msg_size_n 	= s->max_msg_size_n;
+	sw->msg_rsp_limit_n = s->msg_rsp_limit_n;
+	sw->bos_running 	= s->bos_running;
+	sw->bos_pcnt 		= s->bos_pcnt;
+	sw->ingress_port 	= s->ingress_port;
+	sw->num_ports 		= s->num_ports;
+	sw->num_vcss 		= s->num_vcss;
+
+	sp = (struct snap_port*) (buf + sect[JKSN_PORTS].offset);
+	sm = (struct snap_mld*) (buf + sect[JKSN_MLDS].offset);
+	sc = (struct snap_cfg*) (buf + sect[JKSN_CFGSPACE].offset);
+	for ( i = 0 ; i < s->num_ports ; i++, sp++ )
+	{
+		p = &s->ports[i];
+		snapshot_port(sp, p, i);
+
+		if (p->cfgspace != NULL)
+		{
+			sc->ppid = i;
+			sc->ldid = SNLN_PORT_LD;
+			memcpy(sc->data, p->cfgspace, SNLN_MIN(SNLN_CFG, PCLN_CFG));
+			sc++;
+		}
+
+		m = p->mld;
+		if (m == NULL)
+			continue;
+
+		sm->ppid 			= i;
+		sm->memory_size 	= m->memory_size;
+		sm->num 			= m->num;
+		sm->rcb 			= m->rcb;
+		sm->epc 			= m->epc;
+		sm->ttr 			= m->ttr;
+		sm->granularity 	= m->granularity;
+		sm->epc_en 			= m->epc_en;
+		sm->ttr_en 			= m->ttr_en;
+		sm->egress_mod_pcnt = m->egress_mod_pcnt;
+		sm->egress_sev_pcnt = m->egress_sev_pcnt;
+		sm->sample_interval = m->sample_interval;
+		sm->comp_interval 	= m->comp_interval;
+		sm->bp_avg_pcnt 	= m->bp_avg_pcnt;
+		for ( k = 0 ; k < SNLN_LDS ; k++ )
+		{
+			sm->rng1[k] 	= m->rng1[k];
+			sm->rng2[k] 	= m->rng2[k];
+			sm->alloc_bw[k] = m->alloc_bw[k];
+			sm->bw_limit[k] = m->bw_limit[k];
+		}
+		sm++;
+
+		for ( k = 0 ; k < SNLN_MIN(m->num, SNLN_LDS) ; k++ )
+		{
+			if (m->cfgspace[k] == NULL)
+				continue;
+			sc->ppid = i;
+			sc->ldid = k;
+			memcpy(sc->data, m->cfgspace[k], SNLN_MIN(SNLN_CFG, PCLN_CFG));
+			sc++;
+		}
+	}
+
+	sv = (struct snap_vcs*) (buf + sect[JKSN_VCSS].offset);
+	for ( i = 0 ; i < s->num_vcss ; i++, sv++ )
+		snapshot_vcs(sv, &s->vcss[i], i);
+
+	pthread_mutex_unlock(&s->mtx);
+
+	// STEP 5: Write temporary file and rename into place
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+	{
+		printf("Error: Could not create snapshot file %s\n", tmp);
+		goto end;
+	}
+
+	for ( off = 0 ; off < len ; off += n )
+	{
+		n = write(fd, buf + off, len - off);
+		if (n <= 0)
+		{
+			printf("Error: Could not write snapshot file %s\n", tmp);
+			close(fd);
+			unlink(tmp);
+			goto end;
+		}
+	}
+
+	fsync(fd);
+	close(fd);
+
+	if (rename(tmp, path) != 0)
+	{
+		printf("Error: Could not rename snapshot file to %s\n", path);
+		unlink(tmp);
+		goto end;
+	}
+
+	rv = 0;
+
+	goto end;
+
+unlock:
+
+	pthread_mutex_unlock(&s->mtx);
+
+end:
+
+	free(buf);
+
+	return rv;
+}
+
+/**
+ * Validate the header and section table of a mapped snapshot
+ *
+ * @return 0 if valid, non zero otherwise
+ */
+static int validate(__u8 *buf, __u64 len)
+{
+	struct snap_hdr *hdr;
+	struct snap_sect *sect;
+	unsigned i;
+
+	if (len < sizeof(struct snap_hdr))
+		return 1;
+
+	hdr = (struct snap_hdr*) buf;
+	if (hdr->magic != SNLN_MAGIC || hdr->version != SNLN_VERSION || hdr->len != len)
+		return 1;
+	if (hdr->num != JKSN_MAX)
+		return 1;
+	if (sizeof(struct snap_hdr) + hdr->num * sizeof(struct snap_sect) > len)
+		return 1;
+
+	sect = (struct snap_sect*) (buf + sizeof(struct snap_hdr));
+	for ( i = 0 ; i < hdr->num ; i++ )
+	{
+		if (sect[i].type != i || sect[i].rec_len != rec_len[i])
+			return 1;
+		if (sect[i].offset % 8 || sect[i].offset > len)
+			return 1;
+		if ((__u64) sect[i].count * sect[i].rec_len > len - sect[i].offset)
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Load a snapshot file into the cached state of a switch
+ *
+ * @param s 			struct cxl_switch* cache to fill
+ * @param path 			Filename of the snapshot
+ * @return 				0 upon success, non zero otherwise
+ *
+ * STEPS
+ * 1: Map file
+ * 2: Validate
+ * 3: Copy switch record
+ * 4: Copy port records
+ * 5: Copy VCS records
+ * 6: Copy MLD records
+ * 7: Copy config space records
+ * 8: Restore section generations
+ */
+int snapshot_load(struct cxl_switch *s, const char *path)
+{
+	struct stat st;
+	struct snap_sect *sect;
+	struct snap_switch *sw;
+	struct snap_port *sp;
+	struct snap_vcs *sv;
+	struct snap_mld *sm;
+	struct snap_cfg *sc;
+	struct cxl_port *p;
+	struct cxl_vcs *v;
+	struct cxl_mld *m;
+	__u8 *buf;
+	unsigned i, k;
+	int rv, fd;
+
+	rv = 1;
+	buf = MAP_FAILED;
+
+	// STEP 1: Map file
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		goto end;
+
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+		goto close;
+
+	buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (buf == MAP_FAILED)
+		goto close;
+
+	// STEP 2: Validate
+	if (validate(buf, st.st_size))
+	{
+		printf("Error: Invalid snapshot file %s\n", path);
+		goto unmap;
+	}
+
+	sect = (struct snap_sect*) (buf + sizeof(struct snap_hdr));
+	if (sect[JKSN_SWITCH].count != 1)
+		goto unmap;
+
+	pthread_mutex_lock(&s->mtx);
+
+	// STEP 3: Copy switch record
+	sw = (struct snap_switch*) (buf + sect[JKSN_SWITCH].offset);
+	if (fmapi_resize(s, sw->num_ports, sw->num_vcss, sw->num_vppbs))
+		goto unlock;
+
+	s->sn 				= sw->sn;
+	s->vid 				= sw->vid;
+	s->did 				= sw->did;
+	s->svid 			= sw->svid;
+	s->ssid 			= sw->ssid;
+	s->bos_opcode 		= sw->bos_opcode;
+	s->bos_rc 			= sw->bos_rc;
+	s->bos_ext 			= sw->bos_ext;
+	s->active_vppbs 	= sw->active_vppbs;
+	s->num_decoders 	= sw->num_decoders;
+	s->max_msg_size_n 	= sw->max_msg_size_n;
+	s->msg_rsp_limit_n 	= sw->msg_rsp_limit_n;
+	s->bos_running 		= sw->bos_running;
+	s->bos_pcnt 		= sw->bos_pcnt;
+	s->ingress_port 	= sw->ingress_port;
+
+	// STEP 4: Copy port records
+	sp = (struct snap_port*) (buf + sect[JKSN_PORTS].offset);
+	for ( i = 0 ; i < sect[JKSN_PORTS].count ; i++, sp++ )
+	{
+		if (sp->ppid >= s->num_ports)
+			continue;
+		p = &s->ports[sp->ppid];
+		p->state 	= sp->state;
+		p->dv 		= sp->dv;
+		p->dt 		= sp->dt;
+		p->cv 		= sp->cv;
+		p->mlw 		= sp->mlw;
+		p->nlw 		= sp->nlw;
+		p->speeds 	= sp->speeds;
+		p->mls 		= sp->mls;
+		p->cls 		= sp->cls;
+		p->ltssm 	= sp->ltssm;
+		p->lane 	= sp->lane;
+		p->lane_rev = sp->lane_rev;
+		p->perst 	= sp->perst;
+		p->prsnt 	= sp->prsnt;
+		p->pwrctrl 	= sp->pwrctrl;
+		p->ld 		= sp->ld;
+	}
+
+	// STEP 5: Copy VCS records
+	sv = (struct snap_vcs*) (buf + sect[JKSN_VCSS].offset);
+	for ( i = 0 ; i < sect[JKSN_VCSS].count ; i++, sv++ )
+	{
+		if (sv->vcsid >= s->num_vcss)
+			continue;
+		v = &s->vcss[sv->vcsid];
+		v->vcsid 	= sv->vcsid;
+		v->state 	= sv->state;
+		v->uspid 	= sv->uspid;
+		v->num 		= sv->num < s->num_vppbs ? sv->num : s->num_vppbs;
+		for ( k = 0 ; k < v->num && k < SNLN_VPPBS ; k++ )
+		{
+			v->vppbs[k].bind_status = sv->vppbs[k].bind_status;
+			v->vppbs[k].ppid 		= sv->vppbs[k].ppid;
+			v->vppbs[k].ldid 		= sv->vppbs[k].ldid;
+		}
+	}
+	if (binding_rebuild(s))
+		goto unlock;
+
+	// Config space of a snapshot may be stale, so it is read again when used
+	cfgdump_reset(0);
+
+	// STEP 6: Copy MLD records
+	sm = (struct snap_mld*) (buf + sect[JKSN_MLDS].offset);
+	for ( i = 0 ; i < sect[JKSN_MLDS].count ; i++, sm++ )
+	{
+		if (sm->ppid >= s->num_ports)
+			continue;
+		p = &s->ports[sm->ppid];
+		if (p->mld == NULL)
+			p->mld = calloc(1, sizeof(struct cxl_mld));
+		m = p->mld;
+		if (m == NULL)
+			goto unlock;
+
+		m->memory_size 		= sm->memory_size;
+		m->num 				= SNLN_MIN(sm->num, SNLN_LDS);
+		m->rcb 				= sm->rcb;
+		m->epc 				= sm->epc;
+		m->ttr 				= sm->ttr;
+		m->granularity 		= sm->granularity;
+		m->epc_en 			= sm->epc_en;
+		m->ttr_en 			= sm->ttr_en;
+		m->egress_mod_pcnt 	= sm->egress_mod_pcnt;
+		m->egress_sev_pcnt 	= sm->egress_sev_pcnt;
+		m->sample_interval 	= sm->sample_interval;
+		m->comp_interval 	= sm->comp_interval;
+		m->bp_avg_pcnt 		= sm->bp_avg_pcnt;
+		for ( k = 0 ; k < SNLN_LDS ; k++ )
+		{
+			m->rng1[k] 		= sm->rng1[k];
+			m->rng2[k] 		= sm->rng2[k];
+			m->alloc_bw[k] 	= sm->alloc_bw[k];
+			m->bw_limit[k] 	= sm->bw_limit[k];
+		}
+	}
+
+	// STEP 7: Copy config space records
+	sc = (struct snap_cfg*) (buf + sect[JKSN_CFGSPACE].offset);
+	for ( i = 0 ; i < sect[JKSN_CFGSPACE].count ; i++, sc++ )
+	{
+		if (sc->ppid >= s->num_ports)
+			continue;
+		p = &s->ports[sc->ppid];
+
+		if (sc->ldid == SNLN_PORT_LD)
+		{
+			if (p->cfgspace == NULL)
+				p->cfgspace = calloc(1, PCLN_CFG);
+			if (p->cfgspace == NULL)
+				goto unlock;
+			memcpy(p->cfgspace, sc->data, SNLN_MIN(SNLN_CFG, PCLN_CFG));
+			continue;
+		}
+
+		m = p->mld;
+		if (m == NULL || sc->ldid >= SNLN_LDS)
+			continue;
+		if (m->cfgspace[sc->ldid] == NULL)
+			m->cfgspace[sc->ldid] = calloc(1, PCLN_CFG);
+		if (m->cfgspace[sc->ldid] == NULL)
+			goto unlock;
+		memcpy(m->cfgspace[sc->ldid], sc->data, SNLN_MIN(SNLN_CFG, PCLN_CFG));
+	}
+
+	// STEP 8: Restore section generations
+	for ( i = 0 ; i < JKSN_MAX ; i++ )
+	{
+		sections[i].generation = sect[i].generation;
+		sections[i].timestamp = sect[i].timestamp;
+	}
+
+	rv = 0;
+
+unlock:
+
+	pthread_mutex_unlock(&s->mtx);
+
+unmap:
+
+	munmap(buf, st.st_size);
+
+close:
+
+	close(fd);
+
+end:
+
+	return rv;
+}
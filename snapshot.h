@@ -0,0 +1,222 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		snapshot.h
+ *
+ * @brief 		Header file for the on-disk snapshot of the cached switch state
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ * File layout (native byte order, all offsets 8 byte aligned)
+ *
+ *   struct snap_hdr
+ *   struct snap_sect [num]
+ *   section payloads, each an array of fixed length records
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+
+/* __u8
+ * __u16
+ * __u32
+ * __u64
+ */
+#include <linux/types.h>
+
+/* struct cxl_switch
+ */
+#include <cxlstate.h>
+
+/* MACROS ====================================================================*/
+
+#define SNLN_MAGIC 			0x53534B4A 	//!< "JKSS"
+#define SNLN_VERSION 		1
+#define SNLN_LDS 			16 			//!< LDs per MLD stored in a snapshot
+#define SNLN_VPPBS 			256 		//!< vPPBs per VCS stored in a snapshot
+#define SNLN_CFG 			4096 		//!< Bytes of config space per function
+#define SNLN_PORT_LD 		0xFFFF 		//!< ldid of a port (not an LD) config space
+
+#define JKSN_ALL 			((1 << JKSN_MAX) - 1)
+#define JKSN_BIT(s) 		(1 << (s))
+
+/* ENUMERATIONS ==============================================================*/
+
+/**
+ * Snapshot Section Types (SN)
+ *
+ * Each section is refreshed by its own group of FM API requests
+ */
+enum _JKSN
+{
+	JKSN_SWITCH 	= 0,	//!< Switch identity, limits & BOS
+	JKSN_PORTS 		= 1,	//!< Physical port status
+	JKSN_VCSS 		= 2,	//!< VCS and vPPB binding status
+	JKSN_MLDS 		= 3,	//!< MLD info, allocations & QoS
+	JKSN_CFGSPACE 	= 4,	//!< Cached config space of ports and LDs
+	JKSN_MAX
+};
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * Snapshot file header
+ */
+struct snap_hdr
+{
+	__u32 magic;		//!< SNLN_MAGIC
+	__u16 version;		//!< SNLN_VERSION
+	__u16 num;			//!< Number of section descriptors that follow
+	__u64 created;		//!< Time the file was written (seconds since epoch)
+	__u64 len;			//!< Total length of the file
+};
+
+/**
+ * Snapshot section descriptor
+ */
+struct snap_sect
+{
+	__u32 type;			//!< [JKSN]
+	__u32 count;		//!< Number of records
+	__u32 rec_len;		//!< Length of one record
+	__u32 rsvd;
+	__u64 offset;		//!< Offset of first record from start of file
+	__u64 generation;	//!< Incremented each time the section was updated
+	__u64 timestamp;	//!< Time of last update (seconds since epoch)
+};
+
+/**
+ * JKSN_SWITCH record
+ */
+struct snap_switch
+{
+	__u64 sn;
+	__u16 vid;
+	__u16 did;
+	__u16 svid;
+	__u16 ssid;
+	__u16 bos_opcode;
+	__u16 bos_rc;
+	__u16 bos_ext;
+	__u16 num_vppbs;
+	__u16 active_vppbs;
+	__u16 num_decoders;
+	__u8  max_msg_size_n;
+	__u8  msg_rsp_limit_n;
+	__u8  bos_running;
+	__u8  bos_pcnt;
+	__u8  ingress_port;
+	__u8  num_ports;
+	__u8  num_vcss;
+	__u8  rsvd[1];
+};
+
+/**
+ * JKSN_PORTS record
+ */
+struct snap_port
+{
+	__u8 ppid;
+	__u8 state;
+	__u8 dv;
+	__u8 dt;
+	__u8 cv;
+	__u8 mlw;
+	__u8 nlw;
+	__u8 speeds;
+	__u8 mls;
+	__u8 cls;
+	__u8 ltssm;
+	__u8 lane;
+	__u8 lane_rev;
+	__u8 perst;
+	__u8 prsnt;
+	__u8 pwrctrl;
+	__u8 ld;
+	__u8 rsvd[7];
+};
+
+/**
+ * vPPB entry of a JKSN_VCSS record
+ */
+struct snap_vppb
+{
+	__u8  bind_status;
+	__u8  ppid;
+	__u16 ldid;
+};
+
+/**
+ * JKSN_VCSS record
+ */
+struct snap_vcs
+{
+	__u8 vcsid;
+	__u8 state;
+	__u8 uspid;
+	__u8 num;
+	struct snap_vppb vppbs[SNLN_VPPBS];
+};
+
+/**
+ * JKSN_MLDS record
+ */
+struct snap_mld
+{
+	__u64 memory_size;
+	__u64 rng1[SNLN_LDS];
+	__u64 rng2[SNLN_LDS];
+	__u16 num;
+	__u16 rcb;
+	__u8  ppid;
+	__u8  epc;
+	__u8  ttr;
+	__u8  granularity;
+	__u8  epc_en;
+	__u8  ttr_en;
+	__u8  egress_mod_pcnt;
+	__u8  egress_sev_pcnt;
+	__u8  sample_interval;
+	__u8  comp_interval;
+	__u8  bp_avg_pcnt;
+	__u8  rsvd[1];
+	__u8  alloc_bw[SNLN_LDS];
+	__u8  bw_limit[SNLN_LDS];
+};
+
+/**
+ * JKSN_CFGSPACE record
+ */
+struct snap_cfg
+{
+	__u8  ppid;
+	__u8  rsvd;
+	__u16 ldid;			//!< LD-ID, or SNLN_PORT_LD for the port itself
+	__u32 rsvd2;
+	__u8  data[SNLN_CFG];
+};
+
+/* PROTOTYPES ================================================================*/
+
+void snapshot_touch(int section);
+
+__u64 snapshot_age(int section);
+
+__u64 snapshot_generation(int section);
+
+int snapshot_save(struct cxl_switch *s, const char *path);
+
+int snapshot_load(struct cxl_switch *s, const char *path);
+
+const char *snapshot_section(int section);
+
+void snapshot_port(struct snap_port *r, struct cxl_port *p, unsigned ppid);
+
+void snapshot_vcs(struct snap_vcs *r, struct cxl_vcs *v, unsigned vcsid);
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_SNAPSHOT_H
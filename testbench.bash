@@ -7,15 +7,26 @@ set -x
 jack 
 
 jack aer 
+jack batch
+jack daemon -h
+jack events -h
 jack ld 
+jack ld caps
 jack ld cfg 
+jack ld dump
 jack ld mem 
+jack ld snapshot
+jack ld snapshot diff
+jack ld test
 jack mctp 
 jack port 
 jack port bind      
+jack port caps
 jack port config 
 jack port control
 jack port unbind 
+jack regs
+jack regs run
 jack set ld 
 jack set ld allocations
 jack set qos 
@@ -23,6 +34,7 @@ jack set qos allocated
 jack set qos control 
 jack set qos limit 
 jack show 
+jack show binding -h
 jack show ld
 jack show ld allocations
 jack show ld info
@@ -34,6 +46,10 @@ jack show qos limit
 jack show qos status 
 jack show switch -h 
 jack show vcs -h
+jack watch
+jack watch port -h
+jack watch vcs -h
+jack watch qos -h
 set +x
 
 echo -e \\n------------------------------------------------------------------------------
@@ -149,3 +165,120 @@ jack mctp --get-type
 jack mctp --get-ver 0x7
 set +x
 
+echo -e \\n------------------------------------------------------------------------------
+echo -e 12: Show Filters and Bindings \\n
+
+set -x
+jack show port --where "present=1,width>=1" --fields ppid,state,nlw,ltssm
+jack show port --where "ppid<4" --fields ltssm,ppid
+jack show port --where "bogus=1"
+jack show binding -p 1
+jack show binding -p 1 -l 0
+set +x
+
+echo -e \\n------------------------------------------------------------------------------
+echo -e 13: Config Space Dumps and Capabilities \\n
+
+set -x
+jack port config -p 0 --dump
+jack port config -p 0 --dump --outfile /tmp/jack-port0.txt
+lspci -F /tmp/jack-port0.txt -vv
+jack ld config -p 1 -l 0 --dump --window 32
+jack port caps -p 0
+jack ld caps -p 1 -l 0
+set +x
+
+echo -e \\n------------------------------------------------------------------------------
+echo -e 14: LD Memory \\n
+
+set -x
+jack ld mem -p 1 -l 0 -o 0 -n 0x1000 --raw | xxd | head
+jack ld mem -p 1 -l 0 -o 0 -n 0x10000 --outfile /tmp/jack-ld0.bin
+jack ld mem -p 1 -l 0 -o 0 --verify /tmp/jack-ld0.bin --checksum
+jack ld mem -p 1 -l 0 -o 0 -n 0x10000 -w --data 0xa1a2a3a4
+jack ld mem -p 1 -l 0 -o 0 --verify /tmp/jack-ld0.bin --checksum
+jack ld mem -p 1 -l 0 -o 0 -n 0x10000 -w --infile /tmp/jack-ld0.bin
+rm -rf /tmp/jack-snaps /tmp/jack-dumps
+jack ld mem -p 1 -l 0 -o 0 -n 0x40000 --store /tmp/jack-snaps --name before
+jack ld mem -p 1 -l 0 -o 0x20000 -n 0x1000 -w --data 0xb1b2b3b4
+jack ld mem -p 1 -l 0 -o 0 -n 0x40000 --store /tmp/jack-snaps --name after
+jack ld snapshot diff --store /tmp/jack-snaps before after
+jack ld dump -p 1 --all-ld --outdir /tmp/jack-dumps --sparse-map
+ls -ls /tmp/jack-dumps
+jack ld test -p 1 -l 0 -n 0x100000 --pattern prng --seed 7 --chunk 256,1024,4096
+jack ld test -p 1 -l 0 -n 0x100000 --pattern ones
+set +x
+
+echo -e \\n------------------------------------------------------------------------------
+echo -e 15: Register Scripts \\n
+
+cat > /tmp/jack-regs.txt << EOF
+read  0   0x00
+read  1:0 0x00
+write 0   0x10 0xa1a2a3a4
+rmw   0   0x10 0xffff0000 0xb1b20000
+read  0   0x10
+sync
+poll  0   0x00 0xffffffff 0x00000000 100
+EOF
+
+set -x
+jack regs run /tmp/jack-regs.txt
+jack regs run /tmp/jack-regs.txt --window 1
+echo "bogus 0 0x00" | jack regs run -
+set +x
+
+echo -e \\n------------------------------------------------------------------------------
+echo -e 16: Batch Mode \\n
+
+cat > /tmp/jack-batch.txt << EOF
+# Comments and blank lines are skipped
+
+show port -p 1
+port unbind -c 0 -b 0
+port bind -p 1 -l 0 -c 0 -b 0
+show vcs -c 0
+EOF
+
+set -x
+jack batch /tmp/jack-batch.txt
+echo "show switch" | jack batch -
+echo "show nonsense" | jack batch -
+set +x
+
+echo -e \\n------------------------------------------------------------------------------
+echo -e 17: Daemon Mode and Snapshots \\n
+
+set -x
+rm -f /tmp/jack.snap
+jack ld mem -p 1 -l 0 -o 0 -n 0x1000 --outfile /tmp/jack-direct.bin
+jack daemon --cache /tmp/jack.snap &
+sleep 2
+jack show switch
+jack show port -a
+jack show binding -p 1
+jack ld mem -p 1 -l 0 -o 0 -n 0x1000 --raw > /tmp/jack-daemon.bin
+cmp /tmp/jack-daemon.bin /tmp/jack-direct.bin
+kill %1
+wait
+jack show port -a --snapshot /tmp/jack.snap
+jack show vcs -a --snapshot /tmp/jack.snap
+jack show ld info -p 1 --snapshot /tmp/jack.snap
+set +x
+
+echo -e \\n------------------------------------------------------------------------------
+echo -e 18: Watch and Events \\n
+
+set -x
+jack watch port --interval 200 --count 3
+jack watch vcs --interval 200 --count 3
+jack watch qos --interval 200 --count 3
+timeout 5 jack events --follow --count 1
+set +x
+
+echo -e \\n------------------------------------------------------------------------------
+echo -e 19: Local Checks \\n
+
+set -x
+make check
+set +x
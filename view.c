@@ -0,0 +1,240 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		view.c
+ *
+ * @brief 		Code file for read only views of the cached switch state
+ *
+ * Writers update the cxl_switch cache under its mutex and then publish a new
+ * view of the port and VCS state with a single atomic pointer swap. Readers
+ * never take the mutex. They enter one of two reader epochs, load the current
+ * view and leave the epoch when done. The writer flips the epoch after the
+ * swap and frees the old view once no reader is left in the previous epoch.
+ *
+ * Readers must not block (e.g. wait for an MCTP response) while holding a
+ * view, since the writer runs on the MCTP thread and waits for them.
+ *
+ * The readers are watch, events, show binding and the VCS scan of 
+ * refresh_port(), which run next to the MCTP thread applying responses.
+ *
+ * Every response touches its section of the cache, so a new view is only 
+ * published when the copied state differs from the current view. The 
+ * generation of the view therefore only changes with its content.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* calloc()
+ * free()
+ */
+#include <stdlib.h>
+
+/* memcmp()
+ * memset()
+ */
+#include <string.h>
+
+/* sched_yield()
+ */
+#include <sched.h>
+
+/* atomic_load()
+ * atomic_exchange()
+ * atomic_fetch_add()
+ */
+#include <stdatomic.h>
+
+#include "view.h"
+
+/* MACROS ====================================================================*/
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * Currently published view. NULL until the first publish
+ */
+static struct cxl_view *_Atomic current;
+
+/**
+ * Reader epoch. Only the low bit selects the counter in readers[]
+ */
+static atomic_uint epoch;
+
+/**
+ * Number of readers inside each epoch
+ */
+static atomic_uint readers[2];
+
+/**
+ * Generations of the port and VCS sections the current view was last found
+ * equal to. Only used by the writer
+ */
+static __u64 port_gen;
+static __u64 vcs_gen;
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Return 1 if a view holds the same port and VCS state as the cache
+ *
+ * The binding index is derived from the VCSs and is not compared
+ */
+static int view_equal(const struct cxl_view *v, struct cxl_switch *s)
+{
+	struct snap_port port;
+	struct snap_vcs vcs;
+	unsigned i;
+
+	if (v->num_ports != s->num_ports || v->num_vcss != s->num_vcss)
+		return 0;
+
+	// Copies are cleared first like the calloc()ed view, so they compare
+	// equal byte for byte
+	for ( i = 0 ; i < v->num_ports ; i++ )
+	{
+		memset(&port, 0, sizeof(port));
+		snapshot_port(&port, &s->ports[i], i);
+		if (memcmp(&port, &v->ports[i], sizeof(port)))
+			return 0;
+	}
+
+	for ( i = 0 ; i < v->num_vcss ; i++ )
+	{
+		memset(&vcs, 0, sizeof(vcs));
+		snapshot_vcs(&vcs, &s->vcss[i], i);
+		if (memcmp(&vcs, &v->vcss[i], sizeof(vcs)))
+			return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * Publish a new view if the ports or VCSs changed since the current one
+ *
+ * Must be called with s->mtx held. Publishes are serialized by that mutex
+ *
+ * @return 0 upon success. Non zero otherwise
+ */
+int view_publish(struct cxl_switch *s)
+{
+	struct cxl_view *v, *old;
+	unsigned i, e;
+
+	// Nothing was touched since the current view was found equal 
+	old = atomic_load(&current);
+	if (old != NULL
+		&& port_gen == snapshot_generation(JKSN_PORTS)
+		&& vcs_gen == snapshot_generation(JKSN_VCSS)
+		&& old->num_ports == s->num_ports
+		&& old->num_vcss == s->num_vcss)
+		return 0;
+
+	// Responses that rewrote the same state are not published
+	if (old != NULL && view_equal(old, s))
+		goto equal;
+
+	// One allocation holds the view and its arrays
+	v = calloc(1, sizeof(struct cxl_view)
+		+ s->num_ports * sizeof(struct snap_port)
+		+ s->num_vcss * sizeof(struct snap_vcs)
+		+ s->num_ports * BDLN_SLOTS * sizeof(struct bind_entry));
+	if (v == NULL)
+		return 1;
+
+	v->gen 			= old ? old->gen + 1 : 1;
+	v->num_ports 	= s->num_ports;
+	v->num_vcss 	= s->num_vcss;
+	v->ports 		= (struct snap_port*) (v + 1);
+	v->vcss 		= (struct snap_vcs*) (v->ports + v->num_ports);
+	v->binds 		= (struct bind_entry*) (v->vcss + v->num_vcss);
+
+	for ( i = 0 ; i < v->num_ports ; i++ )
+		snapshot_port(&v->ports[i], &s->ports[i], i);
+	for ( i = 0 ; i < v->num_vcss ; i++ )
+		snapshot_vcs(&v->vcss[i], &s->vcss[i], i);
+	binding_copy(v->binds, v->num_ports);
+
+	// Swap, then move new readers to the other epoch and wait for the
+	// readers that may still hold the old view to leave
+	old = atomic_exchange(&current, v);
+	e = atomic_fetch_add(&epoch, 1) & 1;
+	while (atomic_load(&readers[e]) != 0)
+		sched_yield();
+
+	free(old);
+
+equal:
+
+	port_gen 	= snapshot_generation(JKSN_PORTS);
+	vcs_gen 	= snapshot_generation(JKSN_VCSS);
+
+	return 0;
+}
+
+/**
+ * Get the current view without locking
+ *
+ * @param token Filled with the value to pass to view_release()
+ * @return 		The current view or NULL if none was published yet
+ */
+const struct cxl_view *view_acquire(unsigned *token)
+{
+	unsigned e;
+
+	// Retry if the epoch flipped between reading it and entering it
+	for (;;)
+	{
+		e = atomic_load(&epoch) & 1;
+		atomic_fetch_add(&readers[e], 1);
+		if ((atomic_load(&epoch) & 1) == e)
+			break;
+		atomic_fetch_sub(&readers[e], 1);
+	}
+
+	*token = e;
+
+	return atomic_load(&current);
+}
+
+/**
+ * Release a view returned by view_acquire()
+ */
+void view_release(unsigned token)
+{
+	atomic_fetch_sub(&readers[token & 1], 1);
+}
+
+/**
+ * Return the generation of the current view. 0 if none was published yet
+ */
+__u64 view_generation()
+{
+	const struct cxl_view *v;
+	unsigned token;
+	__u64 gen;
+
+	v = view_acquire(&token);
+	gen = v ? v->gen : 0;
+	view_release(token);
+
+	return gen;
+}
+
+/**
+ * Free the current view. No readers may be active
+ */
+void view_free()
+{
+	free(atomic_exchange(&current, NULL));
+}
@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		view.h
+ *
+ * @brief 		Header file for read only views of the cached switch state
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _VIEW_H
+#define _VIEW_H
+
+/* __u64
+ */
+#include <linux/types.h>
+
+/* struct cxl_switch
+ */
+#include <cxlstate.h>
+
+/* struct bind_entry
+ */
+#include "binding.h"
+
+/* struct snap_port
+ * struct snap_vcs
+ */
+#include "snapshot.h"
+
+/* MACROS ====================================================================*/
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * Immutable copy of the port and VCS state of the cache
+ *
+ * A view is never modified after it is published. Each update of the cache
+ * that changes the ports or VCSs publishes a new view in place of the old one
+ */
+struct cxl_view
+{
+	__u64 gen;					//!< Incremented for each published view
+	unsigned num_ports;
+	unsigned num_vcss;
+	struct snap_port *ports;	//!< Array of num_ports
+	struct snap_vcs *vcss;		//!< Array of num_vcss
+	struct bind_entry *binds;	//!< Copy of the binding index. num_ports * BDLN_SLOTS
+};
+
+/* PROTOTYPES ================================================================*/
+
+int view_publish(struct cxl_switch *s);
+
+const struct cxl_view *view_acquire(unsigned *token);
+
+void view_release(unsigned token);
+
+__u64 view_generation();
+
+void view_free();
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_VIEW_H
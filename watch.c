@@ -0,0 +1,566 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		watch.c
+ *
+ * @brief 		Code file for polling the switch and printing only the
+ * 				entries that changed
+ *
+ * Each poll refreshes one section of the cached switch state on the open MCTP
+ * session. The watched fields of every entry (a port, a vPPB or an MLD / LD)
+ * are then copied out of the cache, or its published view, and hashed. Only entries whose hash differs
+ * from the previous poll are compared field by field and printed.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* gettid()
+ */
+#define _GNU_SOURCE
+
+/* printf()
+ */
+#include <stdio.h>
+
+/* calloc()
+ * free()
+ */
+#include <stdlib.h>
+
+/* memset()
+ */
+#include <string.h>
+
+#include <unistd.h>
+
+/* sigaction()
+ */
+#include <signal.h>
+
+/* clock_gettime()
+ * clock_nanosleep()
+ * localtime_r()
+ */
+#include <time.h>
+
+#include <fmapi.h>
+#include <cxlstate.h>
+
+#include "watch.h"
+#include "fmapi_handler.h"
+#include "options.h"
+#include "snapshot.h"
+#include "view.h"
+
+/* MACROS ====================================================================*/
+
+#ifdef JACK_VERBOSE
+ #define INIT 			unsigned step = 0;
+ #define ENTER 					if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_THREADS) 	printf("%d:%s Enter\n", 				gettid(), __FUNCTION__);
+ #define STEP 			step++; if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_STEPS) 		printf("%d:%s STEP: %u\n", 				gettid(), __FUNCTION__, step);
+ #define EXIT(rc) 				if (opts[CLOP_VERBOSITY].u64 & MCTP_VERBOSE_THREADS)	printf("%d:%s Exit: %d\n", 				gettid(), __FUNCTION__,rc);
+#else
+ #define INIT
+ #define ENTER
+ #define STEP
+ #define EXIT(rc)
+#endif
+
+#define WTLN_FIELDS 		10 		//!< Max watched fields per entry
+#define WTLN_LDS 			16 		//!< Max LDs per MLD
+#define WTLN_VPPBS 			256 	//!< Max vPPBs per VCS
+#define WTLN_LABEL 			32 		//!< Max length of an entry label
+#define WTLN_VALUE 			32 		//!< Max length of a printed field value
+
+/* ENUMERATIONS ==============================================================*/
+
+/**
+ * Watch Field Types (WTFT) - How to print a field value
+ */
+enum _WTFT
+{
+	WTFT_INT 	= 0,	//!< Decimal number
+	WTFT_BOOL 	= 1,	//!< Yes / No
+	WTFT_PS 	= 2,	//!< Port State [FMPS]
+	WTFT_DT 	= 3,	//!< Device Type [FMDT]
+	WTFT_LS 	= 4,	//!< LTSSM State [FMLS]
+	WTFT_MS 	= 5,	//!< Link Speed [FMMS]
+	WTFT_WIDTH 	= 6,	//!< Link Width
+	WTFT_VS 	= 7,	//!< VCS State [FMVS]
+	WTFT_BS 	= 8,	//!< vPPB Bind Status [FMBS]
+	WTFT_MAX
+};
+
+/**
+ * Watch Entry Kinds (WTKN)
+ */
+enum _WTKN
+{
+	WTKN_PORT 	= 0,	//!< Physical port
+	WTKN_VPPB 	= 1,	//!< vPPB of a VCS
+	WTKN_QOS 	= 2,	//!< QoS control & status of an MLD
+	WTKN_LD 	= 3,	//!< QoS allocation & limit of one LD of an MLD
+	WTKN_MAX
+};
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * Field description
+ */
+struct watch_field
+{
+	const char *name;
+	int type;			//!< [WTFT]
+};
+
+/**
+ * One watched entry of a poll
+ *
+ * Lists are kept sorted by id so consecutive polls can be merged
+ */
+struct watch_entry
+{
+	__u32 id;					//!< Sort key. Encodes the port / VCS / vPPB / LD
+	int kind;					//!< [WTKN]
+	__u64 hash;					//!< Hash of v[]
+	__u32 v[WTLN_FIELDS];		//!< Field values
+};
+
+/**
+ * The fields of each kind of entry
+ */
+struct watch_kind
+{
+	int num;
+	struct watch_field fields[WTLN_FIELDS];
+};
+
+/* PROTOTYPES ================================================================*/
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * Set by the signal handler to request the watch loop to stop
+ */
+static volatile sig_atomic_t watch_stop;
+
+/**
+ * Watched fields of each kind of entry
+ */
+static const struct watch_kind kinds[] =
+{
+	[WTKN_PORT] = { 9, {
+		{"present", 	WTFT_BOOL},
+		{"state", 		WTFT_PS},
+		{"type", 		WTFT_DT},
+		{"ltssm", 		WTFT_LS},
+		{"width", 		WTFT_WIDTH},
+		{"max width", 	WTFT_WIDTH},
+		{"speed", 		WTFT_MS},
+		{"max speed", 	WTFT_MS},
+		{"perst", 		WTFT_BOOL},
+	}},
+	[WTKN_VPPB] = { 5, {
+		{"vcs state", 	WTFT_VS},
+		{"usp", 		WTFT_INT},
+		{"binding", 	WTFT_BS},
+		{"ppid", 		WTFT_INT},
+		{"ldid", 		WTFT_INT},
+	}},
+	[WTKN_QOS] = { 9, {
+		{"lds", 		WTFT_INT},
+		{"congestion", 	WTFT_BOOL},
+		{"throttle", 	WTFT_BOOL},
+		{"egress mod", 	WTFT_INT},
+		{"egress sev", 	WTFT_INT},
+		{"sample", 		WTFT_INT},
+		{"rcb", 		WTFT_INT},
+		{"interval", 	WTFT_INT},
+		{"bp avg", 		WTFT_INT},
+	}},
+	[WTKN_LD] = { 2, {
+		{"alloc", 		WTFT_INT},
+		{"limit", 		WTFT_INT},
+	}},
+};
+
+/* FUNCTIONS =================================================================*/
+
+static void watch_signal(int sig)
+{
+	watch_stop = sig;
+}
+
+/**
+ * FNV-1a hash of the field values of an entry
+ */
+static __u64 hash_entry(struct watch_entry *e)
+{
+	__u8 *p;
+	__u64 h;
+	size_t i, len;
+
+	h = 0xcbf29ce484222325ULL;
+	p = (__u8*) e->v;
+	len = kinds[e->kind].num * sizeof(__u32);
+
+	for ( i = 0 ; i < len ; i++ )
+	{
+		h ^= p[i];
+		h *= 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+/**
+ * Format a field value
+ */
+static char *field_str(char *buf, int type, __u32 v)
+{
+	switch (type)
+	{
+		case WTFT_BOOL: 	sprintf(buf, "%s", v ? "Yes" : "No");	break;
+		case WTFT_PS: 		sprintf(buf, "%s", fmps(v));			break;
+		case WTFT_DT: 		sprintf(buf, "%s", fmdt(v));			break;
+		case WTFT_LS: 		sprintf(buf, "%s", fmls(v));			break;
+		case WTFT_MS: 		sprintf(buf, "%s", fmms(v));			break;
+		case WTFT_WIDTH: 	sprintf(buf, "x%u", v);					break;
+		case WTFT_VS: 		sprintf(buf, "%s", fmvs(v));			break;
+		case WTFT_BS: 		sprintf(buf, "%s", fmbs(v));			break;
+		default: 			sprintf(buf, "%u", v);					break;
+	}
+	return buf;
+}
+
+/**
+ * Format the label of an entry
+ */
+static char *entry_label(char *buf, struct watch_entry *e)
+{
+	switch (e->kind)
+	{
+		case WTKN_PORT: sprintf(buf, "port %u", e->id);										break;
+		case WTKN_VPPB: sprintf(buf, "vcs %u vppb %u", e->id >> 16, e->id & 0xFFFF);			break;
+		case WTKN_QOS: 	sprintf(buf, "port %u qos", e->id >> 16);							break;
+		case WTKN_LD: 	sprintf(buf, "port %u ld %u", e->id >> 16, (e->id & 0xFFFF) - 1);		break;
+	}
+	return buf;
+}
+
+/**
+ * Print one entry that changed
+ *
+ * @param prev 	Entry from the previous poll. NULL if the entry is new
+ */
+static void print_entry(const char *ts, struct watch_entry *e, struct watch_entry *prev)
+{
+	const struct watch_kind *k;
+	char label[WTLN_LABEL];
+	char a[WTLN_VALUE], b[WTLN_VALUE];
+	int i;
+
+	k = &kinds[e->kind];
+
+	printf("%s %-16s", ts, entry_label(label, e));
+	for ( i = 0 ; i < k->num ; i++ )
+	{
+		if (prev == NULL)
+			printf(" %s: %s", k->fields[i].name, field_str(a, k->fields[i].type, e->v[i]));
+		else if (prev->v[i] != e->v[i])
+			printf(" %s: %s -> %s", k->fields[i].name,
+				field_str(a, k->fields[i].type, prev->v[i]),
+				field_str(b, k->fields[i].type, e->v[i]));
+	}
+	printf("\n");
+}
+
+/**
+ * Copy the watched entries out of the cached switch state
+ *
+ * @param cmd 	[CLCM] watch command
+ * @param list 	Array to fill, sorted by id
+ * @param max 	Size of the list array
+ * @return 		Number of entries filled
+ */
+static int collect(int cmd, struct watch_entry *list, int max)
+{
+	const struct cxl_view *view;
+	const struct snap_port *p;
+	const struct snap_vcs *v;
+	struct watch_entry *e;
+	struct cxl_mld *mld;
+	unsigned token;
+	int i, k, n;
+
+	n = 0;
+
+	// Ports and VCSs are read from the published view without locking
+	view = view_acquire(&token);
+
+	for ( i = 0 ; view != NULL && i < (int) view->num_ports && cmd == CLCM_WATCH_PORT && n < max ; i++ )
+	{
+		p = &view->ports[i];
+		e = &list[n++];
+		memset(e, 0, sizeof(*e));
+		e->id 		= i;
+		e->kind 	= WTKN_PORT;
+		e->v[0] 	= p->prsnt;
+		e->v[1] 	= p->state;
+		e->v[2] 	= p->dt;
+		e->v[3] 	= p->ltssm;
+		e->v[4] 	= p->nlw ? p->nlw : p->mlw;
+		e->v[5] 	= p->mlw;
+		e->v[6] 	= p->cls;
+		e->v[7] 	= p->mls;
+		e->v[8] 	= p->perst;
+	}
+
+	for ( i = 0 ; view != NULL && i < (int) view->num_vcss && cmd == CLCM_WATCH_VCS ; i++ )
+	{
+		v = &view->vcss[i];
+
+		for ( k = 0 ; k < v->num && n < max ; k++ )
+		{
+			e = &list[n++];
+			memset(e, 0, sizeof(*e));
+			e->id 		= (i << 16) | k;
+			e->kind 	= WTKN_VPPB;
+			e->v[0] 	= v->state;
+			e->v[1] 	= v->uspid;
+			e->v[2] 	= v->vppbs[k].bind_status;
+			e->v[3] 	= v->vppbs[k].ppid;
+			e->v[4] 	= v->vppbs[k].ldid;
+		}
+	}
+
+	view_release(token);
+
+	// MLD state is not part of the view 
+	if (cmd == CLCM_WATCH_QOS)
+		pthread_mutex_lock(&cxls->mtx);
+
+	for ( i = 0 ; i < cxls->num_ports && cmd == CLCM_WATCH_QOS ; i++ )
+	{
+		mld = cxls->ports[i].mld;
+		if (mld == NULL || cxls->ports[i].dt != FMDT_CXL_TYPE_3_POOLED || n >= max)
+			continue;
+
+		e = &list[n++];
+		memset(e, 0, sizeof(*e));
+		e->id 		= i << 16;
+		e->kind 	= WTKN_QOS;
+		e->v[0] 	= mld->num;
+		e->v[1] 	= mld->epc_en;
+		e->v[2] 	= mld->ttr_en;
+		e->v[3] 	= mld->egress_mod_pcnt;
+		e->v[4] 	= mld->egress_sev_pcnt;
+		e->v[5] 	= mld->sample_interval;
+		e->v[6] 	= mld->rcb;
+		e->v[7] 	= mld->comp_interval;
+		e->v[8] 	= mld->bp_avg_pcnt;
+
+		for ( k = 0 ; k < mld->num && k < WTLN_LDS && n < max ; k++ )
+		{
+			e = &list[n++];
+			memset(e, 0, sizeof(*e));
+			e->id 		= (i << 16) | (k + 1);
+			e->kind 	= WTKN_LD;
+			e->v[0] 	= mld->alloc_bw[k];
+			e->v[1] 	= mld->bw_limit[k];
+		}
+	}
+
+	if (cmd == CLCM_WATCH_QOS)
+		pthread_mutex_unlock(&cxls->mtx);
+
+	for ( i = 0 ; i < n ; i++ )
+		list[i].hash = hash_entry(&list[i]);
+
+	return n;
+}
+
+/**
+ * Merge two sorted entry lists and print the entries that changed
+ *
+ * @return Number of entries printed
+ */
+static int compare(const char *ts, struct watch_entry *prev, int np, struct watch_entry *cur, int nc)
+{
+	char label[WTLN_LABEL];
+	int i, k, n;
+
+	i = 0;
+	k = 0;
+	n = 0;
+
+	while (i < np || k < nc)
+	{
+		// Entry went away
+		if (k >= nc || (i < np && prev[i].id < cur[k].id))
+		{
+			printf("%s %-16s removed\n", ts, entry_label(label, &prev[i]));
+			i++;
+			n++;
+		}
+		// New entry
+		else if (i >= np || cur[k].id < prev[i].id)
+		{
+			print_entry(ts, &cur[k], NULL);
+			k++;
+			n++;
+		}
+		// Same entry. Only compare fields when the hash differs
+		else
+		{
+			if (cur[k].hash != prev[i].hash)
+			{
+				print_entry(ts, &cur[k], &prev[i]);
+				n++;
+			}
+			i++;
+			k++;
+		}
+	}
+
+	return n;
+}
+
+/**
+ * Poll the switch and print only the entries that changed
+ *
+ * The watched kind is taken from the CLCM_WATCH_* command. Runs until the
+ * --count polls have been done or SIGINT / SIGTERM is received
+ *
+ * @param m 	struct mctp* that is already connected to the endpoint
+ * @param fn 	Function to refresh sections of the cached switch state
+ * @return 		0 upon success. Non zero otherwise
+ *
+ * STEPS
+ * 1: Install signal handlers
+ * 2: Discover the switch
+ * 3: Allocate entry lists
+ * 4: Poll, compare & print until stopped
+ */
+int watch_run(struct mctp *m, int (*fn)(struct mctp *m, unsigned mask))
+{
+	INIT
+	struct sigaction act;
+	struct watch_entry *prev, *cur, *tmp;
+	struct timespec next, now;
+	struct tm tm;
+	char ts[16];
+	unsigned mask, polls;
+	__u64 gen, last;
+	int rv, cmd, max, np, nc;
+
+	ENTER
+
+	rv = 1;
+	prev = NULL;
+	cur = NULL;
+	np = 0;
+	polls = 0;
+	last = 0;
+	cmd = opts[CLOP_CMD].val;
+
+	STEP // 1: Install signal handlers
+	memset(&act, 0, sizeof(act));
+	act.sa_handler = watch_signal;
+	sigemptyset(&act.sa_mask);
+	sigaction(SIGINT, &act, NULL);
+	sigaction(SIGTERM, &act, NULL);
+	watch_stop = 0;
+
+	STEP // 2: Discover the switch
+	switch (cmd)
+	{
+		case CLCM_WATCH_PORT: 	mask = JKSN_BIT(JKSN_PORTS);						break;
+		case CLCM_WATCH_VCS: 	mask = JKSN_BIT(JKSN_VCSS);							break;
+		case CLCM_WATCH_QOS: 	mask = JKSN_BIT(JKSN_PORTS) | JKSN_BIT(JKSN_MLDS);	break;
+		default: 				goto end;
+	}
+
+	if (fn(m, mask | JKSN_BIT(JKSN_SWITCH)) != 0)
+	{
+		printf("Error: Could not read switch state\n");
+		goto end;
+	}
+
+	STEP // 3: Allocate entry lists
+	if (cmd == CLCM_WATCH_VCS)
+		max = cxls->num_vcss * WTLN_VPPBS;
+	else
+		max = cxls->num_ports * (1 + WTLN_LDS);
+	if (max == 0)
+		max = 1;
+
+	prev = calloc(max, sizeof(struct watch_entry));
+	cur = calloc(max, sizeof(struct watch_entry));
+	if (prev == NULL || cur == NULL)
+		goto end;
+
+	STEP // 4: Poll, compare & print until stopped
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	rv = 0;
+	while (!watch_stop)
+	{
+		// The first poll is the discovery above
+		if (polls > 0 && fn(m, mask) != 0)
+			printf("Error: Poll %u failed\n", polls);
+
+		// Nothing to compare if no new port / VCS view was published
+		gen = view_generation();
+		if (cmd != CLCM_WATCH_QOS && polls > 0 && gen == last)
+			goto next;
+		last = gen;
+
+		nc = collect(cmd, cur, max);
+
+		clock_gettime(CLOCK_REALTIME, &now);
+		localtime_r(&now.tv_sec, &tm);
+		sprintf(ts, "%02d:%02d:%02d.%03ld", tm.tm_hour, tm.tm_min, tm.tm_sec, now.tv_nsec / 1000000);
+
+		if (compare(ts, prev, np, cur, nc) > 0)
+			fflush(stdout);
+
+		tmp = prev;
+		prev = cur;
+		cur = tmp;
+		np = nc;
+
+next:
+
+		polls++;
+		if (opts[CLOP_COUNT].set && polls >= opts[CLOP_COUNT].u32)
+			break;
+
+		// Sleep until the next poll is due. A slow poll is not made up for
+		next.tv_sec 	+= opts[CLOP_INTERVAL].u32 / 1000;
+		next.tv_nsec 	+= (opts[CLOP_INTERVAL].u32 % 1000) * 1000000;
+		if (next.tv_nsec >= 1000000000)
+		{
+			next.tv_sec++;
+			next.tv_nsec -= 1000000000;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (now.tv_sec > next.tv_sec || (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec))
+			next = now;
+		else
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+
+end:
+
+	free(prev);
+	free(cur);
+
+	EXIT(rv)
+
+	return rv;
+}
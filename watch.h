@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		watch.h
+ *
+ * @brief 		Header file for polling the switch and printing only the
+ * 				entries that changed
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2024
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+#ifndef _WATCH_H
+#define _WATCH_H
+
+/* struct mctp
+ */
+#include <mctp.h>
+
+/* MACROS ====================================================================*/
+
+/* ENUMERATIONS ==============================================================*/
+
+/* STRUCTS ===================================================================*/
+
+/* PROTOTYPES ================================================================*/
+
+int watch_run(struct mctp *m, int (*fn)(struct mctp *m, unsigned mask));
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+#endif //_WATCH_H